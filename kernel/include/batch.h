@@ -0,0 +1,77 @@
+#pragma once
+
+#include <stdint.h>
+
+// Command buffer format of kernel_batch, shared with the user-side client. Both buffers start with a BatchHeader;
+// requests follow as BatchOp records and replies as BatchResult records, each with its payload padded to 4 bytes.
+
+#define BATCH_MAGIC 0x48544250 // "PBTH"
+#define BATCH_VERSION 1
+#define BATCH_MAX_IN 0x4000
+#define BATCH_MAX_OUT 0x10000
+#define BATCH_MAX_READ 0x1000 // Per read op
+#define BATCH_REGS 17 // r0-r15 and cpsr
+#define BATCH_NAME_MAX 28
+#define BATCH_PAD(n) (((n) + 3) & ~3u)
+
+typedef enum
+{
+    BATCH_READ = 1,         // arg0 address, arg1 size; replies with the bytes
+    BATCH_WRITE,            // arg0 address, payload the bytes
+    BATCH_SET_BREAKPOINT,   // arg0 address, arg1 SlotType; status is the breakpoint id
+    BATCH_CLEAR_BREAKPOINT, // arg0 id
+    BATCH_LIST_BREAKPOINTS, // arg0 id to list after (-1 for all), arg1 max entries; replies BatchBreakpoint[]
+    BATCH_GET_REGISTERS,    // arg0 thid, 0 for the thread the GUI shows; replies BATCH_REGS words, status the reason
+    BATCH_LIST_MODULES      // arg1 max entries; replies BatchModule[]
+} BatchOpcode;
+
+typedef struct
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count; // Records that follow
+    uint32_t size;  // Bytes including this header
+} BatchHeader;
+
+typedef struct
+{
+    uint16_t op;
+    uint16_t size; // Payload bytes after the record, before padding
+    uint32_t arg0, arg1;
+} BatchOp;
+
+typedef struct
+{
+    uint16_t op;
+    uint16_t size;  // Payload bytes after the record, before padding
+    int32_t status; // < 0 on failure, otherwise the op's result
+} BatchResult;
+
+typedef struct
+{
+    int32_t id;
+    uint32_t address;
+    uint32_t type; // SlotType
+    uint32_t hits;
+} BatchBreakpoint;
+
+typedef struct
+{
+    int32_t modid;
+    uint32_t text, text_size;
+    char name[BATCH_NAME_MAX];
+} BatchModule;
+
+// What the executor runs the ops against: the debugger in the kernel module, or anything standing in for it.
+typedef struct
+{
+    int (*read)(uint32_t addr, void *dst, uint32_t size);
+    int (*write)(uint32_t addr, const void *src, uint32_t size);
+    int (*set_breakpoint)(uint32_t addr, uint32_t type);
+    int (*clear_breakpoint)(int id);
+    int (*list_breakpoints)(int after, BatchBreakpoint *dst, uint32_t max); // Returns the count
+    int (*get_registers)(int32_t thid, uint32_t *regs);                    // Returns the ThreadReason
+    int (*list_modules)(BatchModule *dst, uint32_t max);                   // Returns the count
+} BatchBackend;
+
+int batch_execute(const void *in, uint32_t in_size, void *out, uint32_t out_size, const BatchBackend *backend);
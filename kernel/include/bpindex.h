@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BPINDEX_NONE 0xFFFF
+#define BPINDEX_MAX_CHAIN 8 // Slots sharing one address that a lookup returns
+
+typedef struct
+{
+    uint32_t address;
+    uint16_t head; // First slot at this address, BPINDEX_NONE for a free bucket
+} BpBucket;
+
+// Address -> slot index over the breakpoint table. Open addressing with linear probing; slots sharing an address
+// are chained through next[]. Writers are serialised by the caller, readers go through a sequence counter and never
+// block, so the exception handlers can use it while the GUI thread edits breakpoints.
+typedef struct
+{
+    uint32_t seq;
+    uint32_t shift, mask;
+    uint32_t count;
+    BpBucket *buckets;
+    uint16_t *next;
+    uint32_t slots;
+} BpIndex;
+
+void bpindex_init(BpIndex *ix, BpBucket *buckets, uint32_t bucket_bits, uint16_t *next, uint32_t slots);
+int bpindex_insert(BpIndex *ix, uint32_t address, uint32_t slot);
+int bpindex_remove(BpIndex *ix, uint32_t address, uint32_t slot);
+uint32_t bpindex_lookup(const BpIndex *ix, uint32_t address, uint16_t *out, uint32_t max);
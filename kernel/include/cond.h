@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define COND_MAX_CODE 64
+#define COND_MAX_STACK 8
+#define COND_REG_COUNT 17 // r0-r12, sp, lr, pc, cpsr in SceArmCpuRegisters order
+
+// Reads target memory for [ ] dereferences; returns < 0 when the address is unmapped.
+typedef int (*CondReadFn)(uint32_t addr, void *dst, uint32_t size);
+
+typedef struct
+{
+    uint8_t code[COND_MAX_CODE];
+    uint8_t length;
+} CondProgram;
+
+int cond_register(const char **text);
+int cond_compile(CondProgram *prog, const char *text);
+bool cond_eval(const CondProgram *prog, const uint32_t *regs, uint32_t hits, CondReadFn read);
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define DISASM_TEXT_MAX 40
+#define DISASM_CACHE_LINES 256 // Power of two
+
+typedef struct
+{
+    uint32_t addr;
+    uint32_t raw;  // Encoding the text was decoded from; Thumb-2 keeps the first halfword in the top half
+    uint8_t size;  // 2 or 4, 0 for an empty entry
+    bool thumb;
+    char text[DISASM_TEXT_MAX];
+} DisasmLine;
+
+// Decoded lines keyed by address, reused while the bytes under them are unchanged.
+typedef struct
+{
+    DisasmLine lines[DISASM_CACHE_LINES];
+    uint32_t hits, misses;
+} DisasmCache;
+
+uint32_t disasm_decode(uint32_t addr, const uint8_t *bytes, uint32_t avail, bool thumb, char *out, uint32_t out_size,
+                       uint32_t *raw);
+const DisasmLine *disasm_line(DisasmCache *cache, uint32_t addr, const uint8_t *bytes, uint32_t avail, bool thumb);
+void disasm_cache_reset(DisasmCache *cache);
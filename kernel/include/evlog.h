@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdint.h>
+
+#define EVLOG_SIZE 256 // Events, power of two
+#define EVLOG_CORES 4
+#define EVLOG_STAGE_ENTRY 7 // Asm stub entry, before the pre-filter
+#define EVLOG_ASM_A(stage, core) ((stage) | (core) << 8)
+
+enum
+{
+    EV_ASM_ENTRY = 1, // a = EVLOG_ASM_A(stage, core): 7 entry, 0 passed on, 1-6 handled; b = PMU cycles
+    EV_HANDLER,       // a = stage (1-4 through exception_handler), b = pc or thread
+};
+
+typedef struct
+{
+    uint32_t seq; // Position + 1 once the event is complete, 0 while it is written
+    uint32_t time;
+    uint16_t kind;
+    uint16_t a;
+    uint32_t b;
+} EvlogEvent;
+
+// Flight recorder for the exception path: writers on any core claim a slot with one atomic add and overwrite the
+// oldest event, so logging never waits. Readers copy events out and drop the ones overwritten while copying.
+typedef struct
+{
+    uint32_t head;
+    EvlogEvent events[EVLOG_SIZE];
+} Evlog;
+
+typedef struct
+{
+    uint32_t count, p50, max;
+} EvlogSpan;
+
+void evlog_push(Evlog *log, uint32_t time, uint16_t kind, uint16_t a, uint32_t b);
+uint32_t evlog_snapshot(const Evlog *log, EvlogEvent *out, uint32_t max);
+void evlog_asm_span(const EvlogEvent *events, uint32_t count, uint16_t from, uint16_t to, uint32_t *scratch,
+                    EvlogSpan *out);
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define FRAMETIME_WINDOW 64
+
+typedef enum
+{
+    FT_INPUT,    // Controller read and input handling
+    FT_STATE,    // update_memview_state
+    FT_MEMREAD,  // Target memory reads for the view
+    FT_DRAW,     // draw_gui
+    FT_PRESENT,  // Event flag handoff until the user module flips the buffer
+    FT_LATENCY,  // Button edge until the frame that reflects it is flipped
+    FT_COUNT
+} FrameStage;
+
+typedef uint64_t (*FrameClock)(void);
+
+typedef struct
+{
+    uint32_t p50, p95, max;
+    uint32_t count;
+} StageStats;
+
+typedef struct
+{
+    FrameClock clock;
+    uint32_t samples[FT_COUNT][FRAMETIME_WINDOW];
+    uint32_t head[FT_COUNT], count[FT_COUNT];
+    uint64_t start[FT_COUNT];
+    uint32_t current[FT_COUNT];
+    uint64_t input_edge, handoff;
+    bool input_pending, handoff_pending;
+} FrameTimer;
+
+void frametime_init(FrameTimer *t, FrameClock clock);
+void frametime_begin(FrameTimer *t, FrameStage stage);
+void frametime_end(FrameTimer *t, FrameStage stage);
+void frametime_record(FrameTimer *t, FrameStage stage, uint32_t us);
+void frametime_commit(FrameTimer *t);
+void frametime_input_edge(FrameTimer *t);
+void frametime_handoff(FrameTimer *t);
+void frametime_presented(FrameTimer *t);
+void frametime_stats(const FrameTimer *t, FrameStage stage, StageStats *out);
@@ -14,13 +14,37 @@
 #include <psp2kern/kernel/proc_event.h>
 #include <psp2kern/kernel/processmgr.h>
 
+#include "regions.h"
+#include "bpindex.h"
+#include "cond.h"
+#include "trace.h"
+#include "evlog.h"
+#include "nextpc.h"
+#include "unwind.h"
+#include "symbols.h"
+#include "threads.h"
+#include "batch.h"
+#include "swpatch.h"
+
 #define UI_WIDTH 960 // ToDo: Needs adjust for PSTV!!!
 #define UI_HEIGHT 544 // ToDo: Needs adjust for PSTV!!!
 
 #define MAX_CALL_STACK_DEPTH 16
+#define SYMBOL_TEXT_MAX 32 // Symbol text after an address in the right panel, cut off at the screen edge anyway
+#define UNWIND_STACK_WINDOW 0x2000 // Bytes above sp copied for one backtrace
+#define STACK_VIEW_WORDS 1024 // Stack panel window above sp
+#define STACK_PAGE_WORDS 64   // Read at a time as the panel scrolls onto them
 #define MAX_SLOT 16
 #define MAX_HW_BKPT 5
 #define SINGLE_STEP_SLOT (MAX_HW_BKPT - 1)
+#define SW_BKPT_CHUNK 512 // SW breakpoints per store memblock, allocated on demand
+#define SW_BKPT_CHUNKS 8
+#define SW_BKPT_MAX (SW_BKPT_CHUNK * SW_BKPT_CHUNKS)
+#define BP_ID_MAX (MAX_SLOT + SW_BKPT_MAX) // Ids below MAX_SLOT are fixed slots, the rest index the SW store
+#define BP_BUCKET_BITS 13 // 2 buckets per id
+#define MAX_CONDITIONS 32
+#define COND_TEXT_MAX 32
+#define MAX_TRACEPOINTS 16
 #define SW_THUMB 0xBE00
 #define SW_ARM 0xE1200070
 // #define THREADMGR_NID 0xE2C40624 //Wrong for 3.63+?
@@ -37,8 +61,22 @@
 #define DEFAULT_CANCEL SCE_CTRL_CROSS
 #define DEFAULT_CONFIRM SCE_CTRL_CIRCLE
 #define HOTKEY_PATH "ux0:data/pebbleHotkey.txt"
+#define FRAMESTATS_PATH "ux0:data/pebbleFrameStats.txt"
+#define TRACE_PATH "ux0:data/pebbleTracepoints.bin"
+#define NIDDB_PATH "ux0:data/pebbleNids.bin"
+#define GUI_EVT_BREAKPOINT 0x1
+#define GUI_EVT_PROCESS 0x2
+#define GUI_EVT_TRACE 0x4 // Tracepoint ring is half full
+#define GUI_EVT_ALL (GUI_EVT_BREAKPOINT | GUI_EVT_PROCESS | GUI_EVT_TRACE)
 #define CLAMP(x, m, M) ((x) <= (m) ? (m) : (x) >= (M) ? (M) : (x))
 
+// Exception path event points, compiled in with -DPEBBLE_TRACE and dumped with the frame stats.
+#ifdef PEBBLE_TRACE
+#define EVLOG(kind, a, b) evlog_push(&exception_log, ksceKernelGetSystemTimeLow(), kind, a, b)
+#else
+#define EVLOG(kind, a, b) ((void)0)
+#endif
+
 typedef enum
 {
     SLOT_NONE,
@@ -63,8 +101,14 @@ typedef struct
     SceUID pid;
     uint32_t address;
     uint8_t index;
+    uint8_t cond;  // 1-based condition table entry, 0 when the breakpoint always stops
+    uint8_t trace; // 1-based tracepoint entry; tracepoints log the hit and let the thread run on
     uint32_t p_instruction; // Previous instruction
     SlotType type;
+    // Hit statistics, updated by the exception handlers without locking.
+    uint32_t hits;
+    uint32_t last_hit;                 // ksceKernelGetSystemTimeLow at the latest hit
+    uint16_t latency_us, max_latency_us; // Handler entry until the thread is suspended or sent on
 } ActiveBKPTSlot;
 
 typedef struct
@@ -72,7 +116,7 @@ typedef struct
     SceUID pid;
     SceUID main_module_id;
     SceUID main_thread_id;
-    SceUID exception_thid;
+    SceUID exception_thid; // Thread the GUI shows and steps, normally the latest to stop
 } TargetProcess;
 
 typedef enum
@@ -90,21 +134,27 @@ typedef enum
     UI_FEATURE_SUSPEND,
     UI_FEATURE_RESUME,
     UI_FEATURE_STEP,
-    UI_FEATURE_HOTKEYS
+    UI_FEATURE_HOTKEYS,
+    UI_FEATURE_SEARCH,
+    UI_FEATURE_TRACE
 } UIState;
 
 typedef enum
 {
     VIEW_STACK,
     VIEW_CALLSTACK,
-    VIEW_BREAKPOINTS
+    VIEW_BREAKPOINTS,
+    VIEW_THREADS,
+    VIEW_COUNT
 } StackViewState;
 
 typedef enum
 {
     MEM_LAYOUT_8BIT,
     MEM_LAYOUT_16BIT,
-    MEM_LAYOUT_32BIT
+    MEM_LAYOUT_32BIT,
+    MEM_LAYOUT_DISASM,
+    MEM_LAYOUT_COUNT
 } MemLayout;
 
 typedef enum
@@ -139,24 +189,45 @@ typedef struct
     UIState ui_state, active_area;
     int edit_offset, cursor_column;
     ActiveBKPTSlot breakpoints[MAX_SLOT];
-    bool gui_visible, has_active_bp, repeating;
+    bool gui_visible, has_active_bp, repeating, show_hud;
     uint64_t button_press_time, last_repeat_time;
     uint8_t modified_value[4], cached_mem[256], bkpt_edit_offset;
-    uint32_t addr, base_addr, modified_addr, pressed_buttons, stored_edit_feature, edit_feature, stack[64], callstack[MAX_CALL_STACK_DEPTH], stack_size, callstack_size;
+    uint32_t addr, base_addr, modified_addr, pressed_buttons, stored_edit_feature, edit_feature, callstack[MAX_CALL_STACK_DEPTH], stack_size, callstack_size;
+    // Snapshot of the suspended thread, retaken when suspend_generation moves on. stack_size is the readable word
+    // count above sp and stack_pages marks the STACK_PAGE_WORDS pages of stack already read.
+    uint32_t stack[STACK_VIEW_WORDS], stack_pages, stack_scroll, stack_generation;
+    bool stack_valid;
+    uint32_t thread_cursor; // Row of the thread list the panel's buttons act on
 } State;
 
+// Read by the asm stubs before they save anything; the offsets are hardcoded in exceptions.S. An abort of a kind with
+// nothing armed, or from a process other than the target, goes straight on to the next handler.
+typedef struct
+{
+    uint32_t contextidr; // CONTEXTIDR of the target process, 0 while unknown
+    uint32_t armed[5];   // Armed breakpoints per SCE_EXCP_* kind
+} ExceptionFilter;
+
 extern State guistate;
 extern SceUID evtflag;
+extern SceUID gui_evtflag;
 extern uint8_t buf_index;
 extern SceUID pebble_mtx_uid;
+extern SceUID debugger_mtx_uid; // Held while GUI input, process events or a batch change debugger state
 extern uint32_t lowest_vaddr;
 extern uint32_t *fb_bases[2];
 extern uint32_t highest_vaddr;
 extern uint32_t *userframe_base;
 extern TargetProcess g_target_process;
-extern SceArmCpuRegisters current_registers;
+extern uint32_t suspend_generation; // Bumped on thread stops, resumes and switches, and on memory writes
+extern ExceptionFilter exception_filter;
+#ifdef PEBBLE_TRACE
+extern Evlog exception_log;
+#endif
 
 void load_hotkeys(void);
+void gui_notify(uint32_t events);
+void gui_frame_presented(void);
 int pebble_thread(SceSize args, void *argp);
 
 // main.c
@@ -170,18 +241,55 @@ void kernel_debugger_init(void);
 int kernel_set_hardware_breakpoint(uint32_t address);
 int kernel_set_watchpoint(uint32_t address, WatchPointBreakType type);
 int kernel_set_software_breakpoint(uint32_t address, SlotType type);
+int kernel_set_software_breakpoints(const uint32_t *addresses, int count, SlotType type);
 int kernel_clear_breakpoint(int index);
+int kernel_clear_breakpoints(const int *ids, int count);
+void kernel_drop_software_breakpoints(SceUID pid);
+const ActiveBKPTSlot *kernel_get_breakpoint(int id);
+int kernel_next_breakpoint(int id);
+int kernel_prev_breakpoint(int id);
+uint32_t kernel_breakpoint_generation(void);
+int kernel_set_breakpoint_condition(int id, const char *text);
+const char *kernel_get_breakpoint_condition(int id);
+bool kernel_breakpoint_condition_met(int id, const SceArmCpuRegisters *regs);
+void kernel_count_hit(int id);
+void kernel_note_latency(int id, uint32_t latency_us);
+uint32_t kernel_total_hits(void);
+int kernel_step_rearm(int id, SceUID thid, const SceArmCpuRegisters *regs);
+bool kernel_finish_rearm(void);
+int kernel_set_tracepoint(int id, const char *spec);
+const char *kernel_get_tracepoint(int id);
+bool kernel_trace_hit(int id, SceUID thid, const SceArmCpuRegisters *regs);
+TraceRing *kernel_get_trace_ring(void);
 int kernel_list_breakpoints(ActiveBKPTSlot *user_dst);
 int kernel_get_registers(SceArmCpuRegisters *user_dst);
 int kernel_get_callstack(uint32_t *user_dst, int depth);
 int kernel_get_modulelist(SceUID *user_modids, SceSize *user_num);
 int kernel_get_moduleinfo(SceKernelModuleInfo *module_info);
 int kernel_get_memblockinfo(const void *address, uint32_t *info);
+int kernel_refresh_regions(void);
+const RegionIndex *kernel_get_regions(void);
+int kernel_refresh_symbols(void);
+const SymbolIndex *kernel_get_symbols(void);
 void kernel_suspend_process(void);
 void kernel_resume_process(void);
+int kernel_thread_stopped(SceUID thid, const SceArmCpuRegisters *regs, ThreadReason reason, int bp);
+bool kernel_thread_parked(SceUID thid);
+bool kernel_owns_step(SceUID thid);
+const ThreadTable *kernel_get_threads(void);
+int kernel_select_thread(SceUID thid);
+int kernel_resume_thread(SceUID thid);
 int kernel_single_step(void);
+int kernel_step_over(void);
+int kernel_step_out(void);
+int kernel_run_to(uint32_t address);
 int kernel_read_memory(const void *src_addr, void *user_dst, SceSize size);
 int kernel_write_memory(uint32_t user_dst, const void *user_modification, SceSize memwrite_len);
+int kernel_batch(const void *user_in, SceSize in_size, void *user_out, SceSize out_size);
 void kernel_get_userinfo(SceUID PID_user, SceUID pebble_mtx_uid_user, uint32_t *fb_base0_user, SceUID evtflag_user);
+void kernel_frame_presented(void);
+void *kernel_heap_alloc(SceSize size);
+void kernel_heap_free(void *ptr);
 int kernel_get_breakpoint_index(uint32_t addr);
+uint32_t kernel_lookup_breakpoints(uint32_t addr, uint16_t *slots, uint32_t max);
 int register_handler(void);
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MEMCACHE_PAGE_SIZE 0x1000
+#define MEMCACHE_PAGES 8
+#define MEMCACHE_TTL_US 250000 // Visible pages are re-read at most this often to keep live values fresh
+
+typedef int (*MemReadFn)(uint32_t addr, void *dst, uint32_t size);
+
+typedef struct
+{
+    uint32_t base;
+    uint32_t generation;
+    uint32_t last_use;
+    uint64_t loaded;
+    bool used, readable;
+    uint8_t data[MEMCACHE_PAGE_SIZE];
+} MemCachePage;
+
+typedef struct
+{
+    MemReadFn read;
+    uint32_t ttl_us;
+    uint32_t generation, tick;
+    uint32_t hits, misses;
+    uint64_t bytes_copied, since;
+    MemCachePage pages[MEMCACHE_PAGES];
+} MemCache;
+
+void memcache_init(MemCache *c, MemReadFn read, uint32_t ttl_us, uint64_t now);
+void memcache_invalidate(MemCache *c);
+void memcache_invalidate_range(MemCache *c, uint32_t addr, uint32_t size);
+int memcache_read(MemCache *c, uint32_t addr, void *dst, uint32_t size, uint64_t now);
+void memcache_prefetch(MemCache *c, uint32_t addr, uint64_t now);
+uint32_t memcache_hit_rate(const MemCache *c);
+uint32_t memcache_bytes_per_sec(const MemCache *c, uint64_t now);
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define NEXTPC_REG_COUNT 17 // r0-r12, sp, lr, pc, cpsr in SceArmCpuRegisters order
+
+// Reads target memory for instruction fetches and loaded branch targets; returns < 0 when the address is unmapped.
+typedef int (*NextPcReadFn)(uint32_t addr, void *dst, uint32_t size);
+
+bool nextpc_condition(uint32_t cond, uint32_t cpsr);
+uint32_t nextpc_predict(const uint32_t *regs, NextPcReadFn read);
+uint32_t nextpc_call_return(const uint32_t *regs, NextPcReadFn read);
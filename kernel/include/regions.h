@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define REGION_MAX 256
+#define REGION_PAGE_SIZE 0x1000
+#define REGION_PROBE_START 0x70000000
+#define REGION_PROBE_END 0xA0000000
+#define REGION_PROBE_STEP 0x10000 // Blocks smaller than this are only found through the seed addresses
+
+// Looks up the memblock containing addr; block identifies it so probes can tell neighbouring blocks apart.
+typedef int (*RegionProbeFn)(uint32_t addr, uint32_t *block, uint32_t *base, uint32_t *type);
+
+typedef struct
+{
+    uint32_t base, size, type;
+} MemRegion;
+
+typedef struct
+{
+    MemRegion regions[REGION_MAX]; // Sorted by base, non-overlapping
+    uint32_t count;
+    uint32_t signature;
+    uint32_t probes;
+    bool valid;
+} RegionIndex;
+
+void regions_reset(RegionIndex *ri);
+int regions_add(RegionIndex *ri, uint32_t base, uint32_t size, uint32_t type);
+int regions_explore(RegionIndex *ri, RegionProbeFn probe, uint32_t addr);
+void regions_build(RegionIndex *ri, RegionProbeFn probe, const uint32_t *seeds, uint32_t seed_count, uint32_t start,
+                   uint32_t end, uint32_t step);
+const MemRegion *regions_find(const RegionIndex *ri, uint32_t addr);
+const MemRegion *regions_next(const RegionIndex *ri, uint32_t addr);
+const MemRegion *regions_prev(const RegionIndex *ri, uint32_t addr);
@@ -1,28 +1,63 @@
 #pragma once
 
+#include <psp2kern/display.h>
 #include <psp2kern/kernel/debug.h>
 #include <psp2kern/kernel/sysmem.h>
+#include <psp2kern/kernel/threadmgr.h>
 #include <psp2kern/kernel/modulemgr.h>
 
 #include <stdio.h>
 #include <string.h>
+#include <stdbool.h>
 
 #define UI_WIDTH 960
 #define UI_HEIGHT 544
 #define FONT_WIDTH 12
 #define FONT_HEIGHT 20
+#define GLYPH_FIRST 32
+#define GLYPH_COUNT 95
+#define GLYPH_BYTES 40
+#define DAMAGE_MAX_REGIONS 64
+#define CLEAR_COLOR 0x80171717
+#define BACKDROP_MAX_PITCH 1024
+#define RENDER_BLEND_BUDGET_US 8000 // Blending beyond this per frame falls back to opaque fills
+
+typedef struct
+{
+    uint32_t x, y, w, h;
+} RenderRect;
+
+typedef struct
+{
+    uint32_t bytes_written;
+    uint32_t draw_calls;
+    uint32_t regions_redrawn;
+    uint32_t blended_pixels;
+    uint32_t blend_us;
+    RenderRect bounds; // Union of every rectangle touched this frame
+} RenderFrameStats;
 
 extern SceUID pebble_mtx_uid;
 extern uint32_t *fb_bases[2];
 extern uint8_t buf_index;
+void renderer_drawImage(uint32_t x, uint32_t y, uint32_t w, uint32_t h, const unsigned char *img);
+void renderer_drawChar(char c, int x, int y);
 void renderer_drawString(int x, int y, const char *str);
 void renderer_drawStringF(int x, int y, const char *format, ...);
+void renderer_drawStringBlend(int x, int y, const char *str);
 void renderer_drawRectangle(uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint32_t clr);
+void renderer_blendRectangle(uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint32_t clr);
 void renderer_clearRectangle(uint32_t x, uint32_t y, uint32_t w, uint32_t h);
 void draw_frame(int x, int y, int width, int height, uint32_t color);
-int renderer_init(void);
+int renderer_init(SceUID pid);
 //void renderer_destroy(void);
 void renderer_setColor(uint32_t c);
+uint32_t renderer_hash(uint32_t seed, const void *data, uint32_t size);
+bool renderer_regionChanged(uint32_t region, uint32_t signature);
+void renderer_invalidate(void);
+void renderer_beginFrame(void);
+void renderer_endFrame(void);
+const RenderFrameStats *renderer_getFrameStats(void);
 
 static const unsigned char font[3800] = 
 {
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SCANSTORE_PAGE_SIZE 0x1000
+#define SCANSTORE_BITMAP_WORDS (SCANSTORE_PAGE_SIZE / 32) // One bit per value slot, byte slots at most
+#define SCANSTORE_ARENA_SIZE 0x200000
+
+typedef int (*ScanReadFn)(uint32_t addr, void *dst, uint32_t size);
+
+typedef enum
+{
+    SCAN_EQUAL,
+    SCAN_CHANGED,
+    SCAN_UNCHANGED,
+    SCAN_INCREASED,
+    SCAN_DECREASED,
+    SCAN_FILTER_COUNT
+} ScanFilter;
+
+enum
+{
+    SCANSTORE_BITMAP,
+    SCANSTORE_DELTA
+};
+
+// Candidates of one 4 KB page. The arena holds the encoded set followed by the previous values.
+typedef struct
+{
+    uint32_t base;
+    uint32_t first; // Index of the page's first candidate across the store
+    uint32_t offset;
+    uint16_t count, encoded;
+    uint8_t format;
+    bool snapshot; // Previous values are a copy of the whole page rather than one per candidate
+} ScanPage;
+
+// Payload grows up from the bottom of the arena, the page directory grows down from the top.
+typedef struct
+{
+    uint8_t *arena;
+    uint32_t arena_size, used;
+    uint32_t page_count, total;
+    uint32_t width, shift;
+    bool is_float, overflow, narrowing;
+    ScanFilter filter;
+    uint32_t value;
+    uint32_t cursor, write, write_offset, written; // Narrowing progress, compacting in place
+    uint16_t slots[SCANSTORE_PAGE_SIZE];
+    uint8_t page_data[SCANSTORE_PAGE_SIZE];
+    uint8_t encoded[SCANSTORE_PAGE_SIZE / 8 * 2];
+} ScanStore;
+
+void scanstore_init(ScanStore *st, void *arena, uint32_t size);
+ScanStore *scanstore_create(void *block, uint32_t size);
+void scanstore_reset(ScanStore *st, uint32_t width, bool is_float);
+int scanstore_add_page(ScanStore *st, uint32_t base, const uint32_t *bits, const uint8_t *data);
+void scanstore_narrow_begin(ScanStore *st, ScanFilter filter, uint32_t value);
+bool scanstore_narrow_step(ScanStore *st, ScanReadFn read, uint32_t budget_pages);
+int scanstore_get(ScanStore *st, uint32_t index, uint32_t *addr, uint32_t *value);
+uint32_t scanstore_footprint(const ScanStore *st);
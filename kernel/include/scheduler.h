@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SCHED_FOREVER 0xFFFFFFFF
+#define SCHED_FRAME_US 16667         // Frame cap, and the input poll while buttons are in use
+#define SCHED_ACTIVE_US 500000       // The fast input poll lasts this long after the last button activity
+#define SCHED_IDLE_POLL_US 50000     // Input poll while visible and idle; shorter than a quick tap
+#define SCHED_HIDDEN_POLL_US 100000  // Hotkey poll while attached but hidden
+
+typedef struct
+{
+    uint64_t last_frame;
+    uint64_t last_wakeup;
+    uint64_t last_input;
+    uint32_t wakeups;
+    uint32_t refresh_us; // Redraw period for views of live target data, 0 when nothing on screen changes by itself
+    bool dirty;
+} GuiScheduler;
+
+void sched_init(GuiScheduler *s);
+uint32_t sched_timeout(const GuiScheduler *s, bool attached, bool visible, uint64_t now);
+void sched_wakeup(GuiScheduler *s, uint64_t now);
+void sched_input(GuiScheduler *s, uint64_t now);
+void sched_set_refresh(GuiScheduler *s, uint32_t refresh_us);
+void sched_mark_dirty(GuiScheduler *s);
+bool sched_should_draw(GuiScheduler *s, uint64_t now);
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "scanstore.h"
+
+#define SEARCH_CHUNK_SIZE 0x10000
+#define SEARCH_PAGE_SIZE 0x1000
+#define SEARCH_MAX_PATTERN 32
+#define SEARCH_MAX_RESULTS 2048
+#define SEARCH_STEP_BYTES 0x40000 // Scanned per GUI iteration so a search never stalls input for long
+
+typedef int (*SearchReadFn)(uint32_t addr, void *dst, uint32_t size);
+typedef uint32_t (*SearchSkipFn)(uint32_t addr); // First mapped address at or after addr
+
+typedef enum
+{
+    SEARCH_U8,
+    SEARCH_U16,
+    SEARCH_U32,
+    SEARCH_FLOAT,
+    SEARCH_PATTERN,
+    SEARCH_ASCII,
+    SEARCH_UTF16,
+    SEARCH_TYPE_COUNT
+} SearchType;
+
+typedef struct
+{
+    uint8_t bytes[SEARCH_MAX_PATTERN]; // Pre-masked
+    uint8_t mask[SEARCH_MAX_PATTERN];  // 0xFF exact, 0xF0/0x0F nibble, 0x00 wildcard
+    uint32_t length, align;
+    uint32_t anchor; // Byte the word-at-a-time prefilter looks for
+} SearchQuery;
+
+typedef struct
+{
+    SearchQuery query;
+    SearchReadFn read;
+    SearchSkipFn skip;
+    ScanStore *store; // Optional, receives every match for narrowing scans
+    uint32_t start, end, cursor;
+    uint32_t count, matches; // Stored results / total matches
+    uint64_t bytes_scanned, elapsed_us;
+    bool running;
+    uint32_t results[SEARCH_MAX_RESULTS];
+    uint8_t chunk[SEARCH_CHUNK_SIZE + SEARCH_MAX_PATTERN] __attribute__((aligned(4)));
+} SearchState;
+
+int search_query_value(SearchQuery *q, SearchType type, uint32_t value);
+int search_query_pattern(SearchQuery *q, const char *text);
+int search_query_string(SearchQuery *q, const char *text, bool utf16);
+uint32_t search_scan(const SearchQuery *q, const uint8_t *buf, uint32_t size, uint32_t limit, uint32_t addr,
+                     uint32_t *out, uint32_t max_out, uint32_t *matches, uint32_t *bits);
+void search_begin(SearchState *s, const SearchQuery *q, SearchReadFn read, SearchSkipFn skip, ScanStore *store,
+                  uint32_t start, uint32_t end);
+bool search_step(SearchState *s, uint32_t budget);
+uint32_t search_progress(const SearchState *s);
+uint32_t search_mb_per_sec(const SearchState *s);
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SW_PAGE_SIZE 0x1000
+#define SW_PATCH_BATCH 256
+
+typedef struct
+{
+    uint32_t address;
+    uint32_t value;  // Written over the instruction
+    uint32_t *saved; // Receives the bytes it replaced, may be NULL
+    int id;
+    uint8_t size;
+    bool ok;
+} TextPatch;
+
+// What patches are applied through: the target's text and the SW breakpoint store in the kernel module, or anything
+// standing in for them.
+typedef struct
+{
+    int (*read)(uint32_t addr, void *dst, uint32_t size);
+    int (*write)(uint32_t addr, const void *src, uint32_t size); // Into the text domain
+    int (*find)(uint32_t addr);                                  // Breakpoint already at addr, < 0 when there is none
+    int (*reserve)(void);                                        // Store entry id, < 0 when the store is full
+    uint32_t *(*saved)(int id);                                  // Where an entry keeps the instruction it replaced
+} SwPatchBackend;
+
+void swpatch_sort(TextPatch *p, int count);
+int swpatch_prepare(TextPatch *p, const uint32_t *addresses, int count, int *done, uint32_t value, uint8_t size,
+                    const SwPatchBackend *backend, bool *full);
+int swpatch_apply(TextPatch *p, int count, const SwPatchBackend *backend);
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SYMBOLS_MAX_MODULES 64
+#define SYMBOLS_MAX_RANGES (SYMBOLS_MAX_MODULES * 4)
+#define SYMBOLS_NAME_MAX 28
+#define SYMBOLS_SCAN_CHUNK 0x1000 // Bytes of text read at a time while looking for a module's info block
+
+// NID database file, written by tools/nidc: a header, count NIDs in ascending order, count offsets of the matching
+// names in the pool, then the pool of NUL-terminated names. It is used in place once loaded.
+#define NIDDB_MAGIC 0x4244494E // "NIDB"
+#define NIDDB_VERSION 1
+
+typedef struct
+{
+    uint32_t magic, version;
+    uint32_t count, pool_size;
+} NidDbHeader;
+
+typedef struct
+{
+    const uint32_t *nids, *names;
+    const char *pool;
+    uint32_t count, pool_size;
+} NidDb;
+
+// Reads target memory; returns < 0 when the address is unmapped.
+typedef int (*SymbolReadFn)(uint32_t addr, void *dst, uint32_t size);
+
+typedef struct
+{
+    uint32_t addr; // Thumb bit clear
+    uint32_t nid;
+    const char *name; // From the NID database, NULL when it has no entry
+    uint32_t module;
+} Symbol;
+
+// One loaded segment of a module.
+typedef struct
+{
+    uint32_t start, end;
+    uint8_t module, segment;
+} SymbolRange;
+
+typedef struct
+{
+    char modules[SYMBOLS_MAX_MODULES][SYMBOLS_NAME_MAX];
+    SymbolRange ranges[SYMBOLS_MAX_RANGES]; // Sorted by start once symbols_finish ran
+    Symbol *symbols;                        // Caller-owned, capacity entries long, sorted by addr
+    uint32_t module_count, range_count, symbol_count, capacity;
+    uint32_t signature;
+} SymbolIndex;
+
+// Where a module's export table lies, found by symbols_find_exports.
+typedef struct
+{
+    uint32_t top, end;
+    uint32_t count; // Functions and variables over all of its libraries
+} SymbolExports;
+
+int niddb_open(NidDb *db, const void *data, uint32_t size);
+const char *niddb_lookup(const NidDb *db, uint32_t nid);
+
+void symbols_init(SymbolIndex *idx, Symbol *symbols, uint32_t capacity);
+int symbols_find_exports(uint32_t text, uint32_t text_size, const char *name, uint32_t exidx, SymbolReadFn read,
+                         SymbolExports *out);
+int symbols_add_module(SymbolIndex *idx, const char *name, const uint32_t *seg_base, const uint32_t *seg_size,
+                       const SymbolExports *exports, SymbolReadFn read, const NidDb *db);
+void symbols_finish(SymbolIndex *idx);
+const SymbolRange *symbols_find_range(const SymbolIndex *idx, uint32_t addr);
+const Symbol *symbols_lookup(const SymbolIndex *idx, uint32_t addr);
+int symbols_format(const SymbolIndex *idx, uint32_t addr, char *out, uint32_t size);
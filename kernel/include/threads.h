@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define THREAD_TABLE_SIZE 32
+#define THREAD_REGS 17 // r0-r15 and cpsr, the order SceArmCpuRegisters starts with
+
+typedef enum
+{
+    THREAD_RUNNING,
+    THREAD_BREAKPOINT, // Suspended by a breakpoint or watchpoint hit
+    THREAD_STEP,       // Suspended where a step, step over/out or run to ended
+    THREAD_PARKED      // Held at another thread's step target until that step is done
+} ThreadReason;
+
+// Debug state of one thread that stopped at least once. Each entry has its own lock in seq, so handlers for
+// different threads on different cores never wait on each other; readers copy without locking and retry when seq
+// moved.
+typedef struct
+{
+    int32_t thid; // 0 while the entry is free
+    uint32_t seq; // Odd while the entry is locked
+    uint32_t regs[THREAD_REGS];
+    uint32_t reason; // ThreadReason
+    int32_t bp;      // Breakpoint id behind the last stop, -1 for none
+    uint32_t stops;
+} ThreadEntry;
+
+typedef struct
+{
+    ThreadEntry entries[THREAD_TABLE_SIZE];
+    uint32_t generation; // Bumped after every change
+} ThreadTable;
+
+void threads_reset(ThreadTable *t);
+ThreadEntry *threads_lock(ThreadTable *t, int32_t thid, bool create);
+void threads_unlock(ThreadTable *t, ThreadEntry *e);
+bool threads_snapshot(const ThreadTable *t, uint32_t i, ThreadEntry *out);
+bool threads_find(const ThreadTable *t, int32_t thid, ThreadEntry *out);
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cond.h"
+
+#define TRACE_RING_SIZE 1024 // Records, power of two
+#define TRACE_MAX_VALUES 12
+#define TRACE_MAX_MEM 4
+#define TRACE_FILE_MAGIC 0x52544250 // "PBTR"
+#define TRACE_FILE_VERSION 1
+#define TRACE_RECORD_MAX_BYTES (16 + TRACE_MAX_VALUES * 4)
+
+// What a tracepoint captures: registers in index order, then memory words at [reg + offset].
+typedef struct
+{
+    uint32_t reg_mask;
+    uint8_t mem_reg[TRACE_MAX_MEM];
+    int16_t mem_offset[TRACE_MAX_MEM];
+    uint8_t mem_count;
+} TraceSpec;
+
+typedef struct
+{
+    uint32_t seq; // Ring sequence, not part of the record
+    uint32_t time;
+    uint32_t address;
+    uint32_t thread;
+    uint16_t id;
+    uint8_t count;
+    uint8_t faults; // Bit per memory word that could not be read
+    uint32_t values[TRACE_MAX_VALUES];
+} TraceRecord;
+
+// Bounded multi-producer, single-consumer ring. Producers are exception handlers on any core and never wait: when
+// the ring is full the record is dropped and counted.
+typedef struct
+{
+    uint32_t head;
+    uint32_t tail;
+    uint32_t dropped;
+    TraceRecord records[TRACE_RING_SIZE];
+} TraceRing;
+
+int trace_parse_spec(TraceSpec *spec, const char *text);
+void trace_init(TraceRing *ring);
+bool trace_push(TraceRing *ring, const TraceSpec *spec, uint16_t id, uint32_t address, uint32_t time,
+                uint32_t thread, const uint32_t *regs, CondReadFn read);
+bool trace_pop(TraceRing *ring, TraceRecord *out);
+uint32_t trace_pending(const TraceRing *ring);
+uint32_t trace_encode(const TraceRecord *rec, uint8_t *out);
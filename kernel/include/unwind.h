@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define UNWIND_MAX_MODULES 64
+#define UNWIND_CANTUNWIND 1
+#define UNWIND_MAX_OPS 64 // Unwind bytecode kept per frame
+
+// Reads target memory for .ARM.extab entries; returns < 0 when the address is unmapped.
+typedef int (*UnwindReadFn)(uint32_t addr, void *dst, uint32_t size);
+
+// An .ARM.exidx entry with its function offset resolved.
+typedef struct
+{
+    uint32_t fn;   // Function start, Thumb bit clear
+    uint32_t data; // UNWIND_CANTUNWIND, inline compact data (bit 31 set) or the raw prel31 offset of the .ARM.extab entry
+} UnwindEntry;
+
+typedef struct
+{
+    uint32_t exidx;        // Table address, the base of the raw extab offsets
+    uint32_t start, end;   // Text covered by the module's table
+    uint32_t first, count; // Slice of UnwindIndex.entries
+} UnwindModule;
+
+typedef struct
+{
+    UnwindModule modules[UNWIND_MAX_MODULES];
+    UnwindEntry *entries; // Caller-owned, capacity entries long
+    uint32_t module_count, entry_count, capacity;
+    uint32_t signature;
+} UnwindIndex;
+
+// One bulk copy of the stack starting at base; pops outside it end the walk.
+typedef struct
+{
+    uint32_t base, size;
+    const uint8_t *data;
+} UnwindStack;
+
+void unwind_init(UnwindIndex *idx, UnwindEntry *entries, uint32_t capacity);
+int unwind_add_module(UnwindIndex *idx, uint32_t exidx_addr, uint32_t count, uint32_t text_end);
+const UnwindEntry *unwind_lookup(const UnwindIndex *idx, uint32_t pc, const UnwindModule **module);
+int unwind_backtrace(const UnwindIndex *idx, const uint32_t *regs, const UnwindStack *stack, UnwindReadFn read,
+                     uint32_t *dst, int depth);
@@ -0,0 +1,120 @@
+#include "batch.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+// Runs a command buffer against a backend. The request is checked as a whole before anything runs; after that ops run
+// in order and a failing op only sets its own status. When the next reply no longer fits, the batch stops there and
+// the reply header counts the results that were written, so the client knows which ops did not run.
+
+#define BATCH_LIST_BYTES_MAX 0xFFFC // BatchResult.size is 16 bits
+
+static bool request_valid(const BatchHeader *request, uint32_t in_size)
+{
+    if (in_size < sizeof(BatchHeader) || request->magic != BATCH_MAGIC || request->version != BATCH_VERSION ||
+        request->size < sizeof(BatchHeader) || request->size > in_size)
+        return false;
+
+    uint32_t pos = sizeof(BatchHeader);
+    for (uint32_t i = 0; i < request->count; ++i)
+    {
+        BatchOp op;
+        if (request->size - pos < sizeof(op))
+            return false;
+        memcpy(&op, (const uint8_t *)request + pos, sizeof(op));
+        pos += sizeof(op);
+        if (request->size - pos < BATCH_PAD(op.size))
+            return false;
+        pos += BATCH_PAD(op.size);
+    }
+    return true;
+}
+
+// Entries of item bytes that fit in room, at most requested when that is non-zero.
+static uint32_t list_capacity(uint32_t room, uint32_t requested, uint32_t item)
+{
+    const uint32_t max = ((room < BATCH_LIST_BYTES_MAX) ? room : BATCH_LIST_BYTES_MAX) / item;
+    return (requested && requested < max) ? requested : max;
+}
+
+// Reply payload an op needs room for up front; lists just shrink to the room left.
+static uint32_t reply_size(const BatchOp *op)
+{
+    if (op->op == BATCH_READ && op->arg1 <= BATCH_MAX_READ)
+        return BATCH_PAD(op->arg1);
+    if (op->op == BATCH_GET_REGISTERS)
+        return BATCH_REGS * 4;
+    return 0;
+}
+
+// Returns the reply size, or < 0 when the request is malformed and nothing ran.
+int batch_execute(const void *in, uint32_t in_size, void *out, uint32_t out_size, const BatchBackend *backend)
+{
+    const BatchHeader *request = in;
+    if (!request_valid(request, in_size) || out_size < sizeof(BatchHeader))
+        return -1;
+
+    const uint8_t *ops = in;
+    uint8_t *reply = out;
+    uint32_t in_pos = sizeof(BatchHeader), out_pos = sizeof(BatchHeader);
+    uint16_t done = 0;
+    for (; done < request->count; ++done)
+    {
+        BatchOp op;
+        memcpy(&op, ops + in_pos, sizeof(op));
+        const uint8_t *payload = ops + in_pos + sizeof(op);
+        in_pos += sizeof(op) + BATCH_PAD(op.size);
+
+        if (out_size - out_pos < sizeof(BatchResult) + reply_size(&op))
+            break;
+        BatchResult result = {op.op, 0, -1};
+        uint8_t *data = reply + out_pos + sizeof(result);
+        const uint32_t room = out_size - out_pos - sizeof(result);
+        switch (op.op)
+        {
+        case BATCH_READ:
+            if (op.arg1 && op.arg1 <= BATCH_MAX_READ)
+                result.status = backend->read(op.arg0, data, op.arg1);
+            if (result.status >= 0)
+                result.size = op.arg1;
+            break;
+        case BATCH_WRITE:
+            if (op.size)
+                result.status = backend->write(op.arg0, payload, op.size);
+            break;
+        case BATCH_SET_BREAKPOINT:
+            result.status = backend->set_breakpoint(op.arg0, op.arg1);
+            break;
+        case BATCH_CLEAR_BREAKPOINT:
+            result.status = backend->clear_breakpoint((int)op.arg0);
+            break;
+        case BATCH_LIST_BREAKPOINTS:
+            result.status = backend->list_breakpoints((int)op.arg0, (BatchBreakpoint *)data,
+                                                      list_capacity(room, op.arg1, sizeof(BatchBreakpoint)));
+            if (result.status > 0)
+                result.size = result.status * sizeof(BatchBreakpoint);
+            break;
+        case BATCH_GET_REGISTERS:
+            result.status = backend->get_registers((int32_t)op.arg0, (uint32_t *)data);
+            if (result.status >= 0)
+                result.size = BATCH_REGS * 4;
+            break;
+        case BATCH_LIST_MODULES:
+            result.status =
+                backend->list_modules((BatchModule *)data, list_capacity(room, op.arg1, sizeof(BatchModule)));
+            if (result.status > 0)
+                result.size = result.status * sizeof(BatchModule);
+            break;
+        default:
+            break;
+        }
+
+        memset(data + result.size, 0, BATCH_PAD(result.size) - result.size);
+        memcpy(reply + out_pos, &result, sizeof(result));
+        out_pos += sizeof(result) + BATCH_PAD(result.size);
+    }
+
+    const BatchHeader header = {BATCH_MAGIC, BATCH_VERSION, done, out_pos};
+    memcpy(reply, &header, sizeof(header));
+    return out_pos;
+}
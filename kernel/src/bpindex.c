@@ -0,0 +1,131 @@
+#include "bpindex.h"
+
+// Sequence counter protocol: writers make seq odd while they edit, readers retry when they saw an odd value or
+// seq moved under them. Probe and chain walks are bounded so a torn read can only cost a retry.
+
+static inline uint32_t bpindex_hash(const BpIndex *ix, uint32_t address)
+{
+    return (address * 0x9E3779B1u) >> ix->shift;
+}
+
+static inline void bpindex_write_begin(BpIndex *ix)
+{
+    __atomic_store_n(&ix->seq, ix->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void bpindex_write_end(BpIndex *ix)
+{
+    __atomic_store_n(&ix->seq, ix->seq + 1, __ATOMIC_RELEASE);
+}
+
+void bpindex_init(BpIndex *ix, BpBucket *buckets, uint32_t bucket_bits, uint16_t *next, uint32_t slots)
+{
+    ix->seq = 0;
+    ix->shift = 32 - bucket_bits;
+    ix->mask = (1u << bucket_bits) - 1;
+    ix->count = 0;
+    ix->buckets = buckets;
+    ix->next = next;
+    ix->slots = slots;
+    for (uint32_t i = 0; i <= ix->mask; ++i)
+        buckets[i] = (BpBucket){0, BPINDEX_NONE};
+    for (uint32_t i = 0; i < slots; ++i)
+        next[i] = BPINDEX_NONE;
+}
+
+// Bucket holding address, or mask + 1 when there is none.
+static uint32_t bpindex_find(const BpIndex *ix, uint32_t address)
+{
+    uint32_t i = bpindex_hash(ix, address);
+    for (uint32_t n = 0; n <= ix->mask; ++n, i = (i + 1) & ix->mask)
+    {
+        const BpBucket *b = &ix->buckets[i];
+        if (b->head == BPINDEX_NONE)
+            break;
+        if (b->address == address)
+            return i;
+    }
+    return ix->mask + 1;
+}
+
+int bpindex_insert(BpIndex *ix, uint32_t address, uint32_t slot)
+{
+    if (slot >= ix->slots)
+        return -1;
+
+    uint32_t i = bpindex_find(ix, address);
+    if (i > ix->mask)
+    {
+        // Keep the load factor at 3/4 so probe runs stay short.
+        if (ix->count + 1 > (ix->mask + 1) / 4 * 3)
+            return -1;
+        bpindex_write_begin(ix);
+        for (i = bpindex_hash(ix, address); ix->buckets[i].head != BPINDEX_NONE; i = (i + 1) & ix->mask)
+            ;
+        ix->next[slot] = BPINDEX_NONE;
+        ix->buckets[i].address = address;
+        ix->buckets[i].head = slot;
+        ix->count++;
+        bpindex_write_end(ix);
+        return 0;
+    }
+
+    bpindex_write_begin(ix);
+    ix->next[slot] = ix->buckets[i].head;
+    ix->buckets[i].head = slot;
+    bpindex_write_end(ix);
+    return 0;
+}
+
+int bpindex_remove(BpIndex *ix, uint32_t address, uint32_t slot)
+{
+    uint32_t i = bpindex_find(ix, address);
+    if (i > ix->mask || slot >= ix->slots)
+        return -1;
+
+    bpindex_write_begin(ix);
+    uint16_t *link = &ix->buckets[i].head;
+    while (*link != BPINDEX_NONE && *link != slot)
+        link = &ix->next[*link];
+    if (*link == slot)
+        *link = ix->next[slot];
+    ix->next[slot] = BPINDEX_NONE;
+
+    if (ix->buckets[i].head == BPINDEX_NONE)
+    {
+        // Backward-shift deletion: pull later entries of the probe run into the hole instead of leaving tombstones.
+        for (uint32_t j = (i + 1) & ix->mask; ix->buckets[j].head != BPINDEX_NONE; j = (j + 1) & ix->mask)
+        {
+            const uint32_t k = bpindex_hash(ix, ix->buckets[j].address);
+            const bool stays = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+            if (stays)
+                continue;
+            ix->buckets[i] = ix->buckets[j];
+            ix->buckets[j].head = BPINDEX_NONE;
+            i = j;
+        }
+        ix->count--;
+    }
+    bpindex_write_end(ix);
+    return 0;
+}
+
+uint32_t bpindex_lookup(const BpIndex *ix, uint32_t address, uint16_t *out, uint32_t max)
+{
+    uint32_t seq, n;
+    do
+    {
+        seq = __atomic_load_n(&ix->seq, __ATOMIC_ACQUIRE);
+        n = 0;
+        if (!(seq & 1))
+        {
+            const uint32_t i = bpindex_find(ix, address);
+            if (i <= ix->mask)
+                for (uint32_t s = ix->buckets[i].head; s < ix->slots && n < max; s = ix->next[s])
+                    out[n++] = s;
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || seq != __atomic_load_n(&ix->seq, __ATOMIC_RELAXED));
+    return n;
+}
@@ -0,0 +1,458 @@
+#include "cond.h"
+
+#include <string.h>
+
+// Breakpoint conditions: C-like expressions over registers, the hit count and target memory, compiled to a small
+// stack bytecode so the exception handler only runs a flat loop.
+//
+//   r0 == 5 && [r1 + 4] != 0     hits >= 100     b[sp] & 0x80     (lr >> 1) == 0x8100A3C
+//
+// [x], h[x] and b[x] load a word, halfword or byte. Comparisons are unsigned. A load that faults makes the whole
+// condition false. Operators bind as in C, so r0 & 1 == 0 is r0 & (1 == 0); bit tests need their parentheses.
+
+enum
+{
+    OP_END,
+    OP_IMM,  // u32 follows
+    OP_IMM8, // u8 follows
+    OP_REG,  // u8 register index follows
+    OP_HITS,
+    OP_LOAD8,
+    OP_LOAD16,
+    OP_LOAD32,
+    OP_NOT,
+    OP_NEG,
+    OP_INV,
+    OP_ADD,
+    OP_SUB,
+    OP_AND,
+    OP_OR,
+    OP_XOR,
+    OP_SHL,
+    OP_SHR,
+    OP_EQ,
+    OP_NE,
+    OP_LT,
+    OP_LE,
+    OP_GT,
+    OP_GE,
+    OP_JFALSE, // u8 skip follows; jumps leaving 0 when the top is zero, otherwise pops it
+    OP_JTRUE,  // u8 skip follows; jumps leaving 1 when the top is non-zero, otherwise pops it
+    OP_BOOL
+};
+
+typedef struct
+{
+    const char *p;
+    CondProgram *prog;
+    int depth;
+    bool error;
+} CondParser;
+
+static void emit(CondParser *ps, uint8_t byte)
+{
+    if (ps->prog->length >= COND_MAX_CODE - 1)
+        ps->error = true;
+    else
+        ps->prog->code[ps->prog->length++] = byte;
+}
+
+static void push(CondParser *ps, int n)
+{
+    ps->depth += n;
+    if (ps->depth > COND_MAX_STACK)
+        ps->error = true;
+}
+
+static void skip_space(CondParser *ps)
+{
+    while (*ps->p == ' ')
+        ps->p++;
+}
+
+static bool accept(CondParser *ps, const char *token)
+{
+    skip_space(ps);
+    const size_t len = strlen(token);
+    if (strncmp(ps->p, token, len))
+        return false;
+    ps->p += len;
+    return true;
+}
+
+static bool is_ident(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+static int parse_register(CondParser *ps)
+{
+    static const char *names[] = {"sp", "lr", "pc", "cpsr"};
+    const char *start = ps->p;
+    int len = 0;
+    while (is_ident(start[len]))
+        len++;
+
+    int reg = -1;
+    if ((start[0] == 'r' || start[0] == 'R') && len >= 2 && len <= 3)
+    {
+        reg = 0;
+        for (int i = 1; i < len; ++i)
+            reg = (start[i] >= '0' && start[i] <= '9') ? reg * 10 + start[i] - '0' : 99;
+        if (reg > 15)
+            reg = -1;
+    }
+    for (int i = 0; i < 4 && reg < 0; ++i)
+        if ((int)strlen(names[i]) == len && !strncmp(start, names[i], len))
+            reg = 13 + i;
+
+    if (reg >= 0)
+        ps->p += len;
+    return reg;
+}
+
+static void parse_or(CondParser *ps);
+
+static void parse_primary(CondParser *ps)
+{
+    skip_space(ps);
+    const char c = *ps->p;
+
+    if (c >= '0' && c <= '9')
+    {
+        const bool hex = c == '0' && (ps->p[1] == 'x' || ps->p[1] == 'X');
+        uint32_t value = 0;
+        ps->p += hex ? 2 : 0;
+        for (;; ps->p++)
+        {
+            const char d = *ps->p;
+            if (d >= '0' && d <= '9')
+                value = value * (hex ? 16 : 10) + d - '0';
+            else if (hex && ((d >= 'a' && d <= 'f') || (d >= 'A' && d <= 'F')))
+                value = value * 16 + (d | 0x20) - 'a' + 10;
+            else
+                break;
+        }
+        if (value <= 0xFF)
+        {
+            emit(ps, OP_IMM8);
+            emit(ps, value);
+        }
+        else
+        {
+            emit(ps, OP_IMM);
+            for (int i = 0; i < 4; ++i)
+                emit(ps, value >> (i * 8));
+        }
+        push(ps, 1);
+        return;
+    }
+
+    if (accept(ps, "("))
+    {
+        parse_or(ps);
+        if (!accept(ps, ")"))
+            ps->error = true;
+        return;
+    }
+
+    uint8_t load = OP_LOAD32;
+    if ((c == 'b' || c == 'h') && ps->p[1] == '[')
+    {
+        load = (c == 'b') ? OP_LOAD8 : OP_LOAD16;
+        ps->p++;
+    }
+    if (accept(ps, "["))
+    {
+        parse_or(ps);
+        if (!accept(ps, "]"))
+            ps->error = true;
+        emit(ps, load);
+        return;
+    }
+
+    if (!strncmp(ps->p, "hits", 4) && !is_ident(ps->p[4]))
+    {
+        ps->p += 4;
+        emit(ps, OP_HITS);
+        push(ps, 1);
+        return;
+    }
+
+    const int reg = parse_register(ps);
+    if (reg < 0 || reg >= COND_REG_COUNT)
+    {
+        ps->error = true;
+        return;
+    }
+    emit(ps, OP_REG);
+    emit(ps, reg);
+    push(ps, 1);
+}
+
+static void parse_unary(CondParser *ps)
+{
+    static const struct
+    {
+        const char *token;
+        uint8_t op;
+    } ops[] = {{"!", OP_NOT}, {"-", OP_NEG}, {"~", OP_INV}};
+
+    skip_space(ps);
+    for (int i = 0; i < 3; ++i)
+        if (*ps->p == ops[i].token[0])
+        {
+            ps->p++;
+            parse_unary(ps);
+            emit(ps, ops[i].op);
+            return;
+        }
+    parse_primary(ps);
+}
+
+typedef struct
+{
+    const char *token;
+    uint8_t op;
+} CondBinary;
+
+// One precedence level of left-associative binary operators. Longer tokens come first in each table.
+static void parse_binary(CondParser *ps, const CondBinary *ops, int count, void (*next)(CondParser *))
+{
+    next(ps);
+    while (!ps->error)
+    {
+        int i = 0;
+        for (; i < count; ++i)
+        {
+            skip_space(ps);
+            const size_t len = strlen(ops[i].token);
+            // Keep & and | from eating the first half of && and ||.
+            if (!strncmp(ps->p, ops[i].token, len) && !(len == 1 && (*ps->p == '&' || *ps->p == '|') &&
+                                                        ps->p[1] == *ps->p))
+                break;
+        }
+        if (i == count)
+            return;
+        ps->p += strlen(ops[i].token);
+        next(ps);
+        emit(ps, ops[i].op);
+        push(ps, -1);
+    }
+}
+
+static void parse_sum(CondParser *ps)
+{
+    static const CondBinary ops[] = {{"+", OP_ADD}, {"-", OP_SUB}};
+    parse_binary(ps, ops, 2, parse_unary);
+}
+
+static void parse_shift(CondParser *ps)
+{
+    static const CondBinary ops[] = {{"<<", OP_SHL}, {">>", OP_SHR}};
+    parse_binary(ps, ops, 2, parse_sum);
+}
+
+static void parse_relational(CondParser *ps)
+{
+    static const CondBinary ops[] = {{"<=", OP_LE}, {">=", OP_GE}, {"<", OP_LT}, {">", OP_GT}};
+    parse_binary(ps, ops, 4, parse_shift);
+}
+
+static void parse_equality(CondParser *ps)
+{
+    static const CondBinary ops[] = {{"==", OP_EQ}, {"!=", OP_NE}};
+    parse_binary(ps, ops, 2, parse_relational);
+}
+
+static void parse_bitand(CondParser *ps)
+{
+    static const CondBinary ops[] = {{"&", OP_AND}};
+    parse_binary(ps, ops, 1, parse_equality);
+}
+
+static void parse_bitxor(CondParser *ps)
+{
+    static const CondBinary ops[] = {{"^", OP_XOR}};
+    parse_binary(ps, ops, 1, parse_bitand);
+}
+
+static void parse_bitor(CondParser *ps)
+{
+    static const CondBinary ops[] = {{"|", OP_OR}};
+    parse_binary(ps, ops, 1, parse_bitxor);
+}
+
+// a && b: JFALSE skips b and leaves a's zero, otherwise a is dropped and b decides.
+static void parse_logic(CondParser *ps, const char *token, uint8_t jump, void (*next)(CondParser *))
+{
+    next(ps);
+    while (!ps->error && accept(ps, token))
+    {
+        emit(ps, jump);
+        const uint8_t at = ps->prog->length;
+        emit(ps, 0);
+        push(ps, -1);
+        next(ps);
+        emit(ps, OP_BOOL);
+        if (!ps->error)
+            ps->prog->code[at] = ps->prog->length - at - 1;
+    }
+}
+
+static void parse_and(CondParser *ps)
+{
+    parse_logic(ps, "&&", OP_JFALSE, parse_bitor);
+}
+
+static void parse_or(CondParser *ps)
+{
+    parse_logic(ps, "||", OP_JTRUE, parse_and);
+}
+
+// Register index for the name at *text (r0-r15, sp, lr, pc, cpsr), advancing past it; -1 when there is none.
+int cond_register(const char **text)
+{
+    CondParser ps = {*text, NULL, 0, false};
+    const int reg = parse_register(&ps);
+    *text = ps.p;
+    return (reg < COND_REG_COUNT) ? reg : -1;
+}
+
+int cond_compile(CondProgram *prog, const char *text)
+{
+    CondParser ps = {text, prog, 0, false};
+    prog->length = 0;
+    parse_or(&ps);
+    skip_space(&ps);
+    if (ps.error || *ps.p || ps.depth != 1)
+    {
+        prog->length = 0;
+        return -1;
+    }
+    prog->code[prog->length++] = OP_END;
+    return prog->length;
+}
+
+static uint32_t cond_binary(uint8_t op, uint32_t a, uint32_t b)
+{
+    switch (op)
+    {
+    case OP_ADD:
+        return a + b;
+    case OP_SUB:
+        return a - b;
+    case OP_AND:
+        return a & b;
+    case OP_OR:
+        return a | b;
+    case OP_XOR:
+        return a ^ b;
+    case OP_SHL:
+        return (b < 32) ? a << b : 0;
+    case OP_SHR:
+        return (b < 32) ? a >> b : 0;
+    case OP_EQ:
+        return a == b;
+    case OP_NE:
+        return a != b;
+    case OP_LT:
+        return a < b;
+    case OP_LE:
+        return a <= b;
+    case OP_GT:
+        return a > b;
+    case OP_GE:
+        return a >= b;
+    }
+    return 0;
+}
+
+// The program may come from an entry being rewritten under it, so a malformed one has to evaluate to false instead of
+// walking off the stack or the code. Two guard entries below the stack and one above let a single range check per
+// op catch both underflow and overflow, since no op moves sp by more than one.
+bool cond_eval(const CondProgram *prog, const uint32_t *regs, uint32_t hits, CondReadFn read)
+{
+    uint32_t stack[COND_MAX_STACK + 3];
+    int sp = 1; // Empty; stack[2] is the first entry
+    const uint8_t *pc = prog->code;
+    const uint8_t *const end = prog->code + COND_MAX_CODE;
+
+    if (!prog->length)
+        return true;
+    stack[0] = stack[1] = 0;
+
+    while (pc < end && (unsigned)(sp - 1) <= COND_MAX_STACK)
+    {
+        const uint8_t op = *pc++;
+        switch (op)
+        {
+        case OP_END:
+            return stack[sp] != 0;
+        case OP_IMM:
+            if (end - pc < 4)
+                return false;
+            stack[++sp] = pc[0] | (pc[1] << 8) | (pc[2] << 16) | ((uint32_t)pc[3] << 24);
+            pc += 4;
+            break;
+        case OP_IMM8:
+            if (pc == end)
+                return false;
+            stack[++sp] = *pc++;
+            break;
+        case OP_REG:
+            if (pc == end || *pc >= COND_REG_COUNT)
+                return false;
+            stack[++sp] = regs[*pc++];
+            break;
+        case OP_HITS:
+            stack[++sp] = hits;
+            break;
+        case OP_LOAD8:
+        case OP_LOAD16:
+        case OP_LOAD32: {
+            uint32_t value = 0;
+            if (read(stack[sp], &value, 1 << (op - OP_LOAD8)) < 0)
+                return false;
+            stack[sp] = value;
+            break;
+        }
+        case OP_NOT:
+            stack[sp] = !stack[sp];
+            break;
+        case OP_NEG:
+            stack[sp] = -stack[sp];
+            break;
+        case OP_INV:
+            stack[sp] = ~stack[sp];
+            break;
+        case OP_JFALSE:
+        case OP_JTRUE:
+            if (pc == end)
+                return false;
+            if (!stack[sp] == (op == OP_JFALSE))
+            {
+                if (*pc >= end - pc)
+                    return false;
+                stack[sp] = stack[sp] != 0;
+                pc += *pc + 1;
+            }
+            else
+            {
+                sp--;
+                pc++;
+            }
+            break;
+        case OP_BOOL:
+            stack[sp] = stack[sp] != 0;
+            break;
+        default:
+            if (op > OP_GE)
+                return false;
+            sp--;
+            stack[sp] = cond_binary(op, stack[sp], stack[sp + 1]);
+            break;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,991 @@
+#include "disasm.h"
+
+#include <string.h>
+
+// ARMv7-A ARM and Thumb-2 disassembler for the memory view. Each instruction set is a table of mask/value entries
+// with a format string, in the style of binutils' arm-dis: the first matching entry prints the instruction and
+// anything unmatched comes out as .word/.short. Covers the integer instruction set and common VFP.
+//
+// Format escapes are % followed by an optional field spec and a letter:
+//   %<lo>R / %<lo>L            4-bit / 3-bit register field at bit lo
+//   %<lo>:<width>[<n][+n]i     immediate field, optionally shifted left and offset
+//   %<lo>[:<width>]d           bare decimal field, for coprocessor and register numbers
+// and single letters for composite operands, documented in render() below.
+
+typedef struct
+{
+    uint32_t mask, value;
+    const char *format; // NULL marks an encoding that must not fall through to a broader entry
+} DisasmEntry;
+
+typedef struct
+{
+    char *start, *p, *end;
+} DisasmOut;
+
+typedef struct
+{
+    uint32_t insn, addr;
+    bool thumb;
+    DisasmOut out;
+} Disasm;
+
+static const char *const reg_names[16] = {"r0", "r1", "r2",  "r3",  "r4",  "r5", "r6", "r7",
+                                          "r8", "r9", "r10", "r11", "r12", "sp", "lr", "pc"};
+static const char *const cond_names[16] = {"eq", "ne", "hs", "lo", "mi", "pl", "vs", "vc",
+                                           "hi", "ls", "ge", "lt", "gt", "le", "",   ""};
+static const char *const barrier_names[16] = {"#0", "#1", "oshst", "osh", "#4", "#5", "nshst", "nsh",
+                                              "#8", "#9", "ishst", "ish", "#12", "#13", "st", "sy"};
+static const char *const shift_names[4] = {"lsl", "lsr", "asr", "ror"};
+
+// ARM, cond != 0b1111. More specific encodings come before the classes they overlap.
+static const DisasmEntry arm_table[] = {
+    {0x0FFFFFFF, 0x0320F000, "nop%c"},
+    {0x0FFFFFF0, 0x012FFF10, "bx%c\t%0R"},
+    {0x0FFFFFF0, 0x012FFF30, "blx%c\t%0R"},
+    {0x0FFF0FF0, 0x016F0F10, "clz%c\t%12R, %0R"},
+    {0x0FFF0FFF, 0x010F0000, "mrs%c\t%12R, apsr"},
+    {0x0FB0FFF0, 0x0120F000, "msr%c\tapsr, %0R"},
+    {0xFFF000F0, 0xE1200070, "bkpt\t%Z"},
+    {0xFFF000F0, 0xE7F000F0, "udf\t%Z"},
+    {0x0FF000F0, 0x01200070, NULL}, // BKPT and UDF are unconditional
+    {0x0FF000F0, 0x07F000F0, NULL},
+    {0x0F000000, 0x0F000000, "svc%c\t%0:24i"},
+    {0x0FE000F0, 0x00000090, "mul%s%c\t%16R, %0R, %8R"},
+    {0x0FE000F0, 0x00200090, "mla%s%c\t%16R, %0R, %8R, %12R"},
+    {0x0FF000F0, 0x00600090, "mls%c\t%16R, %0R, %8R, %12R"},
+    {0x0FE000F0, 0x00800090, "umull%s%c\t%12R, %16R, %0R, %8R"},
+    {0x0FE000F0, 0x00A00090, "umlal%s%c\t%12R, %16R, %0R, %8R"},
+    {0x0FE000F0, 0x00C00090, "smull%s%c\t%12R, %16R, %0R, %8R"},
+    {0x0FE000F0, 0x00E00090, "smlal%s%c\t%12R, %16R, %0R, %8R"},
+    {0x0FF00FFF, 0x01900F9F, "ldrex%c\t%12R, [%16R]"},
+    {0x0FF00FF0, 0x01800F90, "strex%c\t%12R, %0R, [%16R]"},
+    {0x0F200090, 0x00200090, NULL}, // Unprivileged LDRHT/STRHT and friends
+    {0x0E1000F0, 0x000000B0, "strh%c\t%12R, %h"},
+    {0x0E1000F0, 0x001000B0, "ldrh%c\t%12R, %h"},
+    {0x0E1010F0, 0x000010D0, NULL}, // LDRD/STRD from an odd register
+    {0x0E1010F0, 0x000010F0, NULL},
+    {0x0E1000F0, 0x000000D0, "ldrd%c\t%12R, %&, %h"},
+    {0x0E1000F0, 0x001000D0, "ldrsb%c\t%12R, %h"},
+    {0x0E1000F0, 0x000000F0, "strd%c\t%12R, %&, %h"},
+    {0x0E1000F0, 0x001000F0, "ldrsh%c\t%12R, %h"},
+    {0x0E000090, 0x00000090, NULL},
+    {0x0FF00000, 0x03000000, "movw%c\t%12R, %M"},
+    {0x0FF00000, 0x03400000, "movt%c\t%12R, %M"},
+    {0x0DF0F000, 0x0110F000, NULL}, // Compares with Rd = pc (legacy TSTP and friends)
+    {0x0FB00000, 0x03200000, NULL}, // MSR immediate and hints
+    {0x0DE00000, 0x00000000, "and%s%c\t%12R, %16R, %o"},
+    {0x0DE00000, 0x00200000, "eor%s%c\t%12R, %16R, %o"},
+    {0x0DE00000, 0x00400000, "sub%s%c\t%12R, %16R, %o"},
+    {0x0DE00000, 0x00600000, "rsb%s%c\t%12R, %16R, %o"},
+    {0x0DE00000, 0x00800000, "add%s%c\t%12R, %16R, %o"},
+    {0x0DE00000, 0x00A00000, "adc%s%c\t%12R, %16R, %o"},
+    {0x0DE00000, 0x00C00000, "sbc%s%c\t%12R, %16R, %o"},
+    {0x0DE00000, 0x00E00000, "rsc%s%c\t%12R, %16R, %o"},
+    {0x0DF00000, 0x01100000, "tst%c\t%16R, %o"},
+    {0x0DF00000, 0x01300000, "teq%c\t%16R, %o"},
+    {0x0DF00000, 0x01500000, "cmp%c\t%16R, %o"},
+    {0x0DF00000, 0x01700000, "cmn%c\t%16R, %o"},
+    {0x0DE00000, 0x01800000, "orr%s%c\t%12R, %16R, %o"},
+    {0x0DEF0000, 0x01A00000, "mov%s%c\t%12R, %o"},
+    {0x0DE00000, 0x01C00000, "bic%s%c\t%12R, %16R, %o"},
+    {0x0DEF0000, 0x01E00000, "mvn%s%c\t%12R, %o"},
+    {0x0FFF03F0, 0x06EF0070, "uxtb%c\t%12R, %0R"},
+    {0x0FFF03F0, 0x06FF0070, "uxth%c\t%12R, %0R"},
+    {0x0FFF03F0, 0x06AF0070, "sxtb%c\t%12R, %0R"},
+    {0x0FFF03F0, 0x06BF0070, "sxth%c\t%12R, %0R"},
+    {0x0FFF0FF0, 0x06BF0F30, "rev%c\t%12R, %0R"},
+    {0x0FFF0FF0, 0x06BF0FB0, "rev16%c\t%12R, %0R"},
+    {0x0FFF0FF0, 0x06FF0F30, "rbit%c\t%12R, %0R"},
+    {0x0FE00070, 0x07E00050, "ubfx%c\t%12R, %0R, %7:5i, %16:5+1i"},
+    {0x0FE00070, 0x07A00050, "sbfx%c\t%12R, %0R, %7:5i, %16:5+1i"},
+    {0x0FE0007F, 0x07C0001F, "bfc%c\t%12R, %7:5i, %O"},
+    {0x0FE00070, 0x07C00010, "bfi%c\t%12R, %0R, %7:5i, %O"},
+    {0x0E000010, 0x06000010, NULL}, // Rest of the media space
+    {0x0FFF0FFF, 0x052D0004, "push%c\t{%12R}"},
+    {0x0FFF0FFF, 0x049D0004, "pop%c\t{%12R}"},
+    {0x0D700000, 0x04200000, "strt%c\t%12R, %a"},
+    {0x0D700000, 0x04300000, "ldrt%c\t%12R, %a"},
+    {0x0D700000, 0x04600000, "strbt%c\t%12R, %a"},
+    {0x0D700000, 0x04700000, "ldrbt%c\t%12R, %a"},
+    {0x0C500000, 0x04000000, "str%c\t%12R, %a"},
+    {0x0C500000, 0x04100000, "ldr%c\t%12R, %a"},
+    {0x0C500000, 0x04400000, "strb%c\t%12R, %a"},
+    {0x0C500000, 0x04500000, "ldrb%c\t%12R, %a"},
+    {0x0FFF0000, 0x092D0000, "push%c\t%m"},
+    {0x0FFF0000, 0x08BD0000, "pop%c\t%m"},
+    {0x0E400000, 0x08400000, NULL}, // User-bank LDM/STM
+    {0x0E500000, 0x08000000, "stm%u%c\t%16R%!, %m"},
+    {0x0E500000, 0x08100000, "ldm%u%c\t%16R%!, %m"},
+    {0x0F000000, 0x0A000000, "b%c\t%b"},
+    {0x0F000000, 0x0B000000, "bl%c\t%b"},
+};
+
+// ARM, cond == 0b1111.
+static const DisasmEntry arm_uncond_table[] = {
+    {0xFE000000, 0xFA000000, "blx\t%B"},
+    {0xFFFFFFF0, 0xF57FF040, "dsb\t%y"},
+    {0xFFFFFFF0, 0xF57FF050, "dmb\t%y"},
+    {0xFFFFFFF0, 0xF57FF060, "isb\t%y"},
+    {0xFD70F000, 0xF550F000, "pld\t%a"},
+};
+
+// VFP, shared by ARM (any condition) and Thumb-2 (always 0b1110 in the top nibble).
+static const DisasmEntry vfp_table[] = {
+    {0x0FFFFFFF, 0x0EF1FA10, "vmrs%c\tAPSR_nzcv, fpscr"},
+    {0x0FFF0FFF, 0x0EF10A10, "vmrs%c\t%12R, fpscr"},
+    {0x0FFF0FFF, 0x0EE10A10, "vmsr%c\tfpscr, %12R"},
+    {0x0FF00F7F, 0x0E000A10, "vmov%c\t%vns, %12R"},
+    {0x0FF00F7F, 0x0E100A10, "vmov%c\t%12R, %vns"},
+    {0x0FF00FD0, 0x0C400B10, "vmov%c\t%vmd, %12R, %16R"},
+    {0x0FF00FD0, 0x0C500B10, "vmov%c\t%12R, %16R, %vmd"},
+    {0x0F300E00, 0x0D100A00, "vldr%c\t%vdx, %Y"},
+    {0x0F300E00, 0x0D000A00, "vstr%c\t%vdx, %Y"},
+    {0x0FBF0E00, 0x0D2D0A00, "vpush%c\t%V"},
+    {0x0FBF0E00, 0x0CBD0A00, "vpop%c\t%V"},
+    {0x0F900E00, 0x0C900A00, "vldmia%c\t%16R%!, %V"},
+    {0x0F900E00, 0x0C800A00, "vstmia%c\t%16R%!, %V"},
+    {0x0FB00E00, 0x0D300A00, "vldmdb%c\t%16R!, %V"},
+    {0x0FB00E00, 0x0D200A00, "vstmdb%c\t%16R!, %V"},
+    {0x0FB00E50, 0x0E000A00, "vmla%c%g\t%vdx, %vnx, %vmx"},
+    {0x0FB00E50, 0x0E000A40, "vmls%c%g\t%vdx, %vnx, %vmx"},
+    {0x0FB00E50, 0x0E200A00, "vmul%c%g\t%vdx, %vnx, %vmx"},
+    {0x0FB00E50, 0x0E200A40, "vnmul%c%g\t%vdx, %vnx, %vmx"},
+    {0x0FB00E50, 0x0E300A00, "vadd%c%g\t%vdx, %vnx, %vmx"},
+    {0x0FB00E50, 0x0E300A40, "vsub%c%g\t%vdx, %vnx, %vmx"},
+    {0x0FB00E50, 0x0E800A00, "vdiv%c%g\t%vdx, %vnx, %vmx"},
+    {0x0FBF0ED0, 0x0EB00A40, "vmov%c%g\t%vdx, %vmx"},
+    {0x0FBF0ED0, 0x0EB00AC0, "vabs%c%g\t%vdx, %vmx"},
+    {0x0FBF0ED0, 0x0EB10A40, "vneg%c%g\t%vdx, %vmx"},
+    {0x0FBF0ED0, 0x0EB10AC0, "vsqrt%c%g\t%vdx, %vmx"},
+    {0x0FBF0ED0, 0x0EB40A40, "vcmp%c%g\t%vdx, %vmx"},
+    {0x0FBF0ED0, 0x0EB40AC0, "vcmpe%c%g\t%vdx, %vmx"},
+    {0x0FBF0EFF, 0x0EB50A40, "vcmp%c%g\t%vdx, #0"},
+    {0x0FBF0EFF, 0x0EB50AC0, "vcmpe%c%g\t%vdx, #0"},
+    {0x0FBF0FD0, 0x0EB70AC0, "vcvt%c.f64.f32\t%vdd, %vms"},
+    {0x0FBF0FD0, 0x0EB70BC0, "vcvt%c.f32.f64\t%vds, %vmd"},
+    {0x0FBF0F50, 0x0EB80A40, "vcvt%c.f32.%r\t%vds, %vms"},
+    {0x0FBF0F50, 0x0EB80B40, "vcvt%c.f64.%r\t%vdd, %vms"},
+    {0x0FBE0FD0, 0x0EBC0A40, "vcvtr%c.%q.f32\t%vds, %vms"},
+    {0x0FBE0FD0, 0x0EBC0B40, "vcvtr%c.%q.f64\t%vds, %vmd"},
+    {0x0FBE0F50, 0x0EBC0A40, "vcvt%c.%q.f32\t%vds, %vms"},
+    {0x0FBE0F50, 0x0EBC0B40, "vcvt%c.%q.f64\t%vds, %vmd"},
+    {0x0F000E10, 0x0E000A10, NULL}, // Other transfers to cp10/cp11
+    {0x0F100010, 0x0E000010, "mcr%c\tp%8d, %21:3i, %12R, c%16d, c%0d, %5:3i"},
+    {0x0F100010, 0x0E100010, "mrc%c\tp%8d, %21:3i, %12R, c%16d, c%0d, %5:3i"},
+};
+
+static const DisasmEntry thumb16_table[] = {
+    {0xFFC0, 0x0000, "movs\t%0L, %3L"},
+    {0xF800, 0x0000, "lsls\t%0L, %3L, %6:5i"},
+    {0xF800, 0x0800, "lsrs\t%0L, %3L, %6:5i"},
+    {0xF800, 0x1000, "asrs\t%0L, %3L, %6:5i"},
+    {0xFE00, 0x1800, "adds\t%0L, %3L, %6L"},
+    {0xFE00, 0x1A00, "subs\t%0L, %3L, %6L"},
+    {0xFE00, 0x1C00, "adds\t%0L, %3L, %6:3i"},
+    {0xFE00, 0x1E00, "subs\t%0L, %3L, %6:3i"},
+    {0xF800, 0x2000, "movs\t%8L, %0:8i"},
+    {0xF800, 0x2800, "cmp\t%8L, %0:8i"},
+    {0xF800, 0x3000, "adds\t%8L, %0:8i"},
+    {0xF800, 0x3800, "subs\t%8L, %0:8i"},
+    {0xFFC0, 0x4000, "ands\t%0L, %3L"},
+    {0xFFC0, 0x4040, "eors\t%0L, %3L"},
+    {0xFFC0, 0x4080, "lsls\t%0L, %3L"},
+    {0xFFC0, 0x40C0, "lsrs\t%0L, %3L"},
+    {0xFFC0, 0x4100, "asrs\t%0L, %3L"},
+    {0xFFC0, 0x4140, "adcs\t%0L, %3L"},
+    {0xFFC0, 0x4180, "sbcs\t%0L, %3L"},
+    {0xFFC0, 0x41C0, "rors\t%0L, %3L"},
+    {0xFFC0, 0x4200, "tst\t%0L, %3L"},
+    {0xFFC0, 0x4240, "rsbs\t%0L, %3L, #0"},
+    {0xFFC0, 0x4280, "cmp\t%0L, %3L"},
+    {0xFFC0, 0x42C0, "cmn\t%0L, %3L"},
+    {0xFFC0, 0x4300, "orrs\t%0L, %3L"},
+    {0xFFC0, 0x4340, "muls\t%0L, %3L, %0L"},
+    {0xFFC0, 0x4380, "bics\t%0L, %3L"},
+    {0xFFC0, 0x43C0, "mvns\t%0L, %3L"},
+    {0xFF00, 0x4400, "add\t%H, %3R"},
+    {0xFF00, 0x4500, "cmp\t%H, %3R"},
+    {0xFF00, 0x4600, "mov\t%H, %3R"},
+    {0xFF80, 0x4700, "bx\t%3R"},
+    {0xFF80, 0x4780, "blx\t%3R"},
+    {0xF800, 0x4800, "ldr\t%8L, [pc, %0:8<2i]"},
+    {0xFE00, 0x5000, "str\t%0L, [%3L, %6L]"},
+    {0xFE00, 0x5200, "strh\t%0L, [%3L, %6L]"},
+    {0xFE00, 0x5400, "strb\t%0L, [%3L, %6L]"},
+    {0xFE00, 0x5600, "ldrsb\t%0L, [%3L, %6L]"},
+    {0xFE00, 0x5800, "ldr\t%0L, [%3L, %6L]"},
+    {0xFE00, 0x5A00, "ldrh\t%0L, [%3L, %6L]"},
+    {0xFE00, 0x5C00, "ldrb\t%0L, [%3L, %6L]"},
+    {0xFE00, 0x5E00, "ldrsh\t%0L, [%3L, %6L]"},
+    {0xF800, 0x6000, "str\t%0L, [%3L, %6:5<2i]"},
+    {0xF800, 0x6800, "ldr\t%0L, [%3L, %6:5<2i]"},
+    {0xF800, 0x7000, "strb\t%0L, [%3L, %6:5i]"},
+    {0xF800, 0x7800, "ldrb\t%0L, [%3L, %6:5i]"},
+    {0xF800, 0x8000, "strh\t%0L, [%3L, %6:5<1i]"},
+    {0xF800, 0x8800, "ldrh\t%0L, [%3L, %6:5<1i]"},
+    {0xF800, 0x9000, "str\t%8L, [sp, %0:8<2i]"},
+    {0xF800, 0x9800, "ldr\t%8L, [sp, %0:8<2i]"},
+    {0xF800, 0xA000, "adr\t%8L, %0:8<2i"},
+    {0xF800, 0xA800, "add\t%8L, sp, %0:8<2i"},
+    {0xFF80, 0xB000, "add\tsp, %0:7<2i"},
+    {0xFF80, 0xB080, "sub\tsp, %0:7<2i"},
+    {0xFD00, 0xB100, "cbz\t%0L, %z"},
+    {0xFD00, 0xB900, "cbnz\t%0L, %z"},
+    {0xFFC0, 0xB200, "sxth\t%0L, %3L"},
+    {0xFFC0, 0xB240, "sxtb\t%0L, %3L"},
+    {0xFFC0, 0xB280, "uxth\t%0L, %3L"},
+    {0xFFC0, 0xB2C0, "uxtb\t%0L, %3L"},
+    {0xFE00, 0xB400, "push\t%p"},
+    {0xFE00, 0xBC00, "pop\t%P"},
+    {0xFFC0, 0xBA00, "rev\t%0L, %3L"},
+    {0xFFC0, 0xBA40, "rev16\t%0L, %3L"},
+    {0xFFC0, 0xBAC0, "revsh\t%0L, %3L"},
+    {0xFF00, 0xBE00, "bkpt\t%0:8i"},
+    {0xFFFF, 0xBF00, "nop"},
+    {0xFFFF, 0xBF10, "yield"},
+    {0xFFFF, 0xBF20, "wfe"},
+    {0xFFFF, 0xBF30, "wfi"},
+    {0xFFFF, 0xBF40, "sev"},
+    {0xFF0F, 0xBF00, NULL}, // Other hints
+    {0xFF00, 0xBF00, "%U"},
+    {0xF800, 0xC000, "stm\t%8L!, %l"},
+    {0xF800, 0xC800, "ldm\t%8L%@, %l"},
+    {0xFF00, 0xDE00, "udf\t%0:8i"},
+    {0xFF00, 0xDF00, "svc\t%0:8i"},
+    {0xF000, 0xD000, "b%C\t%t"},
+    {0xF800, 0xE000, "b\t%T"},
+};
+
+// Thumb-2 with the first halfword in the top half.
+static const DisasmEntry thumb32_table[] = {
+    {0xF800D000, 0xF000D000, "bl\t%j"},
+    {0xF800D000, 0xF000C000, "blx\t%J"},
+    {0xF800D000, 0xF0009000, "b.w\t%j"},
+    {0xFFFFFFFF, 0xF3AF8000, "nop.w"},
+    {0xFFFFFFF0, 0xF3BF8F40, "dsb\t%y"},
+    {0xFFFFFFF0, 0xF3BF8F50, "dmb\t%y"},
+    {0xFFFFFFF0, 0xF3BF8F60, "isb\t%y"},
+    {0xFFFFF0FF, 0xF3EF8000, "mrs\t%8R, apsr"},
+    {0xFFF0FF00, 0xF3808800, "msr\tapsr_nzcvq, %16R"},
+    {0xFFFFFF00, 0xF3DE8F00, "subs\tpc, lr, %0:8i"},
+    {0xFB80D000, 0xF3808000, NULL}, // Remaining miscellaneous control
+    {0xF800D000, 0xF0008000, "b%K.w\t%k"},
+    {0xFFF0FFF0, 0xE8D0F000, "tbb\t[%16R, %0R]"},
+    {0xFFF0FFF0, 0xE8D0F010, "tbh\t[%16R, %0R, lsl #1]"},
+    {0xFFF00F00, 0xE8500F00, "ldrex\t%12R, %X"},
+    {0xFFF00000, 0xE8400000, "strex\t%8R, %12R, %X"},
+    {0xFF600000, 0xE8400000, NULL}, // Rest of the exclusives, LDRD/STRD need P or W
+    {0xFE500000, 0xE8500000, "ldrd\t%12R, %8R, %D"},
+    {0xFE500000, 0xE8400000, "strd\t%12R, %8R, %D"},
+    {0xFFFF0000, 0xE92D0000, "push.w\t%m"},
+    {0xFFFF0000, 0xE8BD0000, "pop.w\t%m"},
+    {0xFFD00000, 0xE8900000, "ldm.w\t%16R%!, %m"},
+    {0xFFD00000, 0xE8800000, "stm.w\t%16R%!, %m"},
+    {0xFFD00000, 0xE9100000, "ldmdb\t%16R%!, %m"},
+    {0xFFD00000, 0xE9000000, "stmdb\t%16R%!, %m"},
+    {0xFFF00F00, 0xEA100F00, "tst.w\t%16R, %S"},
+    {0xFFE00000, 0xEA000000, "and%s.w\t%8R, %16R, %S"},
+    {0xFFE00000, 0xEA200000, "bic%s.w\t%8R, %16R, %S"},
+    {0xFFEF0000, 0xEA4F0000, "mov%s.w\t%8R, %S"},
+    {0xFFE00000, 0xEA400000, "orr%s.w\t%8R, %16R, %S"},
+    {0xFFEF0000, 0xEA6F0000, "mvn%s.w\t%8R, %S"},
+    {0xFFE00000, 0xEA600000, "orn%s\t%8R, %16R, %S"},
+    {0xFFF00F00, 0xEA900F00, "teq.w\t%16R, %S"},
+    {0xFFE00000, 0xEA800000, "eor%s.w\t%8R, %16R, %S"},
+    {0xFFF00F00, 0xEB100F00, "cmn.w\t%16R, %S"},
+    {0xFFE00000, 0xEB000000, "add%s.w\t%8R, %16R, %S"},
+    {0xFFE00000, 0xEB400000, "adc%s.w\t%8R, %16R, %S"},
+    {0xFFE00000, 0xEB600000, "sbc%s.w\t%8R, %16R, %S"},
+    {0xFFF00F00, 0xEBB00F00, "cmp.w\t%16R, %S"},
+    {0xFFE00000, 0xEBA00000, "sub%s.w\t%8R, %16R, %S"},
+    {0xFFE00000, 0xEBC00000, "rsb%s\t%8R, %16R, %S"},
+    {0xFBF08F00, 0xF0100F00, "tst.w\t%16R, %I"},
+    {0xFBE08000, 0xF0000000, "and%s.w\t%8R, %16R, %I"},
+    {0xFBE08000, 0xF0200000, "bic%s.w\t%8R, %16R, %I"},
+    {0xFBEF8000, 0xF04F0000, "mov%s.w\t%8R, %I"},
+    {0xFBE08000, 0xF0400000, "orr%s.w\t%8R, %16R, %I"},
+    {0xFBEF8000, 0xF06F0000, "mvn%s.w\t%8R, %I"},
+    {0xFBE08000, 0xF0600000, "orn%s\t%8R, %16R, %I"},
+    {0xFBF08F00, 0xF0900F00, "teq.w\t%16R, %I"},
+    {0xFBE08000, 0xF0800000, "eor%s.w\t%8R, %16R, %I"},
+    {0xFBF08F00, 0xF1100F00, "cmn.w\t%16R, %I"},
+    {0xFBE08000, 0xF1000000, "add%s.w\t%8R, %16R, %I"},
+    {0xFBE08000, 0xF1400000, "adc%s.w\t%8R, %16R, %I"},
+    {0xFBE08000, 0xF1600000, "sbc%s.w\t%8R, %16R, %I"},
+    {0xFBF08F00, 0xF1B00F00, "cmp.w\t%16R, %I"},
+    {0xFBE08000, 0xF1A00000, "sub%s.w\t%8R, %16R, %I"},
+    {0xFBE08000, 0xF1C00000, "rsb%s.w\t%8R, %16R, %I"},
+    {0xFBF08000, 0xF2000000, "addw\t%8R, %16R, %w"},
+    {0xFBF08000, 0xF2A00000, "subw\t%8R, %16R, %w"},
+    {0xFBF08000, 0xF2400000, "movw\t%8R, %N"},
+    {0xFBF08000, 0xF2C00000, "movt\t%8R, %N"},
+    {0xFFF08020, 0xF3C00000, "ubfx\t%8R, %16R, %x, %0:5+1i"},
+    {0xFFF08020, 0xF3400000, "sbfx\t%8R, %16R, %x, %0:5+1i"},
+    {0xFFFF8020, 0xF36F0000, "bfc\t%8R, %x, %W"},
+    {0xFFF08020, 0xF3600000, "bfi\t%8R, %16R, %x, %W"},
+    {0xFFF0F000, 0xF890F000, "pld\t%E"},
+    {0xFFF0FF00, 0xF810FC00, "pld\t%e"},
+    {0xFFF0FFC0, 0xF810F000, "pld\t%F"},
+    {0xFFF0F000, 0xF990F000, "pli\t%E"},
+    {0xFFF0FF00, 0xF910FC00, "pli\t%e"},
+    {0xFFF0FFC0, 0xF910F000, "pli\t%F"},
+    {0xFE50F000, 0xF810F000, NULL}, // Other byte and halfword loads to pc are hints
+    {0xFF7F0000, 0xF85F0000, "ldr.w\t%12R, %Q"},
+    {0xFFF00000, 0xF8800000, "strb.w\t%12R, %E"},
+    {0xFFF00000, 0xF8A00000, "strh.w\t%12R, %E"},
+    {0xFFF00000, 0xF8C00000, "str.w\t%12R, %E"},
+    {0xFFF00000, 0xF8900000, "ldrb.w\t%12R, %E"},
+    {0xFFF00000, 0xF8B00000, "ldrh.w\t%12R, %E"},
+    {0xFFF00000, 0xF8D00000, "ldr.w\t%12R, %E"},
+    {0xFFF00000, 0xF9900000, "ldrsb.w\t%12R, %E"},
+    {0xFFF00000, 0xF9B00000, "ldrsh.w\t%12R, %E"},
+    {0xFE000D00, 0xF8000800, NULL}, // Neither pre-indexed nor writeback
+    {0xFE000F00, 0xF8000E00, NULL}, // Unprivileged LDRT/STRT and friends
+    {0xFFF00800, 0xF8000800, "strb\t%12R, %e"},
+    {0xFFF00800, 0xF8200800, "strh\t%12R, %e"},
+    {0xFFF00800, 0xF8400800, "str\t%12R, %e"},
+    {0xFFF00800, 0xF8100800, "ldrb\t%12R, %e"},
+    {0xFFF00800, 0xF8300800, "ldrh\t%12R, %e"},
+    {0xFFF00800, 0xF8500800, "ldr\t%12R, %e"},
+    {0xFFF00800, 0xF9100800, "ldrsb\t%12R, %e"},
+    {0xFFF00800, 0xF9300800, "ldrsh\t%12R, %e"},
+    {0xFFF00FC0, 0xF8000000, "strb.w\t%12R, %F"},
+    {0xFFF00FC0, 0xF8200000, "strh.w\t%12R, %F"},
+    {0xFFF00FC0, 0xF8400000, "str.w\t%12R, %F"},
+    {0xFFF00FC0, 0xF8100000, "ldrb.w\t%12R, %F"},
+    {0xFFF00FC0, 0xF8300000, "ldrh.w\t%12R, %F"},
+    {0xFFF00FC0, 0xF8500000, "ldr.w\t%12R, %F"},
+    {0xFFF00FC0, 0xF9100000, "ldrsb.w\t%12R, %F"},
+    {0xFFF00FC0, 0xF9300000, "ldrsh.w\t%12R, %F"},
+    {0xFFE0F0F0, 0xFA00F000, "lsl%s.w\t%8R, %16R, %0R"},
+    {0xFFE0F0F0, 0xFA20F000, "lsr%s.w\t%8R, %16R, %0R"},
+    {0xFFE0F0F0, 0xFA40F000, "asr%s.w\t%8R, %16R, %0R"},
+    {0xFFE0F0F0, 0xFA60F000, "ror%s.w\t%8R, %16R, %0R"},
+    {0xFFFFF0C0, 0xFA5FF080, "uxtb.w\t%8R, %0R"},
+    {0xFFFFF0C0, 0xFA1FF080, "uxth.w\t%8R, %0R"},
+    {0xFFFFF0C0, 0xFA4FF080, "sxtb.w\t%8R, %0R"},
+    {0xFFFFF0C0, 0xFA0FF080, "sxth.w\t%8R, %0R"},
+    {0xFFF0F0F0, 0xFAB0F080, "clz\t%8R, %0R"},
+    {0xFFF0F0F0, 0xFA90F080, "rev.w\t%8R, %0R"},
+    {0xFFF0F0F0, 0xFA90F090, "rev16.w\t%8R, %0R"},
+    {0xFFF0F0F0, 0xFA90F0A0, "rbit\t%8R, %0R"},
+    {0xFFF0F0F0, 0xFB00F000, "mul\t%8R, %16R, %0R"},
+    {0xFFF000F0, 0xFB000000, "mla\t%8R, %16R, %0R, %12R"},
+    {0xFFF000F0, 0xFB000010, "mls\t%8R, %16R, %0R, %12R"},
+    {0xFFF000F0, 0xFB800000, "smull\t%12R, %8R, %16R, %0R"},
+    {0xFFF000F0, 0xFBA00000, "umull\t%12R, %8R, %16R, %0R"},
+    {0xFFF000F0, 0xFBC00000, "smlal\t%12R, %8R, %16R, %0R"},
+    {0xFFF000F0, 0xFBE00000, "umlal\t%12R, %8R, %16R, %0R"},
+    {0xFFF0F0F0, 0xFB90F0F0, "sdiv\t%8R, %16R, %0R"},
+    {0xFFF0F0F0, 0xFBB0F0F0, "udiv\t%8R, %16R, %0R"},
+};
+
+#define TABLE_SIZE(t) (sizeof(t) / sizeof((t)[0]))
+
+static void put_char(Disasm *d, char c)
+{
+    if (d->out.p < d->out.end)
+        *d->out.p++ = c;
+}
+
+static void put_str(Disasm *d, const char *s)
+{
+    while (*s)
+        put_char(d, *s++);
+}
+
+static void put_hex(Disasm *d, uint32_t value)
+{
+    char digits[8];
+    int n = 0;
+    do
+    {
+        digits[n++] = "0123456789abcdef"[value & 0xF];
+        value >>= 4;
+    } while (value);
+    put_str(d, "0x");
+    while (n)
+        put_char(d, digits[--n]);
+}
+
+static void put_dec(Disasm *d, uint32_t value)
+{
+    char digits[10];
+    int n = 0;
+    do
+    {
+        digits[n++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    while (n)
+        put_char(d, digits[--n]);
+}
+
+// Small values in decimal, the rest in hex.
+static void put_number(Disasm *d, uint32_t value)
+{
+    if (value < 16)
+        put_dec(d, value);
+    else
+        put_hex(d, value);
+}
+
+static void put_imm(Disasm *d, uint32_t value, bool negative)
+{
+    put_char(d, '#');
+    if (negative)
+        put_char(d, '-');
+    put_number(d, value);
+}
+
+static void put_reg(Disasm *d, uint32_t reg)
+{
+    put_str(d, reg_names[reg & 0xF]);
+}
+
+static uint32_t bits(uint32_t insn, uint32_t lo, uint32_t width)
+{
+    return (insn >> lo) & ((1u << width) - 1);
+}
+
+static int32_t sign_extend(uint32_t value, uint32_t width)
+{
+    const uint32_t sign = 1u << (width - 1);
+    return (int32_t)((value ^ sign) - sign);
+}
+
+static uint32_t pc_value(const Disasm *d)
+{
+    return d->addr + (d->thumb ? 4 : 8);
+}
+
+static void put_reg_list(Disasm *d, uint32_t list)
+{
+    bool first = true;
+    put_char(d, '{');
+    for (uint32_t r = 0; r < 16; ++r)
+    {
+        if (!(list & (1u << r)))
+            continue;
+        // Runs of three or more low registers collapse to r4-r7.
+        uint32_t end = r;
+        while (end + 1 < 13 && (list & (1u << (end + 1))))
+            end++;
+        if (!first)
+            put_str(d, ", ");
+        first = false;
+        put_reg(d, r);
+        if (end >= r + 2)
+        {
+            put_char(d, '-');
+            put_reg(d, end);
+            r = end;
+        }
+    }
+    put_char(d, '}');
+}
+
+// ARM shifter operand: #imm with rotation, Rm, Rm <shift> #n or Rm <shift> Rs.
+static void put_shifted_reg(Disasm *d, uint32_t rm, uint32_t type, uint32_t amount)
+{
+    put_reg(d, rm);
+    if (type == 3 && amount == 0)
+    {
+        put_str(d, ", rrx");
+        return;
+    }
+    if (type == 0 && amount == 0)
+        return;
+    put_str(d, ", ");
+    put_str(d, shift_names[type]);
+    put_str(d, " ");
+    put_imm(d, amount ? amount : 32, false);
+}
+
+static void put_arm_operand(Disasm *d)
+{
+    const uint32_t insn = d->insn;
+    if (insn & (1 << 25))
+    {
+        const uint32_t rot = bits(insn, 8, 4) * 2, imm = bits(insn, 0, 8);
+        put_imm(d, rot ? (imm >> rot) | (imm << (32 - rot)) : imm, false);
+    }
+    else if (insn & (1 << 4))
+    {
+        put_reg(d, bits(insn, 0, 4));
+        put_str(d, ", ");
+        put_str(d, shift_names[bits(insn, 5, 2)]);
+        put_char(d, ' ');
+        put_reg(d, bits(insn, 8, 4));
+    }
+    else
+        put_shifted_reg(d, bits(insn, 0, 4), bits(insn, 5, 2), bits(insn, 7, 5));
+}
+
+// [Rn, #+/-off]{!} or [Rn], #+/-off; a zero pre-indexed offset prints as [Rn].
+static void put_address(Disasm *d, uint32_t rn, uint32_t offset, bool pre, bool up, bool writeback)
+{
+    put_char(d, '[');
+    put_reg(d, rn);
+    if (!pre)
+    {
+        put_str(d, "], ");
+        put_imm(d, offset, !up);
+        return;
+    }
+    if (offset || !up)
+    {
+        put_str(d, ", ");
+        put_imm(d, offset, !up);
+    }
+    put_char(d, ']');
+    if (writeback)
+        put_char(d, '!');
+}
+
+static void put_register_address(Disasm *d, uint32_t rn, uint32_t rm, bool up, uint32_t type, uint32_t amount,
+                                 bool pre, bool writeback)
+{
+    put_char(d, '[');
+    put_reg(d, rn);
+    if (!pre)
+        put_char(d, ']');
+    put_str(d, up ? ", " : ", -");
+    put_shifted_reg(d, rm, type, amount);
+    if (pre)
+        put_char(d, ']');
+    if (pre && writeback)
+        put_char(d, '!');
+}
+
+static void put_arm_address(Disasm *d)
+{
+    const uint32_t insn = d->insn;
+    const bool pre = insn & (1 << 24), up = insn & (1 << 23), writeback = insn & (1 << 21);
+    if (insn & (1 << 25))
+        put_register_address(d, bits(insn, 16, 4), bits(insn, 0, 4), up, bits(insn, 5, 2), bits(insn, 7, 5), pre,
+                             writeback);
+    else
+        put_address(d, bits(insn, 16, 4), bits(insn, 0, 12), pre, up, writeback);
+}
+
+static void put_arm_address3(Disasm *d)
+{
+    const uint32_t insn = d->insn;
+    const bool pre = insn & (1 << 24), up = insn & (1 << 23), writeback = insn & (1 << 21);
+    if (insn & (1 << 22))
+        put_address(d, bits(insn, 16, 4), (bits(insn, 8, 4) << 4) | bits(insn, 0, 4), pre, up, writeback);
+    else
+        put_register_address(d, bits(insn, 16, 4), bits(insn, 0, 4), up, 0, 0, pre, writeback);
+}
+
+static uint32_t thumb_expand_imm(uint32_t insn)
+{
+    const uint32_t imm12 = (bits(insn, 26, 1) << 11) | (bits(insn, 12, 3) << 8) | bits(insn, 0, 8);
+    const uint32_t imm8 = imm12 & 0xFF;
+    if (!(imm12 >> 10))
+    {
+        switch ((imm12 >> 8) & 3)
+        {
+        case 0:
+            return imm8;
+        case 1:
+            return imm8 | (imm8 << 16);
+        case 2:
+            return (imm8 << 8) | (imm8 << 24);
+        default:
+            return imm8 * 0x01010101u;
+        }
+    }
+    const uint32_t value = 0x80 | (imm12 & 0x7F), rot = imm12 >> 7;
+    return (value >> rot) | (value << (32 - rot));
+}
+
+static int32_t thumb_branch_offset(uint32_t insn)
+{
+    const uint32_t s = bits(insn, 26, 1);
+    const uint32_t i1 = !(bits(insn, 13, 1) ^ s), i2 = !(bits(insn, 11, 1) ^ s);
+    return sign_extend((s << 24) | (i1 << 23) | (i2 << 22) | (bits(insn, 16, 10) << 12) | (bits(insn, 0, 11) << 1), 25);
+}
+
+// VFP register: field d (Vd, D), n (Vn, N) or m (Vm, M), sized by the sz bit (x) or forced single (s) or double (d).
+static void put_vfp_reg(Disasm *d, char field, char size)
+{
+    static const uint8_t fields[3][2] = {{12, 22}, {16, 7}, {0, 5}};
+    const uint8_t *f = fields[(field == 'd') ? 0 : (field == 'n') ? 1 : 2];
+    const uint32_t vx = bits(d->insn, f[0], 4), x = bits(d->insn, f[1], 1);
+    const bool dbl = (size == 'x') ? bits(d->insn, 8, 1) : size == 'd';
+    put_char(d, dbl ? 'd' : 's');
+    put_dec(d, dbl ? (x << 4) | vx : (vx << 1) | x);
+}
+
+static void put_vfp_list(Disasm *d)
+{
+    const bool dbl = bits(d->insn, 8, 1);
+    const uint32_t first = dbl ? (bits(d->insn, 22, 1) << 4) | bits(d->insn, 12, 4)
+                               : (bits(d->insn, 12, 4) << 1) | bits(d->insn, 22, 1);
+    const uint32_t count = dbl ? bits(d->insn, 0, 8) / 2 : bits(d->insn, 0, 8);
+    put_char(d, '{');
+    put_char(d, dbl ? 'd' : 's');
+    put_dec(d, first);
+    if (count > 1)
+    {
+        put_char(d, '-');
+        put_char(d, dbl ? 'd' : 's');
+        put_dec(d, first + count - 1);
+    }
+    put_char(d, '}');
+}
+
+// Parses the field spec of %<lo>[:<width>][<shift][+add]<letter> at *fmt.
+static const char *render_field(Disasm *d, const char *fmt)
+{
+    uint32_t lo = 0, width = 4, shift = 0, add = 0;
+    while (*fmt >= '0' && *fmt <= '9')
+        lo = lo * 10 + *fmt++ - '0';
+    if (*fmt == ':')
+        for (width = 0, fmt++; *fmt >= '0' && *fmt <= '9';)
+            width = width * 10 + *fmt++ - '0';
+    if (*fmt == '<')
+        shift = *++fmt - '0', fmt++;
+    if (*fmt == '+')
+        add = *++fmt - '0', fmt++;
+
+    switch (*fmt)
+    {
+    case 'R':
+        put_reg(d, bits(d->insn, lo, 4));
+        break;
+    case 'L':
+        put_reg(d, bits(d->insn, lo, 3));
+        break;
+    case 'i':
+        put_imm(d, (bits(d->insn, lo, width) << shift) + add, false);
+        break;
+    case 'd':
+        put_dec(d, bits(d->insn, lo, width));
+        break;
+    }
+    return fmt + 1;
+}
+
+static void render(Disasm *d, const char *fmt)
+{
+    const uint32_t insn = d->insn;
+    while (*fmt)
+    {
+        if (*fmt == '\t')
+        {
+            // Operands start in a fixed column so rows line up.
+            do
+                put_char(d, ' ');
+            while (d->out.p < d->out.end && d->out.p - d->out.start < 8);
+            fmt++;
+            continue;
+        }
+        if (*fmt != '%')
+        {
+            put_char(d, *fmt++);
+            continue;
+        }
+        fmt++;
+        if ((*fmt >= '0' && *fmt <= '9'))
+        {
+            fmt = render_field(d, fmt);
+            continue;
+        }
+
+        const char c = *fmt++;
+        switch (c)
+        {
+        case 'c': // ARM condition
+            put_str(d, cond_names[insn >> 28]);
+            break;
+        case 'C': // Thumb B<c> condition
+            put_str(d, cond_names[bits(insn, 8, 4)]);
+            break;
+        case 'K': // Thumb-2 B<c>.W condition
+            put_str(d, cond_names[bits(insn, 22, 4)]);
+            break;
+        case 's':
+            if (insn & (1 << 20))
+                put_char(d, 's');
+            break;
+        case '&': // Second register of an ARM LDRD/STRD pair
+            put_reg(d, bits(insn, 12, 4) + 1);
+            break;
+        case 'y': // Barrier option
+            put_str(d, barrier_names[insn & 0xF]);
+            break;
+        case '@': // Thumb LDM writes back unless the base is loaded
+            if (!(insn & (1u << bits(insn, 8, 3))))
+                put_char(d, '!');
+            break;
+        case '!':
+            if (insn & (1 << 21))
+                put_char(d, '!');
+            break;
+        case 'u': // LDM/STM addressing mode, IA is implied
+            put_str(d, (const char *[]){"da", "", "db", "ib"}[bits(insn, 23, 2)]);
+            break;
+        case 'o':
+            put_arm_operand(d);
+            break;
+        case 'a':
+            put_arm_address(d);
+            break;
+        case 'h':
+            put_arm_address3(d);
+            break;
+        case 'm':
+            put_reg_list(d, insn & 0xFFFF);
+            break;
+        case 'l':
+            put_reg_list(d, insn & 0xFF);
+            break;
+        case 'p':
+            put_reg_list(d, (insn & 0xFF) | (bits(insn, 8, 1) << 14));
+            break;
+        case 'P':
+            put_reg_list(d, (insn & 0xFF) | (bits(insn, 8, 1) << 15));
+            break;
+        case 'H': // Thumb high register Rdn, D:Rdn
+            put_reg(d, (bits(insn, 7, 1) << 3) | bits(insn, 0, 3));
+            break;
+        case 'b':
+            put_hex(d, pc_value(d) + sign_extend(bits(insn, 0, 24) << 2, 26));
+            break;
+        case 'B':
+            put_hex(d, pc_value(d) + sign_extend(bits(insn, 0, 24) << 2, 26) + (bits(insn, 24, 1) << 1));
+            break;
+        case 't':
+            put_hex(d, pc_value(d) + sign_extend(bits(insn, 0, 8) << 1, 9));
+            break;
+        case 'T':
+            put_hex(d, pc_value(d) + sign_extend(bits(insn, 0, 11) << 1, 12));
+            break;
+        case 'z':
+            put_hex(d, pc_value(d) + (bits(insn, 9, 1) << 6) + (bits(insn, 3, 5) << 1));
+            break;
+        case 'j':
+            put_hex(d, pc_value(d) + thumb_branch_offset(insn));
+            break;
+        case 'J':
+            put_hex(d, (pc_value(d) & ~3u) + (thumb_branch_offset(insn) & ~3));
+            break;
+        case 'k':
+            put_hex(d, pc_value(d) + sign_extend((bits(insn, 26, 1) << 20) | (bits(insn, 11, 1) << 19) |
+                                                     (bits(insn, 13, 1) << 18) | (bits(insn, 16, 6) << 12) |
+                                                     (bits(insn, 0, 11) << 1),
+                                                 21));
+            break;
+        case 'U': // IT block: it{t|e}{t|e}{t|e} <firstcond>
+        {
+            const uint32_t first = bits(insn, 4, 4), mask = bits(insn, 0, 4);
+            put_str(d, "it");
+            for (uint32_t n = 3; n > 0 && (mask & ((1u << n) - 1)); --n)
+                put_char(d, (bits(mask, n, 1) == (first & 1)) ? 't' : 'e');
+            put_str(d, "      ");
+            put_str(d, cond_names[first]);
+            break;
+        }
+        case 'I':
+            put_imm(d, thumb_expand_imm(insn), false);
+            break;
+        case 'S':
+            put_shifted_reg(d, bits(insn, 0, 4), bits(insn, 4, 2), (bits(insn, 12, 3) << 2) | bits(insn, 6, 2));
+            break;
+        case 'M':
+            put_imm(d, (bits(insn, 16, 4) << 12) | bits(insn, 0, 12), false);
+            break;
+        case 'Z': // ARM BKPT/UDF imm12:imm4
+            put_imm(d, (bits(insn, 8, 12) << 4) | bits(insn, 0, 4), false);
+            break;
+        case 'N':
+            put_imm(d, (bits(insn, 16, 4) << 12) | (bits(insn, 26, 1) << 11) | (bits(insn, 12, 3) << 8) |
+                           bits(insn, 0, 8),
+                    false);
+            break;
+        case 'w':
+            put_imm(d, (bits(insn, 26, 1) << 11) | (bits(insn, 12, 3) << 8) | bits(insn, 0, 8), false);
+            break;
+        case 'x': // Thumb-2 bitfield lsb
+            put_imm(d, (bits(insn, 12, 3) << 2) | bits(insn, 6, 2), false);
+            break;
+        case 'W': // Thumb-2 BFI/BFC width, msb - lsb + 1
+            put_imm(d, bits(insn, 0, 5) - ((bits(insn, 12, 3) << 2) | bits(insn, 6, 2)) + 1, false);
+            break;
+        case 'O': // ARM BFI/BFC width
+            put_imm(d, bits(insn, 16, 5) - bits(insn, 7, 5) + 1, false);
+            break;
+        case 'e':
+            put_address(d, bits(insn, 16, 4), bits(insn, 0, 8), bits(insn, 10, 1), bits(insn, 9, 1),
+                        bits(insn, 8, 1));
+            break;
+        case 'E':
+            put_address(d, bits(insn, 16, 4), bits(insn, 0, 12), true, true, false);
+            break;
+        case 'F':
+            put_register_address(d, bits(insn, 16, 4), bits(insn, 0, 4), true, 0, bits(insn, 4, 2), true, false);
+            break;
+        case 'D':
+            put_address(d, bits(insn, 16, 4), bits(insn, 0, 8) << 2, bits(insn, 24, 1), bits(insn, 23, 1),
+                        bits(insn, 21, 1));
+            break;
+        case 'X': // Thumb-2 exclusive [Rn, #imm8 * 4]
+            put_address(d, bits(insn, 16, 4), bits(insn, 0, 8) << 2, true, true, false);
+            break;
+        case 'Q':
+            put_address(d, 15, bits(insn, 0, 12), true, bits(insn, 23, 1), false);
+            break;
+        case 'Y':
+            put_address(d, bits(insn, 16, 4), bits(insn, 0, 8) << 2, true, bits(insn, 23, 1), false);
+            break;
+        case 'V':
+            put_vfp_list(d);
+            break;
+        case 'v':
+            put_vfp_reg(d, fmt[0], fmt[1]);
+            fmt += 2;
+            break;
+        case 'g':
+            put_str(d, bits(insn, 8, 1) ? ".f64" : ".f32");
+            break;
+        case 'r': // Integer source of VCVT to float
+            put_str(d, bits(insn, 7, 1) ? "s32" : "u32");
+            break;
+        case 'q': // Integer result of VCVT from float
+            put_str(d, bits(insn, 16, 1) ? "s32" : "u32");
+            break;
+        }
+    }
+}
+
+static const DisasmEntry *lookup(const DisasmEntry *table, uint32_t count, uint32_t insn, bool *blocked)
+{
+    for (uint32_t i = 0; i < count; ++i)
+        if ((insn & table[i].mask) == table[i].value)
+        {
+            *blocked = !table[i].format;
+            return table[i].format ? &table[i] : NULL;
+        }
+    return NULL;
+}
+
+// VLDM/VSTM lists must be non-empty and end at the last register; odd D list lengths are the FLDMX/FSTMX forms.
+static bool vfp_list_valid(uint32_t insn)
+{
+    const bool pre = bits(insn, 24, 1), up = bits(insn, 23, 1);
+    if ((insn & 0x0E000E00) != 0x0C000A00 || !(pre ? !up && bits(insn, 21, 1) : up))
+        return true; // Not a register list
+    const uint32_t imm8 = bits(insn, 0, 8);
+    if (bits(insn, 8, 1))
+        return imm8 && !(imm8 & 1) && imm8 <= 32 && ((bits(insn, 22, 1) << 4) | bits(insn, 12, 4)) + imm8 / 2 <= 32;
+    return imm8 && ((bits(insn, 12, 4) << 1) | bits(insn, 22, 1)) + imm8 <= 32;
+}
+
+static const DisasmEntry *lookup_vfp(uint32_t insn)
+{
+    bool blocked = false;
+    return vfp_list_valid(insn) ? lookup(vfp_table, TABLE_SIZE(vfp_table), insn, &blocked) : NULL;
+}
+
+static const DisasmEntry *lookup_arm(uint32_t insn)
+{
+    bool blocked = false;
+    if ((insn >> 28) == 0xF)
+        return lookup(arm_uncond_table, TABLE_SIZE(arm_uncond_table), insn, &blocked);
+    // Coprocessor space (bits 27:26 == 11) only holds VFP here.
+    if (((insn >> 26) & 3) == 3 && ((insn >> 24) & 0xF) != 0xF)
+        return lookup_vfp(insn);
+    return lookup(arm_table, TABLE_SIZE(arm_table), insn, &blocked);
+}
+
+static const DisasmEntry *lookup_thumb32(uint32_t insn)
+{
+    bool blocked = false;
+    // VFP shares the ARM encodings with 0b1110 in place of the condition.
+    if ((insn >> 28) == 0xE && ((insn >> 26) & 3) == 3)
+        return lookup_vfp(insn);
+    return lookup(thumb32_table, TABLE_SIZE(thumb32_table), insn, &blocked);
+}
+
+// Decodes the instruction at addr from the avail bytes at bytes; returns its size, 0 when too few bytes are left.
+uint32_t disasm_decode(uint32_t addr, const uint8_t *bytes, uint32_t avail, bool thumb, char *out, uint32_t out_size,
+                       uint32_t *raw)
+{
+    Disasm d = {0, addr, thumb, {out, out, out + out_size - 1}};
+    uint32_t size = 4;
+    const DisasmEntry *entry = NULL;
+
+    if (!out_size)
+        return 0;
+    if (thumb)
+    {
+        if (avail < 2)
+            return 0;
+        const uint32_t hw1 = bytes[0] | (bytes[1] << 8);
+        if ((hw1 >> 11) >= 0x1D)
+        {
+            if (avail < 4)
+                return 0;
+            d.insn = (hw1 << 16) | bytes[2] | (bytes[3] << 8);
+            entry = lookup_thumb32(d.insn);
+        }
+        else
+        {
+            d.insn = hw1;
+            size = 2;
+            bool blocked;
+            entry = lookup(thumb16_table, TABLE_SIZE(thumb16_table), d.insn, &blocked);
+        }
+    }
+    else
+    {
+        if (avail < 4)
+            return 0;
+        d.insn = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+        entry = lookup_arm(d.insn);
+    }
+
+    if (entry)
+        render(&d, entry->format);
+    else
+    {
+        put_str(&d, (size == 2) ? ".short  " : ".word   ");
+        put_hex(&d, d.insn);
+    }
+    *d.out.p = '\0';
+    if (raw)
+        *raw = d.insn;
+    return size;
+}
+
+void disasm_cache_reset(DisasmCache *cache)
+{
+    memset(cache, 0, sizeof(*cache));
+}
+
+// Line for the instruction at addr, decoded again only when the address, mode or encoding changed.
+const DisasmLine *disasm_line(DisasmCache *cache, uint32_t addr, const uint8_t *bytes, uint32_t avail, bool thumb)
+{
+    DisasmLine *line = &cache->lines[(addr >> 1) & (DISASM_CACHE_LINES - 1)];
+    if (line->size && line->addr == addr && line->thumb == thumb && avail >= line->size)
+    {
+        uint32_t raw = bytes[0] | (bytes[1] << 8);
+        if (line->size == 4)
+            raw = thumb ? (raw << 16) | bytes[2] | (bytes[3] << 8) : raw | (bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+        if (raw == line->raw)
+        {
+            cache->hits++;
+            return line;
+        }
+    }
+
+    cache->misses++;
+    line->addr = addr;
+    line->thumb = thumb;
+    line->size = disasm_decode(addr, bytes, avail, thumb, line->text, sizeof(line->text), &line->raw);
+    return line->size ? line : NULL;
+}
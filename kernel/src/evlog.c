@@ -0,0 +1,75 @@
+#include "evlog.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+void evlog_push(Evlog *log, uint32_t time, uint16_t kind, uint16_t a, uint32_t b)
+{
+    const uint32_t pos = __atomic_fetch_add(&log->head, 1, __ATOMIC_RELAXED);
+    EvlogEvent *ev = &log->events[pos & (EVLOG_SIZE - 1)];
+    __atomic_store_n(&ev->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    ev->time = time;
+    ev->kind = kind;
+    ev->a = a;
+    ev->b = b;
+    __atomic_store_n(&ev->seq, pos + 1, __ATOMIC_RELEASE);
+}
+
+// Copies the newest events out, oldest first. An event is kept only if its sequence is the same before and after
+// the copy, so torn or overwritten slots are skipped rather than reported.
+uint32_t evlog_snapshot(const Evlog *log, EvlogEvent *out, uint32_t max)
+{
+    const uint32_t head = __atomic_load_n(&log->head, __ATOMIC_ACQUIRE);
+    uint32_t span = (head < EVLOG_SIZE) ? head : EVLOG_SIZE;
+    span = (span < max) ? span : max;
+
+    uint32_t count = 0;
+    for (uint32_t pos = head - span; pos != head; ++pos)
+    {
+        const EvlogEvent *ev = &log->events[pos & (EVLOG_SIZE - 1)];
+        if (__atomic_load_n(&ev->seq, __ATOMIC_ACQUIRE) != pos + 1)
+            continue;
+        memcpy(&out[count], ev, sizeof(*ev));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&ev->seq, __ATOMIC_RELAXED) == pos + 1)
+            count++;
+    }
+    return count;
+}
+
+// PMU cycles from asm stage `from` to stage `to` of the same abort, over a snapshot. Pairs are matched per core, and an
+// entry on a core drops its unmatched start, since that abort left by another way. scratch holds count words.
+void evlog_asm_span(const EvlogEvent *events, uint32_t count, uint16_t from, uint16_t to, uint32_t *scratch,
+                    EvlogSpan *out)
+{
+    uint32_t start[EVLOG_CORES];
+    bool open[EVLOG_CORES] = {false};
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (events[i].kind != EV_ASM_ENTRY)
+            continue;
+        const uint32_t core = (events[i].a >> 8) & (EVLOG_CORES - 1);
+        const uint32_t stage = events[i].a & 0xFF;
+        if (stage == from)
+        {
+            start[core] = events[i].b;
+            open[core] = true;
+        }
+        else if (stage == to && open[core])
+        {
+            const uint32_t v = events[i].b - start[core];
+            uint32_t j = n++;
+            for (; j > 0 && scratch[j - 1] > v; --j)
+                scratch[j] = scratch[j - 1];
+            scratch[j] = v;
+            open[core] = false;
+        }
+        else if (stage == EVLOG_STAGE_ENTRY)
+            open[core] = false;
+    }
+    out->count = n;
+    out->p50 = n ? scratch[n / 2] : 0;
+    out->max = n ? scratch[n - 1] : 0;
+}
@@ -1,12 +1,41 @@
 #include "kernel.h"
 
-SceThreadCpuRegisters all_registers;
-SceArmCpuRegisters current_registers;
+uint32_t suspend_generation;
+ExceptionFilter exception_filter;
 
 extern void asm_pabt(void);
 extern void asm_dabt(void);
 extern void asm_undef(void);
 
+#ifdef PEBBLE_TRACE
+Evlog exception_log;
+
+// PMU cycle counter of the current core, switched on the first time each core gets here.
+static uint32_t pmu_cycles(void)
+{
+    uint32_t enabled, cycles;
+    __asm__ volatile("mrc p15, 0, %0, c9, c12, 1" : "=r"(enabled)); // PMCNTENSET
+    if (!(enabled >> 31))
+    {
+        uint32_t pmcr;
+        __asm__ volatile("mrc p15, 0, %0, c9, c12, 0" : "=r"(pmcr));
+        __asm__ volatile("mcr p15, 0, %0, c9, c12, 0" ::"r"(pmcr | 1));
+        __asm__ volatile("mcr p15, 0, %0, c9, c12, 1" ::"r"(1u << 31));
+    }
+    __asm__ volatile("mrc p15, 0, %0, c9, c13, 0" : "=r"(cycles)); // PMCCNTR
+    return cycles;
+}
+
+// Called from the asm handlers with r0-r3, ip and lr saved around it. Stage 0 is an abort the filter passed on. The
+// core goes with the stage so dump_frame_stats can pair up the cycle counts of one abort.
+void evlog_asm_stage(uint32_t stage)
+{
+    uint32_t mpidr;
+    __asm__ volatile("mrc p15, 0, %0, c0, c0, 5" : "=r"(mpidr));
+    EVLOG(EV_ASM_ENTRY, EVLOG_ASM_A(stage, mpidr & (EVLOG_CORES - 1)), pmu_cycles());
+}
+#endif
+
 int handle_create(SceUID pid, SceProcEventInvokeParam2 *a2, int a3)
 {
     (void)a2;
@@ -19,8 +48,11 @@ int handle_create(SceUID pid, SceProcEventInvokeParam2 *a2, int a3)
     guistate.view_state = VIEW_STACK;
     guistate.mem_layout = MEM_LAYOUT_8BIT;
     load_hotkeys();
+    ksceKernelLockMutex(debugger_mtx_uid, 1, NULL);
     kernel_debugger_on_create();
-    
+    ksceKernelUnlockMutex(debugger_mtx_uid, 1);
+    gui_notify(GUI_EVT_PROCESS);
+
     return 0;
 }
 
@@ -28,12 +60,16 @@ int handle_kill(SceUID pid, SceProcEventInvokeParam1 *a2, int a3)
 {
     (void)a2;
     (void)a3;
+    ksceKernelLockMutex(debugger_mtx_uid, 1, NULL);
     for (int i = 0; i < MAX_HW_BKPT; ++i) // Clear HW BKPT & Single step BKPT
     {
         if (guistate.breakpoints[i].pid == pid)
             kernel_clear_breakpoint(i);
     }
+    kernel_drop_software_breakpoints(pid);
     kernel_debugger_init();
+    ksceKernelUnlockMutex(debugger_mtx_uid, 1);
+    gui_notify(GUI_EVT_PROCESS);
 
     return 0;
 }
@@ -50,19 +86,22 @@ const SceProcEventHandler handler = {
 
 int exception_handler(int exception_type, uint32_t dfar_value)
 {
+    const uint32_t entry_time = ksceKernelGetSystemTimeLow();
     SceKernelThreadContextInfo info;
     if (ksceKernelGetThreadContextInfo(&info) < 0 || info.process_id != g_target_process.pid)
         return SCE_EXCPMGR_EXCEPTION_HANDLED;
-    ksceKernelPrintf("Stage 1\n");
-    g_target_process.exception_thid = info.thread_id;
+    EVLOG(EV_HANDLER, 1, info.thread_id);
 
+    // Everything about the faulting thread stays on this stack until it goes into the thread table, so faults of
+    // other threads on other cores run through here side by side.
+    SceThreadCpuRegisters all_registers;
     if (ksceKernelGetThreadCpuRegisters(info.thread_id, &all_registers) < 0)
         return SCE_EXCPMGR_EXCEPTION_HANDLED;
-    ksceKernelPrintf("Stage 2\n");
-    memcpy(&current_registers, &all_registers.user, sizeof(SceArmCpuRegisters));
+    EVLOG(EV_HANDLER, 2, all_registers.user.pc);
+    const SceArmCpuRegisters *regs = &all_registers.user;
 
-    bool is_thumb = (current_registers.cpsr & (1 << 5)) != 0;
-    uint32_t bkpt_addr = current_registers.pc;
+    bool is_thumb = (regs->cpsr & (1 << 5)) != 0;
+    uint32_t bkpt_addr = regs->pc;
 
     // Adjust PC based on exception type
     if (exception_type == SCE_EXCP_PABT) // PABT
@@ -72,13 +111,17 @@ int exception_handler(int exception_type, uint32_t dfar_value)
     else if (exception_type == SCE_EXCP_UNDEF_INSTRUCTION) // UNDEF
         bkpt_addr -= is_thumb ? 2 : 4;
         
-    ksceKernelPrintf("Stage 3\n");
+    EVLOG(EV_HANDLER, 3, bkpt_addr);
     // Check if this exception is caused by one of the breakpoints
-    bool handled = false;
-    ActiveBKPTSlot *bp = guistate.breakpoints;
-    for (int i = 0; i < MAX_SLOT; ++i, ++bp)
+    bool handled = false, silent = false, parked = false;
+    int hit = -1;
+    uint16_t slots[BPINDEX_MAX_CHAIN];
+    const uint32_t hits = kernel_lookup_breakpoints(bkpt_addr, slots, BPINDEX_MAX_CHAIN);
+    for (uint32_t n = 0; n < hits; ++n)
     {
-        if (bp->type == SLOT_NONE || bp->pid != g_target_process.pid)
+        const int i = slots[n];
+        const ActiveBKPTSlot *bp = kernel_get_breakpoint(i);
+        if (!bp || bp->type == SLOT_NONE || bp->pid != g_target_process.pid)
             continue;
 
         if (bp->address == bkpt_addr)
@@ -90,12 +133,14 @@ int exception_handler(int exception_type, uint32_t dfar_value)
                 if (ksceKernelCopyToUserProcTextDomain(g_target_process.pid, (void *)bkpt_addr, 
                     &bp->p_instruction, size) >= 0) {
                     handled = true;
+                    hit = i;
                     break;
                 }
             }
             else if (bp->type == HW_BREAKPOINT && exception_type == SCE_EXCP_PABT)
             {
                 handled = true;
+                hit = i;
                 break;
             }
             else if ((bp->type == HW_WATCHPOINT_R || bp->type == HW_WATCHPOINT_W || bp->type == HW_WATCHPOINT_RW) && exception_type == SCE_EXCP_DABT)
@@ -104,25 +149,55 @@ int exception_handler(int exception_type, uint32_t dfar_value)
                 if (dfar_value >= bp->address && dfar_value < (bp->address + wp_size))
                 {
                     handled = true;
+                    hit = i;
                     break;
                 }
             }
             else if (i == SINGLE_STEP_SLOT && bp->type == SINGLE_STEP_HW_BREAKPOINT && 
                      exception_type == SCE_EXCP_PABT)
             {
-                kernel_clear_breakpoint(SINGLE_STEP_SLOT);
+                // The slot matches every thread; one that is not stepping waits here for the one that is.
+                parked = !kernel_owns_step(info.thread_id);
+                silent = !parked && kernel_finish_rearm();
+                if (!silent && !parked)
+                    kernel_clear_breakpoint(SINGLE_STEP_SLOT);
                 handled = true;
+                hit = i;
                 break;
             }
         }
     }
 
-    if (handled)
+    // A false condition or a tracepoint lets the thread run on; the breakpoint is lifted for one instruction and put
+    // back.
+    if (handled && hit != SINGLE_STEP_SLOT)
+    {
+        kernel_count_hit(hit);
+        const bool stop =
+            kernel_breakpoint_condition_met(hit, regs) && !kernel_trace_hit(hit, info.thread_id, regs);
+        if (!stop && kernel_step_rearm(hit, info.thread_id, regs) >= 0)
+            silent = true;
+    }
+
+    const ThreadReason reason = parked ? THREAD_PARKED : (hit == SINGLE_STEP_SLOT) ? THREAD_STEP : THREAD_BREAKPOINT;
+    if (handled && !silent && kernel_thread_stopped(info.thread_id, regs, reason, hit) >= 0)
     {
-        ksceKernelPrintf("Stage 4\n");
-        guistate.gui_visible = true;
+        EVLOG(EV_HANDLER, 4, info.thread_id);
         ksceKernelChangeThreadSuspendStatus(info.thread_id, 0x1002);
+        if (parked)
+        {
+            // The step may have finished while this thread was on its way here.
+            if (!kernel_thread_parked(info.thread_id))
+                ksceKernelChangeThreadSuspendStatus(info.thread_id, 2);
+        }
+        else
+        {
+            guistate.gui_visible = true;
+            gui_notify(GUI_EVT_BREAKPOINT);
+        }
     }
+    if (handled && hit != SINGLE_STEP_SLOT)
+        kernel_note_latency(hit, ksceKernelGetSystemTimeLow() - entry_time);
 
     return SCE_EXCPMGR_EXCEPTION_HANDLED; // Always return handled to avoid crashes
 }
@@ -0,0 +1,91 @@
+#include "frametime.h"
+
+#include <string.h>
+
+// Rolling per-stage timings. Everything goes through the injected clock so it can run against a fake one.
+
+void frametime_init(FrameTimer *t, FrameClock clock)
+{
+    memset(t, 0, sizeof(*t));
+    t->clock = clock;
+}
+
+void frametime_begin(FrameTimer *t, FrameStage stage)
+{
+    t->start[stage] = t->clock();
+}
+
+void frametime_end(FrameTimer *t, FrameStage stage)
+{
+    // Accumulates, so a stage entered several times per frame is reported as one total.
+    t->current[stage] += (uint32_t)(t->clock() - t->start[stage]);
+}
+
+void frametime_record(FrameTimer *t, FrameStage stage, uint32_t us)
+{
+    t->samples[stage][t->head[stage]] = us;
+    t->head[stage] = (t->head[stage] + 1) % FRAMETIME_WINDOW;
+    if (t->count[stage] < FRAMETIME_WINDOW)
+        t->count[stage]++;
+}
+
+void frametime_commit(FrameTimer *t)
+{
+    for (int stage = FT_INPUT; stage <= FT_DRAW; ++stage)
+    {
+        frametime_record(t, stage, t->current[stage]);
+        t->current[stage] = 0;
+    }
+}
+
+void frametime_input_edge(FrameTimer *t)
+{
+    // Latency is measured from the first unpresented edge; later edges ride along with the same frame.
+    if (t->input_pending)
+        return;
+    t->input_edge = t->clock();
+    t->input_pending = true;
+}
+
+void frametime_handoff(FrameTimer *t)
+{
+    t->handoff = t->clock();
+    t->handoff_pending = true;
+}
+
+void frametime_presented(FrameTimer *t)
+{
+    if (!t->handoff_pending)
+        return;
+    uint64_t now = t->clock();
+    frametime_record(t, FT_PRESENT, (uint32_t)(now - t->handoff));
+    if (t->input_pending && t->input_edge <= t->handoff)
+    {
+        frametime_record(t, FT_LATENCY, (uint32_t)(now - t->input_edge));
+        t->input_pending = false;
+    }
+    t->handoff_pending = false;
+}
+
+void frametime_stats(const FrameTimer *t, FrameStage stage, StageStats *out)
+{
+    uint32_t sorted[FRAMETIME_WINDOW];
+    uint32_t n = t->count[stage];
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        uint32_t v = t->samples[stage][i];
+        uint32_t j = i;
+        for (; j > 0 && sorted[j - 1] > v; --j)
+            sorted[j] = sorted[j - 1];
+        sorted[j] = v;
+    }
+    out->count = n;
+    if (n == 0)
+    {
+        out->p50 = out->p95 = out->max = 0;
+        return;
+    }
+    out->p50 = sorted[n / 2];
+    out->p95 = sorted[(n * 95) / 100];
+    out->max = sorted[n - 1];
+}
@@ -1,16 +1,86 @@
 #include "kernel.h"
 #include "renderer.h"
+#include "scheduler.h"
+#include "frametime.h"
+#include "memcache.h"
+#include "search.h"
+#include "disasm.h"
 
 State guistate;
 uint32_t lowest_vaddr = 0x84000000;
 uint32_t highest_vaddr = 0x85000000;
 
 static const MemLayoutInfo layout_info[] = {
-    [MEM_LAYOUT_8BIT] = {"%02X", 1}, [MEM_LAYOUT_16BIT] = {"%04X", 2}, [MEM_LAYOUT_32BIT] = {"%08X", 4}};
+    [MEM_LAYOUT_8BIT] = {"%02X", 1}, [MEM_LAYOUT_16BIT] = {"%04X", 2}, [MEM_LAYOUT_32BIT] = {"%08X", 4},
+    [MEM_LAYOUT_DISASM] = {"%08X", 4}};
 
 static bool cache_dirty = true;
+static uint32_t hex_panel_sig = 0;
+
+// Damage-tracked regions of the memory view, one signature per framebuffer.
+enum
+{
+    REGION_SCREEN,
+    REGION_HEX_PANEL,
+    REGION_RIGHT_PANEL,
+    REGION_HUD,
+    REGION_HEX_ROWS
+};
+#define HEX_PANEL_MAX_WIDTH ((8 + 1 + 8 * 3 + 1 + 8) * FONT_WIDTH)
+#define RIGHT_PANEL_X 547
 static const char *bp_types[] = {
     "", "Software-Thumb", "Software-Arm", "Hardware", "Watchpoint-R", "Watchpoint-W", "Watchpoint-RW", "SingleStep"};
+static const char *features[] = {"Set Hardware Breakpoint",
+                                 "Set Watchpoint",
+                                 "Set Software Breakpoint",
+                                 "List All Breakpoints",
+                                 "Suspend Process",
+                                 "Resume Process",
+                                 "Single Step",
+                                 "Hotkeys",
+                                 "Frame Stats HUD",
+                                 "Dump Frame Stats",
+                                 "Memory Search",
+                                 "Tracepoints",
+                                 "Step Over",
+                                 "Step Out"};
+#define FEATURE_COUNT (sizeof(features) / sizeof(features[0]))
+static const char *stage_names[FT_COUNT] = {"input", "state", "memread", "draw", "present", "latency"};
+static FrameTimer frametimer;
+static MemCache viewcache;
+static DisasmCache disasm_cache;
+
+#define SEARCH_TEXT_MAX 16
+#define SEARCH_ROWS 4 // Type, value, start and next scan rows ahead of the result list
+#define SEARCH_PAGE_LINES 15
+#define SCAN_STEP_PAGES 64
+#define BKPT_PAGE_LINES 20
+#define TRACE_HISTORY 16
+#define TRACE_FILE_BUFFER 0x1000
+static const char *search_types[SEARCH_TYPE_COUNT] = {"U8", "U16", "U32", "Float", "Pattern", "ASCII", "UTF-16"};
+static const char *scan_filters[SCAN_FILTER_COUNT] = {"Equal", "Changed", "Unchanged", "Increased", "Decreased"};
+static SearchState search;
+static ScanStore *scanstore = NULL;
+static SceUID scan_arena_uid = 0;
+static ScanFilter scan_filter = SCAN_CHANGED;
+static SearchType search_type = SEARCH_U32;
+static uint32_t search_value = 0;
+static char search_text[SEARCH_TEXT_MAX + 1] = "00";
+static char cond_text[COND_TEXT_MAX + 1];
+static int cond_cursor;
+static bool cond_editing, cond_error, cond_trace; // cond_trace: the editor holds a tracepoint spec
+static TraceRecord trace_history[TRACE_HISTORY];
+static uint32_t trace_captured;
+static SceUID trace_fd;
+static uint32_t trace_file_used;
+static uint8_t trace_file_buffer[TRACE_FILE_BUFFER];
+static int search_cursor = 0;
+static bool search_error = false;
+
+static uint64_t frametime_clock(void)
+{
+    return ksceKernelGetSystemTimeWide();
+}
 
 static inline char nibble_to_hex(uint8_t nibble)
 {
@@ -18,6 +88,37 @@ static inline char nibble_to_hex(uint8_t nibble)
     return hex_chars[nibble & 0xF];
 }
 
+// The disassembly follows the instruction set the target stopped in, Thumb while it runs.
+static bool disasm_thumb(void)
+{
+    return !guistate.has_active_bp || (guistate.regs.cpsr & (1 << 5));
+}
+
+// Bytes per hex view row. The disassembly gives every instruction slot its own row.
+static uint32_t row_bytes(void)
+{
+    if (guistate.mem_layout != MEM_LAYOUT_DISASM)
+        return 8;
+    return disasm_thumb() ? 2 : 4;
+}
+
+// Bytes per selectable value; a disassembly row edits as one value.
+static int value_bytes(void)
+{
+    return (guistate.mem_layout == MEM_LAYOUT_DISASM) ? (int)row_bytes() : layout_info[guistate.mem_layout].bytes;
+}
+
+// Snaps the cursor and window to row boundaries after the row size changed.
+static void align_view(void)
+{
+    const uint32_t align = row_bytes() - 1;
+    if (!((guistate.addr | guistate.base_addr) & align))
+        return;
+    guistate.addr &= ~align;
+    guistate.base_addr &= ~align;
+    cache_dirty = true;
+}
+
 static void button_to_string(uint32_t buttons, char *buffer, size_t bufsize)
 {
     static const struct {
@@ -131,14 +232,62 @@ static void check_button_repeat(uint32_t current_buttons, uint32_t *released)
     guistate.pressed_buttons = current_buttons;
 }
 
+static uint32_t stack_panel_rows(void)
+{
+    return (guistate.active_area == MEMVIEW_STACK) ? 16 : 3;
+}
+
+// Registers, callstack and the stack's readable extent, taken once per suspend.
+static void take_stack_snapshot(void)
+{
+    const uint32_t old_sp = guistate.regs.sp;
+    kernel_get_registers(&guistate.regs);
+    guistate.stack_generation = suspend_generation;
+    guistate.stack_valid = true;
+    guistate.stack_pages = 0;
+    if (guistate.regs.sp != old_sp)
+        guistate.stack_scroll = 0;
+
+    guistate.stack_size = STACK_VIEW_WORDS;
+    const MemRegion *region = regions_find(kernel_get_regions(), guistate.regs.sp);
+    if (region && (region->base + region->size - guistate.regs.sp) / 4 < guistate.stack_size)
+        guistate.stack_size = (region->base + region->size - guistate.regs.sp) / 4;
+
+    const int frames = kernel_get_callstack(guistate.callstack, MAX_CALL_STACK_DEPTH);
+    guistate.callstack_size = (frames > 0) ? frames : 0;
+    kernel_refresh_symbols();
+}
+
+// Reads the pages of stack under rows [first, first + count) not read since the snapshot.
+static void fetch_stack_rows(uint32_t first, uint32_t count)
+{
+    for (uint32_t word = first & ~(STACK_PAGE_WORDS - 1); word < first + count && word < guistate.stack_size;
+         word += STACK_PAGE_WORDS)
+    {
+        const uint32_t page = 1u << (word / STACK_PAGE_WORDS);
+        if (guistate.stack_pages & page)
+            continue;
+        const uint32_t words = (guistate.stack_size - word < STACK_PAGE_WORDS) ? guistate.stack_size - word
+                                                                                  : STACK_PAGE_WORDS;
+        if (kernel_read_memory((void *)(guistate.regs.sp + word * 4), &guistate.stack[word], words * 4) < 0)
+        {
+            guistate.stack_size = word; // Ran off the mapped stack
+            break;
+        }
+        guistate.stack_pages |= page;
+    }
+    if (guistate.stack_scroll > 0 && guistate.stack_scroll >= guistate.stack_size)
+        guistate.stack_scroll = guistate.stack_size ? guistate.stack_size - 1 : 0;
+}
+
 static void update_memview_state(void)
 {
     kernel_list_breakpoints(guistate.breakpoints);
 
     guistate.has_active_bp = false;
-    for (int i = 0; i < MAX_SLOT; i++)
+    for (int id = kernel_next_breakpoint(-1); id >= 0; id = kernel_next_breakpoint(id))
     {
-        if (guistate.breakpoints[i].type && guistate.breakpoints[i].pid == g_target_process.pid)
+        if (kernel_get_breakpoint(id)->pid == g_target_process.pid)
         {
             guistate.has_active_bp = true;
             break;
@@ -150,14 +299,68 @@ static void update_memview_state(void)
         memset(&guistate.regs, 0, sizeof(guistate.regs));
         guistate.stack_size = 0;
         guistate.callstack_size = 0;
+        guistate.stack_valid = false;
         return;
     }
 
-    kernel_get_registers(&guistate.regs);
-    guistate.stack_size = kernel_read_memory((void *)guistate.regs.sp, guistate.stack, sizeof(guistate.stack)) / 4;
+    // The thread stays put between suspends, so a stopped thread costs no reads per frame.
+    if (!guistate.stack_valid || guistate.stack_generation != suspend_generation)
+        take_stack_snapshot();
+    fetch_stack_rows(guistate.stack_scroll, stack_panel_rows());
+}
+
+static int target_read(uint32_t addr, void *dst, uint32_t size)
+{
+    return kernel_read_memory((void *)addr, dst, size);
+}
+
+static uint32_t target_skip(uint32_t addr)
+{
+    const RegionIndex *ri = kernel_get_regions();
+    if (!ri->valid)
+        return addr;
+    const MemRegion *region = regions_next(ri, addr);
+    if (!region)
+        return 0xFFFFFFFF;
+    return (region->base > addr) ? region->base : addr;
+}
+
+// Moves an address that fell into a gap between memblocks to the nearest mapped row in the direction of travel.
+static uint32_t skip_unmapped(uint32_t addr, bool down)
+{
+    const RegionIndex *ri = kernel_get_regions();
+    if (!ri->valid || regions_find(ri, addr))
+        return addr;
+    const MemRegion *region = down ? regions_next(ri, addr) : regions_prev(ri, addr);
+    if (!region)
+        return addr;
+    return down ? region->base : region->base + region->size - row_bytes();
+}
+
+static void update_memory_bounds(void)
+{
+    const RegionIndex *ri = kernel_get_regions();
+    if (kernel_refresh_regions() > 0)
+    {
+        lowest_vaddr = ri->regions[0].base;
+        highest_vaddr = ri->regions[ri->count - 1].base + ri->regions[ri->count - 1].size;
+        return;
+    }
+
+    // No index, fall back to the main module's segments.
+    for (int i = 0; i < 4; ++i)
+    {
+        if (guistate.modinfo.segments[i].vaddr && guistate.modinfo.segments[i].memsz > 0)
+        {
+            uint32_t seg_start = (uint32_t)guistate.modinfo.segments[i].vaddr;
+            uint32_t seg_end = seg_start + guistate.modinfo.segments[i].memsz;
 
-    guistate.callstack_size = MAX_CALL_STACK_DEPTH;
-    kernel_get_callstack(guistate.callstack, guistate.callstack_size);
+            if (seg_start > 0 && seg_start < lowest_vaddr)
+                lowest_vaddr = seg_start;
+            if (seg_end > highest_vaddr)
+                highest_vaddr = seg_end;
+        }
+    }
 }
 
 static void read_memview_cache(void)
@@ -165,8 +368,13 @@ static void read_memview_cache(void)
     if (!cache_dirty)
         return;
 
-    if (kernel_read_memory((void *)guistate.base_addr, guistate.cached_mem, sizeof(guistate.cached_mem)) < 0)
-        memset(guistate.cached_mem, 0xFF, sizeof(guistate.cached_mem));
+    frametime_begin(&frametimer, FT_MEMREAD);
+    uint64_t now = ksceKernelGetSystemTimeWide();
+    memcache_read(&viewcache, guistate.base_addr, guistate.cached_mem, sizeof(guistate.cached_mem), now);
+    // Keep the pages around the window warm so scrolling and auto-repeat stay in memory.
+    memcache_prefetch(&viewcache, guistate.base_addr - MEMCACHE_PAGE_SIZE, now);
+    memcache_prefetch(&viewcache, guistate.base_addr + sizeof(guistate.cached_mem) - 1 + MEMCACHE_PAGE_SIZE, now);
+    frametime_end(&frametimer, FT_MEMREAD);
 
     cache_dirty = false;
 }
@@ -206,15 +414,36 @@ static void draw_hex_row_highlight(int ypos, int hex_chars)
     renderer_drawRectangle(2 + underline_x, underline_y, underline_w, 1, 0xFFFFFFFF);
 }
 
-static void draw_hex_row(uint32_t addr, const uint8_t *data)
+static uint32_t cursor_signature(uint32_t sig)
 {
-    if (addr < guistate.base_addr || addr >= guistate.base_addr + sizeof(guistate.cached_mem))
-        return;
+    const int cursor[] = {guistate.edit_mode, guistate.edit_offset, guistate.cursor_column,
+                          guistate.active_area == MEMVIEW_HEX};
+    sig = renderer_hash(sig, cursor, sizeof(cursor));
+    sig = renderer_hash(sig, &guistate.modified_addr, sizeof(guistate.modified_addr));
+    return renderer_hash(sig, guistate.modified_value, sizeof(guistate.modified_value));
+}
 
-    const int ypos = 10 + ((addr - guistate.base_addr) / 8) * FONT_HEIGHT;
-    const bool is_selected_row = (addr == guistate.addr);
+static uint32_t hex_row_signature(uint32_t addr, const uint8_t *data, bool is_selected_row, uint8_t bp_mask)
+{
+    uint32_t sig = renderer_hash(hex_panel_sig, &addr, sizeof(addr));
+    sig = renderer_hash(sig, &bp_mask, sizeof(bp_mask));
+    if (data)
+        sig = renderer_hash(sig, data, 8);
+    return is_selected_row ? cursor_signature(sig) : sig;
+}
+
+// Text is a function of address, mode and encoding, so those stand in for it.
+static uint32_t disasm_row_signature(uint32_t addr, const uint8_t *data, const DisasmLine *line, bool is_selected_row,
+                                     bool has_bp)
+{
+    const uint32_t key[] = {addr, line ? line->raw : 0, line ? line->size : 0, has_bp};
+    uint32_t sig = renderer_hash(hex_panel_sig, key, sizeof(key));
+    sig = renderer_hash(sig, data, row_bytes());
+    return is_selected_row ? cursor_signature(sig) : sig;
+}
 
-    // Draw address
+static void draw_row_address(uint32_t addr, bool is_selected_row, int ypos)
+{
     char addr_str[9];
     uint32_t temp_addr = (is_selected_row && guistate.edit_mode == EDIT_ADDRESS) ? guistate.modified_addr : addr;
 
@@ -225,19 +454,40 @@ static void draw_hex_row(uint32_t addr, const uint8_t *data)
     }
     addr_str[8] = '\0';
     renderer_drawString(1, ypos, addr_str);
+}
 
-    if (!data)
-    {
-        renderer_drawString(2 + 8 * FONT_WIDTH, ypos, " Read Error");
-        renderer_drawString(2 + (10 + 10) * FONT_WIDTH, ypos, "........");
-        return;
-    }
+static bool draw_hex_row(uint32_t addr, const uint8_t *data, int hex_width)
+{
+    if (addr < guistate.base_addr || addr >= guistate.base_addr + sizeof(guistate.cached_mem))
+        return false;
+
+    const uint32_t row = (addr - guistate.base_addr) / 8;
+    const int ypos = 10 + row * FONT_HEIGHT;
+    const bool is_selected_row = (addr == guistate.addr);
 
     const MemLayoutInfo *layout = &layout_info[guistate.mem_layout];
     const int bytes_per_value = layout->bytes;
     const int values_per_row = 8 / bytes_per_value;
     const int hex_chars = bytes_per_value * 2;
 
+    uint8_t bp_mask = 0;
+    for (int i = 0; i < values_per_row; i++)
+        if (kernel_get_breakpoint_index(addr + i * bytes_per_value) >= 0)
+            bp_mask |= 1 << i;
+
+    if (!renderer_regionChanged(REGION_HEX_ROWS + row, hex_row_signature(addr, data, is_selected_row, bp_mask)))
+        return false;
+    renderer_clearRectangle(1, ypos, hex_width - 1, FONT_HEIGHT);
+
+    draw_row_address(addr, is_selected_row, ypos);
+
+    if (!data)
+    {
+        renderer_drawString(2 + 8 * FONT_WIDTH, ypos, " Read Error");
+        renderer_drawString(2 + (10 + 10) * FONT_WIDTH, ypos, "........");
+        return true;
+    }
+
     // Prepare hex and ASCII
     char hex_str[28];
     hex_str[0] = ' ';
@@ -248,10 +498,8 @@ static void draw_hex_row(uint32_t addr, const uint8_t *data)
     for (int i = 0; i < values_per_row; i++)
     {
         const bool is_edited = is_selected_row && guistate.edit_mode == EDIT_VALUE && guistate.cursor_column - 1 == i;
-        uint32_t value_addr = addr + i * bytes_per_value;
-
         // Highlight breakpoints
-        if (kernel_get_breakpoint_index(value_addr) >= 0)
+        if (bp_mask & (1 << i))
             renderer_drawRectangle(2 + (9 + i * (hex_chars + 1)) * FONT_WIDTH, ypos, hex_chars * FONT_WIDTH,
                                    FONT_HEIGHT, 0xFF0000FF);
 
@@ -284,6 +532,55 @@ static void draw_hex_row(uint32_t addr, const uint8_t *data)
     // Draw cursor for current row
     if (is_selected_row && guistate.active_area == MEMVIEW_HEX)
         draw_hex_row_highlight(ypos, hex_chars);
+    return true;
+}
+
+// One instruction slot: address, encoding in memory order, then the instruction. Rows covered by the second half of a
+// 32-bit Thumb instruction have no line and only show their bytes.
+static bool draw_disasm_row(uint32_t addr, const uint8_t *data, const DisasmLine *line)
+{
+    const uint32_t row = (addr - guistate.base_addr) / row_bytes();
+    const int ypos = 10 + row * FONT_HEIGHT;
+    const bool is_selected_row = (addr == guistate.addr);
+    const bool has_bp = kernel_get_breakpoint_index(addr) >= 0;
+    const int bytes = value_bytes();
+
+    if (!renderer_regionChanged(REGION_HEX_ROWS + row,
+                                disasm_row_signature(addr, data, line, is_selected_row, has_bp)))
+        return false;
+    renderer_clearRectangle(1, ypos, HEX_PANEL_MAX_WIDTH - 1, FONT_HEIGHT);
+    draw_row_address(addr, is_selected_row, ypos);
+
+    const uint32_t size = line ? line->size : row_bytes();
+    if (has_bp)
+        renderer_drawRectangle(2 + 9 * FONT_WIDTH, ypos, size * 2 * FONT_WIDTH, FONT_HEIGHT, 0xFF0000FF);
+
+    // Space, 8 encoding digits, space, then as much of the text as fits the panel
+    char text[HEX_PANEL_MAX_WIDTH / FONT_WIDTH - 8 + 1];
+    memset(text, ' ', 10);
+    const bool is_edited = is_selected_row && guistate.edit_mode == EDIT_VALUE;
+    for (uint32_t i = 0; i < size; i++)
+    {
+        const uint8_t value = (is_edited && (int)i < bytes) ? guistate.modified_value[i] : data[i];
+        text[1 + i * 2] = nibble_to_hex(value >> 4);
+        text[2 + i * 2] = nibble_to_hex(value & 0xF);
+    }
+    text[10] = '\0';
+    if (line)
+        strncpy(text + 10, line->text, sizeof(text) - 11);
+    text[sizeof(text) - 1] = '\0';
+    renderer_drawString(2 + 8 * FONT_WIDTH, ypos, text);
+
+    if (is_selected_row && guistate.active_area == MEMVIEW_HEX)
+        draw_hex_row_highlight(ypos, bytes * 2);
+    return true;
+}
+
+// Module and export an address falls in, "" when it is in no module. Only called while a panel is redrawn.
+static const char *address_symbol(uint32_t addr)
+{
+    static char text[SYMBOL_TEXT_MAX];
+    return symbols_format(kernel_get_symbols(), addr, text, sizeof(text)) ? text : "";
 }
 
 static void draw_registers(int x, int y)
@@ -293,7 +590,8 @@ static void draw_registers(int x, int y)
 
     uint32_t *reg_ptr = (uint32_t *)&guistate.regs;
     for (int i = 0; i < 16; i++, y += FONT_HEIGHT)
-        renderer_drawStringF(x, y, (i >= 10 && i <= 12) ? "%s:%08X" : "%-3s: %08X", reg_names[i], reg_ptr[i]);
+        renderer_drawStringF(x, y, (i >= 10 && i <= 12) ? "%s:%08X %s" : "%-3s: %08X %s", reg_names[i], reg_ptr[i],
+                             address_symbol(reg_ptr[i]));
 }
 
 static void handle_area_selection(uint32_t released)
@@ -315,8 +613,52 @@ static void handle_area_selection(uint32_t released)
     }
 }
 
+// Thread list rows: up/down pick a thread, confirm shows and steps it, triangle resumes it alone.
+static bool handle_thread_list(uint32_t released)
+{
+    const ThreadTable *threads = kernel_get_threads();
+    SceUID ids[THREAD_TABLE_SIZE];
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < THREAD_TABLE_SIZE; ++i)
+    {
+        ThreadEntry e;
+        if (threads_snapshot(threads, i, &e))
+            ids[count++] = e.thid;
+    }
+
+    if ((released & SCE_CTRL_UP) && guistate.thread_cursor > 0)
+        guistate.thread_cursor--;
+    else if ((released & SCE_CTRL_DOWN) && guistate.thread_cursor + 1 < count)
+        guistate.thread_cursor++;
+    else if ((released & guistate.hotkeys.confirm) && guistate.thread_cursor < count)
+        kernel_select_thread(ids[guistate.thread_cursor]);
+    else if ((released & SCE_CTRL_TRIANGLE) && guistate.thread_cursor < count)
+        kernel_resume_thread(ids[guistate.thread_cursor]);
+    else
+        return false;
+    return true;
+}
+
 static void handle_memview_stack(uint32_t released)
 {
+    if (guistate.view_state == VIEW_STACK && (released & (SCE_CTRL_UP | SCE_CTRL_DOWN)))
+    {
+        // Rows past the pages read so far are fetched by the next update_memview_state.
+        if (released & SCE_CTRL_DOWN)
+        {
+            if (guistate.stack_scroll + stack_panel_rows() < guistate.stack_size)
+                guistate.stack_scroll++;
+        }
+        else if (guistate.stack_scroll > 0)
+            guistate.stack_scroll--;
+        else
+            guistate.active_area = MEMVIEW_REGS;
+        return;
+    }
+
+    if (guistate.view_state == VIEW_THREADS && handle_thread_list(released))
+        return;
+
     if (released & SCE_CTRL_UP)
     {
         guistate.active_area = MEMVIEW_REGS;
@@ -324,9 +666,9 @@ static void handle_memview_stack(uint32_t released)
     }
 
     if (released & (SCE_CTRL_RIGHT | SCE_CTRL_RTRIGGER))
-        guistate.view_state = (guistate.view_state + 1) % 3;
+        guistate.view_state = (guistate.view_state + 1) % VIEW_COUNT;
     else if (released & (SCE_CTRL_LEFT | SCE_CTRL_LTRIGGER))
-        guistate.view_state = (guistate.view_state + 2) % 3;
+        guistate.view_state = (guistate.view_state + VIEW_COUNT - 1) % VIEW_COUNT;
 }
 
 static void handle_breakpoint_toggle(uint32_t released, uint32_t address)
@@ -383,6 +725,7 @@ static void change_nibble_value(bool increase, int byte_idx, int shift, uint8_t
 static bool handle_memview_navigation(uint32_t released, int values_per_row)
 {
     bool needs_reread = false;
+    const uint32_t stride = row_bytes();
 
     // Horizontal movement
     if (released & SCE_CTRL_RIGHT && guistate.cursor_column < values_per_row)
@@ -393,17 +736,17 @@ static bool handle_memview_navigation(uint32_t released, int values_per_row)
     // Vertical movement
     if (released & SCE_CTRL_DOWN)
     {
-        if (guistate.addr + 8 <= highest_vaddr)
+        if (guistate.addr + stride <= highest_vaddr)
         {
-            guistate.addr += 8;
+            guistate.addr = skip_unmapped(guistate.addr + stride, true);
 
             const int visible_lines = (UI_HEIGHT - FONT_HEIGHT) / FONT_HEIGHT;
-            uint32_t last_visible = guistate.base_addr + (visible_lines - 1) * 8;
+            uint32_t last_visible = guistate.base_addr + (visible_lines - 1) * stride;
 
             if (guistate.addr > last_visible)
             {
-                guistate.base_addr = (guistate.addr - (visible_lines / 2) * 8) & ~7;
-                guistate.base_addr = CLAMP(guistate.base_addr, lowest_vaddr, highest_vaddr - visible_lines * 8);
+                guistate.base_addr = (guistate.addr - (visible_lines / 2) * stride) & ~(stride - 1);
+                guistate.base_addr = CLAMP(guistate.base_addr, lowest_vaddr, highest_vaddr - visible_lines * stride);
                 needs_reread = true;
             }
         }
@@ -412,11 +755,12 @@ static bool handle_memview_navigation(uint32_t released, int values_per_row)
     {
         if (guistate.addr > lowest_vaddr)
         {
-            guistate.addr -= 8;
+            guistate.addr = skip_unmapped(guistate.addr - stride, false);
 
             if (guistate.addr < guistate.base_addr)
             {
-                guistate.base_addr = (guistate.addr - (UI_HEIGHT - FONT_HEIGHT) / (2 * FONT_HEIGHT) * 8) & ~7;
+                guistate.base_addr =
+                    (guistate.addr - (UI_HEIGHT - FONT_HEIGHT) / (2 * FONT_HEIGHT) * stride) & ~(stride - 1);
                 guistate.base_addr = CLAMP(guistate.base_addr, lowest_vaddr, highest_vaddr);
                 needs_reread = true;
             }
@@ -471,7 +815,7 @@ static bool handle_memview_confirm(int bytes)
     if (guistate.edit_mode == EDIT_ADDRESS)
     {
         guistate.addr = CLAMP(guistate.modified_addr, lowest_vaddr, highest_vaddr);
-        guistate.base_addr = guistate.addr & ~7;
+        guistate.base_addr = guistate.addr & ~(row_bytes() - 1);
         guistate.edit_mode = EDIT_NONE;
         cache_dirty = true;
         return true;
@@ -479,6 +823,7 @@ static bool handle_memview_confirm(int bytes)
     else if (bytes)
     {
         kernel_write_memory(guistate.modified_addr, guistate.modified_value, bytes);
+        memcache_invalidate_range(&viewcache, guistate.modified_addr, bytes);
         guistate.edit_mode = EDIT_NONE;
         cache_dirty = true;
         return true;
@@ -497,12 +842,22 @@ static void handle_memview_input(uint32_t released, uint32_t current)
         return;
     }
 
-    // Single step
+    // Single step, step over, step out
     if (released == (SCE_CTRL_START | SCE_CTRL_RTRIGGER))
     {
         kernel_single_step();
         return;
     }
+    if (released == (SCE_CTRL_START | SCE_CTRL_SQUARE))
+    {
+        kernel_step_over();
+        return;
+    }
+    if (released == (SCE_CTRL_START | SCE_CTRL_TRIANGLE))
+    {
+        kernel_step_out();
+        return;
+    }
 
     // Handle other areas first
     if (guistate.active_area == MEMVIEW_REGS)
@@ -519,11 +874,17 @@ static void handle_memview_input(uint32_t released, uint32_t current)
     }
 
     // Handle hex view
-    const MemLayoutInfo *layout = &layout_info[guistate.mem_layout];
-    const int bytes = layout->bytes;
-    const int values_per_row = 8 / bytes;
+    int bytes = value_bytes();
+    int values_per_row = row_bytes() / bytes;
     bool needs_reread = false;
 
+    // Run to cursor
+    if (released == (SCE_CTRL_START | SCE_CTRL_CROSS) && guistate.edit_mode == EDIT_NONE && guistate.cursor_column > 0)
+    {
+        kernel_run_to(guistate.addr + (guistate.cursor_column - 1) * bytes);
+        return;
+    }
+
     // Handle breakpoint toggling
     if ((released & (SCE_CTRL_TRIANGLE | SCE_CTRL_SQUARE)) && guistate.edit_mode == EDIT_NONE &&
         guistate.cursor_column > 0)
@@ -535,16 +896,13 @@ static void handle_memview_input(uint32_t released, uint32_t current)
     }
 
     // Handle layout change
-    if (released & SCE_CTRL_LTRIGGER)
-    {
-        guistate.mem_layout = (guistate.mem_layout + 1) % 3;
-        if (guistate.cursor_column > values_per_row)
-            guistate.cursor_column = values_per_row;
-        needs_reread = true;
-    }
-    else if (released & SCE_CTRL_RTRIGGER)
+    if (released & (SCE_CTRL_LTRIGGER | SCE_CTRL_RTRIGGER))
     {
-        guistate.mem_layout = (guistate.mem_layout + 2) % 3;
+        const int step = (released & SCE_CTRL_LTRIGGER) ? 1 : MEM_LAYOUT_COUNT - 1;
+        guistate.mem_layout = (guistate.mem_layout + step) % MEM_LAYOUT_COUNT;
+        align_view();
+        bytes = value_bytes();
+        values_per_row = row_bytes() / bytes;
         if (guistate.cursor_column > values_per_row)
             guistate.cursor_column = values_per_row;
         needs_reread = true;
@@ -583,95 +941,208 @@ static void draw_memview_contents(void)
     const int bytes_per_value = layout->bytes;
     const int values_per_row = 8 / bytes_per_value;
     const int hex_chars = bytes_per_value * 2;
-    int hex_width = (8 + 1 + values_per_row * (hex_chars + 1) + 1 + 8) * FONT_WIDTH;
+    const bool disasm = guistate.mem_layout == MEM_LAYOUT_DISASM;
+    int hex_width = disasm ? HEX_PANEL_MAX_WIDTH : (8 + 1 + values_per_row * (hex_chars + 1) + 1 + 8) * FONT_WIDTH;
+    const bool active = guistate.active_area == MEMVIEW_HEX;
 
-    // Draw frame
-    if (guistate.active_area == MEMVIEW_HEX)
-    {
-        renderer_drawRectangle(0, 10, hex_width, visible_lines * FONT_HEIGHT, 0x80171717);
-        draw_frame(0, 10, hex_width, visible_lines * FONT_HEIGHT, 0xFFFF64AA);
-    }
+    // A breakpoint hit can switch the disassembly between ARM and Thumb rows.
+    align_view();
+
+    // Layout or focus changes repaint the whole panel; rows key their signatures off it.
+    const int panel_key[] = {guistate.mem_layout, active, row_bytes()};
+    hex_panel_sig = renderer_hash(0, panel_key, sizeof(panel_key));
+    bool redrawn = renderer_regionChanged(REGION_HEX_PANEL, hex_panel_sig);
+    if (redrawn)
+        renderer_clearRectangle(0, 10, HEX_PANEL_MAX_WIDTH + 1, visible_lines * FONT_HEIGHT + 1);
 
     renderer_setColor(0xFFFFFFFF);
     read_memview_cache();
 
+    // Disassembly decodes only the visible rows, in order, so 32-bit Thumb instructions claim the row after them.
+    if (disasm)
+    {
+        const bool thumb = disasm_thumb();
+        const uint32_t stride = row_bytes(), end = guistate.base_addr + sizeof(guistate.cached_mem);
+        uint32_t next = guistate.base_addr;
+        for (int i = 0; i < visible_lines; i++)
+        {
+            const uint32_t line_addr = guistate.base_addr + i * stride;
+            if (line_addr >= end)
+                break;
+            const uint8_t *data_ptr = guistate.cached_mem + (line_addr - guistate.base_addr);
+            const DisasmLine *line = NULL;
+            if (line_addr >= next)
+            {
+                line = disasm_line(&disasm_cache, line_addr, data_ptr, end - line_addr, thumb);
+                next = line_addr + (line ? line->size : stride);
+            }
+            redrawn |= draw_disasm_row(line_addr, data_ptr, line);
+        }
+    }
+
     // Draw memory rows
-    for (int i = 0; i < visible_lines; i++)
+    for (int i = 0; !disasm && i < visible_lines; i++)
     {
         const uint32_t line_addr = guistate.base_addr + i * 8;
         if (line_addr < guistate.base_addr + sizeof(guistate.cached_mem))
         {
             const uint8_t *data_ptr = guistate.cached_mem + (line_addr - guistate.base_addr);
-            draw_hex_row(line_addr, data_ptr);
+            redrawn |= draw_hex_row(line_addr, data_ptr, hex_width);
         }
     }
+
+    // Row repaints can cut into the frame, so redraw it whenever anything underneath changed.
+    if (redrawn && active)
+        draw_frame(0, 10, hex_width, visible_lines * FONT_HEIGHT, 0xFFFF64AA);
+}
+
+static void draw_thread_list(int x, int y, uint32_t max_items)
+{
+    static const char *reasons[] = {"RUN", "BKPT", "STEP", "PARK"};
+    const ThreadTable *threads = kernel_get_threads();
+    const uint32_t first = (guistate.thread_cursor >= max_items) ? guistate.thread_cursor - max_items + 1 : 0;
+    for (uint32_t i = 0, row = 0; i < THREAD_TABLE_SIZE && row < first + max_items; ++i)
+    {
+        ThreadEntry e;
+        if (!threads_snapshot(threads, i, &e) || row++ < first)
+            continue;
+        // '>' marks the row the buttons act on, '*' the thread the other panels show.
+        const bool cursor = guistate.active_area == MEMVIEW_STACK && row - 1 == guistate.thread_cursor;
+        renderer_drawStringF(x, y, "%c%c%08X %-4s %08X %s", cursor ? '>' : ' ',
+                             (e.thid == g_target_process.exception_thid) ? '*' : ' ', e.thid,
+                             (e.reason <= THREAD_PARKED) ? reasons[e.reason] : "?", e.regs[15],
+                             kernel_owns_step(e.thid) ? "step" : address_symbol(e.regs[15]));
+        y += FONT_HEIGHT;
+    }
 }
 
 static void draw_stack_panel(int x, int y, int width, int height)
 {
-    renderer_drawRectangle(x - 3, y - 3, width, height, 0x80000000);
+    renderer_blendRectangle(x - 3, y - 3, width, height, 0x80000000);
     if (guistate.active_area == MEMVIEW_STACK)
         draw_frame(x - 3, y - 3, width, height, 0xFFFF64AA);
 
-    static const char *view_titles[] = {"Stack:", "Callstack:", "Breakpoints:"};
+    static const char *view_titles[] = {"Stack:", "Callstack:", "Breakpoints:", "Threads:"};
     renderer_setColor(0xFFFFFFFF);
     renderer_drawString(x, y, view_titles[guistate.view_state]);
 
     y += FONT_HEIGHT;
-    const uint32_t max_items = (guistate.active_area == MEMVIEW_STACK) ? 16 : 3;
+    const uint32_t max_items = stack_panel_rows();
 
     switch (guistate.view_state)
     {
     case VIEW_STACK:
-        for (uint32_t i = 0; i < guistate.stack_size && i < max_items; i++, y += FONT_HEIGHT)
+        for (uint32_t i = guistate.stack_scroll; i < guistate.stack_size && i < guistate.stack_scroll + max_items;
+             i++, y += FONT_HEIGHT)
+        {
+            if (!(guistate.stack_pages & (1u << (i / STACK_PAGE_WORDS))))
+                break;
             renderer_drawStringF(x, y, "%08X:%08X", guistate.regs.sp + i * 4, guistate.stack[i]);
+        }
         break;
 
     case VIEW_CALLSTACK:
         for (uint32_t i = 0; i < guistate.callstack_size && i < max_items; i++, y += FONT_HEIGHT)
-            renderer_drawStringF(x, y, "[%d] %08X", i, guistate.callstack[i]);
+            renderer_drawStringF(x, y, "[%d] %08X %s", i, guistate.callstack[i], address_symbol(guistate.callstack[i]));
         break;
 
     case VIEW_BREAKPOINTS:
-        for (uint8_t i = 0, count = 0; i < MAX_SLOT && count < max_items; i++)
+        for (int i = kernel_next_breakpoint(-1), count = 0; i >= 0 && count < (int)max_items;
+             i = kernel_next_breakpoint(i))
         {
-            ActiveBKPTSlot *bp = &guistate.breakpoints[i];
-            if (bp->type != SLOT_NONE && bp->pid == g_target_process.pid)
+            const ActiveBKPTSlot *bp = kernel_get_breakpoint(i);
+            if (bp->pid == g_target_process.pid)
             {
                 if (guistate.active_area == MEMVIEW_STACK)
                 {
                     const char *type_str = (bp->type <= SINGLE_STEP_HW_BREAKPOINT) ? bp_types[bp->type] : "?";
-                    renderer_drawStringF(x, y, "[%d]%s@%08X", i, type_str, bp->address);
+                    renderer_drawStringF(x, y, "[%d]%s@%08X x%u %uus", i, type_str, bp->address, bp->hits,
+                                         bp->latency_us);
                 }
                 else
-                    renderer_drawStringF(x, y, "[%d]@%08X", i, bp->address);
+                    renderer_drawStringF(x, y, "[%d]@%08X x%u %s", i, bp->address, bp->hits,
+                                         address_symbol(bp->address));
 
                 y += FONT_HEIGHT;
                 count++;
             }
         }
         break;
+
+    case VIEW_THREADS:
+        draw_thread_list(x, y, max_items);
+        break;
+
+    default:
+        break;
+    }
+}
+
+static uint32_t right_panel_signature(void)
+{
+    const int layout[] = {guistate.has_active_bp, guistate.active_area, guistate.view_state, g_target_process.pid,
+                          kernel_get_symbols()->signature};
+    uint32_t sig = renderer_hash(0, layout, sizeof(layout));
+    if (!guistate.has_active_bp)
+        return sig;
+    sig = renderer_hash(sig, &guistate.regs, sizeof(guistate.regs));
+    switch (guistate.view_state)
+    {
+    case VIEW_STACK:
+    {
+        // The words shown only change with a new snapshot or a scroll.
+        const uint32_t snapshot[] = {guistate.stack_generation, guistate.stack_scroll, guistate.stack_size,
+                                     guistate.stack_pages};
+        sig = renderer_hash(sig, snapshot, sizeof(snapshot));
+        break;
+    }
+    case VIEW_CALLSTACK:
+        sig = renderer_hash(sig, &guistate.callstack_size, sizeof(guistate.callstack_size));
+        sig = renderer_hash(sig, guistate.callstack, sizeof(guistate.callstack));
+        break;
+    case VIEW_THREADS:
+    {
+        const uint32_t threads[] = {kernel_get_threads()->generation, guistate.thread_cursor,
+                                    g_target_process.exception_thid};
+        sig = renderer_hash(sig, threads, sizeof(threads));
+        break;
+    }
+    case VIEW_BREAKPOINTS:
+    {
+        const uint32_t counters[] = {kernel_breakpoint_generation(), kernel_total_hits()};
+        sig = renderer_hash(sig, guistate.breakpoints, sizeof(guistate.breakpoints));
+        sig = renderer_hash(sig, counters, sizeof(counters));
+        break;
+    }
+    default:
+        break;
     }
+    return sig;
 }
 
-static void draw_right_panel(void)
+static bool draw_right_panel(void)
 {
     int right_panel_x = 550;
     int right_panel_y = 10;
 
+    if (!renderer_regionChanged(REGION_RIGHT_PANEL, right_panel_signature()))
+        return false;
+    renderer_clearRectangle(RIGHT_PANEL_X, 0, UI_WIDTH - RIGHT_PANEL_X, UI_HEIGHT);
+
     if (!guistate.has_active_bp)
     {
         renderer_setColor(0xFFFFFFFF);
         renderer_drawString(right_panel_x, right_panel_y, "Debugger Inactive");
-        renderer_drawString(right_panel_x, right_panel_y + 20, "(No Breakpoint Created...)");
-        return;
+        renderer_setColor(0xA0FFFFFF);
+        renderer_drawStringBlend(right_panel_x, right_panel_y + 20, "(No Breakpoint Created...)");
+        return true;
     }
 
     // Draw registers panel
     int highlight_y = (guistate.active_area == MEMVIEW_REGS) ? right_panel_y : right_panel_y + FONT_HEIGHT;
     int highlight_h = 17 * FONT_HEIGHT;
 
-    renderer_drawRectangle(right_panel_x - 3, highlight_y - 3, 400, highlight_h,
+    renderer_blendRectangle(right_panel_x - 3, highlight_y - 3, 400, highlight_h,
                            (guistate.active_area == MEMVIEW_REGS || guistate.active_area == MEMVIEW_STACK) ? 0x40171717
                                                                                                            : 0);
 
@@ -703,39 +1174,157 @@ static void draw_right_panel(void)
     // Draw stack/callstack/breakpoints panel
     right_panel_y += (guistate.active_area == MEMVIEW_REGS ? 17 : 7) * FONT_HEIGHT + 10;
     draw_stack_panel(right_panel_x, right_panel_y, 400, 17 * FONT_HEIGHT);
+    return true;
 }
 
 static void find_next_breakpoint(bool up)
 {
-    uint8_t original = guistate.edit_feature;
-    uint8_t next = original;
+    int next = up ? kernel_prev_breakpoint(guistate.edit_feature) : kernel_next_breakpoint(guistate.edit_feature);
+    if (next < 0)
+        next = up ? kernel_prev_breakpoint(-1) : kernel_next_breakpoint(-1);
+    if (next >= 0)
+        guistate.edit_feature = next;
+}
 
-    do
+// Fills ids with the list page holding the selection and returns how many there are on it.
+static int breakpoint_list_page(int *ids, int *page, int *pages)
+{
+    int total = 0, selected = -1;
+    for (int id = kernel_next_breakpoint(-1); id >= 0; id = kernel_next_breakpoint(id), total++)
+        if (id == (int)guistate.edit_feature)
+            selected = total;
+    if (selected < 0)
     {
-        next = up ? (next - 1 + MAX_SLOT) % MAX_SLOT : (next + 1) % MAX_SLOT;
-        if (next == original)
-            break;
-    } while (guistate.breakpoints[next].type == SLOT_NONE);
+        selected = 0;
+        guistate.edit_feature = (total > 0) ? kernel_next_breakpoint(-1) : 0;
+    }
+
+    *page = selected / BKPT_PAGE_LINES;
+    *pages = (total + BKPT_PAGE_LINES - 1) / BKPT_PAGE_LINES;
+    int count = 0, ordinal = 0;
+    for (int id = kernel_next_breakpoint(-1); id >= 0 && count < BKPT_PAGE_LINES; id = kernel_next_breakpoint(id))
+        if (ordinal++ >= *page * BKPT_PAGE_LINES)
+            ids[count++] = id;
+    return count;
+}
+
+static void start_condition_edit(bool trace)
+{
+    const char *text = trace ? kernel_get_tracepoint(guistate.edit_feature)
+                             : kernel_get_breakpoint_condition(guistate.edit_feature);
+    strcpy(cond_text, text ? text : trace ? "r0 r1 r2 r3 lr" : "r0 == 0");
+    cond_cursor = 0;
+    cond_editing = true;
+    cond_error = false;
+    cond_trace = trace;
+}
+
+static void handle_condition_input(uint32_t released)
+{
+    static const char cond_chars[] = " r0123456789abcdefxhilpst[]()=!<>&|+-^~";
+    const int count = sizeof(cond_chars) - 1;
+    int len = strlen(cond_text);
+
+    if (released & guistate.hotkeys.confirm)
+    {
+        // Trailing spaces come from growing the text; an all-blank condition removes it.
+        while (len > 0 && cond_text[len - 1] == ' ')
+            cond_text[--len] = '\0';
+        cond_error = (cond_trace ? kernel_set_tracepoint(guistate.edit_feature, cond_text)
+                                 : kernel_set_breakpoint_condition(guistate.edit_feature, cond_text)) < 0;
+        cond_editing = cond_error;
+        return;
+    }
+    if (released & (SCE_CTRL_LTRIGGER | SCE_CTRL_RTRIGGER))
+    {
+        start_condition_edit(!cond_trace);
+        return;
+    }
+
+    if ((released & SCE_CTRL_LEFT) && cond_cursor > 0)
+        cond_cursor--;
+    else if ((released & SCE_CTRL_RIGHT) && cond_cursor < COND_TEXT_MAX - 1)
+    {
+        if (++cond_cursor >= len)
+        {
+            cond_text[len] = ' ';
+            cond_text[len + 1] = '\0';
+        }
+    }
+    else if ((released & SCE_CTRL_SQUARE) && len > 0)
+    {
+        memmove(&cond_text[cond_cursor], &cond_text[cond_cursor + 1], len - cond_cursor);
+        if (cond_cursor > 0 && cond_cursor >= len - 1)
+            cond_cursor--;
+    }
 
-    guistate.edit_feature = next;
+    if (released & (SCE_CTRL_UP | SCE_CTRL_DOWN))
+    {
+        if (cond_cursor >= len)
+        {
+            cond_text[len] = ' ';
+            cond_text[len + 1] = '\0';
+        }
+        char *c = &cond_text[cond_cursor];
+        const char *pos = strchr(cond_chars, *c);
+        const int idx = pos ? pos - cond_chars : 0;
+        *c = cond_chars[(idx + ((released & SCE_CTRL_UP) ? 1 : count - 1)) % count];
+    }
 }
 
 static void handle_breakpoint_list_input(uint32_t released)
 {
+    if (cond_editing)
+    {
+        handle_condition_input(released);
+        return;
+    }
+
     if (released & SCE_CTRL_UP)
         find_next_breakpoint(true);
     else if (released & SCE_CTRL_DOWN)
         find_next_breakpoint(false);
+    else if (released & (SCE_CTRL_LTRIGGER | SCE_CTRL_RTRIGGER))
+    {
+        const bool up = released & SCE_CTRL_LTRIGGER;
+        for (int i = 0, id = guistate.edit_feature; i < BKPT_PAGE_LINES; ++i)
+        {
+            id = up ? kernel_prev_breakpoint(id) : kernel_next_breakpoint(id);
+            if (id < 0)
+                break;
+            guistate.edit_feature = id;
+        }
+    }
 
     if (released & guistate.hotkeys.confirm)
     {
-        if (guistate.breakpoints[guistate.edit_feature].type != SLOT_NONE)
+        const ActiveBKPTSlot *bp = kernel_get_breakpoint(guistate.edit_feature);
+        if (bp && bp->type != SLOT_NONE)
         {
             kernel_clear_breakpoint(guistate.edit_feature);
             kernel_list_breakpoints(guistate.breakpoints);
             find_next_breakpoint(false);
         }
     }
+    else if (released & SCE_CTRL_TRIANGLE)
+    {
+        const ActiveBKPTSlot *bp = kernel_get_breakpoint(guistate.edit_feature);
+        if (bp && bp->type != SLOT_NONE && bp->type != SINGLE_STEP_HW_BREAKPOINT)
+            start_condition_edit(false);
+    }
+    else if (released & SCE_CTRL_SQUARE)
+    {
+        // Whole page at once; SW breakpoints sharing a code page are restored with a single write.
+        int ids[BKPT_PAGE_LINES], page, pages;
+        const int count = breakpoint_list_page(ids, &page, &pages);
+        if (count > 0)
+        {
+            kernel_clear_breakpoints(ids, count);
+            kernel_list_breakpoints(guistate.breakpoints);
+            guistate.edit_feature = ids[count - 1];
+            find_next_breakpoint(false);
+        }
+    }
 }
 
 static void start_breakpoint_list(void)
@@ -743,17 +1332,10 @@ static void start_breakpoint_list(void)
     guistate.ui_state = UI_FEATURE_LIST_ALL_BKPT;
     guistate.stored_edit_feature = guistate.edit_feature;
     kernel_list_breakpoints(guistate.breakpoints);
+    cond_editing = false;
 
-    // Find first active breakpoint
-    guistate.edit_feature = 0;
-    for (int i = 0; i < MAX_SLOT; i++)
-    {
-        if (guistate.breakpoints[i].type != SLOT_NONE)
-        {
-            guistate.edit_feature = i;
-            break;
-        }
-    }
+    const int first = kernel_next_breakpoint(-1);
+    guistate.edit_feature = (first >= 0) ? first : 0;
 }
 
 static void handle_breakpoint_edit_input(uint32_t released)
@@ -767,7 +1349,7 @@ static void handle_breakpoint_edit_input(uint32_t released)
         else if (guistate.ui_state == UI_FEATURE_WATCH)
             kernel_set_watchpoint(guistate.edit_feature, BREAK_READ_WRITE);
         else if (guistate.ui_state == UI_FEATURE_SW_BREAK)
-            kernel_set_software_breakpoint(guistate.edit_feature, SW_BREAKPOINT_THUMB);
+            kernel_set_software_breakpoint(guistate.edit_feature & ~1, SW_BREAKPOINT_THUMB);
 
         guistate.bkpt_edit_offset = 0;
         return;
@@ -823,7 +1405,385 @@ static void handle_hotkey_config_input(uint32_t released)
     }
 }
 
-static void handle_features_menu_input(uint32_t released)
+static bool search_is_text(void)
+{
+    return search_type >= SEARCH_PATTERN;
+}
+
+static void jump_to_address(uint32_t address)
+{
+    const int bytes = value_bytes();
+    const uint32_t stride = row_bytes();
+    guistate.addr = CLAMP(address & ~(stride - 1), lowest_vaddr, highest_vaddr);
+    guistate.base_addr = guistate.addr;
+    guistate.cursor_column = 1 + (address & (stride - 1)) / bytes;
+    guistate.edit_mode = EDIT_NONE;
+    guistate.active_area = MEMVIEW_HEX;
+    guistate.ui_state = UI_MEMVIEW;
+    cache_dirty = true;
+}
+
+// The narrowing store lives in its own memblock, working buffers and candidates alike; pebbleHeap is too small for it.
+static ScanStore *get_scanstore(void)
+{
+    if (scanstore)
+        return scanstore;
+
+    void *base = NULL;
+    scan_arena_uid = ksceKernelAllocMemBlock("pebble_scan", SCE_KERNEL_MEMBLOCK_TYPE_KERNEL_RW, SCANSTORE_ARENA_SIZE, NULL);
+    if (scan_arena_uid <= 0 || ksceKernelGetMemBlockBase(scan_arena_uid, &base) < 0)
+    {
+        ksceKernelPrintf("Scan arena allocation failed: %#X.\n", scan_arena_uid);
+        if (scan_arena_uid > 0)
+            ksceKernelFreeMemBlock(scan_arena_uid);
+        scan_arena_uid = 0;
+        return NULL;
+    }
+    scanstore = scanstore_create(base, SCANSTORE_ARENA_SIZE);
+    return scanstore;
+}
+
+static uint32_t search_result_count(void)
+{
+    if (search.store)
+        return search.store->narrowing ? 0 : search.store->total;
+    return search.count;
+}
+
+static uint32_t search_result(uint32_t index, uint32_t *value)
+{
+    uint32_t addr = 0;
+    if (search.store)
+        scanstore_get(search.store, index, &addr, value);
+    else
+        addr = search.results[index];
+    return addr;
+}
+
+static void start_search(void)
+{
+    SearchQuery query;
+    int ret;
+    if (search_type == SEARCH_PATTERN)
+        ret = search_query_pattern(&query, search_text);
+    else if (search_is_text())
+        ret = search_query_string(&query, search_text, search_type == SEARCH_UTF16);
+    else
+        ret = search_query_value(&query, search_type, search_value);
+
+    search_error = ret < 0;
+    if (search_error)
+        return;
+
+    // Value searches keep every match so they can be narrowed later.
+    ScanStore *store = (search_type <= SEARCH_FLOAT) ? get_scanstore() : NULL;
+    if (store)
+        scanstore_reset(store, query.length, search_type == SEARCH_FLOAT);
+    update_memory_bounds();
+    search_begin(&search, &query, target_read, target_skip, store, lowest_vaddr, highest_vaddr);
+}
+
+static void start_next_scan(void)
+{
+    if (search.running || !search.store || search.store->narrowing)
+        return;
+    scanstore_narrow_begin(search.store, scan_filter, search_value);
+}
+
+static void search_edit_value(uint32_t released)
+{
+    if (search_is_text())
+    {
+        static const char pattern_chars[] = "0123456789ABCDEF?";
+        int len = strlen(search_text);
+
+        if ((released & SCE_CTRL_LEFT) && search_cursor > 0)
+            search_cursor--;
+        else if ((released & SCE_CTRL_RIGHT) && search_cursor < SEARCH_TEXT_MAX - 1)
+        {
+            // Moving past the end grows the text by repeating the last character.
+            if (++search_cursor >= len)
+            {
+                search_text[len] = search_text[len - 1];
+                search_text[len + 1] = '\0';
+            }
+        }
+        else if ((released & SCE_CTRL_SQUARE) && len > 1)
+        {
+            memmove(&search_text[search_cursor], &search_text[search_cursor + 1], len - search_cursor);
+            if (search_cursor >= len - 1)
+                search_cursor = len - 2;
+        }
+
+        if (released & (SCE_CTRL_UP | SCE_CTRL_DOWN))
+        {
+            char *c = &search_text[search_cursor];
+            const bool up = released & SCE_CTRL_UP;
+            if (search_type == SEARCH_PATTERN)
+            {
+                const char *pos = strchr(pattern_chars, *c);
+                int idx = pos ? pos - pattern_chars : 0;
+                idx = (idx + (up ? 1 : 16)) % 17;
+                *c = pattern_chars[idx];
+            }
+            else
+                *c = 32 + (*c - 32 + (up ? 1 : 94)) % 95;
+        }
+        return;
+    }
+
+    if (released & SCE_CTRL_LEFT)
+        search_cursor = (search_cursor + 1) % 8;
+    else if (released & SCE_CTRL_RIGHT)
+        search_cursor = (search_cursor + 7) % 8;
+
+    if (released & (SCE_CTRL_UP | SCE_CTRL_DOWN))
+    {
+        const int change = (released & SCE_CTRL_UP) ? 1 : 15;
+        const int shift = 4 * search_cursor;
+        const uint32_t mask = 0xF << shift;
+        uint32_t val = (search_value >> shift) & 0xF;
+        val = (val + change) & 0xF;
+        search_value = (search_value & ~mask) | (val << shift);
+    }
+}
+
+static void handle_search_input(uint32_t released)
+{
+    if (guistate.edit_mode == EDIT_VALUE)
+    {
+        if (released & guistate.hotkeys.confirm)
+            guistate.edit_mode = EDIT_NONE;
+        else
+            search_edit_value(released);
+        return;
+    }
+
+    const uint32_t count = search_result_count();
+    const uint32_t rows = SEARCH_ROWS + count;
+    if (released & SCE_CTRL_UP)
+        guistate.edit_feature = (guistate.edit_feature + rows - 1) % rows;
+    else if (released & SCE_CTRL_DOWN)
+        guistate.edit_feature = (guistate.edit_feature + 1) % rows;
+
+    // Page through the results
+    if ((released & SCE_CTRL_RTRIGGER) && count)
+    {
+        uint32_t next = ((guistate.edit_feature < SEARCH_ROWS) ? SEARCH_ROWS : guistate.edit_feature) + SEARCH_PAGE_LINES;
+        guistate.edit_feature = (next < rows) ? next : rows - 1;
+    }
+    else if ((released & SCE_CTRL_LTRIGGER) && guistate.edit_feature >= SEARCH_ROWS)
+        guistate.edit_feature = (guistate.edit_feature >= SEARCH_ROWS + SEARCH_PAGE_LINES)
+                                    ? guistate.edit_feature - SEARCH_PAGE_LINES
+                                    : SEARCH_ROWS;
+
+    switch (guistate.edit_feature)
+    {
+    case 0: // Type
+        if (released & (SCE_CTRL_LEFT | SCE_CTRL_RIGHT))
+        {
+            const bool was_pattern = search_type == SEARCH_PATTERN;
+            search_type = (search_type + ((released & SCE_CTRL_RIGHT) ? 1 : SEARCH_TYPE_COUNT - 1)) % SEARCH_TYPE_COUNT;
+            if (was_pattern != (search_type == SEARCH_PATTERN))
+                strcpy(search_text, search_type == SEARCH_PATTERN ? "00" : "A");
+            search_cursor = 0;
+        }
+        break;
+    case 1: // Value
+        if (released & guistate.hotkeys.confirm)
+            guistate.edit_mode = EDIT_VALUE;
+        break;
+    case 2: // Start
+        if (released & guistate.hotkeys.confirm)
+            start_search();
+        break;
+    case 3: // Next scan
+        if (released & (SCE_CTRL_LEFT | SCE_CTRL_RIGHT))
+            scan_filter = (scan_filter + ((released & SCE_CTRL_RIGHT) ? 1 : SCAN_FILTER_COUNT - 1)) % SCAN_FILTER_COUNT;
+        if (released & guistate.hotkeys.confirm)
+            start_next_scan();
+        break;
+    default: // Result
+        if ((released & guistate.hotkeys.confirm) && guistate.edit_feature - SEARCH_ROWS < count)
+            jump_to_address(search_result(guistate.edit_feature - SEARCH_ROWS, NULL));
+        break;
+    }
+}
+
+static void dump_frame_stats(void)
+{
+    SceUID fd = ksceIoOpen(FRAMESTATS_PATH, SCE_O_WRONLY | SCE_O_CREAT | SCE_O_TRUNC, 0666);
+    if (fd < 0)
+        return;
+
+    char buf[128];
+    const RenderFrameStats *rs = renderer_getFrameStats();
+    int len = snprintf(buf, sizeof(buf), "bytes_written %u regions_redrawn %u blended_pixels %u blend_us %u\n",
+                       rs->bytes_written, rs->regions_redrawn, rs->blended_pixels, rs->blend_us);
+    if (len > 0)
+        ksceIoWrite(fd, buf, len);
+    len = snprintf(buf, sizeof(buf), "memcache hits %u misses %u hit_rate %u%% bytes_per_sec %u\n", viewcache.hits,
+                   viewcache.misses, memcache_hit_rate(&viewcache),
+                   memcache_bytes_per_sec(&viewcache, ksceKernelGetSystemTimeWide()));
+    if (len > 0)
+        ksceIoWrite(fd, buf, len);
+    len = snprintf(buf, sizeof(buf), "disasm hits %u misses %u\n", disasm_cache.hits, disasm_cache.misses);
+    if (len > 0)
+        ksceIoWrite(fd, buf, len);
+
+    // Present and latency samples are recorded by the user module's thread; copy them out under its lock.
+    static FrameTimer timer;
+    if (ksceKernelLockMutex(pebble_mtx_uid, 1, NULL) < 0)
+    {
+        ksceIoClose(fd);
+        return;
+    }
+    memcpy(&timer, &frametimer, sizeof(timer));
+    ksceKernelUnlockMutex(pebble_mtx_uid, 1);
+
+    for (int stage = 0; stage < FT_COUNT; ++stage)
+    {
+        StageStats st;
+        frametime_stats(&timer, stage, &st);
+        len = snprintf(buf, sizeof(buf), "%-8s p50 %u p95 %u max %u n %u us:", stage_names[stage], st.p50, st.p95,
+                       st.max, st.count);
+        if (len > 0)
+            ksceIoWrite(fd, buf, len);
+        for (uint32_t i = 0; i < timer.count[stage]; ++i)
+        {
+            len = snprintf(buf, sizeof(buf), " %u", timer.samples[stage][i]);
+            if (len > 0)
+                ksceIoWrite(fd, buf, len);
+        }
+        ksceIoWrite(fd, "\n", 1);
+    }
+
+    // Handler latency per breakpoint, to compare builds with and without PEBBLE_TRACE.
+    for (int id = kernel_next_breakpoint(-1); id >= 0; id = kernel_next_breakpoint(id))
+    {
+        const ActiveBKPTSlot *bp = kernel_get_breakpoint(id);
+        if (!bp->hits)
+            continue;
+        len = snprintf(buf, sizeof(buf), "bkpt %d @%08X hits %u latency_us %u max %u\n", id, bp->address, bp->hits,
+                       bp->latency_us, bp->max_latency_us);
+        if (len > 0)
+            ksceIoWrite(fd, buf, len);
+    }
+
+#ifdef PEBBLE_TRACE
+    static EvlogEvent events[EVLOG_SIZE];
+    const uint32_t count = evlog_snapshot(&exception_log, events, EVLOG_SIZE);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (events[i].kind == EV_ASM_ENTRY)
+            len = snprintf(buf, sizeof(buf), "event %u asm core %u stage %u cycles %u\n", events[i].time,
+                           events[i].a >> 8, events[i].a & 0xFF, events[i].b);
+        else
+            len = snprintf(buf, sizeof(buf), "event %u handler stage %u %08X\n", events[i].time, events[i].a,
+                           events[i].b);
+        if (len > 0)
+            ksceIoWrite(fd, buf, len);
+    }
+
+    // PMU cycles through the asm stub, each span including the cost of one trace_stage. In a PEBBLE_NO_PREFILTER build
+    // the filter span is that cost alone, and unrelated aborts show up under full instead of passed_on.
+    static uint32_t scratch[EVLOG_SIZE];
+    static const struct
+    {
+        uint16_t from, to;
+        const char *name;
+    } spans[] = {{EVLOG_STAGE_ENTRY, 0, "passed_on"}, {EVLOG_STAGE_ENTRY, 1, "filter"}, {1, 6, "full"}};
+    for (uint32_t i = 0; i < sizeof(spans) / sizeof(spans[0]); ++i)
+    {
+        EvlogSpan span;
+        evlog_asm_span(events, count, spans[i].from, spans[i].to, scratch, &span);
+        len = snprintf(buf, sizeof(buf), "cycles %-9s n %u p50 %u max %u\n", spans[i].name, span.count, span.p50,
+                       span.max);
+        if (len > 0)
+            ksceIoWrite(fd, buf, len);
+    }
+#endif
+    ksceIoClose(fd);
+}
+
+static void draw_frame_hud(bool force)
+{
+    if (!guistate.show_hud)
+        return;
+
+    StageStats draw, latency;
+    frametime_stats(&frametimer, FT_DRAW, &draw);
+    frametime_stats(&frametimer, FT_LATENCY, &latency);
+    const uint32_t hud[] = {draw.p50, draw.p95, latency.p95 / 1000, renderer_getFrameStats()->bytes_written / 1024};
+    if (!renderer_regionChanged(REGION_HUD, renderer_hash(0, hud, sizeof(hud))) && !force)
+        return;
+
+    renderer_clearRectangle(RIGHT_PANEL_X, UI_HEIGHT - FONT_HEIGHT, UI_WIDTH - RIGHT_PANEL_X, FONT_HEIGHT);
+    renderer_setColor(0xFF00FFFF);
+    renderer_drawStringF(RIGHT_PANEL_X + 3, UI_HEIGHT - FONT_HEIGHT, "drw %u/%uus lat %ums %uKB", hud[0], hud[1],
+                         hud[2], hud[3]);
+    renderer_setColor(0xFFFFFFFF);
+}
+
+static void flush_trace_file(void)
+{
+    if (trace_fd > 0 && trace_file_used)
+        ksceIoWrite(trace_fd, trace_file_buffer, trace_file_used);
+    trace_file_used = 0;
+}
+
+static void toggle_trace_dump(void)
+{
+    if (trace_fd > 0)
+    {
+        flush_trace_file();
+        ksceIoClose(trace_fd);
+        trace_fd = 0;
+        return;
+    }
+    trace_fd = ksceIoOpen(TRACE_PATH, SCE_O_WRONLY | SCE_O_CREAT | SCE_O_TRUNC, 0666);
+    if (trace_fd <= 0)
+    {
+        trace_fd = 0;
+        return;
+    }
+    const uint32_t header[2] = {TRACE_FILE_MAGIC, TRACE_FILE_VERSION};
+    ksceIoWrite(trace_fd, header, sizeof(header));
+}
+
+// Moves captured records out of the ring into the on-screen history and, while dumping, the trace file.
+static bool drain_tracepoints(void)
+{
+    TraceRing *ring = kernel_get_trace_ring();
+    TraceRecord rec;
+    bool drained = false;
+    while (ring && trace_pop(ring, &rec))
+    {
+        trace_history[trace_captured++ % TRACE_HISTORY] = rec;
+        drained = true;
+        if (trace_fd <= 0)
+            continue;
+        if (trace_file_used + TRACE_RECORD_MAX_BYTES > TRACE_FILE_BUFFER)
+            flush_trace_file();
+        trace_file_used += trace_encode(&rec, trace_file_buffer + trace_file_used);
+    }
+    if (drained)
+        flush_trace_file();
+    return drained;
+}
+
+static void handle_trace_input(uint32_t released)
+{
+    if (released & SCE_CTRL_SQUARE)
+        toggle_trace_dump();
+    else if (released & guistate.hotkeys.confirm)
+    {
+        trace_captured = 0;
+        memset(trace_history, 0, sizeof(trace_history));
+    }
+}
+
+static void handle_features_menu_input(uint32_t released)
 {
     // Exit to memory view
     if (released & (SCE_CTRL_LTRIGGER | SCE_CTRL_RTRIGGER))
@@ -834,9 +1794,9 @@ static void handle_features_menu_input(uint32_t released)
 
     // Feature selection navigation
     if (released & SCE_CTRL_UP)
-        guistate.edit_feature = (guistate.edit_feature - 1 + 8) % 8;
+        guistate.edit_feature = (guistate.edit_feature - 1 + FEATURE_COUNT) % FEATURE_COUNT;
     if (released & SCE_CTRL_DOWN)
-        guistate.edit_feature = (guistate.edit_feature + 1) % 8;
+        guistate.edit_feature = (guistate.edit_feature + 1) % FEATURE_COUNT;
 
     // Feature activation
     if (!(released & guistate.hotkeys.confirm))
@@ -870,11 +1830,38 @@ static void handle_features_menu_input(uint32_t released)
         guistate.stored_edit_feature = guistate.edit_feature;
         guistate.edit_feature = 0;
         break;
+    case 8: // Frame stats HUD
+        guistate.show_hud = !guistate.show_hud;
+        break;
+    case 9: // Dump frame stats
+        dump_frame_stats();
+        break;
+    case 10: // Memory search
+        guistate.ui_state = UI_FEATURE_SEARCH;
+        guistate.stored_edit_feature = guistate.edit_feature;
+        guistate.edit_feature = 0;
+        break;
+    case 11: // Tracepoints
+        guistate.ui_state = UI_FEATURE_TRACE;
+        guistate.stored_edit_feature = guistate.edit_feature;
+        break;
+    case 12: // Step over
+        kernel_step_over();
+        break;
+    case 13: // Step out
+        kernel_step_out();
+        break;
     }
 }
 
 static void handle_feature_input(uint32_t released)
 {
+    if ((released & guistate.hotkeys.cancel) && cond_editing)
+    {
+        cond_editing = false;
+        return;
+    }
+
     // Common cancel handling for all features
     if ((released & guistate.hotkeys.cancel) && guistate.ui_state >= UI_FEATURE_HW_BREAK)
     {
@@ -901,6 +1888,12 @@ static void handle_feature_input(uint32_t released)
     case UI_FEATURE_HOTKEYS:
         handle_hotkey_config_input(released);
         break;
+    case UI_FEATURE_SEARCH:
+        handle_search_input(released);
+        break;
+    case UI_FEATURE_TRACE:
+        handle_trace_input(released);
+        break;
     default:
         break;
     }
@@ -932,17 +1925,8 @@ static void draw_feature(void)
     renderer_setColor(0xFFFFFFFF);
     renderer_drawString(50, 30, "Features:");
 
-    static const char *features[] = {"Set Hardware Breakpoint",
-                                     "Set Watchpoint",
-                                     "Set Software Breakpoint",
-                                     "List All Breakpoints",
-                                     "Suspend Process",
-                                     "Resume Process",
-                                     "Single Step",
-                                     "Hotkeys"};
-
     int y = 60;
-    for (uint32_t i = 0; i < 8; i++, y += 25)
+    for (uint32_t i = 0; i < FEATURE_COUNT; i++, y += 25)
     {
         renderer_setColor(i == guistate.edit_feature ? 0xFF0000FF : 0xFFFFFFFF);
         renderer_drawString(50, y, features[i]);
@@ -1002,36 +1986,85 @@ static void draw_feature_breakpoint_list(void)
 
     kernel_list_breakpoints(guistate.breakpoints);
 
+    int ids[BKPT_PAGE_LINES], page, pages;
+    const int count = breakpoint_list_page(ids, &page, &pages);
     int y = 60;
-    int count = 0;
-    for (uint32_t i = 0; i < MAX_SLOT; i++)
+    for (int i = 0; i < count; i++, y += 20)
     {
-        if (guistate.breakpoints[i].type != SLOT_NONE)
-        {
-            const char *type_str = (guistate.breakpoints[i].type <= SINGLE_STEP_HW_BREAKPOINT)
-                                       ? bp_types[guistate.breakpoints[i].type]
-                                       : "?";
-            renderer_setColor(i == guistate.edit_feature ? 0xFF0000FF : 0xFFFFFFFF);
-            renderer_drawStringF(50, y, "[%d] PID:%08X %s@%08X", i, guistate.breakpoints[i].pid, type_str,
-                                 guistate.breakpoints[i].address);
-            y += 20;
-            count++;
-            if (y > UI_HEIGHT - 40)
-            {
-                y += 5;
-                renderer_drawString(50, y, "... more breakpoints exist");
-                break;
-            }
-        }
+        const ActiveBKPTSlot *bp = kernel_get_breakpoint(ids[i]);
+        const char *type_str = (bp->type <= SINGLE_STEP_HW_BREAKPOINT) ? bp_types[bp->type] : "?";
+        renderer_setColor(ids[i] == (int)guistate.edit_feature ? 0xFF0000FF : 0xFFFFFFFF);
+        const char *cond = kernel_get_breakpoint_condition(ids[i]);
+        const char *trace = kernel_get_tracepoint(ids[i]);
+        char extra[96] = "";
+        if (bp->hits)
+            snprintf(extra, sizeof(extra), " %u hits, %u/%uus", bp->hits, bp->latency_us, bp->max_latency_us);
+        if (cond)
+            snprintf(extra + strlen(extra), sizeof(extra) - strlen(extra), " if %s", cond);
+        if (trace)
+            snprintf(extra + strlen(extra), sizeof(extra) - strlen(extra), " trace %s", trace);
+        renderer_drawStringF(50, y, "[%d] PID:%08X %s@%08X%s", ids[i], bp->pid, type_str, bp->address, extra);
     }
     if (count == 0)
         renderer_drawString(50, y, "No breakpoint found");
+    else
+    {
+        renderer_setColor(0xFFFFFFFF);
+        renderer_drawStringF(UI_WIDTH - 200, 30, "Page %d/%d", page + 1, pages);
+    }
 
     char confirm_btn[64], cancel_btn[64];
     button_to_string(guistate.hotkeys.confirm, confirm_btn, sizeof(confirm_btn));
     button_to_string(guistate.hotkeys.cancel, cancel_btn, sizeof(cancel_btn));
     renderer_setColor(0xFFFFFFFF);
-    renderer_drawStringF(50, UI_HEIGHT - 40, "Press %s to delete, %s to return", confirm_btn, cancel_btn);
+    if (cond_editing)
+    {
+        renderer_setColor(cond_error ? 0xFF0000FF : 0xFFFFFFFF);
+        const char *label = cond_trace ? "Trace:     " : "Condition: ";
+        renderer_drawStringF(50, UI_HEIGHT - 65, "%s%s%s", label, cond_text, cond_error ? "  (invalid)" : "");
+        renderer_drawRectangle(50 + (strlen(label) + cond_cursor) * FONT_WIDTH, UI_HEIGHT - 65 + FONT_HEIGHT - 2,
+                               FONT_WIDTH, 1, 0xFFFFFFFF);
+        renderer_setColor(0xFFFFFFFF);
+        renderer_drawStringF(50, UI_HEIGHT - 40, "%s apply (blank removes), L/R condition/trace, %s discard",
+                             confirm_btn, cancel_btn);
+    }
+    else
+        renderer_drawStringF(50, UI_HEIGHT - 40,
+                             "%s delete, Square delete page, Triangle condition/trace, L/R flip, %s return",
+                             confirm_btn, cancel_btn);
+}
+
+static void draw_feature_trace(void)
+{
+    renderer_clearRectangle(0, 0, UI_WIDTH, UI_HEIGHT);
+    renderer_setColor(0xFFFFFFFF);
+    renderer_drawString(50, 30, "Tracepoints:");
+
+    const TraceRing *ring = kernel_get_trace_ring();
+    renderer_drawStringF(50, 60, "%u captured, %u dropped, %u pending%s", trace_captured, ring ? ring->dropped : 0,
+                         ring ? trace_pending(ring) : 0, (trace_fd > 0) ? ", dumping to " TRACE_PATH : "");
+
+    // Newest first.
+    int y = 90;
+    const uint32_t shown = (trace_captured < TRACE_HISTORY) ? trace_captured : TRACE_HISTORY;
+    for (uint32_t i = 0; i < shown; ++i, y += 25)
+    {
+        const TraceRecord *rec = &trace_history[(trace_captured - 1 - i) % TRACE_HISTORY];
+        char line[128];
+        int len = snprintf(line, sizeof(line), "%08X [%u]@%08X T:%08X", rec->time, rec->id, rec->address,
+                           rec->thread);
+        for (uint32_t v = 0; v < rec->count && len < (int)sizeof(line) - 10; ++v)
+            len += snprintf(line + len, sizeof(line) - len, " %08X", rec->values[v]);
+        renderer_drawString(50, y, line);
+    }
+    if (!shown)
+        renderer_drawString(50, y, "No tracepoint hits yet (set one from the breakpoint list)");
+
+    char confirm_btn[64], cancel_btn[64];
+    button_to_string(guistate.hotkeys.confirm, confirm_btn, sizeof(confirm_btn));
+    button_to_string(guistate.hotkeys.cancel, cancel_btn, sizeof(cancel_btn));
+    renderer_drawStringF(50, UI_HEIGHT - 40, "%s clear, Square %s dump, %s return", confirm_btn,
+                         (trace_fd > 0) ? "stop" : "start", cancel_btn);
 }
 
 static void draw_hotkey_config(void)
@@ -1068,6 +2101,87 @@ static void draw_hotkey_config(void)
     renderer_drawStringF(50, y, "Press %s to Cancel", cancel_btn);
 }
 
+static void draw_feature_search(void)
+{
+    renderer_clearRectangle(0, 0, UI_WIDTH, UI_HEIGHT);
+    renderer_setColor(0xFFFFFFFF);
+    renderer_drawString(50, 30, "Memory Search:");
+
+    int y = 60;
+    renderer_setColor(guistate.edit_feature == 0 ? 0xFF0000FF : 0xFFFFFFFF);
+    renderer_drawStringF(50, y, "Type : < %s >", search_types[search_type]);
+    y += 25;
+
+    int cursor_x;
+    renderer_setColor(guistate.edit_feature == 1 ? 0xFF0000FF : 0xFFFFFFFF);
+    if (search_is_text())
+    {
+        renderer_drawStringF(50, y, "Value: %s", search_text);
+        cursor_x = 50 + (7 + search_cursor) * FONT_WIDTH;
+    }
+    else
+    {
+        renderer_drawStringF(50, y, "Value: %08X (%d)", search_value, (int32_t)search_value);
+        cursor_x = 50 + 7 * FONT_WIDTH + (7 - search_cursor) * FONT_WIDTH;
+    }
+    if (guistate.edit_mode == EDIT_VALUE)
+        renderer_drawRectangle(cursor_x, y + FONT_HEIGHT - 2, FONT_WIDTH, 1, 0xFFFFFFFF);
+    y += 25;
+
+    renderer_setColor(guistate.edit_feature == 2 ? 0xFF0000FF : 0xFFFFFFFF);
+    renderer_drawStringF(50, y, "Start Search %08X-%08X", lowest_vaddr, highest_vaddr);
+    y += 25;
+
+    renderer_setColor(guistate.edit_feature == 3 ? 0xFF0000FF : (search.store ? 0xFFFFFFFF : 0xFF808080));
+    renderer_drawStringF(50, y, "Next Scan: < %s >", scan_filters[scan_filter]);
+    y += 30;
+
+    const ScanStore *store = search.store;
+    renderer_setColor(0xFFFFFFFF);
+    if (search_error)
+        renderer_drawString(50, y, "Invalid search value");
+    else if (search.running)
+        renderer_drawStringF(50, y, "Scanning... %u%% (%u found)", search_progress(&search), search.matches);
+    else if (store && store->narrowing)
+        renderer_drawStringF(50, y, "Narrowing... %u/%u pages", store->cursor, store->page_count);
+    else if (store && search.bytes_scanned)
+        renderer_drawStringF(50, y, "%u candidates%s in %u pages, %uKB held", store->total,
+                             store->overflow ? " (truncated)" : "", store->page_count, scanstore_footprint(store) / 1024);
+    else if (search.bytes_scanned)
+        renderer_drawStringF(50, y, "%u found (%u listed), %uKB in %ums, %uMB/s", search.matches, search.count,
+                             (uint32_t)(search.bytes_scanned / 1024), (uint32_t)(search.elapsed_us / 1000),
+                             search_mb_per_sec(&search));
+    y += 25;
+
+    // Results, one page at a time around the selection
+    const uint32_t selected = (guistate.edit_feature >= SEARCH_ROWS) ? guistate.edit_feature - SEARCH_ROWS : 0;
+    const uint32_t first = selected / SEARCH_PAGE_LINES * SEARCH_PAGE_LINES;
+    const uint32_t count = search_result_count();
+    const int list_y = y;
+    for (uint32_t i = first; i < count && i < first + SEARCH_PAGE_LINES; i++, y += FONT_HEIGHT)
+    {
+        uint32_t value = 0;
+        const uint32_t addr = search_result(i, &value);
+        renderer_setColor(i + SEARCH_ROWS == guistate.edit_feature ? 0xFF0000FF : 0xFFFFFFFF);
+        if (store)
+            renderer_drawStringF(70, y, "%08X = %X", addr, value);
+        else
+            renderer_drawStringF(70, y, "%08X", addr);
+    }
+    if (count)
+    {
+        renderer_setColor(0xFFFFFFFF);
+        renderer_drawStringF(350, list_y, "Page %u/%u", first / SEARCH_PAGE_LINES + 1,
+                             (count + SEARCH_PAGE_LINES - 1) / SEARCH_PAGE_LINES);
+    }
+
+    char confirm_btn[64], cancel_btn[64];
+    button_to_string(guistate.hotkeys.confirm, confirm_btn, sizeof(confirm_btn));
+    button_to_string(guistate.hotkeys.cancel, cancel_btn, sizeof(cancel_btn));
+    renderer_setColor(0xFFFFFFFF);
+    renderer_drawStringF(50, UI_HEIGHT - 40, "%s: edit/start/jump, L/R: page, %s: return", confirm_btn, cancel_btn);
+}
+
 static void draw_unknown_state(void)
 {
     renderer_clearRectangle(0, 0, UI_WIDTH, UI_HEIGHT);
@@ -1078,10 +2192,14 @@ static void draw_unknown_state(void)
 
 static void draw_memory_view(void)
 {
-    renderer_clearRectangle(0, 0, UI_WIDTH, UI_HEIGHT);
+    // Other screens invalidate the buffer they draw into, so this only fires on the first memview frame per buffer.
+    if (renderer_regionChanged(REGION_SCREEN, UI_MEMVIEW))
+        renderer_clearRectangle(0, 0, UI_WIDTH, UI_HEIGHT);
+    frametime_begin(&frametimer, FT_STATE);
     update_memview_state();
+    frametime_end(&frametimer, FT_STATE);
     draw_memview_contents();
-    draw_right_panel();
+    draw_frame_hud(draw_right_panel());
 }
 
 static void draw_gui(void)
@@ -1108,6 +2226,12 @@ static void draw_gui(void)
     case UI_FEATURE_HOTKEYS:
         draw_hotkey_config();
         break;
+    case UI_FEATURE_SEARCH:
+        draw_feature_search();
+        break;
+    case UI_FEATURE_TRACE:
+        draw_feature_trace();
+        break;
     case UI_FEATURE_SUSPEND:
     case UI_FEATURE_RESUME:
     case UI_FEATURE_STEP:
@@ -1116,6 +2240,18 @@ static void draw_gui(void)
         draw_unknown_state();
         break;
     }
+
+    if (guistate.ui_state != UI_MEMVIEW)
+    {
+        draw_frame_hud(true);
+        renderer_invalidate();
+    }
+}
+
+static uint32_t main_module_address(void)
+{
+    const uint32_t start = (uint32_t)guistate.modinfo.segments[0].vaddr;
+    return (start >= lowest_vaddr && start < highest_vaddr) ? start & ~7 : lowest_vaddr;
 }
 
 static void handle_welcome_confirm(void)
@@ -1129,23 +2265,8 @@ static void handle_welcome_confirm(void)
     guistate.active_area = MEMVIEW_HEX;
     guistate.cursor_column = 1;
 
-    // Find module memory range
-    for (int i = 0; i < 4; ++i)
-    {
-        if (guistate.modinfo.segments[i].vaddr && guistate.modinfo.segments[i].memsz > 0)
-        {
-            uint32_t seg_start = (uint32_t)guistate.modinfo.segments[i].vaddr;
-            uint32_t seg_end = seg_start + guistate.modinfo.segments[i].memsz;
-
-            if (seg_start > 0 && seg_start < lowest_vaddr)
-                lowest_vaddr = seg_start;
-            if (seg_end > highest_vaddr)
-                highest_vaddr = seg_end;
-        }
-    }
-
-    guistate.base_addr = lowest_vaddr;
-    guistate.addr = lowest_vaddr;
+    update_memory_bounds();
+    guistate.base_addr = guistate.addr = main_module_address();
     cache_dirty = true;
     read_memview_cache();
 }
@@ -1158,24 +2279,8 @@ static void update_module_info_if_needed(void)
     if (kernel_get_moduleinfo(&guistate.modinfo) < 0)
         return;
 
-    for (int i = 0; i < 4; ++i)
-    {
-        if (guistate.modinfo.segments[i].vaddr && guistate.modinfo.segments[i].memsz > 0)
-        {
-            uint32_t seg_start = (uint32_t)guistate.modinfo.segments[i].vaddr;
-            uint32_t seg_end = seg_start + guistate.modinfo.segments[i].memsz;
-
-            if (seg_start > 0 && seg_start < lowest_vaddr)
-            {
-                lowest_vaddr = seg_start;
-                if (seg_end > 0)
-                    highest_vaddr = seg_end;
-            }
-        }
-    }
-
-    guistate.base_addr = lowest_vaddr;
-    guistate.addr = lowest_vaddr;
+    update_memory_bounds();
+    guistate.base_addr = guistate.addr = main_module_address();
     cache_dirty = true;
     read_memview_cache();
 }
@@ -1209,15 +2314,43 @@ int pebble_thread(SceSize args, void *argp)
 
     SceCtrlData ctrl;
     uint32_t prev_buttons = 0;
+    uint32_t shown_hits = 0;
+    GuiScheduler sched;
+    sched_init(&sched);
+    frametime_init(&frametimer, frametime_clock);
+    memcache_init(&viewcache, target_read, MEMCACHE_TTL_US, ksceKernelGetSystemTimeWide());
 
     while (1)
     {
-        if (!g_target_process.pid)
+        uint32_t events = 0;
+        uint32_t timeout = sched_timeout(&sched, g_target_process.pid > 0, guistate.gui_visible,
+                                         ksceKernelGetSystemTimeWide());
+        if (timeout == SCHED_FOREVER)
+            ksceKernelWaitEventFlag(gui_evtflag, GUI_EVT_ALL, SCE_EVENT_WAITOR | SCE_EVENT_WAITCLEAR_PAT, &events,
+                                    NULL);
+        else if (timeout)
+            ksceKernelWaitEventFlag(gui_evtflag, GUI_EVT_ALL, SCE_EVENT_WAITOR | SCE_EVENT_WAITCLEAR_PAT, &events,
+                                    &timeout);
+
+        uint64_t now = ksceKernelGetSystemTimeWide();
+        sched_wakeup(&sched, now);
+        if (events)
+            sched_mark_dirty(&sched);
+        if (events & (GUI_EVT_BREAKPOINT | GUI_EVT_PROCESS))
+            memcache_invalidate(&viewcache);
+        if (events & GUI_EVT_PROCESS)
         {
-            ksceKernelDelayThread(5 * 1000 * 1000);
-            continue;
+            search.running = false;
+            search.count = 0;
+            search.matches = 0;
+            search.store = NULL;
         }
+        if (!g_target_process.pid)
+            continue;
+        if (drain_tracepoints() && guistate.ui_state == UI_FEATURE_TRACE)
+            sched_mark_dirty(&sched);
 
+        frametime_begin(&frametimer, FT_INPUT);
         ksceCtrlPeekBufferPositive(0, &ctrl, 1);
         uint32_t current_buttons = ctrl.buttons;
         uint32_t released = (prev_buttons & ~current_buttons);
@@ -1228,16 +2361,21 @@ int pebble_thread(SceSize args, void *argp)
 
             if (!guistate.gui_visible && evtflag)
             {
-                if (g_target_process.main_thread_id && renderer_init())
+                if (g_target_process.main_thread_id && renderer_init(g_target_process.pid))
                 {
                     ksceKernelDebugSuspendThread(g_target_process.main_thread_id, 0x100);
                     guistate.gui_visible = true;
+                    memcache_invalidate(&viewcache);
+                    if (guistate.ui_state != UI_WELCOME)
+                        update_memory_bounds();
+                    sched_mark_dirty(&sched);
                 }
                 else
                 {
+                    ksceKernelLockMutex(debugger_mtx_uid, 1, NULL);
                     kernel_debugger_on_create();
+                    ksceKernelUnlockMutex(debugger_mtx_uid, 1);
                     prev_buttons = current_buttons;
-                    ksceKernelDelayThread(33333);
                     continue;
                 }
             }
@@ -1246,7 +2384,6 @@ int pebble_thread(SceSize args, void *argp)
                 guistate.gui_visible = false;
                 ksceKernelDebugResumeThread(g_target_process.main_thread_id, 0x100);
                 prev_buttons = current_buttons;
-                ksceKernelDelayThread(33333);
                 continue;
             }
         }
@@ -1255,15 +2392,38 @@ int pebble_thread(SceSize args, void *argp)
         if (!guistate.gui_visible)
         {
             prev_buttons = current_buttons;
-            ksceKernelDelayThread(33333);
             continue;
         }
 
         // GUI is visible - handle input and drawing
         ksceKernelPowerTick(SCE_KERNEL_POWER_TICK_DISABLE_AUTO_SUSPEND);
         check_button_repeat(current_buttons, &released);
+        if (current_buttons || released)
+            sched_input(&sched, now);
+        if (released)
+        {
+            sched_mark_dirty(&sched);
+            // The present side updates the same edge from the user module's thread, under pebble_mtx_uid.
+            if (ksceKernelLockMutex(pebble_mtx_uid, 1, NULL) == 0)
+            {
+                frametime_input_edge(&frametimer);
+                ksceKernelUnlockMutex(pebble_mtx_uid, 1);
+            }
+        }
 
-        // Handle input based on UI state
+        // Hit counts are on screen in the memory view and the breakpoint list; target memory changes without any
+        // event, so the memory view refreshes as often as its page cache would re-read anyway.
+        const uint32_t total_hits = kernel_total_hits();
+        if (total_hits != shown_hits)
+        {
+            shown_hits = total_hits;
+            sched_mark_dirty(&sched);
+        }
+        sched_set_refresh(&sched, (guistate.ui_state == UI_MEMVIEW) ? MEMCACHE_TTL_US : 0);
+        const bool draw = sched_should_draw(&sched, now);
+
+        // Handle input based on UI state; batches from the user side change the same state, so under the debugger lock.
+        ksceKernelLockMutex(debugger_mtx_uid, 1, NULL);
         if (guistate.ui_state == UI_WELCOME && (released & guistate.hotkeys.confirm))
         {
             handle_welcome_confirm();
@@ -1271,25 +2431,61 @@ int pebble_thread(SceSize args, void *argp)
         else if (guistate.ui_state == UI_MEMVIEW)
         {
             update_module_info_if_needed();
-            cache_dirty = true;
-            read_memview_cache();
+            if (draw)
+            {
+                cache_dirty = true;
+                read_memview_cache();
+            }
             handle_memview_input(released, current_buttons);
         }
         else if (guistate.ui_state >= UI_FEATURES)
             handle_feature_input(released);
+        ksceKernelUnlockMutex(debugger_mtx_uid, 1);
+        frametime_end(&frametimer, FT_INPUT);
+
+        // Scan incrementally and keep waking up until the search is done.
+        if (search.running)
+        {
+            uint64_t scan_start = ksceKernelGetSystemTimeWide();
+            search_step(&search, SEARCH_STEP_BYTES);
+            search.elapsed_us += ksceKernelGetSystemTimeWide() - scan_start;
+            sched_mark_dirty(&sched);
+        }
+        else if (search.store && search.store->narrowing)
+        {
+            scanstore_narrow_step(search.store, target_read, SCAN_STEP_PAGES);
+            sched_mark_dirty(&sched);
+        }
 
         // Draw the GUI
-        if (ksceKernelLockMutex(pebble_mtx_uid, 1, NULL) == 0)
+        if (draw && ksceKernelLockMutex(pebble_mtx_uid, 1, NULL) == 0)
         {
+            renderer_beginFrame();
+            frametime_begin(&frametimer, FT_DRAW);
             draw_gui();
+            frametime_end(&frametimer, FT_DRAW);
+            renderer_endFrame();
+            frametime_commit(&frametimer);
+            frametime_handoff(&frametimer);
             ksceKernelUnlockMutex(pebble_mtx_uid, 1);
             ksceKernelSetEventFlag(evtflag, buf_index + 1);
             buf_index ^= 1;
         }
 
         prev_buttons = current_buttons;
-        ksceKernelDelayThread(33333);
     }
 
     return 0;
-}
\ No newline at end of file
+}
+
+void gui_frame_presented(void)
+{
+    // Called from the user module with pebble_mtx_uid held, same as the handoff side.
+    frametime_presented(&frametimer);
+}
+
+void gui_notify(uint32_t events)
+{
+    if (gui_evtflag > 0)
+        ksceKernelSetEventFlag(gui_evtflag, events);
+}
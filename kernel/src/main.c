@@ -1,4 +1,3 @@
-// ToDo: Add memory search.
 // ToDo: Add support for 3.60
 // ToDo: Bug in cursor highlight when changing layout.
 // ToDo: Availability for ARM/THUMB type adjustment in UI_FEATURE_SW_BREAK.
@@ -13,10 +12,68 @@ int (*ksceKernelSetPHWP)(SceUID pid, SceUInt32 a2, void *WVR, SceUInt32 WCR);
 int (*ksceKernelSetPHBP)(SceUID pid, SceUInt32 a2, void *BVR, SceUInt32 BCR);
 
 SceUID evtflag = 0;
+SceUID gui_evtflag = 0;
 SceUID pebble_mtx_uid = 0;
+SceUID debugger_mtx_uid = 0;
 TargetProcess g_target_process;
 static SceUID heap_uid = 0;
 static SceUID gui_buffer_uids[2] = {0, 0};
+static RegionIndex region_index;
+static UnwindIndex unwind_index;
+static SceUID unwind_block_uid = 0;
+static bool unwind_ready = false;
+static uint8_t unwind_stack[UNWIND_STACK_WINDOW];
+static SymbolIndex symbol_index;
+static SceUID symbol_block_uid = 0;
+static bool symbols_ready = false;
+static NidDb nid_db;
+static SceUID nid_block_uid = 0;
+static BpBucket bp_buckets[1 << BP_BUCKET_BITS];
+static uint16_t bp_next[BP_ID_MAX];
+static BpIndex bp_index;
+static uint32_t region_seeds[128 * 4];
+
+#define SW_CHUNK_BYTES ((SW_BKPT_CHUNK * sizeof(ActiveBKPTSlot) + 0xFFF) & ~0xFFF)
+
+// SW breakpoint store. Chunks are never moved or freed once allocated, so the exception handler can read entries
+// found through the index while the GUI thread adds more.
+static ActiveBKPTSlot *sw_chunks[SW_BKPT_CHUNKS];
+static SceUID sw_chunk_uids[SW_BKPT_CHUNKS];
+static uint32_t sw_used[SW_BKPT_MAX / 32];
+static uint32_t bp_generation;
+static TextPatch sw_patches[SW_PATCH_BATCH];
+
+#define HW_BCR ((1 << 0) | (0x3 << 1) | (0xF << 5) | (0x1 << 14) | (0x0 << 20))
+
+typedef struct
+{
+    CondProgram program;
+    bool used;
+    char text[COND_TEXT_MAX + 1];
+} BpCondition;
+
+static BpCondition bp_conditions[MAX_CONDITIONS];
+static uint32_t cond_pins[MAX_CONDITIONS];
+
+typedef struct
+{
+    TraceSpec spec;
+    bool used;
+    char text[COND_TEXT_MAX + 1];
+} BpTrace;
+
+static BpTrace bp_traces[MAX_TRACEPOINTS];
+static uint32_t trace_pins[MAX_TRACEPOINTS];
+static TraceRing *trace_ring;
+static SceUID trace_ring_uid;
+static int rearm_id = -1; // Breakpoint lifted for one instruction after a hit whose condition was false
+static ThreadTable thread_table;
+static uint8_t *batch_buffer; // BATCH_MAX_IN request bytes, then BATCH_MAX_OUT reply bytes
+static SceUID batch_buffer_uid;
+static int32_t step_owner; // Thread the step slot is armed for, 0 while it is free
+
+static void release_step(void);
+static uint32_t total_hits;
 
 static int find_empty_slot(int start, int end)
 {
@@ -26,12 +83,72 @@ static int find_empty_slot(int start, int end)
     return -1;
 }
 
+// Handlers pin the condition or trace entry they run, and writers only reuse entries that are free and unpinned, so
+// an entry is never rewritten under a hit still using it on another core. A handler pins first and then re-reads
+// the breakpoint's reference; a writer detaches the entry before freeing it, so one of the two always sees the other.
+static uint8_t pin_entry(const uint8_t *ref, uint32_t *pins)
+{
+    for (;;)
+    {
+        const uint8_t n = __atomic_load_n(ref, __ATOMIC_SEQ_CST);
+        if (!n)
+            return 0;
+        __atomic_fetch_add(&pins[n - 1], 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(ref, __ATOMIC_SEQ_CST) == n)
+            return n;
+        __atomic_fetch_sub(&pins[n - 1], 1, __ATOMIC_RELEASE);
+    }
+}
+
+static void unpin_entry(uint32_t *pins, uint8_t n)
+{
+    __atomic_fetch_sub(&pins[n - 1], 1, __ATOMIC_RELEASE);
+}
+
+static bool entry_pinned(const uint32_t *pins, int n)
+{
+    return __atomic_load_n(&pins[n], __ATOMIC_SEQ_CST) != 0;
+}
+
+static void release_condition(ActiveBKPTSlot *bp)
+{
+    const uint8_t n = bp->cond;
+    __atomic_store_n(&bp->cond, 0, __ATOMIC_SEQ_CST);
+    if (n)
+        bp_conditions[n - 1].used = false;
+}
+
+static void release_trace(ActiveBKPTSlot *bp)
+{
+    const uint8_t n = bp->trace;
+    __atomic_store_n(&bp->trace, 0, __ATOMIC_SEQ_CST);
+    if (n)
+        bp_traces[n - 1].used = false;
+}
+
+// Counted before a breakpoint is armed and uncounted once it is gone, so the asm filter never passes on one of ours.
+static void filter_count(SlotType type, int delta)
+{
+    static const uint8_t kinds[] = {
+        [SW_BREAKPOINT_THUMB] = SCE_EXCP_UNDEF_INSTRUCTION, [SW_BREAKPOINT_ARM] = SCE_EXCP_UNDEF_INSTRUCTION,
+        [HW_BREAKPOINT] = SCE_EXCP_PABT,                    [HW_WATCHPOINT_R] = SCE_EXCP_DABT,
+        [HW_WATCHPOINT_W] = SCE_EXCP_DABT,                  [HW_WATCHPOINT_RW] = SCE_EXCP_DABT,
+        [SINGLE_STEP_HW_BREAKPOINT] = SCE_EXCP_PABT};
+    if (type != SLOT_NONE && type <= SINGLE_STEP_HW_BREAKPOINT)
+        __atomic_add_fetch(&exception_filter.armed[kinds[type]], delta, __ATOMIC_SEQ_CST);
+}
+
 static void clear_slot(ActiveBKPTSlot *slot)
 {
     if (slot)
     {
+        filter_count(slot->type, -1);
+        release_condition(slot);
+        release_trace(slot);
+        bpindex_remove(&bp_index, slot->address, slot - guistate.breakpoints);
         memset(slot, 0, sizeof(*slot));
         slot->index = 0xFF;
+        bp_generation++;
     }
 }
 
@@ -40,6 +157,15 @@ void kernel_debugger_on_create(void)
     g_target_process.main_module_id = ksceKernelGetProcessMainModule(g_target_process.pid);
     g_target_process.main_thread_id = ksceKernelGetProcessMainThread(g_target_process.pid);
     g_target_process.exception_thid = 0;
+    threads_reset(&thread_table);
+    step_owner = 0;
+    regions_reset(&region_index);
+    unwind_ready = false;
+    symbols_ready = false;
+    suspend_generation++;
+
+    SceKernelProcessContext *ctx;
+    exception_filter.contextidr = (ksceKernelGetPidContext(g_target_process.pid, &ctx) >= 0) ? ctx->CONTEXTIDR : 0;
 }
 
 void kernel_debugger_init(void)
@@ -54,6 +180,12 @@ void kernel_debugger_init(void)
     guistate.edit_mode = EDIT_NONE;
     lowest_vaddr = 0x84000000;
     highest_vaddr = 0x85000000;
+    threads_reset(&thread_table);
+    step_owner = 0;
+    regions_reset(&region_index);
+    unwind_ready = false;
+    symbols_ready = false;
+    exception_filter.contextidr = 0;
 }
 
 int kernel_set_hardware_breakpoint(uint32_t address)
@@ -63,21 +195,28 @@ int kernel_set_hardware_breakpoint(uint32_t address)
     int index = find_empty_slot(0, MAX_HW_BKPT - 1);
     if (index < 0)
         return -1;
-    uint32_t BCR = (1 << 0) | (0x3 << 1) | (0xF << 5) | (0x1 << 14) | (0x0 << 20);
-    if (ksceKernelSetPHBP(g_target_process.pid, index, (void *)address, BCR) >= 0)
+    filter_count(HW_BREAKPOINT, 1);
+    if (ksceKernelSetPHBP(g_target_process.pid, index, (void *)address, HW_BCR) >= 0)
     {
         ActiveBKPTSlot *slot = &guistate.breakpoints[index];
         slot->pid = g_target_process.pid;
         slot->address = address;
         slot->index = index;
         slot->type = HW_BREAKPOINT;
+        bpindex_insert(&bp_index, address, index);
         ksceKernelPrintf("HW Breakpoint set at %#X.\n", address);
         return index;
     }
+    filter_count(HW_BREAKPOINT, -1);
     ksceKernelPrintf("HW Breakpoint failed: %d, %#X.\n", index, address);
     return -1;
 }
 
+static uint32_t watch_wcr(WatchPointBreakType type)
+{
+    return 1 | (1 << 1) | (type << 3) | (0xF << 5) | (0x1 << 14) | (0 << 20) | (0 << 24); // Explicitly for the last two options but no effect.
+}
+
 int kernel_set_watchpoint(uint32_t address, WatchPointBreakType type)
 {
     if (g_target_process.pid <= 0 || type < BREAK_READ || type > BREAK_READ_WRITE)
@@ -85,53 +224,182 @@ int kernel_set_watchpoint(uint32_t address, WatchPointBreakType type)
     int index = find_empty_slot(0, MAX_HW_BKPT - 1);
     if (index < 0)
         return -1;
-    uint32_t WCR = 1 | (1 << 1) | (type << 3) | (0xF << 5) | (0x1 << 14) | (0 << 20) | (0 << 24); // Explicitly for the last two options but no effect.
-    if (ksceKernelSetPHWP(g_target_process.pid, index, (void *)address, WCR) >= 0)
+    const SlotType slot_type = (type == BREAK_READ)    ? HW_WATCHPOINT_R
+                               : (type == BREAK_WRITE) ? HW_WATCHPOINT_W
+                                                       : HW_WATCHPOINT_RW;
+    filter_count(slot_type, 1);
+    if (ksceKernelSetPHWP(g_target_process.pid, index, (void *)address, watch_wcr(type)) >= 0)
     {
         ActiveBKPTSlot *slot = &guistate.breakpoints[index];
         slot->pid = g_target_process.pid;
         slot->address = address;
         slot->index = index;
-        slot->type = (type == BREAK_READ)    ? HW_WATCHPOINT_R
-                     : (type == BREAK_WRITE) ? HW_WATCHPOINT_W
-                                             : HW_WATCHPOINT_RW;
+        slot->type = slot_type;
+        bpindex_insert(&bp_index, address, index);
         ksceKernelPrintf("Watchpoint set at %#X.\n", address);
         return index;
     }
+    filter_count(slot_type, -1);
     ksceKernelPrintf("Watchpoint failed: %d, %#X.\n", index, address);
     return -1;
 }
 
-int kernel_set_software_breakpoint(uint32_t address, SlotType type)
+static ActiveBKPTSlot *sw_entry(int id)
 {
-    if (g_target_process.pid <= 0 || (type != SW_BREAKPOINT_THUMB && type != SW_BREAKPOINT_ARM))
-        return -1;
-    int index = find_empty_slot(MAX_HW_BKPT + 1, MAX_SLOT);
-    if (index < 0)
-        return -1;
-    uint32_t bkpt_instruction = (type == SW_BREAKPOINT_THUMB) ? SW_THUMB : SW_ARM;
-    uint8_t instruction_size = (type == SW_BREAKPOINT_THUMB) ? 2 : 4;
-    uint32_t original_instruction = 0;
-    if (ksceKernelCopyFromUserProc(g_target_process.pid, &original_instruction, (void *)address, instruction_size) < 0)
-        return -1;
-    if (ksceKernelCopyToUserProcTextDomain(g_target_process.pid, (void *)address, &bkpt_instruction, instruction_size) < 0)
+    const uint32_t n = id - MAX_SLOT;
+    ActiveBKPTSlot *chunk = (id >= MAX_SLOT && n < SW_BKPT_MAX) ? sw_chunks[n / SW_BKPT_CHUNK] : NULL;
+    return chunk ? &chunk[n % SW_BKPT_CHUNK] : NULL;
+}
+
+static ActiveBKPTSlot *bp_entry(int id)
+{
+    if (id >= 0 && id < MAX_SLOT)
+        return &guistate.breakpoints[id];
+    return sw_entry(id);
+}
+
+static bool sw_in_use(uint32_t n)
+{
+    return (sw_used[n / 32] >> (n & 31)) & 1;
+}
+
+// Claims the lowest free store id, allocating its chunk the first time it is reached.
+static int sw_reserve(void)
+{
+    for (uint32_t w = 0; w < SW_BKPT_MAX / 32; ++w)
+    {
+        if (sw_used[w] == 0xFFFFFFFF)
+            continue;
+        const uint32_t n = w * 32 + __builtin_ctz(~sw_used[w]);
+        const uint32_t c = n / SW_BKPT_CHUNK;
+        if (!sw_chunks[c])
+        {
+            void *base;
+            SceUID uid = ksceKernelAllocMemBlock("pebble_swbp", SCE_KERNEL_MEMBLOCK_TYPE_KERNEL_RW, SW_CHUNK_BYTES, NULL);
+            if (uid <= 0 || ksceKernelGetMemBlockBase(uid, &base) < 0)
+            {
+                ksceKernelPrintf("SW breakpoint store allocation failed: %#X.\n", uid);
+                if (uid > 0)
+                    ksceKernelFreeMemBlock(uid);
+                return -1;
+            }
+            memset(base, 0, SW_CHUNK_BYTES);
+            sw_chunk_uids[c] = uid;
+            sw_chunks[c] = base;
+        }
+        sw_used[w] |= 1u << (n & 31);
+        return MAX_SLOT + n;
+    }
+    return -1;
+}
+
+static void sw_release(int id)
+{
+    ActiveBKPTSlot *bp = sw_entry(id);
+    if (!bp)
+        return;
+    if (bp->type != SLOT_NONE)
+        bpindex_remove(&bp_index, bp->address, id);
+    filter_count(bp->type, -1);
+    release_condition(bp);
+    release_trace(bp);
+    memset(bp, 0, sizeof(*bp));
+    bp->index = 0xFF;
+    sw_used[(id - MAX_SLOT) / 32] &= ~(1u << ((id - MAX_SLOT) & 31));
+    bp_generation++;
+}
+
+static int sw_find(SceUID pid, uint32_t address)
+{
+    uint16_t ids[BPINDEX_MAX_CHAIN];
+    const uint32_t count = bpindex_lookup(&bp_index, address, ids, BPINDEX_MAX_CHAIN);
+    for (uint32_t i = 0; i < count; ++i)
     {
-        ksceKernelCopyToUserProcTextDomain(g_target_process.pid, (void *)address, &original_instruction,
-                                           instruction_size);
+        const ActiveBKPTSlot *bp = sw_entry(ids[i]);
+        if (bp && bp->type != SLOT_NONE && bp->pid == pid && bp->address == address)
+            return ids[i];
+    }
+    return -1;
+}
+
+static int sw_read_text(uint32_t addr, void *dst, uint32_t size)
+{
+    return ksceKernelCopyFromUserProc(g_target_process.pid, dst, (void *)addr, size);
+}
+
+static int sw_write_text(uint32_t addr, const void *src, uint32_t size)
+{
+    return ksceKernelCopyToUserProcTextDomain(g_target_process.pid, (void *)addr, src, size);
+}
+
+static int sw_find_target(uint32_t addr)
+{
+    return sw_find(g_target_process.pid, addr);
+}
+
+static uint32_t *sw_saved(int id)
+{
+    return &sw_entry(id)->p_instruction;
+}
+
+static const SwPatchBackend sw_backend = {
+    .read = sw_read_text,
+    .write = sw_write_text,
+    .find = sw_find_target,
+    .reserve = sw_reserve,
+    .saved = sw_saved,
+};
+
+int kernel_set_software_breakpoints(const uint32_t *addresses, int count, SlotType type)
+{
+    if (g_target_process.pid <= 0 || !addresses || (type != SW_BREAKPOINT_THUMB && type != SW_BREAKPOINT_ARM))
         return -1;
+    const SceUID pid = g_target_process.pid;
+    const uint32_t bkpt_instruction = (type == SW_BREAKPOINT_THUMB) ? SW_THUMB : SW_ARM;
+    const uint8_t instruction_size = (type == SW_BREAKPOINT_THUMB) ? 2 : 4;
+    int set = 0;
+    bool full = false;
+
+    for (int done = 0; done < count && !full;)
+    {
+        const int kept = swpatch_prepare(sw_patches, addresses, count, &done, bkpt_instruction, instruction_size,
+                                         &sw_backend, &full);
+        filter_count(type, kept);
+        swpatch_apply(sw_patches, kept, &sw_backend);
+        for (int i = 0; i < kept; ++i)
+        {
+            const TextPatch *patch = &sw_patches[i];
+            if (!patch->ok)
+            {
+                filter_count(type, -1);
+                sw_release(patch->id);
+                continue;
+            }
+            ActiveBKPTSlot *bp = sw_entry(patch->id);
+            bp->pid = pid;
+            bp->address = patch->address;
+            bp->index = 0xFF;
+            bp->type = type;
+            bpindex_insert(&bp_index, patch->address, patch->id);
+            set++;
+        }
+        bp_generation++;
     }
-    ActiveBKPTSlot *slot = &guistate.breakpoints[index];
-    slot->pid = g_target_process.pid;
-    slot->address = address;
-    slot->index = index;
-    slot->p_instruction = original_instruction;
-    slot->type = type;
-    return index;
+    return set;
+}
+
+int kernel_set_software_breakpoint(uint32_t address, SlotType type)
+{
+    if (kernel_set_software_breakpoints(&address, 1, type) < 0)
+        return -1;
+    return sw_find(g_target_process.pid, address);
 }
 
 int kernel_clear_breakpoint(int index)
 {
-    if (index < 0 || index >= MAX_SLOT)
+    if (index >= MAX_SLOT)
+        return (kernel_clear_breakpoints(&index, 1) == 1) ? 0 : -1;
+    if (index < 0)
         return -1;
     ActiveBKPTSlot *slot = &guistate.breakpoints[index];
     if (slot->type == SLOT_NONE)
@@ -149,19 +417,112 @@ int kernel_clear_breakpoint(int index)
     case HW_WATCHPOINT_RW:
         ret = ksceKernelSetPHWP(pid, slot->index, 0, 0);
         break;
-    case SW_BREAKPOINT_THUMB:
-    case SW_BREAKPOINT_ARM: {
-        uint8_t size = (slot->type == SW_BREAKPOINT_THUMB) ? 2 : 4;
-        ret = ksceKernelCopyToUserProcTextDomain(pid, (void *)slot->address, &slot->p_instruction, size);
-        break;
-    }
     default:
         return -1;
     }
     clear_slot(slot);
+    if (index == SINGLE_STEP_SLOT)
+        release_step();
     return ret;
 }
 
+// Clears breakpoints by id. SW ones are restored in page batches; entries of a process other than the target are
+// just forgotten. Ones whose memory could not be restored stay set, since the bkpt is still in the text. Returns how
+// many were cleared with their memory restored.
+int kernel_clear_breakpoints(const int *ids, int count)
+{
+    if (!ids)
+        return -1;
+    int cleared = 0;
+    for (int done = 0; done < count;)
+    {
+        int n = 0;
+        for (; done < count && n < SW_PATCH_BATCH; ++done)
+        {
+            const int id = ids[done];
+            const ActiveBKPTSlot *bp = sw_entry(id);
+            if (id < MAX_SLOT)
+                cleared += (kernel_clear_breakpoint(id) >= 0);
+            else if (bp && bp->type != SLOT_NONE)
+            {
+                if (bp->pid == g_target_process.pid)
+                    sw_patches[n++] = (TextPatch){bp->address, bp->p_instruction, NULL, id,
+                                                  (bp->type == SW_BREAKPOINT_THUMB) ? 2 : 4, false};
+                else
+                    sw_release(id);
+            }
+        }
+        swpatch_sort(sw_patches, n);
+        cleared += swpatch_apply(sw_patches, n, &sw_backend);
+        for (int i = 0; i < n; ++i)
+            if (sw_patches[i].ok)
+                sw_release(sw_patches[i].id);
+    }
+    return cleared;
+}
+
+// The process is gone, so there is nothing to restore.
+void kernel_drop_software_breakpoints(SceUID pid)
+{
+    for (int id = kernel_next_breakpoint(MAX_SLOT - 1); id >= 0; id = kernel_next_breakpoint(id))
+        if (sw_entry(id)->pid == pid)
+            sw_release(id);
+}
+
+const ActiveBKPTSlot *kernel_get_breakpoint(int id)
+{
+    return bp_entry(id);
+}
+
+// Next id after the given one that holds a breakpoint, fixed slots first; -1 when there is none.
+int kernel_next_breakpoint(int id)
+{
+    for (++id; id >= 0 && id < MAX_SLOT; ++id)
+        if (guistate.breakpoints[id].type != SLOT_NONE)
+            return id;
+
+    for (uint32_t n = (id < MAX_SLOT) ? 0 : id - MAX_SLOT; n < SW_BKPT_MAX;)
+    {
+        const uint32_t word = sw_used[n / 32] >> (n & 31);
+        if (word)
+        {
+            n += __builtin_ctz(word);
+            if (sw_entry(MAX_SLOT + n)->type != SLOT_NONE)
+                return MAX_SLOT + n;
+            n++;
+        }
+        else
+            n = (n | 31) + 1;
+    }
+    return -1;
+}
+
+int kernel_prev_breakpoint(int id)
+{
+    if (id < 0 || id > BP_ID_MAX)
+        id = BP_ID_MAX;
+    for (int n = id - 1 - MAX_SLOT; n >= 0; --n)
+    {
+        if (!sw_used[n / 32])
+        {
+            n &= ~31;
+            continue;
+        }
+        if (sw_in_use(n) && sw_entry(MAX_SLOT + n)->type != SLOT_NONE)
+            return MAX_SLOT + n;
+    }
+    for (id = (id > MAX_SLOT) ? MAX_SLOT - 1 : id - 1; id >= 0; --id)
+        if (guistate.breakpoints[id].type != SLOT_NONE)
+            return id;
+    return -1;
+}
+
+// Bumped on every change to the SW store, so views can tell when to redraw.
+uint32_t kernel_breakpoint_generation(void)
+{
+    return bp_generation;
+}
+
 int kernel_list_breakpoints(ActiveBKPTSlot *dst)
 {
     if (!dst)
@@ -170,46 +531,18 @@ int kernel_list_breakpoints(ActiveBKPTSlot *dst)
     return 0;
 }
 
+// Registers of the thread the GUI shows, as of its latest stop.
 int kernel_get_registers(SceArmCpuRegisters *dst)
 {
     if (!dst)
         return -1;
-    memcpy(dst, &current_registers, sizeof(SceArmCpuRegisters));
+    ThreadEntry e;
+    memset(dst, 0, sizeof(SceArmCpuRegisters));
+    if (threads_find(&thread_table, g_target_process.exception_thid, &e))
+        memcpy(dst, e.regs, sizeof(e.regs));
     return 0;
 }
 
-int kernel_get_callstack(uint32_t *dst, int depth)
-{
-    if (!dst || depth <= 0)
-        return -1;
-    if (g_target_process.pid <= 0 || g_target_process.exception_thid <= 0 ||
-        ksceKernelIsThreadDebugSuspended(g_target_process.exception_thid) <= 0)
-        return -1;
-        
-    uint32_t call_stack_buffer[MAX_CALL_STACK_DEPTH];
-    int current_depth = 0;
-    int max_depth = (depth < MAX_CALL_STACK_DEPTH) ? depth : MAX_CALL_STACK_DEPTH;
-    call_stack_buffer[current_depth++] = current_registers.pc;
-    uint32_t current_fp = current_registers.r11;
-
-    while (current_depth < max_depth)
-    {
-        if (current_fp == 0 || (current_fp & 3) != 0)
-            break;
-        uint32_t saved_lr, saved_fp;
-        if (ksceKernelCopyFromUserProc(g_target_process.pid, &saved_lr, (void *)(current_fp - 4), sizeof(saved_lr)) <
-                0 ||
-            ksceKernelCopyFromUserProc(g_target_process.pid, &saved_fp, (void *)current_fp, sizeof(saved_fp)) < 0)
-            break;
-        if (saved_lr == 0 || saved_fp == 0 || saved_fp <= current_fp)
-            break;
-        call_stack_buffer[current_depth++] = saved_lr;
-        current_fp = saved_fp;
-    }
-    memcpy(dst, call_stack_buffer, current_depth * sizeof(uint32_t));
-    return current_depth;
-}
-
 int kernel_get_modulelist(SceUID *user_modids, SceSize *user_num)
 {
     if (g_target_process.pid <= 0 || !user_modids || !user_num)
@@ -230,8 +563,68 @@ int kernel_get_moduleinfo(SceKernelModuleInfo *module_info)
     return ksceKernelGetModuleInfo(g_target_process.pid, ksceKernelGetModuleIdByPid(g_target_process.pid), module_info);
 }
 
+static int region_probe(uint32_t addr, uint32_t *block, uint32_t *base, uint32_t *type)
+{
+    SceUID memblock_uid = ksceKernelFindProcMemBlockByAddr(g_target_process.pid, (void *)addr, 0);
+    void *memblock_base;
+    if (memblock_uid <= 0 || ksceKernelGetMemBlockBase(memblock_uid, &memblock_base) < 0 ||
+        ksceKernelGetMemBlockType(memblock_uid, type) < 0)
+        return -1;
+    *block = memblock_uid;
+    *base = (uint32_t)memblock_base;
+    return 0;
+}
+
+// Rebuilds the memblock index when the process or its module list changed since the last build.
+int kernel_refresh_regions(void)
+{
+    if (g_target_process.pid <= 0)
+        return -1;
+
+    SceUID modids[128];
+    SceSize num = sizeof(modids) / sizeof(modids[0]);
+    if (ksceKernelGetModuleList(g_target_process.pid, 0x7FFFFFFF, 1, modids, &num) < 0)
+        num = 0;
+
+    uint32_t signature = g_target_process.pid;
+    for (SceSize i = 0; i < num; ++i)
+        signature = signature * 31 + modids[i];
+    if (region_index.valid && region_index.signature == signature)
+        return region_index.count;
+
+    uint32_t seed_count = 0;
+    for (SceSize i = 0; i < num; ++i)
+    {
+        SceKernelModuleInfo info = {.size = sizeof(SceKernelModuleInfo)};
+        if (ksceKernelGetModuleInfo(g_target_process.pid, modids[i], &info) < 0)
+            continue;
+        for (int j = 0; j < 4; ++j)
+            if (info.segments[j].vaddr && info.segments[j].memsz > 0)
+                region_seeds[seed_count++] = (uint32_t)info.segments[j].vaddr;
+    }
+
+    regions_build(&region_index, region_probe, region_seeds, seed_count, REGION_PROBE_START, REGION_PROBE_END,
+                  REGION_PROBE_STEP);
+    region_index.signature = signature;
+    ksceKernelPrintf("Indexed %u memblocks with %u probes.\n", region_index.count, region_index.probes);
+    return region_index.count;
+}
+
+const RegionIndex *kernel_get_regions(void)
+{
+    return &region_index;
+}
+
 int kernel_get_memblockinfo(const void *address, uint32_t *info)
 {
+    const MemRegion *region = regions_find(&region_index, (uint32_t)address);
+    if (region)
+    {
+        *info = region->type;
+        return 0;
+    }
+
+    // Blocks mapped after the last index build are still found the slow way.
     SceUID memblok_uid = ksceKernelFindProcMemBlockByAddr(g_target_process.pid, address, 0);
     if (memblok_uid <= 0)
         return -1;
@@ -248,148 +641,642 @@ void kernel_suspend_process(void)
 
 void kernel_resume_process(void)
 {
-    if (g_target_process.exception_thid && ksceKernelIsThreadDebugSuspended(g_target_process.exception_thid) > 0)
+    for (uint32_t i = 0; i < THREAD_TABLE_SIZE; ++i)
     {
-        ksceKernelChangeThreadSuspendStatus(g_target_process.exception_thid, 2);
-        ksceKernelResumeProcess(g_target_process.pid);
+        ThreadEntry e;
+        if (threads_snapshot(&thread_table, i, &e) && e.reason != THREAD_RUNNING)
+            kernel_resume_thread(e.thid);
     }
-    else
-        ksceKernelResumeProcess(g_target_process.pid);
-}
-
-static inline bool branch_condition(uint32_t cond, uint32_t cpsr)
-{
-    bool n = (cpsr >> 31) & 1;
-    bool z = (cpsr >> 30) & 1;
-    bool c = (cpsr >> 29) & 1;
-    bool v = (cpsr >> 28) & 1;
-    switch (cond)
-    {
-    case 0:
-        return z;
-    case 1:
-        return !z;
-    case 2:
-        return c;
-    case 3:
-        return !c;
-    case 4:
-        return n;
-    case 5:
-        return !n;
-    case 6:
-        return v;
-    case 7:
-        return !v;
-    case 8:
-        return c && !z;
-    case 9:
-        return !c || z;
-    case 10:
-        return n == v;
-    case 11:
-        return n != v;
-    case 12:
-        return !z && (n == v);
-    case 13:
-        return z || (n != v);
-    case 14:
-        return true;
-    case 15:
-        return false;
-    }
-    return false;
+    ksceKernelResumeProcess(g_target_process.pid);
 }
 
-int kernel_single_step(void)
+static void set_thread_reason(SceUID thid, ThreadReason from, ThreadReason to)
 {
-    if (g_target_process.pid <= 0 || g_target_process.exception_thid <= 0 ||
-        ksceKernelIsThreadDebugSuspended(g_target_process.exception_thid) <= 0)
-        return ksceKernelPrintf("Let a breakpoint be triggered first to use STEP.\n");
-        
-    uint32_t current_pc = current_registers.pc;
-    uint32_t cpsr = current_registers.cpsr;
-    uint32_t next_pc = 0;
-    uint32_t instruction = 0;
+    ThreadEntry *e = threads_lock(&thread_table, thid, false);
+    if (!e)
+        return;
+    if (e->reason == (uint32_t)from || from == THREAD_RUNNING)
+        e->reason = to;
+    threads_unlock(&thread_table, e);
+}
+
+// Records a stop of thid before exception_handler suspends it; < 0 when the table has no room, in which case the
+// thread must not be suspended since nothing could resume it.
+int kernel_thread_stopped(SceUID thid, const SceArmCpuRegisters *regs, ThreadReason reason, int bp)
+{
+    ThreadEntry *e = threads_lock(&thread_table, thid, true);
+    if (!e)
+        return -1;
+    memcpy(e->regs, regs, sizeof(e->regs));
+    e->reason = reason;
+    e->bp = bp;
+    e->stops++;
+    threads_unlock(&thread_table, e);
+
+    // The GUI stays on the thread it shows while that one is stopped; parked threads never take it over.
+    ThreadEntry focus;
+    const SceUID current = g_target_process.exception_thid;
+    if (reason != THREAD_PARKED &&
+        (current <= 0 || !threads_find(&thread_table, current, &focus) || focus.reason == THREAD_RUNNING))
+        g_target_process.exception_thid = thid;
+    __atomic_add_fetch(&suspend_generation, 1, __ATOMIC_RELAXED);
+    return 0;
+}
+
+// True while thid is held at another thread's step target; exception_handler checks again after suspending a parked
+// thread, in case the step finished in between and release_step found it still running.
+bool kernel_thread_parked(SceUID thid)
+{
+    ThreadEntry e;
+    return threads_find(&thread_table, thid, &e) && e.reason == THREAD_PARKED;
+}
+
+bool kernel_owns_step(SceUID thid)
+{
+    return __atomic_load_n(&step_owner, __ATOMIC_ACQUIRE) == thid;
+}
 
-    if (ksceKernelCopyFromUserProc(g_target_process.pid, &instruction, (void *)current_pc, 4) < 0)
+const ThreadTable *kernel_get_threads(void)
+{
+    return &thread_table;
+}
+
+int kernel_select_thread(SceUID thid)
+{
+    ThreadEntry e;
+    if (!threads_find(&thread_table, thid, &e))
         return -1;
+    g_target_process.exception_thid = thid;
+    suspend_generation++;
+    return 0;
+}
+
+int kernel_resume_thread(SceUID thid)
+{
+    ThreadEntry e;
+    if (!threads_find(&thread_table, thid, &e) || e.reason == THREAD_RUNNING)
+        return -1;
+    set_thread_reason(thid, THREAD_RUNNING, THREAD_RUNNING);
+    suspend_generation++;
+    if (ksceKernelIsThreadDebugSuspended(thid) <= 0)
+        return -1;
+    return ksceKernelChangeThreadSuspendStatus(thid, 2);
+}
+
+// The step slot is free again: let go of the threads that ran into it while it was armed for another thread.
+static void release_step(void)
+{
+    __atomic_store_n(&step_owner, 0, __ATOMIC_RELEASE);
+    for (uint32_t i = 0; i < THREAD_TABLE_SIZE; ++i)
+    {
+        ThreadEntry e;
+        if (!threads_snapshot(&thread_table, i, &e) || e.reason != THREAD_PARKED)
+            continue;
+        set_thread_reason(e.thid, THREAD_PARKED, THREAD_RUNNING);
+        if (ksceKernelIsThreadDebugSuspended(e.thid) > 0)
+            ksceKernelChangeThreadSuspendStatus(e.thid, 2);
+    }
+    suspend_generation++;
+}
+
+static int cond_read(uint32_t addr, void *dst, uint32_t size)
+{
+    return ksceKernelCopyFromUserProc(g_target_process.pid, dst, (const void *)addr, size);
+}
+
+// Copies every module's .ARM.exidx into the unwind index after an attach or a change to the module list.
+static void refresh_unwind_index(void)
+{
+    SceUID modids[UNWIND_MAX_MODULES];
+    SceSize num = UNWIND_MAX_MODULES;
+    if (ksceKernelGetModuleList(g_target_process.pid, 0x7FFFFFFF, 1, modids, &num) < 0)
+        return;
+
+    uint32_t signature = g_target_process.pid;
+    for (SceSize i = 0; i < num; ++i)
+        signature = signature * 31 + modids[i];
+    if (unwind_ready && unwind_index.signature == signature)
+        return;
+
+    uint32_t total = 0;
+    for (SceSize i = 0; i < num; ++i)
+    {
+        SceKernelModuleInfo info = {.size = sizeof(SceKernelModuleInfo)};
+        if (ksceKernelGetModuleInfo(g_target_process.pid, modids[i], &info) >= 0 && info.exidx_btm > info.exidx_top)
+            total += ((uint32_t)info.exidx_btm - (uint32_t)info.exidx_top) / sizeof(UnwindEntry);
+    }
+
+    if (unwind_block_uid > 0)
+        ksceKernelFreeMemBlock(unwind_block_uid);
+    unwind_block_uid = 0;
+    unwind_init(&unwind_index, NULL, 0);
+    unwind_index.signature = signature;
+    unwind_ready = true;
+    if (!total)
+        return;
+
+    void *base;
+    const SceSize size = (total * sizeof(UnwindEntry) + 0xFFF) & ~0xFFF;
+    unwind_block_uid = ksceKernelAllocMemBlock("pebble_unwind", SCE_KERNEL_MEMBLOCK_TYPE_KERNEL_RW, size, NULL);
+    if (unwind_block_uid <= 0 || ksceKernelGetMemBlockBase(unwind_block_uid, &base) < 0)
+    {
+        ksceKernelPrintf("Unwind index allocation failed: %#X.\n", unwind_block_uid);
+        if (unwind_block_uid > 0)
+            ksceKernelFreeMemBlock(unwind_block_uid);
+        unwind_block_uid = 0;
+        return;
+    }
+    unwind_init(&unwind_index, base, total);
+    unwind_index.signature = signature;
+
+    // One copy per module straight into the index; unwind_add_module resolves the entries in place.
+    for (SceSize i = 0; i < num; ++i)
+    {
+        SceKernelModuleInfo info = {.size = sizeof(SceKernelModuleInfo)};
+        if (ksceKernelGetModuleInfo(g_target_process.pid, modids[i], &info) < 0 || info.exidx_btm <= info.exidx_top)
+            continue;
+        const uint32_t count = ((uint32_t)info.exidx_btm - (uint32_t)info.exidx_top) / sizeof(UnwindEntry);
+        if (count > unwind_index.capacity - unwind_index.entry_count)
+            break;
+        if (ksceKernelCopyFromUserProc(g_target_process.pid, unwind_index.entries + unwind_index.entry_count,
+                                       info.exidx_top, count * sizeof(UnwindEntry)) < 0)
+            continue;
+        unwind_add_module(&unwind_index, (uint32_t)info.exidx_top, count,
+                          (uint32_t)info.segments[0].vaddr + info.segments[0].memsz);
+    }
+    ksceKernelPrintf("Indexed %u unwind entries in %u modules.\n", unwind_index.entry_count, unwind_index.module_count);
+}
 
-    bool is_thumb = (cpsr & (1 << 5)) != 0;
-    if (is_thumb)
+// Maps the NID database into a memblock on first use; the index points straight into it.
+static void load_nid_db(void)
+{
+    static bool attempted = false;
+    if (attempted)
+        return;
+    attempted = true;
+
+    const SceUID fd = ksceIoOpen(NIDDB_PATH, SCE_O_RDONLY, 0);
+    if (fd < 0)
+        return;
+    const SceOff size = ksceIoLseek(fd, 0, SCE_SEEK_END);
+    ksceIoLseek(fd, 0, SCE_SEEK_SET);
+
+    void *base;
+    if (size > 0 && size < 0x1000000)
     {
-        uint16_t instr16 = instruction & 0xFFFF;
-        bool is_32bit = (instr16 & 0xE000) == 0xE000 || (instr16 & 0xF800) == 0xF000 || (instr16 & 0xF800) == 0xF800;
-        if (!is_32bit)
+        nid_block_uid = ksceKernelAllocMemBlock("pebble_nids", SCE_KERNEL_MEMBLOCK_TYPE_KERNEL_RW,
+                                                ((SceSize)size + 0xFFF) & ~0xFFF, NULL);
+        if (nid_block_uid <= 0 || ksceKernelGetMemBlockBase(nid_block_uid, &base) < 0 ||
+            ksceIoRead(fd, base, (SceSize)size) != size || niddb_open(&nid_db, base, (uint32_t)size) < 0)
         {
-            uint32_t instr_pc = current_pc + 2;
-            if ((instr16 & 0xF800) == 0xE000)
-            {
-                int32_t offset = ((instr16 & 0x7FF) << 1);
-                next_pc = instr_pc + ((offset & 0x800) ? (int32_t)(offset | 0xFFFFF000) : offset);
-            }
-            else if ((instr16 & 0xF000) == 0xD000 && (instr16 & 0x0F00) != 0x0F00 && (instr16 & 0x0F00) != 0x0E00)
-            {
-                uint32_t cond = (instr16 >> 8) & 0xF;
-                int32_t offset = ((instr16 & 0xFF) << 1);
-                next_pc = branch_condition(cond, cpsr)
-                              ? (instr_pc + ((offset & 0x100) ? (int32_t)(offset | 0xFFFFFE00) : offset))
-                              : instr_pc;
-            }
-            else
-                next_pc = instr_pc;
+            ksceKernelPrintf("NID database load failed: %#X.\n", nid_block_uid);
+            if (nid_block_uid > 0)
+                ksceKernelFreeMemBlock(nid_block_uid);
+            nid_block_uid = 0;
+            memset(&nid_db, 0, sizeof(nid_db));
         }
         else
-        {
-            uint32_t instr_pc = current_pc + 4;
-            uint16_t instr_hi = instruction >> 16;
+            ksceKernelPrintf("Loaded %u NIDs.\n", nid_db.count);
+    }
+    ksceIoClose(fd);
+}
 
-            if (((instr16 & 0xF800) == 0xF000) && ((instr_hi & 0xD000) == 0x8000))
-            {
-                uint32_t S = (instr16 >> 10) & 1;
-                uint32_t J1 = (instr_hi >> 13) & 1;
-                uint32_t J2 = (instr_hi >> 11) & 1;
-                uint32_t imm10 = instr16 & 0x3FF;
-                uint32_t imm11 = instr_hi & 0x7FF;
-                int32_t offset = (S << 24) | (J1 << 23) | (J2 << 22) | (imm10 << 12) | (imm11 << 1);
-                offset = S ? (int32_t)(offset | 0xFE000000) : offset;
-                uint32_t cond = (instr16 >> 6) & 0xF;
-                bool is_unconditional = (cond & 0xE) == 0xE || ((instr_hi >> 12) & 0x1);
-                next_pc = is_unconditional || branch_condition(cond, cpsr) ? (instr_pc + offset) : instr_pc;
-            }
-            else
-                next_pc = instr_pc;
+// Rebuilds the symbol index after an attach or a change to the module list. Finding a module's exports means scanning
+// its text for the module info, so this only runs when the signature moves.
+int kernel_refresh_symbols(void)
+{
+    if (g_target_process.pid <= 0)
+        return -1;
+
+    SceUID modids[SYMBOLS_MAX_MODULES];
+    SceSize num = SYMBOLS_MAX_MODULES;
+    if (ksceKernelGetModuleList(g_target_process.pid, 0x7FFFFFFF, 1, modids, &num) < 0)
+        return -1;
+
+    uint32_t signature = g_target_process.pid;
+    for (SceSize i = 0; i < num; ++i)
+        signature = signature * 31 + modids[i];
+    if (symbols_ready && symbol_index.signature == signature)
+        return symbol_index.symbol_count;
+
+    load_nid_db();
+    SymbolExports exports[SYMBOLS_MAX_MODULES];
+    uint32_t total = 0;
+    for (SceSize i = 0; i < num; ++i)
+    {
+        SceKernelModuleInfo info = {.size = sizeof(SceKernelModuleInfo)};
+        if (ksceKernelGetModuleInfo(g_target_process.pid, modids[i], &info) < 0 ||
+            symbols_find_exports((uint32_t)info.segments[0].vaddr, info.segments[0].memsz, info.module_name,
+                                 (uint32_t)info.exidx_top, cond_read, &exports[i]) < 0)
+            memset(&exports[i], 0, sizeof(exports[i]));
+        total += exports[i].count;
+    }
+
+    if (symbol_block_uid > 0)
+        ksceKernelFreeMemBlock(symbol_block_uid);
+    symbol_block_uid = 0;
+    symbols_init(&symbol_index, NULL, 0);
+
+    void *base = NULL;
+    if (total)
+    {
+        const SceSize size = (total * sizeof(Symbol) + 0xFFF) & ~0xFFF;
+        symbol_block_uid = ksceKernelAllocMemBlock("pebble_symbols", SCE_KERNEL_MEMBLOCK_TYPE_KERNEL_RW, size, NULL);
+        if (symbol_block_uid <= 0 || ksceKernelGetMemBlockBase(symbol_block_uid, &base) < 0)
+        {
+            ksceKernelPrintf("Symbol index allocation failed: %#X.\n", symbol_block_uid);
+            if (symbol_block_uid > 0)
+                ksceKernelFreeMemBlock(symbol_block_uid);
+            symbol_block_uid = 0;
+            base = NULL;
         }
     }
-    else
+    symbols_init(&symbol_index, base, base ? total : 0);
+    symbol_index.signature = signature;
+    symbols_ready = true;
+
+    // Modules without an export table or symbol storage still get their segments named.
+    for (SceSize i = 0; i < num; ++i)
     {
-        uint32_t instr_pc = current_pc + 8;
-        uint32_t cond = instruction >> 28;
-        bool condition_met = branch_condition(cond, cpsr);
-        if (condition_met && (instruction & 0x0E000000) == 0x0A000000)
+        SceKernelModuleInfo info = {.size = sizeof(SceKernelModuleInfo)};
+        if (ksceKernelGetModuleInfo(g_target_process.pid, modids[i], &info) < 0)
+            continue;
+        uint32_t seg_base[4], seg_size[4];
+        for (int j = 0; j < 4; ++j)
         {
-            int32_t offset = (instruction & 0x00FFFFFF) << 2;
-            next_pc = instr_pc + ((offset & 0x02000000) ? (int32_t)(offset | 0xFC000000) : offset);
+            seg_base[j] = (uint32_t)info.segments[j].vaddr;
+            seg_size[j] = info.segments[j].memsz;
         }
-        else
-            next_pc = current_pc + 4;
+        symbols_add_module(&symbol_index, info.module_name, seg_base, seg_size, base ? &exports[i] : NULL, cond_read,
+                           nid_db.count ? &nid_db : NULL);
     }
+    symbols_finish(&symbol_index);
+    ksceKernelPrintf("Indexed %u symbols in %u modules.\n", symbol_index.symbol_count, symbol_index.module_count);
+    return symbol_index.symbol_count;
+}
+
+const SymbolIndex *kernel_get_symbols(void)
+{
+    return &symbol_index;
+}
+
+// Copies the stack above sp in one read, clipped to the stack's memblock when the region index knows it.
+static UnwindStack read_stack_window(uint32_t sp)
+{
+    UnwindStack stack = {sp, UNWIND_STACK_WINDOW, unwind_stack};
+    const MemRegion *region = regions_find(&region_index, sp);
+    if (region && region->base + region->size - sp < stack.size)
+        stack.size = region->base + region->size - sp;
+
+    // Blocks the index has not seen yet: shrink until the copy stays mapped.
+    while (stack.size >= 16 &&
+           ksceKernelCopyFromUserProc(g_target_process.pid, unwind_stack, (const void *)sp, stack.size) < 0)
+        stack.size /= 2;
+    if (stack.size < 16)
+        stack.size = 0;
+    return stack;
+}
 
-    uint32_t BCR = (1 << 0) | (0x3 << 1) | (0xF << 5) | (0x1 << 14) | (0x0 << 20);
-    int ret = ksceKernelSetPHBP(g_target_process.pid, SINGLE_STEP_SLOT, (void *)next_pc, BCR);
+// Registers of the thread the GUI shows, when it is suspended by a stop.
+static bool stopped_at_breakpoint(SceArmCpuRegisters *regs)
+{
+    ThreadEntry e;
+    const SceUID thid = g_target_process.exception_thid;
+    if (g_target_process.pid <= 0 || thid <= 0 || !threads_find(&thread_table, thid, &e) ||
+        e.reason == THREAD_RUNNING || ksceKernelIsThreadDebugSuspended(thid) <= 0)
+        return false;
+    memset(regs, 0, sizeof(*regs));
+    memcpy(regs, e.regs, sizeof(e.regs));
+    return true;
+}
+
+int kernel_get_callstack(uint32_t *dst, int depth)
+{
+    SceArmCpuRegisters regs;
+    if (!dst || depth <= 0 || !stopped_at_breakpoint(&regs))
+        return -1;
+
+    refresh_unwind_index();
+    const UnwindStack stack = read_stack_window(regs.sp);
+    // SceArmCpuRegisters starts with r0-r12, sp, lr, pc, the order the unwinder walks.
+    return unwind_backtrace(&unwind_index, (const uint32_t *)&regs, &stack, cond_read, dst,
+                            (depth < MAX_CALL_STACK_DEPTH) ? depth : MAX_CALL_STACK_DEPTH);
+}
+
+// Address of the instruction after the one at regs->pc, following branches whose condition holds. 0 when the
+// instruction cannot be read.
+static uint32_t predict_next_pc(const SceArmCpuRegisters *regs)
+{
+    // SceArmCpuRegisters starts with r0-r12, sp, lr, pc, cpsr, the layout nextpc expects.
+    return nextpc_predict((const uint32_t *)regs, cond_read);
+}
+
+static int arm_step_slot(uint32_t next_pc)
+{
+    ActiveBKPTSlot *slot = &guistate.breakpoints[SINGLE_STEP_SLOT];
+    const bool counted = slot->type != SLOT_NONE;
+    if (!counted)
+        filter_count(SINGLE_STEP_HW_BREAKPOINT, 1);
+    int ret = ksceKernelSetPHBP(g_target_process.pid, SINGLE_STEP_SLOT, (void *)next_pc, HW_BCR);
+    if (ret < 0 && !counted)
+        filter_count(SINGLE_STEP_HW_BREAKPOINT, -1);
     if (ret >= 0)
     {
-        ActiveBKPTSlot *slot = &guistate.breakpoints[SINGLE_STEP_SLOT];
+        if (slot->type != SLOT_NONE)
+            bpindex_remove(&bp_index, slot->address, SINGLE_STEP_SLOT);
         slot->pid = g_target_process.pid;
         slot->address = next_pc;
         slot->index = SINGLE_STEP_SLOT;
         slot->type = SINGLE_STEP_HW_BREAKPOINT;
-        ksceKernelChangeThreadSuspendStatus(g_target_process.exception_thid, 2);
-        ksceKernelResumeProcess(g_target_process.pid);
+        bpindex_insert(&bp_index, next_pc, SINGLE_STEP_SLOT);
+    }
+    return ret;
+}
+
+// Sets the step slot at pc for the thread the GUI shows and lets it run until it gets there. Other threads that reach
+// pc first are parked there until the step is done.
+static int resume_to(uint32_t pc)
+{
+    const SceUID thid = g_target_process.exception_thid;
+    int32_t owner = __atomic_load_n(&step_owner, __ATOMIC_ACQUIRE);
+    // A re-arm step in flight owns the slot until its thread gets past the breakpoint.
+    if (!pc || rearm_id >= 0 || !__atomic_compare_exchange_n(&step_owner, &owner, thid, false, __ATOMIC_ACQ_REL,
+                                                             __ATOMIC_RELAXED))
+        return -1;
+    int ret = arm_step_slot(pc & ~1u);
+    if (ret < 0)
+    {
+        __atomic_store_n(&step_owner, 0, __ATOMIC_RELEASE);
+        return ret;
     }
+    set_thread_reason(thid, THREAD_RUNNING, THREAD_RUNNING);
+    suspend_generation++;
+    ksceKernelChangeThreadSuspendStatus(thid, 2);
+    ksceKernelResumeProcess(g_target_process.pid);
     return ret;
 }
 
+int kernel_single_step(void)
+{
+    SceArmCpuRegisters regs;
+    if (!stopped_at_breakpoint(&regs))
+        return ksceKernelPrintf("Let a breakpoint be triggered first to use STEP.\n");
+    return resume_to(predict_next_pc(&regs));
+}
+
+// Like a single step, except that a call runs to its return address instead of stopping in the callee.
+int kernel_step_over(void)
+{
+    SceArmCpuRegisters regs;
+    if (!stopped_at_breakpoint(&regs))
+        return ksceKernelPrintf("Let a breakpoint be triggered first to use STEP OVER.\n");
+    const uint32_t ret = nextpc_call_return((const uint32_t *)&regs, cond_read);
+    return resume_to(ret ? ret : predict_next_pc(&regs));
+}
+
+// Runs until the current function returns: to the caller found by walking the frame chain, or lr when there is no
+// frame to walk.
+int kernel_step_out(void)
+{
+    SceArmCpuRegisters regs;
+    if (!stopped_at_breakpoint(&regs))
+        return ksceKernelPrintf("Let a breakpoint be triggered first to use STEP OUT.\n");
+    uint32_t callstack[2];
+    const uint32_t ret = (kernel_get_callstack(callstack, 2) == 2) ? callstack[1] : regs.lr;
+    return resume_to(ret);
+}
+
+int kernel_run_to(uint32_t address)
+{
+    SceArmCpuRegisters regs;
+    if (!stopped_at_breakpoint(&regs))
+        return ksceKernelPrintf("Let a breakpoint be triggered first to use RUN TO.\n");
+    return resume_to(address);
+}
+
+int kernel_set_breakpoint_condition(int id, const char *text)
+{
+    ActiveBKPTSlot *bp = bp_entry(id);
+    if (!bp || bp->type == SLOT_NONE || id == SINGLE_STEP_SLOT)
+        return -1;
+
+    const uint8_t old = bp->cond;
+    if (!text || !*text)
+    {
+        release_condition(bp);
+        bp_generation++;
+        return 0;
+    }
+    if (strlen(text) > COND_TEXT_MAX)
+        return -1;
+
+    // Compile into a free entry and switch over, so a hit in flight never sees a half-written program.
+    int n = 0;
+    while (n < MAX_CONDITIONS && (bp_conditions[n].used || entry_pinned(cond_pins, n)))
+        n++;
+    if (n == MAX_CONDITIONS || cond_compile(&bp_conditions[n].program, text) < 0)
+        return -1;
+    BpCondition *c = &bp_conditions[n];
+    strcpy(c->text, text);
+    c->used = true;
+    __atomic_store_n(&bp->cond, n + 1, __ATOMIC_SEQ_CST);
+    if (old)
+        bp_conditions[old - 1].used = false;
+    bp_generation++;
+    return 0;
+}
+
+const char *kernel_get_breakpoint_condition(int id)
+{
+    const ActiveBKPTSlot *bp = kernel_get_breakpoint(id);
+    return (bp && bp->cond) ? bp_conditions[bp->cond - 1].text : NULL;
+}
+
+// Evaluates the condition against the registers of the faulting thread, after kernel_count_hit counted the hit.
+bool kernel_breakpoint_condition_met(int id, const SceArmCpuRegisters *regs)
+{
+    const ActiveBKPTSlot *bp = kernel_get_breakpoint(id);
+    const uint8_t n = bp ? pin_entry(&bp->cond, cond_pins) : 0;
+    if (!n)
+        return true;
+    // SceArmCpuRegisters starts with r0-r12, sp, lr, pc, cpsr, the order conditions index registers in.
+    const bool met = cond_eval(&bp_conditions[n - 1].program, (const uint32_t *)regs, bp->hits, cond_read);
+    unpin_entry(cond_pins, n);
+    return met;
+}
+
+// Hits can land on several cores at once, so the counters are updated atomically; the other fields are plain stores
+// where a lost race only loses one sample.
+void kernel_count_hit(int id)
+{
+    ActiveBKPTSlot *bp = bp_entry(id);
+    if (!bp)
+        return;
+    __atomic_fetch_add(&bp->hits, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&total_hits, 1, __ATOMIC_RELAXED);
+    bp->last_hit = ksceKernelGetSystemTimeLow();
+}
+
+void kernel_note_latency(int id, uint32_t latency_us)
+{
+    ActiveBKPTSlot *bp = bp_entry(id);
+    if (!bp)
+        return;
+    bp->latency_us = (latency_us < 0xFFFF) ? latency_us : 0xFFFF;
+    if (bp->latency_us > bp->max_latency_us)
+        bp->max_latency_us = bp->latency_us;
+}
+
+uint32_t kernel_total_hits(void)
+{
+    return __atomic_load_n(&total_hits, __ATOMIC_RELAXED);
+}
+
+// The ring is allocated with the first tracepoint and kept for the life of the module.
+static TraceRing *get_trace_ring(void)
+{
+    if (trace_ring)
+        return trace_ring;
+    void *base;
+    const SceSize size = (sizeof(TraceRing) + 0xFFF) & ~0xFFF;
+    trace_ring_uid = ksceKernelAllocMemBlock("pebble_trace", SCE_KERNEL_MEMBLOCK_TYPE_KERNEL_RW, size, NULL);
+    if (trace_ring_uid <= 0 || ksceKernelGetMemBlockBase(trace_ring_uid, &base) < 0)
+    {
+        ksceKernelPrintf("Trace ring allocation failed: %#X.\n", trace_ring_uid);
+        if (trace_ring_uid > 0)
+            ksceKernelFreeMemBlock(trace_ring_uid);
+        trace_ring_uid = 0;
+        return NULL;
+    }
+    trace_init(base);
+    trace_ring = base;
+    return trace_ring;
+}
+
+int kernel_set_tracepoint(int id, const char *spec)
+{
+    ActiveBKPTSlot *bp = bp_entry(id);
+    if (!bp || bp->type == SLOT_NONE || id == SINGLE_STEP_SLOT)
+        return -1;
+
+    const uint8_t old = bp->trace;
+    if (!spec || !*spec)
+    {
+        release_trace(bp);
+        bp_generation++;
+        return 0;
+    }
+    if (strlen(spec) > COND_TEXT_MAX || !get_trace_ring())
+        return -1;
+
+    int n = 0;
+    while (n < MAX_TRACEPOINTS && (bp_traces[n].used || entry_pinned(trace_pins, n)))
+        n++;
+    if (n == MAX_TRACEPOINTS || trace_parse_spec(&bp_traces[n].spec, spec) < 0)
+        return -1;
+    strcpy(bp_traces[n].text, spec);
+    bp_traces[n].used = true;
+    __atomic_store_n(&bp->trace, n + 1, __ATOMIC_SEQ_CST);
+    if (old)
+        bp_traces[old - 1].used = false;
+    bp_generation++;
+    return 0;
+}
+
+const char *kernel_get_tracepoint(int id)
+{
+    const ActiveBKPTSlot *bp = kernel_get_breakpoint(id);
+    return (bp && bp->trace) ? bp_traces[bp->trace - 1].text : NULL;
+}
+
+// Logs the hit if id is a tracepoint; true means the caller should let the thread run on.
+bool kernel_trace_hit(int id, SceUID thid, const SceArmCpuRegisters *regs)
+{
+    const ActiveBKPTSlot *bp = kernel_get_breakpoint(id);
+    const uint8_t n = (bp && trace_ring) ? pin_entry(&bp->trace, trace_pins) : 0;
+    if (!n)
+        return false;
+    trace_push(trace_ring, &bp_traces[n - 1].spec, id, bp->address, ksceKernelGetSystemTimeLow(), thid,
+               (const uint32_t *)regs, cond_read);
+    unpin_entry(trace_pins, n);
+    if (trace_pending(trace_ring) == TRACE_RING_SIZE / 2)
+        gui_notify(GUI_EVT_TRACE);
+    return true;
+}
+
+TraceRing *kernel_get_trace_ring(void)
+{
+    return trace_ring;
+}
+
+static int rearm_breakpoint(const ActiveBKPTSlot *bp)
+{
+    switch (bp->type)
+    {
+    case HW_BREAKPOINT:
+        return ksceKernelSetPHBP(bp->pid, bp->index, (void *)bp->address, HW_BCR);
+    case HW_WATCHPOINT_R:
+    case HW_WATCHPOINT_W:
+    case HW_WATCHPOINT_RW:
+        return ksceKernelSetPHWP(bp->pid, bp->index, (void *)bp->address,
+                                 watch_wcr(bp->type - HW_WATCHPOINT_R + BREAK_READ));
+    case SW_BREAKPOINT_THUMB:
+    case SW_BREAKPOINT_ARM: {
+        const uint32_t bkpt_instruction = (bp->type == SW_BREAKPOINT_THUMB) ? SW_THUMB : SW_ARM;
+        return ksceKernelCopyToUserProcTextDomain(bp->pid, (void *)bp->address, &bkpt_instruction,
+                                                  (bp->type == SW_BREAKPOINT_THUMB) ? 2 : 4);
+    }
+    default:
+        return -1;
+    }
+}
+
+// Lifts breakpoint id for one instruction so the thread can run on without stopping: the step slot catches the
+// next instruction, where kernel_finish_rearm puts the breakpoint back. SW breakpoints have already had their
+// original instruction restored by the handler.
+int kernel_step_rearm(int id, SceUID thid, const SceArmCpuRegisters *regs)
+{
+    const ActiveBKPTSlot *bp = kernel_get_breakpoint(id);
+    int32_t free_slot = 0;
+    // Handlers on other cores may get here at the same time; whoever takes the step slot first re-arms.
+    if (!bp || id == SINGLE_STEP_SLOT ||
+        !__atomic_compare_exchange_n(&step_owner, &free_slot, thid, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+        return -1;
+    const uint32_t next_pc = predict_next_pc(regs);
+    if (rearm_id >= 0 || guistate.breakpoints[SINGLE_STEP_SLOT].type != SLOT_NONE || !next_pc)
+    {
+        __atomic_store_n(&step_owner, 0, __ATOMIC_RELEASE);
+        return -1;
+    }
+
+    if (bp->type == HW_BREAKPOINT)
+        ksceKernelSetPHBP(bp->pid, bp->index, 0, 0);
+    else if (bp->type >= HW_WATCHPOINT_R && bp->type <= HW_WATCHPOINT_RW)
+        ksceKernelSetPHWP(bp->pid, bp->index, 0, 0);
+
+    if (arm_step_slot(next_pc) < 0)
+    {
+        rearm_breakpoint(bp);
+        __atomic_store_n(&step_owner, 0, __ATOMIC_RELEASE);
+        return -1;
+    }
+    rearm_id = id;
+    return 0;
+}
+
+// Called when the step slot fires; returns true when it was a re-arm step rather than a user step.
+bool kernel_finish_rearm(void)
+{
+    if (rearm_id < 0)
+        return false;
+    kernel_clear_breakpoint(SINGLE_STEP_SLOT);
+    const ActiveBKPTSlot *bp = kernel_get_breakpoint(rearm_id);
+    if (bp && bp->type != SLOT_NONE)
+        rearm_breakpoint(bp);
+    rearm_id = -1;
+    return true;
+}
+
 int kernel_read_memory(const void *src_addr, void *user_dst, SceSize size)
 {
     if (!src_addr || !user_dst || !size || g_target_process.pid <= 0)
@@ -406,6 +1293,7 @@ int kernel_write_memory(uint32_t dst, const void *user_modification, SceSize mem
 
     if (kernel_get_memblockinfo((void *)dst, &mem_type) >= 0)
     {
+        suspend_generation++; // The edit may land in the snapshotted stack
         if (mem_type == SCE_KERNEL_MEMBLOCK_TYPE_USER_RX)
             return ksceKernelCopyToUserProcTextDomain(g_target_process.pid, (void *)dst, user_modification, memwrite_len);
         else
@@ -415,6 +1303,132 @@ int kernel_write_memory(uint32_t dst, const void *user_modification, SceSize mem
     return -1;
 }
 
+static int batch_read(uint32_t addr, void *dst, uint32_t size)
+{
+    return kernel_read_memory((const void *)addr, dst, size);
+}
+
+static int batch_write(uint32_t addr, const void *src, uint32_t size)
+{
+    return kernel_write_memory(addr, src, size);
+}
+
+static int batch_set_breakpoint(uint32_t addr, uint32_t type)
+{
+    switch (type)
+    {
+    case HW_BREAKPOINT:
+        return kernel_set_hardware_breakpoint(addr);
+    case SW_BREAKPOINT_THUMB:
+    case SW_BREAKPOINT_ARM:
+        return kernel_set_software_breakpoint(addr, type);
+    case HW_WATCHPOINT_R:
+        return kernel_set_watchpoint(addr, BREAK_READ);
+    case HW_WATCHPOINT_W:
+        return kernel_set_watchpoint(addr, BREAK_WRITE);
+    case HW_WATCHPOINT_RW:
+        return kernel_set_watchpoint(addr, BREAK_READ_WRITE);
+    default:
+        return -1;
+    }
+}
+
+static int batch_list_breakpoints(int after, BatchBreakpoint *dst, uint32_t max)
+{
+    uint32_t count = 0;
+    for (int id = kernel_next_breakpoint(after); id >= 0 && count < max; id = kernel_next_breakpoint(id))
+    {
+        const ActiveBKPTSlot *bp = kernel_get_breakpoint(id);
+        if (bp->pid == g_target_process.pid)
+            dst[count++] = (BatchBreakpoint){id, bp->address, bp->type, bp->hits};
+    }
+    return count;
+}
+
+static int batch_get_registers(int32_t thid, uint32_t *regs)
+{
+    ThreadEntry e;
+    if (!threads_find(&thread_table, thid ? thid : g_target_process.exception_thid, &e))
+        return -1;
+    memcpy(regs, e.regs, sizeof(e.regs));
+    return e.reason;
+}
+
+static int batch_list_modules(BatchModule *dst, uint32_t max)
+{
+    SceUID modids[SYMBOLS_MAX_MODULES];
+    SceSize num = (max < SYMBOLS_MAX_MODULES) ? max : SYMBOLS_MAX_MODULES;
+    if (g_target_process.pid <= 0 || ksceKernelGetModuleList(g_target_process.pid, 0x7FFFFFFF, 1, modids, &num) < 0)
+        return -1;
+
+    uint32_t count = 0;
+    for (SceSize i = 0; i < num; ++i)
+    {
+        SceKernelModuleInfo info = {.size = sizeof(SceKernelModuleInfo)};
+        if (ksceKernelGetModuleInfo(g_target_process.pid, modids[i], &info) < 0)
+            continue;
+        BatchModule *mod = &dst[count++];
+        mod->modid = modids[i];
+        mod->text = (uint32_t)info.segments[0].vaddr;
+        mod->text_size = info.segments[0].memsz;
+        memcpy(mod->name, info.module_name, BATCH_NAME_MAX);
+        mod->name[BATCH_NAME_MAX - 1] = '\0';
+    }
+    return count;
+}
+
+static uint8_t *get_batch_buffer(void)
+{
+    if (batch_buffer)
+        return batch_buffer;
+    void *base;
+    const SceSize size = (BATCH_MAX_IN + BATCH_MAX_OUT + 0xFFF) & ~0xFFF;
+    batch_buffer_uid = ksceKernelAllocMemBlock("pebble_batch", SCE_KERNEL_MEMBLOCK_TYPE_KERNEL_RW, size, NULL);
+    if (batch_buffer_uid <= 0 || ksceKernelGetMemBlockBase(batch_buffer_uid, &base) < 0)
+    {
+        ksceKernelPrintf("Batch buffer allocation failed: %#X.\n", batch_buffer_uid);
+        if (batch_buffer_uid > 0)
+            ksceKernelFreeMemBlock(batch_buffer_uid);
+        batch_buffer_uid = 0;
+        return NULL;
+    }
+    batch_buffer = base;
+    return batch_buffer;
+}
+
+// Runs a command buffer from the user side in one round trip: the ops run under the debugger lock, so a client sees
+// the same state the GUI thread would between two frames. Returns the reply size or < 0.
+int kernel_batch(const void *user_in, SceSize in_size, void *user_out, SceSize out_size)
+{
+    static const BatchBackend backend = {
+        .read = batch_read,
+        .write = batch_write,
+        .set_breakpoint = batch_set_breakpoint,
+        .clear_breakpoint = kernel_clear_breakpoint,
+        .list_breakpoints = batch_list_breakpoints,
+        .get_registers = batch_get_registers,
+        .list_modules = batch_list_modules,
+    };
+    if (!user_in || !user_out || in_size < sizeof(BatchHeader) || in_size > BATCH_MAX_IN ||
+        out_size < sizeof(BatchHeader) || debugger_mtx_uid <= 0)
+        return -1;
+    if (out_size > BATCH_MAX_OUT)
+        out_size = BATCH_MAX_OUT;
+    if (ksceKernelLockMutex(debugger_mtx_uid, 1, NULL) < 0)
+        return -1;
+
+    int ret = -1;
+    uint8_t *buffer = get_batch_buffer();
+    if (buffer && ksceKernelMemcpyUserToKernel(buffer, user_in, in_size) >= 0)
+    {
+        ret = batch_execute(buffer, in_size, buffer + BATCH_MAX_IN, out_size, &backend);
+        if (ret > 0 && ksceKernelMemcpyKernelToUser(user_out, buffer + BATCH_MAX_IN, ret) < 0)
+            ret = -1;
+    }
+    ksceKernelUnlockMutex(debugger_mtx_uid, 1);
+    return ret;
+}
+
 void kernel_get_userinfo(SceUID PID_user, SceUID pebble_mtx_uid_user, uint32_t *fb_base0_user, SceUID evtflag_user)
 {
     pebble_mtx_uid = kscePUIDtoGUID(PID_user, pebble_mtx_uid_user);
@@ -427,14 +1441,36 @@ void kernel_get_userinfo(SceUID PID_user, SceUID pebble_mtx_uid_user, uint32_t *
     //ksceKernelPrintf("!!!USRINFO: usrFB0: %#X, usrFB1: %#X\nusrPID: %#X, mtxID: %#X\nkrnlFB0: %#X, krnlFB1: %#X\nevtFlg: %#X, evtFlgUsr: %#X, bufID0: %#X, bufID1: %#X!!!\n", fb_base0_user, fb_base0_user + 0x80000, PID_user, pebble_mtx_uid, fb_bases[0], fb_bases[1], evtflag, evtflag_user, gui_buffer_uids[0], gui_buffer_uids[1]);
 }
 
+void *kernel_heap_alloc(SceSize size)
+{
+    return (heap_uid > 0) ? ksceKernelAllocHeapMemory(heap_uid, size) : NULL;
+}
+
+void kernel_heap_free(void *ptr)
+{
+    if (heap_uid > 0 && ptr)
+        ksceKernelFreeHeapMemory(heap_uid, ptr);
+}
+
+void kernel_frame_presented(void)
+{
+    gui_frame_presented();
+}
+
+uint32_t kernel_lookup_breakpoints(uint32_t addr, uint16_t *slots, uint32_t max)
+{
+    return bpindex_lookup(&bp_index, addr, slots, max);
+}
+
 int kernel_get_breakpoint_index(uint32_t addr)
 {
-    for (int i = 0; i < MAX_SLOT; i++) 
+    uint16_t slots[BPINDEX_MAX_CHAIN];
+    const uint32_t count = bpindex_lookup(&bp_index, addr, slots, BPINDEX_MAX_CHAIN);
+    for (uint32_t i = 0; i < count; i++)
     {
-        if (guistate.breakpoints[i].type != SLOT_NONE && 
-            guistate.breakpoints[i].pid == g_target_process.pid &&
-            guistate.breakpoints[i].address == addr)
-            return i;
+        const ActiveBKPTSlot *bp = kernel_get_breakpoint(slots[i]);
+        if (bp && bp->type != SLOT_NONE && bp->pid == g_target_process.pid && bp->address == addr)
+            return slots[i];
     }
     return -1;
 }
@@ -450,6 +1486,14 @@ int module_start(void)
 
     load_hotkeys();
     kernel_debugger_init();
+    bpindex_init(&bp_index, bp_buckets, BP_BUCKET_BITS, bp_next, BP_ID_MAX);
+
+    gui_evtflag = ksceKernelCreateEventFlag("pebbleGuiEvt", SCE_KERNEL_EVF_ATTR_MULTI, 0, NULL);
+    if (gui_evtflag <= 0)
+        return SCE_KERNEL_START_FAILED;
+    debugger_mtx_uid = ksceKernelCreateMutex("pebbleDebugger", 0, 0, NULL);
+    if (debugger_mtx_uid <= 0)
+        return SCE_KERNEL_START_FAILED;
 
     SceUID thid = ksceKernelCreateThread("pebble", pebble_thread, 0x40, 0x3000, 0, 0, NULL);
     if (thid <= 0)
@@ -0,0 +1,116 @@
+#include "memcache.h"
+
+#include <string.h>
+
+// Page cache in front of the target process, so scrolling does not go back to the kernel for every row.
+
+void memcache_init(MemCache *c, MemReadFn read, uint32_t ttl_us, uint64_t now)
+{
+    memset(c, 0, sizeof(*c));
+    c->read = read;
+    c->ttl_us = ttl_us;
+    c->since = now;
+}
+
+void memcache_invalidate(MemCache *c)
+{
+    // Pages from older generations are refetched the next time they are touched.
+    c->generation++;
+}
+
+void memcache_invalidate_range(MemCache *c, uint32_t addr, uint32_t size)
+{
+    uint32_t first = addr & ~(MEMCACHE_PAGE_SIZE - 1);
+    uint32_t last = (addr + size - 1) & ~(MEMCACHE_PAGE_SIZE - 1);
+    for (int i = 0; i < MEMCACHE_PAGES; ++i)
+        if (c->pages[i].used && c->pages[i].base >= first && c->pages[i].base <= last)
+            c->pages[i].used = false;
+}
+
+static MemCachePage *memcache_find(MemCache *c, uint32_t base)
+{
+    for (int i = 0; i < MEMCACHE_PAGES; ++i)
+        if (c->pages[i].used && c->pages[i].base == base)
+            return &c->pages[i];
+    return NULL;
+}
+
+static MemCachePage *memcache_victim(MemCache *c)
+{
+    MemCachePage *victim = &c->pages[0];
+    for (int i = 0; i < MEMCACHE_PAGES; ++i)
+    {
+        if (!c->pages[i].used)
+            return &c->pages[i];
+        if (c->pages[i].last_use < victim->last_use)
+            victim = &c->pages[i];
+    }
+    return victim;
+}
+
+static void memcache_load(MemCache *c, MemCachePage *page, uint32_t base, uint64_t now)
+{
+    page->base = base;
+    page->used = true;
+    page->generation = c->generation;
+    page->loaded = now;
+    page->readable = c->read(base, page->data, MEMCACHE_PAGE_SIZE) >= 0;
+    if (page->readable)
+        c->bytes_copied += MEMCACHE_PAGE_SIZE;
+    else
+        memset(page->data, 0xFF, MEMCACHE_PAGE_SIZE);
+    c->misses++;
+}
+
+static MemCachePage *memcache_get(MemCache *c, uint32_t base, uint64_t now, bool refresh)
+{
+    MemCachePage *page = memcache_find(c, base);
+    if (!page)
+        memcache_load(c, page = memcache_victim(c), base, now);
+    else if (page->generation != c->generation || (refresh && now - page->loaded >= c->ttl_us))
+        memcache_load(c, page, base, now);
+    else
+        c->hits++;
+    page->last_use = ++c->tick;
+    return page;
+}
+
+int memcache_read(MemCache *c, uint32_t addr, void *dst, uint32_t size, uint64_t now)
+{
+    uint8_t *out = dst;
+    int ret = 0;
+    while (size)
+    {
+        uint32_t base = addr & ~(MEMCACHE_PAGE_SIZE - 1);
+        uint32_t offset = addr - base;
+        uint32_t chunk = MEMCACHE_PAGE_SIZE - offset;
+        if (chunk > size)
+            chunk = size;
+        MemCachePage *page = memcache_get(c, base, now, true);
+        memcpy(out, page->data + offset, chunk);
+        if (!page->readable)
+            ret = -1;
+        out += chunk;
+        addr += chunk;
+        size -= chunk;
+    }
+    return ret;
+}
+
+void memcache_prefetch(MemCache *c, uint32_t addr, uint64_t now)
+{
+    // Prefetched pages are not refreshed on TTL; they only need to exist before the viewport reaches them.
+    memcache_get(c, addr & ~(MEMCACHE_PAGE_SIZE - 1), now, false);
+}
+
+uint32_t memcache_hit_rate(const MemCache *c)
+{
+    uint32_t total = c->hits + c->misses;
+    return total ? (uint32_t)((uint64_t)c->hits * 100 / total) : 0;
+}
+
+uint32_t memcache_bytes_per_sec(const MemCache *c, uint64_t now)
+{
+    uint64_t elapsed = now - c->since;
+    return elapsed ? (uint32_t)(c->bytes_copied * 1000000ULL / elapsed) : 0;
+}
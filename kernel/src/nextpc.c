@@ -0,0 +1,461 @@
+#include "nextpc.h"
+
+// Next-PC prediction for single stepping: where the instruction at regs[15] passes control to, given the registers
+// it executes with. Each instruction set has a rule table covering the ARMv7-A instructions that can write the PC;
+// anything no rule matches falls through to the following instruction.
+
+#define CPSR_T (1u << 5)
+
+typedef struct
+{
+    const uint32_t *regs;
+    NextPcReadFn read;
+    uint32_t pc;   // Address of the instruction
+    uint32_t size; // 2 or 4
+    bool thumb;
+    bool fault;
+} NextPcCtx;
+
+// Returns the new PC, or the fall-through address when the instruction turns out not to branch.
+typedef uint32_t (*NextPcHandler)(NextPcCtx *c, uint32_t insn);
+
+typedef struct
+{
+    uint32_t mask, value;
+    NextPcHandler target;
+} NextPcRule;
+
+bool nextpc_condition(uint32_t cond, uint32_t cpsr)
+{
+    const bool n = (cpsr >> 31) & 1;
+    const bool z = (cpsr >> 30) & 1;
+    const bool c = (cpsr >> 29) & 1;
+    const bool v = (cpsr >> 28) & 1;
+    bool result;
+    switch (cond >> 1)
+    {
+    case 0:
+        result = z;
+        break;
+    case 1:
+        result = c;
+        break;
+    case 2:
+        result = n;
+        break;
+    case 3:
+        result = v;
+        break;
+    case 4:
+        result = c && !z;
+        break;
+    case 5:
+        result = n == v;
+        break;
+    case 6:
+        result = !z && n == v;
+        break;
+    default:
+        return cond == 14; // AL; 15 only appears where the caller handles it
+    }
+    return (cond & 1) ? !result : result;
+}
+
+static uint32_t fallthrough(const NextPcCtx *c)
+{
+    return c->pc + c->size;
+}
+
+// Reading the PC gives the instruction address plus 8 in ARM state and plus 4 in Thumb.
+static uint32_t reg(const NextPcCtx *c, uint32_t n)
+{
+    return (n == 15) ? c->pc + (c->thumb ? 4 : 8) : c->regs[n];
+}
+
+static uint32_t load32(NextPcCtx *c, uint32_t addr)
+{
+    uint32_t value = 0;
+    if (c->read(addr, &value, 4) < 0)
+        c->fault = true;
+    return value;
+}
+
+static int32_t sign_extend(uint32_t value, uint32_t bits)
+{
+    const uint32_t sign = 1u << (bits - 1);
+    return (int32_t)((value ^ sign) - sign);
+}
+
+// BX, loads and ARM data processing interwork: bit 0 selects Thumb, otherwise the target is word aligned.
+static uint32_t bx_write(uint32_t target)
+{
+    return (target & 1) ? target & ~1u : target & ~3u;
+}
+
+static uint32_t shift(uint32_t value, uint32_t type, uint32_t amount)
+{
+    switch (type)
+    {
+    case 0:
+        return (amount >= 32) ? 0 : value << amount;
+    case 1:
+        return (amount >= 32) ? 0 : value >> amount;
+    case 2:
+        return (uint32_t)((int32_t)value >> ((amount >= 32) ? 31 : amount));
+    default:
+        amount &= 31;
+        return amount ? (value >> amount) | (value << (32 - amount)) : value;
+    }
+}
+
+// Immediate shifts encode LSR/ASR #32 as 0, and ROR #0 as RRX.
+static uint32_t shift_imm(uint32_t value, uint32_t type, uint32_t imm5, uint32_t cpsr)
+{
+    if (imm5)
+        return shift(value, type, imm5);
+    if (type == 0)
+        return value;
+    if (type == 3)
+        return (value >> 1) | (((cpsr >> 29) & 1) << 31);
+    return shift(value, type, 32);
+}
+
+// Address of the last register an LDM/POP loads, which is where the PC comes from.
+static uint32_t ldm_pc_slot(uint32_t base, uint32_t list, bool before, bool up)
+{
+    const uint32_t count = __builtin_popcount(list);
+    const uint32_t lowest = up ? base + (before ? 4 : 0) : base - 4 * count + (before ? 0 : 4);
+    return lowest + 4 * (count - 1);
+}
+
+// ARM
+
+static uint32_t arm_branch(NextPcCtx *c, uint32_t insn)
+{
+    return reg(c, 15) + sign_extend((insn & 0xFFFFFF) << 2, 26);
+}
+
+static uint32_t arm_bx(NextPcCtx *c, uint32_t insn)
+{
+    return bx_write(reg(c, insn & 0xF));
+}
+
+static uint32_t arm_ldr(NextPcCtx *c, uint32_t insn)
+{
+    const bool imm = !(insn & (1 << 25)), pre = insn & (1 << 24), up = insn & (1 << 23);
+    if (!imm && (insn & (1 << 4)))
+        return fallthrough(c); // Media instructions
+    const uint32_t offset =
+        imm ? insn & 0xFFF : shift_imm(reg(c, insn & 0xF), (insn >> 5) & 3, (insn >> 7) & 0x1F, c->regs[16]);
+    const uint32_t base = reg(c, (insn >> 16) & 0xF);
+    const uint32_t addr = pre ? (up ? base + offset : base - offset) : base;
+    return bx_write(load32(c, addr));
+}
+
+static uint32_t arm_ldm(NextPcCtx *c, uint32_t insn)
+{
+    const uint32_t addr = ldm_pc_slot(reg(c, (insn >> 16) & 0xF), insn & 0xFFFF, insn & (1 << 24), insn & (1 << 23));
+    return bx_write(load32(c, addr));
+}
+
+// Data processing with Rd = pc: MOV pc, lr / ADD pc, pc, r0, lsl #2 / LDR-free jump tables and the like.
+static uint32_t arm_data(NextPcCtx *c, uint32_t insn)
+{
+    const bool imm = insn & (1 << 25);
+    const uint32_t opcode = (insn >> 21) & 0xF;
+    const uint32_t cpsr = c->regs[16];
+    if ((!imm && (insn & 0x90) == 0x90) || (opcode >= 8 && opcode <= 11))
+        return fallthrough(c); // Multiplies, extra loads/stores, compares and the miscellaneous space
+
+    uint32_t b;
+    if (imm)
+        b = shift(insn & 0xFF, 3, ((insn >> 8) & 0xF) * 2);
+    else if (insn & (1 << 4))
+        b = shift(reg(c, insn & 0xF), (insn >> 5) & 3, reg(c, (insn >> 8) & 0xF) & 0xFF);
+    else
+        b = shift_imm(reg(c, insn & 0xF), (insn >> 5) & 3, (insn >> 7) & 0x1F, cpsr);
+    const uint32_t a = reg(c, (insn >> 16) & 0xF);
+    const uint32_t carry = (cpsr >> 29) & 1;
+
+    uint32_t result = 0;
+    switch (opcode)
+    {
+    case 0:
+        result = a & b;
+        break;
+    case 1:
+        result = a ^ b;
+        break;
+    case 2:
+        result = a - b;
+        break;
+    case 3:
+        result = b - a;
+        break;
+    case 4:
+        result = a + b;
+        break;
+    case 5:
+        result = a + b + carry;
+        break;
+    case 6:
+        result = a + ~b + carry;
+        break;
+    case 7:
+        result = b + ~a + carry;
+        break;
+    case 12:
+        result = a | b;
+        break;
+    case 13:
+        result = b;
+        break;
+    case 14:
+        result = a & ~b;
+        break;
+    case 15:
+        result = ~b;
+        break;
+    }
+    return bx_write(result);
+}
+
+// First match wins, so the specific encodings sit above the broad classes they overlap.
+static const NextPcRule arm_rules[] = {
+    {0x0E000000, 0x0A000000, arm_branch}, // B, BL
+    {0x0FFFFFD0, 0x012FFF10, arm_bx},     // BX, BLX register
+    {0x0C50F000, 0x0410F000, arm_ldr},    // LDR pc
+    {0x0E108000, 0x08108000, arm_ldm},    // LDM/POP with pc
+    {0x0C00F000, 0x0000F000, arm_data},   // Data processing to pc
+};
+
+// Thumb, 16-bit
+
+static uint32_t t16_bcond(NextPcCtx *c, uint32_t insn)
+{
+    const uint32_t cond = (insn >> 8) & 0xF;
+    if (cond >= 14 || !nextpc_condition(cond, c->regs[16]))
+        return fallthrough(c); // 14 is UDF, 15 SVC
+    return reg(c, 15) + sign_extend((insn & 0xFF) << 1, 9);
+}
+
+static uint32_t t16_branch(NextPcCtx *c, uint32_t insn)
+{
+    return reg(c, 15) + sign_extend((insn & 0x7FF) << 1, 12);
+}
+
+static uint32_t t16_cbz(NextPcCtx *c, uint32_t insn)
+{
+    const bool zero = reg(c, insn & 7) == 0, nonzero = insn & (1 << 11);
+    if (zero == nonzero)
+        return fallthrough(c);
+    return reg(c, 15) + (((insn >> 9) & 1) << 6) + (((insn >> 3) & 0x1F) << 1);
+}
+
+static uint32_t t16_bx(NextPcCtx *c, uint32_t insn)
+{
+    return bx_write(reg(c, (insn >> 3) & 0xF));
+}
+
+static uint32_t t16_mov_pc(NextPcCtx *c, uint32_t insn)
+{
+    return reg(c, (insn >> 3) & 0xF) & ~1u;
+}
+
+static uint32_t t16_add_pc(NextPcCtx *c, uint32_t insn)
+{
+    return (reg(c, 15) + reg(c, (insn >> 3) & 0xF)) & ~1u;
+}
+
+static uint32_t t16_pop(NextPcCtx *c, uint32_t insn)
+{
+    return bx_write(load32(c, reg(c, 13) + 4 * __builtin_popcount(insn & 0xFF)));
+}
+
+static const NextPcRule thumb16_rules[] = {
+    {0xF000, 0xD000, t16_bcond},  // B<c>
+    {0xF800, 0xE000, t16_branch}, // B
+    {0xF500, 0xB100, t16_cbz},    // CBZ, CBNZ
+    {0xFF00, 0x4700, t16_bx},     // BX, BLX register
+    {0xFF87, 0x4687, t16_mov_pc}, // MOV pc, Rm
+    {0xFF87, 0x4487, t16_add_pc}, // ADD pc, Rm
+    {0xFF00, 0xBD00, t16_pop},    // POP {..., pc}
+};
+
+// Thumb, 32-bit; insn holds the first halfword in the top half.
+
+// imm32 of B.W, BL and BLX: S:I1:I2:imm10:imm11:0 with I = !(J ^ S).
+static int32_t t32_branch_offset(uint32_t insn)
+{
+    const uint32_t s = (insn >> 26) & 1;
+    const uint32_t i1 = !(((insn >> 13) & 1) ^ s), i2 = !(((insn >> 11) & 1) ^ s);
+    return sign_extend((s << 24) | (i1 << 23) | (i2 << 22) | (((insn >> 16) & 0x3FF) << 12) | ((insn & 0x7FF) << 1),
+                       25);
+}
+
+static uint32_t t32_bcond(NextPcCtx *c, uint32_t insn)
+{
+    const uint32_t cond = (insn >> 22) & 0xF;
+    if (cond >= 14 || !nextpc_condition(cond, c->regs[16]))
+        return fallthrough(c); // 14 and 15 are the branch-space miscellaneous control instructions
+    const uint32_t imm = (((insn >> 26) & 1) << 20) | (((insn >> 11) & 1) << 19) | (((insn >> 13) & 1) << 18) |
+                         (((insn >> 16) & 0x3F) << 12) | ((insn & 0x7FF) << 1);
+    return reg(c, 15) + sign_extend(imm, 21);
+}
+
+static uint32_t t32_branch(NextPcCtx *c, uint32_t insn)
+{
+    return reg(c, 15) + t32_branch_offset(insn);
+}
+
+static uint32_t t32_blx(NextPcCtx *c, uint32_t insn)
+{
+    return (reg(c, 15) & ~3u) + (t32_branch_offset(insn) & ~3);
+}
+
+static uint32_t t32_table(NextPcCtx *c, uint32_t insn)
+{
+    const bool half = insn & (1 << 4);
+    const uint32_t addr = reg(c, (insn >> 16) & 0xF) + (reg(c, insn & 0xF) << half);
+    uint16_t entry = 0;
+    if (c->read(addr, &entry, half ? 2 : 1) < 0)
+        c->fault = true;
+    return reg(c, 15) + 2 * entry;
+}
+
+static uint32_t t32_ldr_literal(NextPcCtx *c, uint32_t insn)
+{
+    const uint32_t base = reg(c, 15) & ~3u, offset = insn & 0xFFF;
+    return bx_write(load32(c, (insn & (1 << 23)) ? base + offset : base - offset));
+}
+
+static uint32_t t32_ldr_imm12(NextPcCtx *c, uint32_t insn)
+{
+    return bx_write(load32(c, reg(c, (insn >> 16) & 0xF) + (insn & 0xFFF)));
+}
+
+// LDR pc, [Rn, #+/-imm8] with pre/post indexing (POP.W {pc} is the post-indexed sp form), or [Rn, Rm, lsl #n].
+static uint32_t t32_ldr(NextPcCtx *c, uint32_t insn)
+{
+    const uint32_t base = reg(c, (insn >> 16) & 0xF);
+    uint32_t addr;
+    if (insn & (1 << 11))
+    {
+        const uint32_t offset = insn & 0xFF;
+        const bool pre = insn & (1 << 10), up = insn & (1 << 9);
+        addr = pre ? (up ? base + offset : base - offset) : base;
+    }
+    else if (!(insn & 0xFC0))
+        addr = base + (reg(c, insn & 0xF) << ((insn >> 4) & 3));
+    else
+        return fallthrough(c);
+    return bx_write(load32(c, addr));
+}
+
+static uint32_t t32_ldm(NextPcCtx *c, uint32_t insn)
+{
+    const bool up = insn & (1 << 23);
+    return bx_write(load32(c, ldm_pc_slot(reg(c, (insn >> 16) & 0xF), insn & 0xFFFF, !up, up)));
+}
+
+static uint32_t t32_subs_pc_lr(NextPcCtx *c, uint32_t insn)
+{
+    return bx_write(reg(c, 14) - (insn & 0xFF));
+}
+
+static const NextPcRule thumb32_rules[] = {
+    {0xFFFFFF00, 0xF3DE8F00, t32_subs_pc_lr},  // SUBS pc, lr, #imm8
+    {0xF800D000, 0xF0008000, t32_bcond},       // B<c>.W
+    {0xF800D000, 0xF0009000, t32_branch},      // B.W
+    {0xF800D000, 0xF000D000, t32_branch},      // BL
+    {0xF800D000, 0xF000C000, t32_blx},         // BLX immediate
+    {0xFFF0FFE0, 0xE8D0F000, t32_table},       // TBB, TBH
+    {0xFF7FF000, 0xF85FF000, t32_ldr_literal}, // LDR pc, [pc, #imm]
+    {0xFFF0F000, 0xF8D0F000, t32_ldr_imm12},   // LDR.W pc, [Rn, #imm12]
+    {0xFFF0F000, 0xF850F000, t32_ldr},         // LDR pc, [Rn, #imm8] / [Rn, Rm]
+    {0xFFD08000, 0xE8908000, t32_ldm},         // LDMIA/POP.W with pc
+    {0xFFD08000, 0xE9108000, t32_ldm},         // LDMDB with pc
+};
+
+static uint32_t apply_rules(NextPcCtx *c, const NextPcRule *rules, uint32_t count, uint32_t insn)
+{
+    for (uint32_t i = 0; i < count; ++i)
+        if ((insn & rules[i].mask) == rules[i].value)
+            return rules[i].target(c, insn);
+    return fallthrough(c);
+}
+
+// Reads the instruction at regs[15] into c; Thumb-2 32-bit instructions keep the first halfword in the top half.
+static bool fetch(NextPcCtx *c, const uint32_t *regs, NextPcReadFn read, uint32_t *insn)
+{
+    *c = (NextPcCtx){regs, read, regs[15], 4, (regs[16] & CPSR_T) != 0, false};
+    if (!c->thumb)
+        return read(c->pc, insn, 4) >= 0;
+
+    uint16_t hw[2];
+    if (read(c->pc, &hw[0], 2) < 0)
+        return false;
+    *insn = hw[0];
+    c->size = 2;
+    if ((hw[0] >> 11) >= 0x1D)
+    {
+        if (read(c->pc + 2, &hw[1], 2) < 0)
+            return false;
+        *insn = (*insn << 16) | hw[1];
+        c->size = 4;
+    }
+    return true;
+}
+
+// 0 when the instruction or a branch target in memory cannot be read.
+uint32_t nextpc_predict(const uint32_t *regs, NextPcReadFn read)
+{
+    NextPcCtx c;
+    uint32_t insn, next;
+    if (!fetch(&c, regs, read, &insn))
+        return 0;
+    const uint32_t cpsr = regs[16];
+
+    if (c.thumb)
+    {
+        // Inside an IT block the condition comes from ITSTATE (cpsr[15:10] and cpsr[26:25]).
+        const uint32_t itstate = ((cpsr >> 8) & 0xFC) | ((cpsr >> 25) & 3);
+        if ((itstate & 0xF) && !nextpc_condition(itstate >> 4, cpsr))
+            next = fallthrough(&c);
+        else if (c.size == 2)
+            next = apply_rules(&c, thumb16_rules, sizeof(thumb16_rules) / sizeof(thumb16_rules[0]), insn);
+        else
+            next = apply_rules(&c, thumb32_rules, sizeof(thumb32_rules) / sizeof(thumb32_rules[0]), insn);
+    }
+    else
+    {
+        const uint32_t cond = insn >> 28;
+        if (cond == 15)
+            // Unconditional space: BLX immediate is the only branch a user thread can run.
+            next = ((insn & 0x0E000000) == 0x0A000000) ? arm_branch(&c, insn) + (((insn >> 24) & 1) << 1)
+                                                       : fallthrough(&c);
+        else if (!nextpc_condition(cond, cpsr))
+            next = fallthrough(&c);
+        else
+            next = apply_rules(&c, arm_rules, sizeof(arm_rules) / sizeof(arm_rules[0]), insn);
+    }
+    return c.fault ? 0 : next;
+}
+
+// Return address of the call at regs[15] (BL, BLX immediate or register), or 0 when it is not a call. A call whose
+// condition fails continues at the same address, so callers need not check it.
+uint32_t nextpc_call_return(const uint32_t *regs, NextPcReadFn read)
+{
+    NextPcCtx c;
+    uint32_t insn;
+    if (!fetch(&c, regs, read, &insn))
+        return 0;
+
+    bool call;
+    if (c.thumb)
+        call = (c.size == 2) ? (insn & 0xFF80) == 0x4780 : (insn & 0xF800C000) == 0xF000C000;
+    else
+        call = (insn & 0x0F000000) == 0x0B000000 || (insn & 0xFE000000) == 0xFA000000 ||
+               (insn & 0x0FFFFFF0) == 0x012FFF30;
+    return call ? fallthrough(&c) : 0;
+}
@@ -0,0 +1,137 @@
+#include "regions.h"
+
+#include <string.h>
+
+// Sorted memblock index for the target process. The probe callback does the kernel lookups so the index can be
+// built against a simulated address space.
+
+void regions_reset(RegionIndex *ri)
+{
+    ri->count = 0;
+    ri->probes = 0;
+    ri->valid = false;
+}
+
+// Index of the first region starting above addr.
+static uint32_t regions_upper(const RegionIndex *ri, uint32_t addr)
+{
+    uint32_t lo = 0, hi = ri->count;
+    while (lo < hi)
+    {
+        const uint32_t mid = (lo + hi) / 2;
+        if (ri->regions[mid].base <= addr)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+int regions_add(RegionIndex *ri, uint32_t base, uint32_t size, uint32_t type)
+{
+    const uint32_t i = regions_upper(ri, base);
+    if (!size || ri->count >= REGION_MAX)
+        return -1;
+    if (i > 0 && ri->regions[i - 1].base + ri->regions[i - 1].size > base)
+        return -1;
+    if (i < ri->count && ri->regions[i].base < base + size)
+        return -1;
+
+    memmove(&ri->regions[i + 1], &ri->regions[i], (ri->count - i) * sizeof(MemRegion));
+    ri->regions[i] = (MemRegion){base, size, type};
+    ri->count++;
+    return 0;
+}
+
+static bool regions_same_block(RegionIndex *ri, RegionProbeFn probe, uint32_t addr, uint32_t block)
+{
+    uint32_t other, base, type;
+    ri->probes++;
+    return probe(addr, &other, &base, &type) >= 0 && other == block;
+}
+
+int regions_explore(RegionIndex *ri, RegionProbeFn probe, uint32_t addr)
+{
+    if (regions_find(ri, addr))
+        return 0;
+
+    uint32_t block, base, type;
+    ri->probes++;
+    if (probe(addr, &block, &base, &type) < 0)
+        return -1;
+
+    // Gallop forward a page at a time, doubling, until we leave the block, then bisect the last gap.
+    uint32_t in = addr & ~(REGION_PAGE_SIZE - 1), out = 0;
+    for (uint32_t step = REGION_PAGE_SIZE;; step <<= 1)
+    {
+        const uint32_t at = in + step;
+        if (at <= in || !regions_same_block(ri, probe, at, block))
+        {
+            out = (at <= in) ? in + REGION_PAGE_SIZE : at;
+            break;
+        }
+        in = at;
+    }
+    while (out - in > REGION_PAGE_SIZE)
+    {
+        const uint32_t mid = in + (((out - in) / 2) & ~(REGION_PAGE_SIZE - 1));
+        if (regions_same_block(ri, probe, mid, block))
+            in = mid;
+        else
+            out = mid;
+    }
+
+    return (regions_add(ri, base, out - base, type) < 0) ? -1 : 1;
+}
+
+void regions_build(RegionIndex *ri, RegionProbeFn probe, const uint32_t *seeds, uint32_t seed_count, uint32_t start,
+                   uint32_t end, uint32_t step)
+{
+    regions_reset(ri);
+
+    // Seeds (module segments) catch blocks smaller than the probe stride.
+    for (uint32_t i = 0; i < seed_count; ++i)
+        regions_explore(ri, probe, seeds[i]);
+
+    for (uint32_t addr = start; addr < end;)
+    {
+        const MemRegion *r = regions_find(ri, addr);
+        if (r)
+        {
+            if (r->base + r->size <= addr)
+                break;
+            addr = r->base + r->size;
+            continue;
+        }
+        if (regions_explore(ri, probe, addr) > 0)
+            continue;
+        if (addr + step < addr)
+            break;
+        addr += step;
+    }
+    ri->valid = true;
+}
+
+const MemRegion *regions_find(const RegionIndex *ri, uint32_t addr)
+{
+    const uint32_t i = regions_upper(ri, addr);
+    if (i > 0 && addr - ri->regions[i - 1].base < ri->regions[i - 1].size)
+        return &ri->regions[i - 1];
+    return NULL;
+}
+
+// Region containing addr, or the first one after it.
+const MemRegion *regions_next(const RegionIndex *ri, uint32_t addr)
+{
+    const uint32_t i = regions_upper(ri, addr);
+    if (i > 0 && addr - ri->regions[i - 1].base < ri->regions[i - 1].size)
+        return &ri->regions[i - 1];
+    return (i < ri->count) ? &ri->regions[i] : NULL;
+}
+
+// Region containing addr, or the last one before it.
+const MemRegion *regions_prev(const RegionIndex *ri, uint32_t addr)
+{
+    const uint32_t i = regions_upper(ri, addr);
+    return (i > 0) ? &ri->regions[i - 1] : NULL;
+}
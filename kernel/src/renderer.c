@@ -3,6 +3,73 @@
 static uint32_t color = 0xFF171717;
 uint8_t buf_index = 0;
 uint32_t *fb_bases[2] = {NULL, NULL};
+static uint16_t glyph_masks[GLYPH_COUNT][FONT_HEIGHT];
+static bool glyphs_ready = false;
+static uint32_t region_sigs[2][DAMAGE_MAX_REGIONS];
+static uint64_t region_valid[2] = {0, 0};
+static RenderFrameStats frame_stats, last_frame_stats;
+static SceUID backdrop_uid = 0;
+static uint32_t *backdrop = NULL;
+static bool backdrop_valid = false;
+
+static inline uint32_t renderer_blendPixel(uint32_t dst, uint32_t src_rb, uint32_t src_g, uint32_t inv)
+{
+    // src_rb/src_g are the source channels premultiplied by alpha (0..256), two channels per multiply.
+    uint32_t rb = ((src_rb + (dst & 0xFF00FF) * inv) >> 8) & 0xFF00FF;
+    uint32_t g = ((src_g + (dst & 0x00FF00) * inv) >> 8) & 0x00FF00;
+    return 0xFF000000 | rb | g;
+}
+
+static inline void renderer_blendRowScalar(uint32_t *dst, uint32_t clr, uint32_t count)
+{
+    uint32_t a = clr >> 24;
+    a += a >> 7;
+    const uint32_t src_rb = (clr & 0xFF00FF) * a;
+    const uint32_t src_g = (clr & 0x00FF00) * a;
+    const uint32_t inv = 256 - a;
+    for (uint32_t i = 0; i < count; ++i)
+        dst[i] = renderer_blendPixel(dst[i], src_rb, src_g, inv);
+}
+
+#if defined(__arm__) && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+extern void renderer_fillRowNeon(uint32_t *dst, uint32_t clr, uint32_t count);
+extern void renderer_blendRowNeon(uint32_t *dst, uint32_t clr, uint32_t count);
+#define renderer_fillRow renderer_fillRowNeon
+
+static inline void renderer_blendRow(uint32_t *dst, uint32_t clr, uint32_t count)
+{
+    // The NEON kernel only takes whole groups of 8 pixels.
+    uint32_t vec = count & ~7;
+    if (vec)
+        renderer_blendRowNeon(dst, clr, vec);
+    renderer_blendRowScalar(dst + vec, clr, count - vec);
+}
+#else
+static inline void renderer_fillRow(uint32_t *dst, uint32_t clr, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i)
+        dst[i] = clr;
+}
+#define renderer_blendRow renderer_blendRowScalar
+#endif
+
+static void renderer_damage(uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint32_t pixels)
+{
+    frame_stats.bytes_written += pixels * sizeof(uint32_t);
+    frame_stats.draw_calls++;
+    RenderRect *b = &frame_stats.bounds;
+    if (b->w == 0 || b->h == 0)
+    {
+        *b = (RenderRect){x, y, w, h};
+        return;
+    }
+    uint32_t endX = (x + w > b->x + b->w) ? x + w : b->x + b->w;
+    uint32_t endY = (y + h > b->y + b->h) ? y + h : b->y + b->h;
+    b->x = (x < b->x) ? x : b->x;
+    b->y = (y < b->y) ? y : b->y;
+    b->w = endX - b->x;
+    b->h = endY - b->y;
+}
 
 void renderer_drawImage(uint32_t x, uint32_t y, uint32_t w, uint32_t h, const unsigned char *img)
 {
@@ -32,39 +99,136 @@ void renderer_drawImage(uint32_t x, uint32_t y, uint32_t w, uint32_t h, const un
     }
 }
 
-void renderer_drawChar(char c, int x, int y)
+static void renderer_buildGlyphs(void)
+{
+    // Expand the 1bpp MSB-first font once into per-row masks where bit N is column N.
+    for (uint32_t g = 0; g < GLYPH_COUNT; ++g)
+    {
+        const unsigned char *src = &font[g * GLYPH_BYTES];
+        for (uint32_t row = 0; row < FONT_HEIGHT; ++row)
+        {
+            uint32_t bits = (src[row * 2] << 8) | src[row * 2 + 1];
+            uint16_t mask = 0;
+            for (uint32_t col = 0; col < FONT_WIDTH; ++col)
+                if (bits & (0x8000 >> col))
+                    mask |= 1 << col;
+            glyph_masks[g][row] = mask;
+        }
+    }
+    glyphs_ready = true;
+}
+
+static void renderer_blitGlyph(const uint16_t *rows, int x, int y, bool blend)
 {
-    if (c < 32 || c > 126)
+    uint32_t a = color >> 24;
+    a += a >> 7;
+    const uint32_t src_rb = (color & 0xFF00FF) * a;
+    const uint32_t src_g = (color & 0x00FF00) * a;
+    const uint32_t inv = 256 - a;
+
+    uint32_t clip = (1 << FONT_WIDTH) - 1;
+    if (x < 0)
+        clip &= clip << -x;
+    if (x + FONT_WIDTH > UI_WIDTH)
+        clip &= (1 << (UI_WIDTH - x)) - 1;
+
+    int first_row = (y < 0) ? -y : 0;
+    int last_row = (y + FONT_HEIGHT > UI_HEIGHT) ? UI_HEIGHT - y : FONT_HEIGHT;
+    uint32_t pixels = 0;
+    for (int row = first_row; row < last_row; ++row)
+    {
+        uint32_t mask = rows[row] & clip;
+        if (!mask)
+            continue;
+        pixels += __builtin_popcount(mask);
+        uint32_t *row_ptr = fb_bases[buf_index] + (y + row) * UI_WIDTH + x;
+        while (mask)
+        {
+            uint32_t *px = &row_ptr[__builtin_ctz(mask)];
+            *px = blend ? renderer_blendPixel(*px, src_rb, src_g, inv) : color;
+            mask &= mask - 1;
+        }
+    }
+    int left = (x < 0) ? 0 : x;
+    int right = (x + FONT_WIDTH > UI_WIDTH) ? UI_WIDTH : x + FONT_WIDTH;
+    if (blend)
+        frame_stats.blended_pixels += pixels;
+    if (pixels)
+        renderer_damage(left, y + first_row, right - left, last_row - first_row, pixels);
+}
+
+static void renderer_drawGlyph(char c, int x, int y, bool blend)
+{
+    if (!fb_bases[buf_index] || c < 32 || c > 126 || x <= -FONT_WIDTH || x >= UI_WIDTH || y <= -FONT_HEIGHT || y >= UI_HEIGHT)
         return;
-    renderer_drawImage(x, y, FONT_WIDTH, FONT_HEIGHT, &font[(uint32_t)(c - 32) * 40]);
+    if (!glyphs_ready)
+        renderer_buildGlyphs();
+    renderer_blitGlyph(glyph_masks[c - GLYPH_FIRST], x, y, blend);
 }
 
-void renderer_drawRectangle(uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint32_t clr)
+void renderer_drawChar(char c, int x, int y)
+{
+    renderer_drawGlyph(c, x, y, false);
+}
+
+static bool renderer_clipRect(uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint32_t *endX, uint32_t *endY)
 {
     if (!fb_bases[buf_index] || w == 0 || h == 0 || x >= UI_WIDTH || y >= UI_HEIGHT)
-        return;
-    uint32_t endX = x + w;
-    uint32_t endY = y + h;
-    if (endX > UI_WIDTH)
-        endX = UI_WIDTH;
-    if (endY > UI_HEIGHT)
-        endY = UI_HEIGHT;
-    if (x >= endX || y >= endY)
+        return false;
+    *endX = (x + w > UI_WIDTH) ? UI_WIDTH : x + w;
+    *endY = (y + h > UI_HEIGHT) ? UI_HEIGHT : y + h;
+    return x < *endX && y < *endY;
+}
+
+void renderer_drawRectangle(uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint32_t clr)
+{
+    uint32_t endX, endY;
+    if (!renderer_clipRect(x, y, w, h, &endX, &endY))
         return;
     for (uint32_t j = y; j < endY; ++j)
+        renderer_fillRow(fb_bases[buf_index] + j * UI_WIDTH + x, clr, endX - x);
+    renderer_damage(x, y, endX - x, endY - y, (endX - x) * (endY - y));
+}
+
+void renderer_blendRectangle(uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint32_t clr)
+{
+    uint32_t alpha = clr >> 24;
+    if (alpha == 0)
+        return;
+    // Opaque colors, and anything past this frame's blend budget, degrade to a plain fill.
+    if (alpha == 0xFF || frame_stats.blend_us >= RENDER_BLEND_BUDGET_US)
     {
-        uint32_t *row_ptr = fb_bases[buf_index] + j * UI_WIDTH + x;
-        for (uint32_t i = 0; i < (endX - x); ++i)
-            row_ptr[i] = clr;
+        renderer_drawRectangle(x, y, w, h, clr | 0xFF000000);
+        return;
     }
+    uint32_t endX, endY;
+    if (!renderer_clipRect(x, y, w, h, &endX, &endY))
+        return;
+    uint64_t start = ksceKernelGetSystemTimeWide();
+    for (uint32_t j = y; j < endY; ++j)
+        renderer_blendRow(fb_bases[buf_index] + j * UI_WIDTH + x, clr, endX - x);
+    frame_stats.blend_us += ksceKernelGetSystemTimeWide() - start;
+    frame_stats.blended_pixels += (endX - x) * (endY - y);
+    renderer_damage(x, y, endX - x, endY - y, (endX - x) * (endY - y));
 }
 
 void renderer_clearRectangle(uint32_t x, uint32_t y, uint32_t w, uint32_t h)
 {
-    renderer_drawRectangle(x, y, w, h, 0x80171717);
+    if (!backdrop_valid)
+    {
+        renderer_drawRectangle(x, y, w, h, CLEAR_COLOR);
+        return;
+    }
+    // The backdrop already holds the game frame under CLEAR_COLOR, so clearing is a row copy.
+    uint32_t endX, endY;
+    if (!renderer_clipRect(x, y, w, h, &endX, &endY))
+        return;
+    for (uint32_t j = y; j < endY; ++j)
+        memcpy(fb_bases[buf_index] + j * UI_WIDTH + x, backdrop + j * UI_WIDTH + x, (endX - x) * sizeof(uint32_t));
+    renderer_damage(x, y, endX - x, endY - y, (endX - x) * (endY - y));
 }
 
-void renderer_drawString(int x, int y, const char *str)
+static void renderer_drawText(int x, int y, const char *str, bool blend)
 {
     if (!str || !fb_bases[buf_index] || y < -FONT_HEIGHT || y >= UI_HEIGHT)
         return;
@@ -75,11 +239,22 @@ void renderer_drawString(int x, int y, const char *str)
         if (cx >= UI_WIDTH)
             break;
         if (cx + FONT_WIDTH > 0 && c != ' ')
-            renderer_drawChar(c, cx, y);
+            renderer_drawGlyph(c, cx, y, blend);
         cx += FONT_WIDTH;
     }
 }
 
+void renderer_drawString(int x, int y, const char *str)
+{
+    renderer_drawText(x, y, str, false);
+}
+
+void renderer_drawStringBlend(int x, int y, const char *str)
+{
+    // Translucent text only makes sense for colors with alpha below 0xFF.
+    renderer_drawText(x, y, str, (color >> 24) != 0xFF);
+}
+
 void renderer_drawStringF(int x, int y, const char *format, ...)
 {
     char str[512];
@@ -115,7 +290,52 @@ void draw_frame(int x, int y, int width, int height, uint32_t color)
 //    ksceKernelUnlockMutex(pebble_mtx_uid, 1);
 //}
 
-int renderer_init(void)
+static void renderer_captureBackdrop(SceUID pid)
+{
+    backdrop_valid = false;
+    if (pid <= 0)
+        return;
+    if (!backdrop)
+    {
+        backdrop_uid = ksceKernelAllocMemBlock("pebble_backdrop", SCE_KERNEL_MEMBLOCK_TYPE_KERNEL_RW, 0x200000, NULL);
+        if (backdrop_uid <= 0 || ksceKernelGetMemBlockBase(backdrop_uid, (void **)&backdrop) < 0)
+        {
+            backdrop = NULL;
+            return;
+        }
+    }
+
+    SceDisplayFrameBufInfo info;
+    memset(&info, 0, sizeof(info));
+    info.size = sizeof(info);
+    const SceDisplayFrameBuf *fb = &info.framebuf;
+    if (ksceDisplayGetFrameBufInfoForPid(pid, 0, 0, &info) < 0 || !fb->base || fb->width == 0 || fb->height == 0 ||
+        fb->width > BACKDROP_MAX_PITCH || fb->pitch > BACKDROP_MAX_PITCH || fb->pitch < fb->width ||
+        fb->pixelformat != SCE_DISPLAY_PIXELFORMAT_A8B8G8R8)
+        return;
+
+    // Games may render below 960x544, so scale the captured frame with nearest-neighbour sampling.
+    static uint32_t line[BACKDROP_MAX_PITCH];
+    uint32_t clr = CLEAR_COLOR;
+    uint32_t a = clr >> 24;
+    a += a >> 7;
+    const uint32_t src_rb = (clr & 0xFF00FF) * a;
+    const uint32_t src_g = (clr & 0x00FF00) * a;
+    const uint32_t inv = 256 - a;
+    for (uint32_t j = 0; j < UI_HEIGHT; ++j)
+    {
+        uint32_t sy = j * fb->height / UI_HEIGHT;
+        const uint32_t *src = (const uint32_t *)fb->base + sy * fb->pitch;
+        if (ksceKernelCopyFromUserProc(pid, line, src, fb->width * sizeof(uint32_t)) < 0)
+            return;
+        uint32_t *dst = backdrop + j * UI_WIDTH;
+        for (uint32_t i = 0; i < UI_WIDTH; ++i)
+            dst[i] = renderer_blendPixel(line[i * fb->width / UI_WIDTH], src_rb, src_g, inv);
+    }
+    backdrop_valid = true;
+}
+
+int renderer_init(SceUID pid)
 {
     //SceKernelAllocMemBlockKernelOpt optp_1;
 	//optp_1.size = sizeof(SceKernelAllocMemBlockKernelOpt);
@@ -155,6 +375,11 @@ int renderer_init(void)
     //    return -1;
     //}
     
+    if (!glyphs_ready)
+        renderer_buildGlyphs();
+    region_valid[0] = 0;
+    region_valid[1] = 0;
+    renderer_captureBackdrop(pid);
     renderer_clearRectangle(0, 0, UI_WIDTH, UI_HEIGHT);
     buf_index ^= 1;
     renderer_clearRectangle(0, 0, UI_WIDTH, UI_HEIGHT);
@@ -164,4 +389,48 @@ int renderer_init(void)
 void renderer_setColor(uint32_t c)
 {
     color = c;
-}
\ No newline at end of file
+}
+
+uint32_t renderer_hash(uint32_t seed, const void *data, uint32_t size)
+{
+    // FNV-1a, only used to tell whether a UI region needs repainting.
+    const uint8_t *p = data;
+    uint32_t h = seed ^ 0x811C9DC5;
+    while (size--)
+        h = (h ^ *p++) * 0x01000193;
+    return h;
+}
+
+bool renderer_regionChanged(uint32_t region, uint32_t signature)
+{
+    // Each framebuffer remembers what it last showed per region, since the two are drawn alternately.
+    if (region >= DAMAGE_MAX_REGIONS)
+        return true;
+    uint64_t bit = 1ULL << region;
+    if ((region_valid[buf_index] & bit) && region_sigs[buf_index][region] == signature)
+        return false;
+    region_sigs[buf_index][region] = signature;
+    region_valid[buf_index] |= bit;
+    frame_stats.regions_redrawn++;
+    return true;
+}
+
+void renderer_invalidate(void)
+{
+    region_valid[buf_index] = 0;
+}
+
+void renderer_beginFrame(void)
+{
+    memset(&frame_stats, 0, sizeof(frame_stats));
+}
+
+void renderer_endFrame(void)
+{
+    last_frame_stats = frame_stats;
+}
+
+const RenderFrameStats *renderer_getFrameStats(void)
+{
+    return &last_frame_stats;
+}
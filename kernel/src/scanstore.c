@@ -0,0 +1,282 @@
+#include "scanstore.h"
+
+#include <string.h>
+
+// Candidate store for narrowing scans. Each page keeps whichever encoding is smaller: a slot bitmap or a list of
+// varint slot deltas. Narrowing only removes candidates, and neither encoding can grow when a set shrinks, so a
+// rescan compacts the arena in place.
+
+static inline ScanPage *scanstore_page(const ScanStore *st, uint32_t index)
+{
+    return (ScanPage *)(st->arena + st->arena_size) - 1 - index;
+}
+
+static inline uint32_t scanstore_load(const uint8_t *p, uint32_t width)
+{
+    uint32_t v = 0;
+    memcpy(&v, p, width);
+    return v;
+}
+
+void scanstore_init(ScanStore *st, void *arena, uint32_t size)
+{
+    st->arena = arena;
+    st->arena_size = size & ~3;
+    scanstore_reset(st, 4, false);
+}
+
+// Places the store at the start of the block and hands it the rest as its arena, so its working buffers come out of
+// the same block as the candidates.
+ScanStore *scanstore_create(void *block, uint32_t size)
+{
+    const uint32_t header = (sizeof(ScanStore) + 7) & ~7;
+    if (size < header + SCANSTORE_PAGE_SIZE)
+        return NULL;
+    ScanStore *st = block;
+    scanstore_init(st, (uint8_t *)block + header, size - header);
+    return st;
+}
+
+void scanstore_reset(ScanStore *st, uint32_t width, bool is_float)
+{
+    st->used = 0;
+    st->page_count = 0;
+    st->total = 0;
+    st->width = width;
+    st->shift = (width == 4) ? 2 : (width == 2) ? 1 : 0;
+    st->is_float = is_float;
+    st->overflow = false;
+    st->narrowing = false;
+}
+
+static uint32_t scanstore_bitmap_bytes(const ScanStore *st)
+{
+    return (SCANSTORE_PAGE_SIZE >> st->shift) / 8;
+}
+
+// Encodes st->slots[0..count) into st->encoded, returning the size and picking the smaller format.
+static uint32_t scanstore_encode(ScanStore *st, uint32_t count, uint8_t *format)
+{
+    const uint32_t bitmap_bytes = scanstore_bitmap_bytes(st);
+    uint8_t *delta = st->encoded + bitmap_bytes;
+    uint32_t len = 0, prev = 0;
+
+    for (uint32_t k = 0; k < count && len < bitmap_bytes; ++k)
+    {
+        uint32_t gap = st->slots[k] - prev;
+        prev = st->slots[k];
+        do
+        {
+            delta[len++] = (gap & 0x7F) | ((gap > 0x7F) ? 0x80 : 0);
+            gap >>= 7;
+        } while (gap && len < bitmap_bytes);
+    }
+
+    if (len < bitmap_bytes)
+    {
+        memmove(st->encoded, delta, len);
+        *format = SCANSTORE_DELTA;
+        return len;
+    }
+
+    memset(st->encoded, 0, bitmap_bytes);
+    for (uint32_t k = 0; k < count; ++k)
+        st->encoded[st->slots[k] >> 3] |= 1 << (st->slots[k] & 7);
+    *format = SCANSTORE_BITMAP;
+    return bitmap_bytes;
+}
+
+static uint32_t scanstore_decode(ScanStore *st, const ScanPage *pg)
+{
+    const uint8_t *p = st->arena + pg->offset;
+
+    if (pg->format == SCANSTORE_BITMAP)
+    {
+        uint32_t count = 0;
+        for (uint32_t i = 0; i < pg->encoded; ++i)
+            for (uint32_t b = p[i]; b; b &= b - 1)
+                st->slots[count++] = i * 8 + __builtin_ctz(b);
+        return count;
+    }
+
+    uint32_t slot = 0;
+    for (uint32_t k = 0; k < pg->count; ++k)
+    {
+        uint32_t gap = 0;
+        for (int shift = 0;; shift += 7)
+        {
+            const uint8_t b = *p++;
+            gap |= (b & 0x7F) << shift;
+            if (!(b & 0x80))
+                break;
+        }
+        slot += gap;
+        st->slots[k] = slot;
+    }
+    return pg->count;
+}
+
+// Writes the page for st->slots[0..count) at the given directory slot and arena offset, with values taken from data.
+static int scanstore_emit(ScanStore *st, uint32_t index, uint32_t offset, uint32_t base, uint32_t count,
+                          const uint8_t *data)
+{
+    uint8_t format;
+    const uint32_t encoded = scanstore_encode(st, count, &format);
+    const bool snapshot = count * st->width >= SCANSTORE_PAGE_SIZE;
+    const uint32_t size = encoded + (snapshot ? SCANSTORE_PAGE_SIZE : count * st->width);
+
+    if (offset + size > st->arena_size - (index + 1) * sizeof(ScanPage))
+    {
+        st->overflow = true;
+        return -1;
+    }
+
+    uint8_t *dst = st->arena + offset;
+    memcpy(dst, st->encoded, encoded);
+    dst += encoded;
+    if (snapshot)
+        memcpy(dst, data, SCANSTORE_PAGE_SIZE);
+    else
+        for (uint32_t k = 0; k < count; ++k, dst += st->width)
+            memcpy(dst, data + (st->slots[k] << st->shift), st->width);
+
+    ScanPage *pg = scanstore_page(st, index);
+    pg->base = base;
+    pg->offset = offset;
+    pg->count = count;
+    pg->encoded = encoded;
+    pg->format = format;
+    pg->snapshot = snapshot;
+    return size;
+}
+
+int scanstore_add_page(ScanStore *st, uint32_t base, const uint32_t *bits, const uint8_t *data)
+{
+    uint32_t count = 0;
+    for (uint32_t w = 0; w < (SCANSTORE_PAGE_SIZE >> st->shift) / 32u; ++w)
+        for (uint32_t b = bits[w]; b; b &= b - 1)
+            st->slots[count++] = w * 32 + __builtin_ctz(b);
+    if (!count)
+        return 0;
+
+    int size = scanstore_emit(st, st->page_count, st->used, base, count, data);
+    if (size < 0)
+        return -1;
+    scanstore_page(st, st->page_count)->first = st->total;
+    st->page_count++;
+    st->used += size;
+    st->total += count;
+    return count;
+}
+
+void scanstore_narrow_begin(ScanStore *st, ScanFilter filter, uint32_t value)
+{
+    if (st->is_float)
+    {
+        // Same integer entry as search_query_value.
+        float f = (float)(int32_t)value;
+        memcpy(&value, &f, sizeof(value));
+    }
+    st->filter = filter;
+    st->value = value;
+    st->cursor = 0;
+    st->write = 0;
+    st->write_offset = 0;
+    st->written = 0;
+    st->narrowing = true;
+}
+
+static bool scanstore_keep(const ScanStore *st, uint32_t prev, uint32_t cur)
+{
+    switch (st->filter)
+    {
+    case SCAN_EQUAL:
+        return cur == st->value;
+    case SCAN_CHANGED:
+        return cur != prev;
+    case SCAN_UNCHANGED:
+        return cur == prev;
+    default:
+        break;
+    }
+
+    if (st->is_float)
+    {
+        float p, c;
+        memcpy(&p, &prev, sizeof(p));
+        memcpy(&c, &cur, sizeof(c));
+        return (st->filter == SCAN_INCREASED) ? c > p : c < p;
+    }
+    return (st->filter == SCAN_INCREASED) ? cur > prev : cur < prev;
+}
+
+bool scanstore_narrow_step(ScanStore *st, ScanReadFn read, uint32_t budget_pages)
+{
+    for (; st->narrowing && budget_pages; --budget_pages)
+    {
+        if (st->cursor >= st->page_count)
+        {
+            st->page_count = st->write;
+            st->used = st->write_offset;
+            st->total = st->written;
+            st->narrowing = false;
+            break;
+        }
+
+        const ScanPage pg = *scanstore_page(st, st->cursor++);
+        if (read(pg.base, st->page_data, SCANSTORE_PAGE_SIZE) < 0)
+            continue; // Unmapped since the last scan, nothing there can match
+
+        const uint32_t count = scanstore_decode(st, &pg);
+        const uint8_t *prev = st->arena + pg.offset + pg.encoded;
+        uint32_t kept = 0;
+        for (uint32_t k = 0; k < count; ++k)
+        {
+            const uint32_t at = st->slots[k] << st->shift;
+            const uint32_t old = scanstore_load(prev + (pg.snapshot ? at : k * st->width), st->width);
+            if (scanstore_keep(st, old, scanstore_load(st->page_data + at, st->width)))
+                st->slots[kept++] = st->slots[k];
+        }
+        if (!kept)
+            continue;
+
+        int size = scanstore_emit(st, st->write, st->write_offset, pg.base, kept, st->page_data);
+        if (size < 0)
+            continue;
+        scanstore_page(st, st->write)->first = st->written;
+        st->write++;
+        st->write_offset += size;
+        st->written += kept;
+    }
+    return st->narrowing;
+}
+
+int scanstore_get(ScanStore *st, uint32_t index, uint32_t *addr, uint32_t *value)
+{
+    if (st->narrowing || index >= st->total)
+        return -1;
+
+    uint32_t lo = 0, hi = st->page_count;
+    while (hi - lo > 1)
+    {
+        const uint32_t mid = (lo + hi) / 2;
+        if (scanstore_page(st, mid)->first <= index)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    const ScanPage *pg = scanstore_page(st, lo);
+    scanstore_decode(st, pg);
+    const uint32_t k = index - pg->first;
+    const uint32_t at = st->slots[k] << st->shift;
+    *addr = pg->base + at;
+    if (value)
+        *value = scanstore_load(st->arena + pg->offset + pg->encoded + (pg->snapshot ? at : k * st->width), st->width);
+    return 0;
+}
+
+uint32_t scanstore_footprint(const ScanStore *st)
+{
+    return st->used + st->page_count * sizeof(ScanPage);
+}
@@ -0,0 +1,77 @@
+#include "scheduler.h"
+
+// Pure timing policy for pebble_thread, kept free of kernel calls so it can be driven by a simulated clock.
+//
+// Controls can only be polled, so a visible GUI still wakes up: at frame rate while buttons are in use and for a
+// moment after, and at SCHED_IDLE_POLL_US otherwise. Frames are drawn only when something marked the GUI dirty, or
+// when the view shows live target data and its refresh period ran out.
+
+void sched_init(GuiScheduler *s)
+{
+    s->last_frame = 0;
+    s->last_wakeup = 0;
+    s->last_input = 0;
+    s->wakeups = 0;
+    s->refresh_us = 0;
+    s->dirty = true;
+}
+
+static uint32_t remaining(uint64_t since, uint32_t period)
+{
+    return (since >= period) ? 0 : (uint32_t)(period - since);
+}
+
+uint32_t sched_timeout(const GuiScheduler *s, bool attached, bool visible, uint64_t now)
+{
+    // Nothing to watch until a process shows up; block on the process event alone.
+    if (!attached)
+        return SCHED_FOREVER;
+    if (!visible)
+        return SCHED_HIDDEN_POLL_US;
+
+    const uint64_t since_frame = now - s->last_frame;
+    if (s->dirty)
+        return remaining(since_frame, SCHED_FRAME_US);
+
+    uint32_t timeout = (now - s->last_input < SCHED_ACTIVE_US) ? SCHED_FRAME_US : SCHED_IDLE_POLL_US;
+    if (s->refresh_us)
+    {
+        const uint32_t refresh = remaining(since_frame, s->refresh_us);
+        timeout = (refresh < timeout) ? refresh : timeout;
+    }
+    return timeout;
+}
+
+void sched_wakeup(GuiScheduler *s, uint64_t now)
+{
+    s->last_wakeup = now;
+    s->wakeups++;
+}
+
+// A button is held or was just released; keeps the input poll at frame rate for SCHED_ACTIVE_US.
+void sched_input(GuiScheduler *s, uint64_t now)
+{
+    s->last_input = now;
+}
+
+void sched_set_refresh(GuiScheduler *s, uint32_t refresh_us)
+{
+    s->refresh_us = refresh_us;
+}
+
+void sched_mark_dirty(GuiScheduler *s)
+{
+    s->dirty = true;
+}
+
+bool sched_should_draw(GuiScheduler *s, uint64_t now)
+{
+    const uint64_t since_frame = now - s->last_frame;
+    if ((s->dirty && since_frame >= SCHED_FRAME_US) || (s->refresh_us && since_frame >= s->refresh_us))
+    {
+        s->last_frame = now;
+        s->dirty = false;
+        return true;
+    }
+    return false;
+}
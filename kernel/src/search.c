@@ -0,0 +1,288 @@
+#include "search.h"
+
+#include <string.h>
+
+// Scan core for the memory search feature. Memory access goes through injected callbacks so the same code can run
+// against a simulated address space.
+
+static int search_finish_query(SearchQuery *q, uint32_t length, uint32_t align)
+{
+    if (length == 0 || length > SEARCH_MAX_PATTERN)
+        return -1;
+    q->length = length;
+    q->align = align;
+
+    // Anchor on a fully fixed byte, preferring one that is not 0x00/0xFF since those fill most of memory.
+    int fixed = -1, partial = -1;
+    for (uint32_t i = 0; i < length; ++i)
+    {
+        q->bytes[i] &= q->mask[i];
+        if (q->mask[i] == 0xFF && q->bytes[i] != 0x00 && q->bytes[i] != 0xFF)
+        {
+            q->anchor = i;
+            return 0;
+        }
+        if (q->mask[i] == 0xFF && fixed < 0)
+            fixed = i;
+        if (q->mask[i] && partial < 0)
+            partial = i;
+    }
+    if (fixed < 0 && partial < 0)
+        return -1;
+    q->anchor = (fixed >= 0) ? fixed : partial;
+    return 0;
+}
+
+int search_query_value(SearchQuery *q, SearchType type, uint32_t value)
+{
+    static const uint8_t sizes[] = {[SEARCH_U8] = 1, [SEARCH_U16] = 2, [SEARCH_U32] = 4, [SEARCH_FLOAT] = 4};
+    if (type > SEARCH_FLOAT)
+        return -1;
+
+    memset(q, 0, sizeof(*q));
+    if (type == SEARCH_FLOAT)
+    {
+        // Values are entered as integers; games mostly keep whole numbers in their float fields.
+        float f = (float)(int32_t)value;
+        memcpy(&value, &f, sizeof(value));
+    }
+    for (int i = 0; i < sizes[type]; ++i)
+    {
+        q->bytes[i] = (value >> (i * 8)) & 0xFF;
+        q->mask[i] = 0xFF;
+    }
+    return search_finish_query(q, sizes[type], sizes[type]);
+}
+
+static int hex_nibble(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    return -1;
+}
+
+int search_query_pattern(SearchQuery *q, const char *text)
+{
+    memset(q, 0, sizeof(*q));
+
+    // "DE AD ?? E?" style; spaces are optional and '?' wildcards a single nibble.
+    uint32_t nibbles = 0;
+    for (; *text; ++text)
+    {
+        if (*text == ' ')
+            continue;
+        if (nibbles / 2 >= SEARCH_MAX_PATTERN)
+            return -1;
+
+        const uint32_t byte = nibbles / 2, shift = (nibbles & 1) ? 0 : 4;
+        if (*text != '?')
+        {
+            int v = hex_nibble(*text);
+            if (v < 0)
+                return -1;
+            q->bytes[byte] |= v << shift;
+            q->mask[byte] |= 0xF << shift;
+        }
+        nibbles++;
+    }
+    if (nibbles & 1)
+        return -1;
+    return search_finish_query(q, nibbles / 2, 1);
+}
+
+int search_query_string(SearchQuery *q, const char *text, bool utf16)
+{
+    memset(q, 0, sizeof(*q));
+
+    const uint32_t unit = utf16 ? 2 : 1;
+    uint32_t length = 0;
+    for (; *text; ++text)
+    {
+        if (length + unit > SEARCH_MAX_PATTERN)
+            return -1;
+        q->bytes[length] = (uint8_t)*text;
+        q->mask[length] = 0xFF;
+        if (utf16)
+            q->mask[length + 1] = 0xFF;
+        length += unit;
+    }
+    return search_finish_query(q, length, unit);
+}
+
+static inline bool search_match(const SearchQuery *q, const uint8_t *p)
+{
+    for (uint32_t j = 0; j < q->length; ++j)
+        if ((p[j] & q->mask[j]) != q->bytes[j])
+            return false;
+    return true;
+}
+
+uint32_t search_scan(const SearchQuery *q, const uint8_t *buf, uint32_t size, uint32_t limit, uint32_t addr,
+                     uint32_t *out, uint32_t max_out, uint32_t *matches, uint32_t *bits)
+{
+    if (size < q->length)
+        return 0;
+    uint32_t last = size - q->length + 1;
+    if (last > limit)
+        last = limit;
+
+    // Word-at-a-time prefilter: flag bytes equal to the anchor, 16 bytes per round, and only verify rounds that hit.
+    // The zero-byte trick can over-report after a real hit but never misses one.
+    const uint8_t *a = buf + q->anchor;
+    const uint32_t want = 0x01010101u * q->bytes[q->anchor];
+    const uint32_t keep = 0x01010101u * q->mask[q->anchor];
+    const uint32_t align = q->align - 1;
+    const uint32_t shift = __builtin_ctz(q->align);
+    uint32_t stored = 0;
+    uint32_t i = 0;
+
+    while (i < last)
+    {
+        uint32_t stop = last;
+        if (last - i >= 16)
+        {
+            uint32_t w[4];
+            memcpy(w, a + i, sizeof(w));
+            uint32_t hit = 0;
+            for (int k = 0; k < 4; ++k)
+            {
+                const uint32_t x = (w[k] & keep) ^ want;
+                hit |= (x - 0x01010101u) & ~x & 0x80808080u;
+            }
+            if (!hit)
+            {
+                i += 16;
+                continue;
+            }
+            stop = i + 16;
+        }
+
+        for (; i < stop; ++i)
+        {
+            if (((addr + i) & align) || (a[i] & q->mask[q->anchor]) != q->bytes[q->anchor] || !search_match(q, buf + i))
+                continue;
+            if (stored < max_out)
+                out[stored++] = addr + i;
+            if (bits)
+                bits[(i >> shift) >> 5] |= 1u << ((i >> shift) & 31);
+            (*matches)++;
+        }
+    }
+    return stored;
+}
+
+void search_begin(SearchState *s, const SearchQuery *q, SearchReadFn read, SearchSkipFn skip, ScanStore *store,
+                  uint32_t start, uint32_t end)
+{
+    s->query = *q;
+    s->read = read;
+    s->skip = skip;
+    s->store = store;
+    if (store)
+    {
+        // The store works on whole pages; the caller resets it for the value width beforehand.
+        start &= ~(SCANSTORE_PAGE_SIZE - 1);
+        end = (end + SCANSTORE_PAGE_SIZE - 1) & ~(SCANSTORE_PAGE_SIZE - 1);
+    }
+    s->start = start;
+    s->end = end;
+    s->cursor = start;
+    s->count = 0;
+    s->matches = 0;
+    s->bytes_scanned = 0;
+    s->elapsed_us = 0;
+    s->running = start < end;
+}
+
+static uint32_t search_next_boundary(uint32_t addr, uint32_t unit, uint32_t end)
+{
+    const uint32_t next = (addr & ~(unit - 1)) + unit;
+    return (next <= addr || next > end) ? end : next;
+}
+
+// Reads [addr, next) plus enough of the following bytes to catch matches straddling the boundary.
+static bool search_block(SearchState *s, uint32_t addr, uint32_t next)
+{
+    const uint32_t positions = next - addr;
+    uint32_t size = positions + s->query.length - 1;
+    if (size > s->end - addr)
+        size = s->end - addr;
+
+    if (s->read(addr, s->chunk, size) < 0)
+    {
+        // The overlap may run into an unmapped block; the block itself can still hold matches.
+        size = positions;
+        if (s->read(addr, s->chunk, size) < 0)
+            return false;
+    }
+
+    if (!s->store)
+        s->count += search_scan(&s->query, s->chunk, size, positions, addr, s->results + s->count,
+                                SEARCH_MAX_RESULTS - s->count, &s->matches, NULL);
+    else
+    {
+        // Whole pages only, so each one hands its match bitmap and contents to the store.
+        for (uint32_t off = 0; off + SCANSTORE_PAGE_SIZE <= size; off += SCANSTORE_PAGE_SIZE)
+        {
+            uint32_t bits[SCANSTORE_BITMAP_WORDS] = {0};
+            s->count += search_scan(&s->query, s->chunk + off, SCANSTORE_PAGE_SIZE, SCANSTORE_PAGE_SIZE, addr + off,
+                                    s->results + s->count, SEARCH_MAX_RESULTS - s->count, &s->matches, bits);
+            scanstore_add_page(s->store, addr + off, bits, s->chunk + off);
+        }
+    }
+    s->bytes_scanned += positions;
+    return true;
+}
+
+bool search_step(SearchState *s, uint32_t budget)
+{
+    while (s->running && budget)
+    {
+        const uint32_t addr = s->cursor;
+        const uint32_t mapped = s->skip ? s->skip(addr) : addr;
+        if (mapped != addr)
+        {
+            // Jump over the gap between memblocks without reading it.
+            s->cursor = (mapped > addr && mapped < s->end) ? mapped : s->end;
+            s->running = s->cursor < s->end;
+            continue;
+        }
+
+        const uint32_t next = search_next_boundary(addr, SEARCH_CHUNK_SIZE, s->end);
+        if (!search_block(s, addr, next))
+        {
+            // Partially mapped chunk: fall back to pages, skipping the ones with no memblock behind them.
+            for (uint32_t page = addr; page < next;)
+            {
+                const uint32_t page_next = search_next_boundary(page, SEARCH_PAGE_SIZE, next);
+                if (!s->skip || s->skip(page) == page)
+                    search_block(s, page, page_next);
+                page = page_next;
+            }
+        }
+
+        budget = (budget > next - addr) ? budget - (next - addr) : 0;
+        s->cursor = next;
+        if (next >= s->end)
+            s->running = false;
+    }
+    return s->running;
+}
+
+uint32_t search_progress(const SearchState *s)
+{
+    if (s->end <= s->start)
+        return 100;
+    return (uint32_t)((uint64_t)(s->cursor - s->start) * 100 / (s->end - s->start));
+}
+
+uint32_t search_mb_per_sec(const SearchState *s)
+{
+    if (!s->elapsed_us)
+        return 0;
+    return (uint32_t)(s->bytes_scanned / s->elapsed_us); // bytes/us == MB/s
+}
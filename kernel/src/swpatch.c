@@ -0,0 +1,89 @@
+#include "swpatch.h"
+
+#include <string.h>
+
+// Writes SW breakpoints into, and restores instructions to, the target's text in page batches: one read and one
+// text-domain write per page touched, instead of a copy per instruction.
+
+static uint8_t page_buf[SW_PAGE_SIZE];
+
+void swpatch_sort(TextPatch *p, int count)
+{
+    for (int gap = count / 2; gap > 0; gap /= 2)
+        for (int i = gap; i < count; ++i)
+        {
+            const TextPatch t = p[i];
+            int j = i;
+            for (; j >= gap && p[j - gap].address > t.address; j -= gap)
+                p[j] = p[j - gap];
+            p[j] = t;
+        }
+}
+
+// Turns up to SW_PATCH_BATCH addresses from addresses[*done] on into sorted patches writing value, advancing *done
+// past them. Misaligned addresses, duplicates and addresses that already carry a breakpoint are dropped, and every
+// patch kept gets a store entry to save into. Returns the patches kept; *full is set when the store ran out, and the
+// patches before that are still returned.
+int swpatch_prepare(TextPatch *p, const uint32_t *addresses, int count, int *done, uint32_t value, uint8_t size,
+                    const SwPatchBackend *backend, bool *full)
+{
+    int n = 0;
+    // Misaligned addresses are not instructions of this set, and could straddle the page swpatch_apply copies.
+    for (; *done < count && n < SW_PATCH_BATCH; ++*done)
+        if (!(addresses[*done] & (size - 1)))
+            p[n++] = (TextPatch){addresses[*done], value, NULL, -1, size, false};
+    swpatch_sort(p, n);
+
+    int kept = 0;
+    *full = false;
+    for (int i = 0; i < n; ++i)
+    {
+        TextPatch *patch = &p[i];
+        if ((kept && p[kept - 1].address == patch->address) || backend->find(patch->address) >= 0)
+            continue;
+        patch->id = backend->reserve();
+        if (patch->id < 0)
+        {
+            *full = true;
+            break;
+        }
+        patch->saved = backend->saved(patch->id);
+        p[kept++] = *patch;
+    }
+    return kept;
+}
+
+// Applies address-sorted patches. Returns how many were applied; each patch's ok flag says whether it was.
+int swpatch_apply(TextPatch *p, int count, const SwPatchBackend *backend)
+{
+    int applied = 0;
+    for (int i = 0; i < count;)
+    {
+        const uint32_t page = p[i].address & ~(SW_PAGE_SIZE - 1);
+        const uint32_t start = p[i].address;
+        uint32_t end = start;
+        int j = i;
+        for (; j < count && (p[j].address & ~(SW_PAGE_SIZE - 1)) == page; ++j)
+            if (p[j].address + p[j].size > end)
+                end = p[j].address + p[j].size;
+
+        if (backend->read(start, page_buf, end - start) >= 0)
+        {
+            for (int k = i; k < j; ++k)
+            {
+                uint8_t *at = page_buf + (p[k].address - start);
+                if (p[k].saved)
+                    memcpy(p[k].saved, at, p[k].size);
+                memcpy(at, &p[k].value, p[k].size);
+            }
+            if (backend->write(start, page_buf, end - start) >= 0)
+            {
+                for (int k = i; k < j; ++k)
+                    p[k].ok = true;
+                applied += j - i;
+            }
+        }
+        i = j;
+    }
+    return applied;
+}
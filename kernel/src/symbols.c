@@ -0,0 +1,301 @@
+#include "symbols.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Address to symbol index over the target's modules. Exports are found through each module's sce_module_info, named
+// from an optional NID database, and sorted once so panels can resolve every address they draw by bisection.
+
+// sce_module_info as the toolchain lays it out; the table offsets are relative to the text segment.
+typedef struct
+{
+    uint16_t attributes, version;
+    char name[27];
+    uint8_t type;
+    uint32_t gp_value;
+    uint32_t export_top, export_end, import_top, import_end;
+    uint32_t module_nid;
+    uint32_t tls_start, tls_filesz, tls_memsz;
+    uint32_t module_start, module_stop;
+    uint32_t exidx_top, exidx_end, extab_top, extab_end;
+} ModuleInfoRaw;
+
+// One library in the export table; the table pointers are absolute once the module is loaded.
+typedef struct
+{
+    uint16_t size, version, flags, num_funcs;
+    uint32_t num_vars, num_tls;
+    uint32_t library_nid;
+    uint32_t library_name, nid_table, entry_table;
+} ExportsRaw;
+
+#define EXPORTS_MAX_PER_LIBRARY 0x4000 // Anything larger is not an export table
+#define EXPORTS_BATCH 64
+
+int niddb_open(NidDb *db, const void *data, uint32_t size)
+{
+    const NidDbHeader *header = data;
+    memset(db, 0, sizeof(*db));
+    if (size < sizeof(*header) || header->magic != NIDDB_MAGIC || header->version != NIDDB_VERSION)
+        return -1;
+    if (header->count > (size - sizeof(*header)) / 8 || !header->pool_size ||
+        header->pool_size > size - sizeof(*header) - header->count * 8)
+        return -1;
+
+    const uint32_t *nids = (const uint32_t *)(header + 1);
+    const char *pool = (const char *)(nids + header->count * 2);
+    if (pool[header->pool_size - 1] != '\0')
+        return -1;
+    for (uint32_t i = 0; i < header->count; ++i)
+        if (nids[header->count + i] >= header->pool_size || (i > 0 && nids[i] <= nids[i - 1]))
+            return -1;
+
+    db->nids = nids;
+    db->names = nids + header->count;
+    db->pool = pool;
+    db->count = header->count;
+    db->pool_size = header->pool_size;
+    return 0;
+}
+
+const char *niddb_lookup(const NidDb *db, uint32_t nid)
+{
+    uint32_t lo = 0, hi = db->count;
+    while (lo < hi)
+    {
+        const uint32_t mid = lo + (hi - lo) / 2;
+        if (db->nids[mid] == nid)
+            return db->pool + db->names[mid];
+        if (db->nids[mid] < nid)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return NULL;
+}
+
+void symbols_init(SymbolIndex *idx, Symbol *symbols, uint32_t capacity)
+{
+    memset(idx, 0, sizeof(*idx));
+    idx->symbols = symbols;
+    idx->capacity = capacity;
+}
+
+static bool module_info_matches(const ModuleInfoRaw *info, uint32_t text, uint32_t text_size, const char *name,
+                                uint32_t exidx)
+{
+    if (strncmp(info->name, name, sizeof(info->name)) != 0)
+        return false;
+    // Every module exports at least its own entry points, so an empty table means a stray copy of the name.
+    if (info->export_top >= info->export_end || info->export_end > text_size || info->import_top > info->import_end ||
+        info->import_end > text_size)
+        return false;
+    // The unwind table the module manager reports pins the block down when the name also appears elsewhere.
+    return !exidx || text + info->exidx_top == exidx;
+}
+
+// Counts the functions and variables exported from [top, end); < 0 when the table does not parse.
+static int count_exports(uint32_t top, uint32_t end, SymbolReadFn read)
+{
+    uint32_t count = 0;
+    for (uint32_t addr = top; addr + sizeof(ExportsRaw) <= end;)
+    {
+        ExportsRaw lib;
+        if (read(addr, &lib, sizeof(lib)) < 0 || lib.size < sizeof(lib) ||
+            lib.num_funcs + lib.num_vars > EXPORTS_MAX_PER_LIBRARY)
+            return -1;
+        count += lib.num_funcs + lib.num_vars;
+        addr += lib.size;
+    }
+    return count;
+}
+
+// Looks for the module's info block in its text segment, newest bytes first: the toolchain puts it just ahead of the
+// export and unwind tables at the end of the segment, so the scan starts at exidx when that lies inside the text.
+int symbols_find_exports(uint32_t text, uint32_t text_size, const char *name, uint32_t exidx, SymbolReadFn read,
+                         SymbolExports *out)
+{
+    static uint8_t chunk[SYMBOLS_SCAN_CHUNK + sizeof(ModuleInfoRaw)];
+    memset(out, 0, sizeof(*out));
+    if (!name[0] || text_size < sizeof(ModuleInfoRaw))
+        return -1;
+
+    const uint32_t end = text + text_size;
+    uint32_t pos = (exidx > text && exidx < end) ? exidx : end;
+    while (pos > text)
+    {
+        const uint32_t start = (pos - text > SYMBOLS_SCAN_CHUNK) ? pos - SYMBOLS_SCAN_CHUNK : text;
+        uint32_t size = pos - start + sizeof(ModuleInfoRaw);
+        if (size > end - start)
+            size = end - start;
+        pos = start;
+        if (size < sizeof(ModuleInfoRaw) || read(start, chunk, size) < 0)
+            continue;
+
+        for (int32_t off = (int32_t)((size - sizeof(ModuleInfoRaw)) & ~3u); off >= 0; off -= 4)
+        {
+            ModuleInfoRaw info;
+            memcpy(&info, chunk + off, sizeof(info));
+            if (!module_info_matches(&info, text, text_size, name, exidx))
+                continue;
+            const int count = count_exports(text + info.export_top, text + info.export_end, read);
+            if (count < 0)
+                continue;
+            out->top = text + info.export_top;
+            out->end = text + info.export_end;
+            out->count = count;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// Adds the module's segments and, when exports is given, every function and variable it exports; returns the number
+// of symbols added or < 0 when the index is full.
+int symbols_add_module(SymbolIndex *idx, const char *name, const uint32_t *seg_base, const uint32_t *seg_size,
+                       const SymbolExports *exports, SymbolReadFn read, const NidDb *db)
+{
+    if (idx->module_count >= SYMBOLS_MAX_MODULES)
+        return -1;
+    const uint32_t module = idx->module_count++;
+    strncpy(idx->modules[module], name, SYMBOLS_NAME_MAX - 1);
+    idx->modules[module][SYMBOLS_NAME_MAX - 1] = '\0';
+
+    const uint32_t first_range = idx->range_count;
+    for (uint32_t i = 0; i < 4 && idx->range_count < SYMBOLS_MAX_RANGES; ++i)
+        if (seg_base[i] && seg_size[i])
+            idx->ranges[idx->range_count++] = (SymbolRange){seg_base[i], seg_base[i] + seg_size[i], module, i};
+
+    int added = 0;
+    for (uint32_t addr = exports ? exports->top : 0; exports && addr + sizeof(ExportsRaw) <= exports->end;)
+    {
+        ExportsRaw lib;
+        if (read(addr, &lib, sizeof(lib)) < 0 || lib.size < sizeof(lib))
+            break;
+        addr += lib.size;
+
+        const uint32_t total = lib.num_funcs + lib.num_vars;
+        for (uint32_t i = 0; i < total; i += EXPORTS_BATCH)
+        {
+            uint32_t nids[EXPORTS_BATCH], entries[EXPORTS_BATCH];
+            const uint32_t n = (total - i < EXPORTS_BATCH) ? total - i : EXPORTS_BATCH;
+            if (read(lib.nid_table + i * 4, nids, n * 4) < 0 || read(lib.entry_table + i * 4, entries, n * 4) < 0)
+                break;
+
+            for (uint32_t j = 0; j < n; ++j)
+            {
+                const uint32_t target = (i + j < lib.num_funcs) ? entries[j] & ~1u : entries[j];
+                bool inside = false;
+                for (uint32_t r = first_range; r < idx->range_count && !inside; ++r)
+                    inside = target >= idx->ranges[r].start && target < idx->ranges[r].end;
+                if (!inside)
+                    continue;
+                if (idx->symbol_count >= idx->capacity)
+                    return -1;
+                idx->symbols[idx->symbol_count++] =
+                    (Symbol){target, nids[j], db ? niddb_lookup(db, nids[j]) : NULL, module};
+                added++;
+            }
+        }
+    }
+    return added;
+}
+
+static void sift_down(Symbol *s, uint32_t root, uint32_t count)
+{
+    for (uint32_t child; (child = root * 2 + 1) < count; root = child)
+    {
+        if (child + 1 < count && s[child + 1].addr > s[child].addr)
+            child++;
+        if (s[root].addr >= s[child].addr)
+            return;
+        const Symbol tmp = s[root];
+        s[root] = s[child];
+        s[child] = tmp;
+    }
+}
+
+// Sorts the ranges and symbols once every module was added; the symbol table can run to thousands of entries, so
+// it gets a heap sort rather than the insertion sorts used for short lists elsewhere.
+void symbols_finish(SymbolIndex *idx)
+{
+    for (uint32_t i = 1; i < idx->range_count; ++i)
+    {
+        const SymbolRange r = idx->ranges[i];
+        uint32_t j = i;
+        for (; j > 0 && idx->ranges[j - 1].start > r.start; --j)
+            idx->ranges[j] = idx->ranges[j - 1];
+        idx->ranges[j] = r;
+    }
+
+    Symbol *s = idx->symbols;
+    const uint32_t count = idx->symbol_count;
+    for (uint32_t i = count / 2; i-- > 0;)
+        sift_down(s, i, count);
+    for (uint32_t n = count; n > 1; --n)
+    {
+        const Symbol tmp = s[0];
+        s[0] = s[n - 1];
+        s[n - 1] = tmp;
+        sift_down(s, 0, n - 1);
+    }
+}
+
+const SymbolRange *symbols_find_range(const SymbolIndex *idx, uint32_t addr)
+{
+    uint32_t lo = 0, hi = idx->range_count;
+    while (lo < hi)
+    {
+        const uint32_t mid = lo + (hi - lo) / 2;
+        if (idx->ranges[mid].start <= addr)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return (lo > 0 && addr < idx->ranges[lo - 1].end) ? &idx->ranges[lo - 1] : NULL;
+}
+
+// Closest export at or below addr within the same segment, NULL when there is none.
+const Symbol *symbols_lookup(const SymbolIndex *idx, uint32_t addr)
+{
+    const SymbolRange *range = symbols_find_range(idx, addr);
+    if (!range)
+        return NULL;
+
+    uint32_t lo = 0, hi = idx->symbol_count;
+    while (lo < hi)
+    {
+        const uint32_t mid = lo + (hi - lo) / 2;
+        if (idx->symbols[mid].addr <= addr)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return (lo > 0 && idx->symbols[lo - 1].addr >= range->start) ? &idx->symbols[lo - 1] : NULL;
+}
+
+// Writes "name+0x10", "Module!NID+0x10" for an export the database cannot name, or "Module+0x10" (segment offset,
+// ":n" for segments past the first); returns 0 when addr is in no module.
+int symbols_format(const SymbolIndex *idx, uint32_t addr, char *out, uint32_t size)
+{
+    const SymbolRange *range = symbols_find_range(idx, addr);
+    if (!range || !size)
+        return 0;
+
+    const Symbol *sym = symbols_lookup(idx, addr);
+    const char *module = idx->modules[range->module];
+    int len;
+    if (sym && sym->name)
+        len = snprintf(out, size, "%s", sym->name);
+    else if (sym)
+        len = snprintf(out, size, "%s!%08X", module, sym->nid);
+    else if (range->segment)
+        len = snprintf(out, size, "%s:%u", module, range->segment);
+    else
+        len = snprintf(out, size, "%s", module);
+
+    const uint32_t offset = addr - (sym ? sym->addr : range->start);
+    if (len >= 0 && (uint32_t)len < size && offset)
+        len += snprintf(out + len, size - len, "+0x%X", offset);
+    return (len < 0) ? 0 : ((uint32_t)len < size) ? len : (int)size - 1;
+}
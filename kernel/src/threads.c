@@ -0,0 +1,130 @@
+#include "threads.h"
+
+#include <string.h>
+
+// Per-thread debug state shared by the exception handlers and the GUI thread. Entries are claimed with a
+// compare-and-swap on thid and never freed until the process goes away, except that a full table recycles the entry
+// of a thread that is running again.
+
+void threads_reset(ThreadTable *t)
+{
+    memset(t, 0, sizeof(*t));
+}
+
+static bool try_lock(ThreadEntry *e)
+{
+    uint32_t seq = __atomic_load_n(&e->seq, __ATOMIC_RELAXED);
+    return !(seq & 1) && __atomic_compare_exchange_n(&e->seq, &seq, seq + 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+static void lock(ThreadEntry *e)
+{
+    // Held for a copy of the registers at most.
+    while (!try_lock(e))
+        ;
+}
+
+static void claim(ThreadEntry *e, int32_t thid)
+{
+    __atomic_store_n(&e->thid, thid, __ATOMIC_RELAXED);
+    memset(e->regs, 0, sizeof(e->regs));
+    e->reason = THREAD_RUNNING;
+    e->bp = -1;
+    e->stops = 0;
+}
+
+// Entry of thid, locked; with create, a free or recycled one when thid has none yet. NULL when there is no entry or
+// the table is full of stopped threads.
+ThreadEntry *threads_lock(ThreadTable *t, int32_t thid, bool create)
+{
+    if (thid <= 0)
+        return NULL;
+
+    for (;;)
+    {
+        bool moved = false;
+        for (uint32_t i = 0; i < THREAD_TABLE_SIZE; ++i)
+        {
+            ThreadEntry *e = &t->entries[i];
+            if (__atomic_load_n(&e->thid, __ATOMIC_RELAXED) != thid)
+                continue;
+            lock(e);
+            if (e->thid == thid)
+                return e;
+            // Recycled under us.
+            __atomic_store_n(&e->seq, e->seq + 1, __ATOMIC_RELEASE);
+            moved = true;
+            break;
+        }
+        if (moved)
+            continue;
+        if (!create)
+            return NULL;
+
+        // Only the thread itself creates its entry, so no other core can be claiming the same thid.
+        for (uint32_t i = 0; i < THREAD_TABLE_SIZE; ++i)
+        {
+            ThreadEntry *e = &t->entries[i];
+            int32_t expected = 0;
+            if (__atomic_load_n(&e->thid, __ATOMIC_RELAXED) != 0 ||
+                !__atomic_compare_exchange_n(&e->thid, &expected, thid, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+                continue;
+            lock(e);
+            if (e->thid == thid)
+            {
+                claim(e, thid);
+                return e;
+            }
+            // A full table recycled it before the lock was taken.
+            __atomic_store_n(&e->seq, e->seq + 1, __ATOMIC_RELEASE);
+            moved = true;
+            break;
+        }
+        if (moved)
+            continue;
+        for (uint32_t i = 0; i < THREAD_TABLE_SIZE; ++i)
+        {
+            ThreadEntry *e = &t->entries[i];
+            if (__atomic_load_n(&e->reason, __ATOMIC_RELAXED) != THREAD_RUNNING || !try_lock(e))
+                continue;
+            if (e->reason == THREAD_RUNNING)
+            {
+                claim(e, thid);
+                return e;
+            }
+            __atomic_store_n(&e->seq, e->seq + 1, __ATOMIC_RELEASE);
+        }
+        return NULL;
+    }
+}
+
+void threads_unlock(ThreadTable *t, ThreadEntry *e)
+{
+    __atomic_store_n(&e->seq, e->seq + 1, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&t->generation, 1, __ATOMIC_RELEASE);
+}
+
+// Consistent copy of entry i; false when it is free.
+bool threads_snapshot(const ThreadTable *t, uint32_t i, ThreadEntry *out)
+{
+    const ThreadEntry *e = &t->entries[i];
+    uint32_t seq;
+    do
+    {
+        seq = __atomic_load_n(&e->seq, __ATOMIC_ACQUIRE);
+        if (seq & 1)
+            continue;
+        memcpy(out, e, sizeof(*out));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || seq != __atomic_load_n(&e->seq, __ATOMIC_RELAXED));
+    return out->thid != 0;
+}
+
+bool threads_find(const ThreadTable *t, int32_t thid, ThreadEntry *out)
+{
+    for (uint32_t i = 0; i < THREAD_TABLE_SIZE; ++i)
+        if (__atomic_load_n(&t->entries[i].thid, __ATOMIC_RELAXED) == thid && threads_snapshot(t, i, out) &&
+            out->thid == thid)
+            return true;
+    return false;
+}
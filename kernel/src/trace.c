@@ -0,0 +1,149 @@
+#include "trace.h"
+
+#include <string.h>
+
+// Tracepoint capture and the record ring between the exception handlers and the GUI thread.
+
+static uint32_t parse_number(const char **text)
+{
+    const char *p = *text;
+    const bool hex = p[0] == '0' && (p[1] == 'x' || p[1] == 'X');
+    uint32_t value = 0;
+    for (p += hex ? 2 : 0;; ++p)
+    {
+        if (*p >= '0' && *p <= '9')
+            value = value * (hex ? 16 : 10) + *p - '0';
+        else if (hex && ((*p >= 'a' && *p <= 'f') || (*p >= 'A' && *p <= 'F')))
+            value = value * 16 + (*p | 0x20) - 'a' + 10;
+        else
+            break;
+    }
+    *text = p;
+    return value;
+}
+
+// "r0 r1 lr [r0] [sp+8]": registers and memory words, separated by spaces or commas.
+int trace_parse_spec(TraceSpec *spec, const char *text)
+{
+    memset(spec, 0, sizeof(*spec));
+    uint32_t values = 0;
+
+    while (*text)
+    {
+        if (*text == ' ' || *text == ',')
+        {
+            text++;
+            continue;
+        }
+
+        const bool mem = *text == '[';
+        text += mem;
+        const int reg = cond_register(&text);
+        if (reg < 0 || ++values > TRACE_MAX_VALUES)
+            return -1;
+        if (!mem)
+        {
+            spec->reg_mask |= 1u << reg;
+            continue;
+        }
+
+        int32_t offset = 0;
+        if (*text == '+' || *text == '-')
+        {
+            const bool negative = *text++ == '-';
+            offset = parse_number(&text);
+            offset = negative ? -offset : offset;
+        }
+        if (*text++ != ']' || spec->mem_count >= TRACE_MAX_MEM || offset < -0x8000 || offset > 0x7FFF)
+            return -1;
+        spec->mem_reg[spec->mem_count] = reg;
+        spec->mem_offset[spec->mem_count++] = offset;
+    }
+
+    return (spec->reg_mask || spec->mem_count) ? 0 : -1;
+}
+
+void trace_init(TraceRing *ring)
+{
+    ring->head = 0;
+    ring->tail = 0;
+    ring->dropped = 0;
+    for (uint32_t i = 0; i < TRACE_RING_SIZE; ++i)
+        ring->records[i].seq = i;
+}
+
+bool trace_push(TraceRing *ring, const TraceSpec *spec, uint16_t id, uint32_t address, uint32_t time,
+                uint32_t thread, const uint32_t *regs, CondReadFn read)
+{
+    // Each record's seq equals the position that may claim it next; one ring lap later it is free again.
+    uint32_t pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    TraceRecord *rec;
+    for (;;)
+    {
+        rec = &ring->records[pos & (TRACE_RING_SIZE - 1)];
+        const int32_t diff = (int32_t)(__atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE) - pos);
+        if (diff == 0)
+        {
+            if (__atomic_compare_exchange_n(&ring->head, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        }
+        else if (diff < 0)
+        {
+            __atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+            return false;
+        }
+        else
+            pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    }
+
+    rec->time = time;
+    rec->address = address;
+    rec->thread = thread;
+    rec->id = id;
+    rec->faults = 0;
+    // The spec may be mid-rewrite under a hit, so nothing in it is trusted to stay within the record or the registers.
+    uint32_t n = 0;
+    for (uint32_t mask = spec->reg_mask & ((1u << COND_REG_COUNT) - 1); mask && n < TRACE_MAX_VALUES; mask &= mask - 1)
+        rec->values[n++] = regs[__builtin_ctz(mask)];
+    for (uint32_t i = 0; i < spec->mem_count && i < TRACE_MAX_MEM && n < TRACE_MAX_VALUES; ++i, ++n)
+    {
+        rec->values[n] = 0;
+        if (spec->mem_reg[i] >= COND_REG_COUNT ||
+            read(regs[spec->mem_reg[i]] + spec->mem_offset[i], &rec->values[n], 4) < 0)
+            rec->faults |= 1 << i;
+    }
+    rec->count = n;
+
+    __atomic_store_n(&rec->seq, pos + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool trace_pop(TraceRing *ring, TraceRecord *out)
+{
+    TraceRecord *rec = &ring->records[ring->tail & (TRACE_RING_SIZE - 1)];
+    if (__atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE) != ring->tail + 1)
+        return false;
+    *out = *rec;
+    __atomic_store_n(&rec->seq, ring->tail + TRACE_RING_SIZE, __ATOMIC_RELEASE);
+    ring->tail++;
+    return true;
+}
+
+uint32_t trace_pending(const TraceRing *ring)
+{
+    return __atomic_load_n(&ring->head, __ATOMIC_RELAXED) - ring->tail;
+}
+
+// File form of a record: time, address, thread, id (u16), count (u8), faults (u8), then count values, all
+// little-endian.
+uint32_t trace_encode(const TraceRecord *rec, uint8_t *out)
+{
+    memcpy(out, &rec->time, 4);
+    memcpy(out + 4, &rec->address, 4);
+    memcpy(out + 8, &rec->thread, 4);
+    memcpy(out + 12, &rec->id, 2);
+    out[14] = rec->count;
+    out[15] = rec->faults;
+    memcpy(out + 16, rec->values, rec->count * 4);
+    return 16 + rec->count * 4;
+}
@@ -0,0 +1,255 @@
+#include "unwind.h"
+
+#include <string.h>
+
+// ARM EHABI unwinder. Each module's .ARM.exidx is copied into the index once with its function offsets resolved; frames
+// are then unwound by running the personality 0-2 bytecode against a single copy of the stack window.
+
+static uint32_t prel31(uint32_t word, uint32_t place)
+{
+    return place + (uint32_t)((int32_t)(word << 1) >> 1);
+}
+
+void unwind_init(UnwindIndex *idx, UnwindEntry *entries, uint32_t capacity)
+{
+    memset(idx, 0, sizeof(*idx));
+    idx->entries = entries;
+    idx->capacity = capacity;
+}
+
+// Resolves the function offsets of count raw .ARM.exidx entries, already copied from exidx_addr to entries +
+// entry_count, in place.
+int unwind_add_module(UnwindIndex *idx, uint32_t exidx_addr, uint32_t count, uint32_t text_end)
+{
+    if (!count || idx->module_count >= UNWIND_MAX_MODULES || count > idx->capacity - idx->entry_count)
+        return -1;
+
+    UnwindEntry *e = idx->entries + idx->entry_count;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const uint32_t place = exidx_addr + i * sizeof(UnwindEntry);
+        e[i].fn = prel31(e[i].fn, place) & ~1u;
+    }
+    // The linker sorts the table; an unsorted one would only be half searchable.
+    for (uint32_t i = 1; i < count; ++i)
+        if (e[i].fn < e[i - 1].fn)
+            return -1;
+
+    UnwindModule *m = &idx->modules[idx->module_count++];
+    m->exidx = exidx_addr;
+    m->start = e[0].fn;
+    m->end = (text_end > e[count - 1].fn) ? text_end : e[count - 1].fn + 1;
+    m->first = idx->entry_count;
+    m->count = count;
+    idx->entry_count += count;
+    return 0;
+}
+
+// Entry of the function containing pc, NULL when no module table covers it.
+const UnwindEntry *unwind_lookup(const UnwindIndex *idx, uint32_t pc, const UnwindModule **module)
+{
+    for (uint32_t m = 0; m < idx->module_count; ++m)
+    {
+        const UnwindModule *mod = &idx->modules[m];
+        if (pc < mod->start || pc >= mod->end)
+            continue;
+        const UnwindEntry *e = idx->entries + mod->first;
+        uint32_t lo = 0, hi = mod->count;
+        while (hi - lo > 1)
+        {
+            const uint32_t mid = lo + (hi - lo) / 2;
+            if (e[mid].fn <= pc)
+                lo = mid;
+            else
+                hi = mid;
+        }
+        if (module)
+            *module = mod;
+        return &e[lo];
+    }
+    return NULL;
+}
+
+// Gathers an entry's unwind bytecode, most significant byte of each word first; returns the byte count or < 0.
+static int load_ops(const UnwindIndex *idx, const UnwindModule *mod, const UnwindEntry *entry, UnwindReadFn read,
+                    uint8_t *ops)
+{
+    uint32_t word = entry->data, addr = 0, extra = 0, skip = 1, n = 0;
+    if (word == UNWIND_CANTUNWIND)
+        return -1;
+
+    if (!(word & 0x80000000))
+    {
+        // The .ARM.extab offset is relative to the data word's own place in the module's table.
+        const uint32_t index = (uint32_t)(entry - (idx->entries + mod->first));
+        addr = prel31(word, mod->exidx + index * sizeof(UnwindEntry) + 4);
+        if (read(addr, &word, 4) < 0)
+            return -1;
+        if (!(word & 0x80000000))
+        {
+            // Generic personality routine (__gxx_personality_v0 and friends), followed by the long format.
+            addr += 4;
+            if (read(addr, &word, 4) < 0)
+                return -1;
+            extra = word >> 24;
+        }
+        else if (((word >> 24) & 0xF) == 1 || ((word >> 24) & 0xF) == 2)
+        {
+            extra = (word >> 16) & 0xFF;
+            skip = 2;
+        }
+        else if ((word >> 24) & 0xF)
+            return -1;
+    }
+    else if ((word >> 24) & 0xF)
+        return -1; // Only the short form fits inline
+
+    if (3 - skip + 1 + extra * 4 > UNWIND_MAX_OPS)
+        return -1;
+    for (int b = 3 - skip; b >= 0; --b)
+        ops[n++] = word >> (b * 8);
+    for (uint32_t i = 0; i < extra; ++i)
+    {
+        addr += 4;
+        if (read(addr, &word, 4) < 0)
+            return -1;
+        for (int b = 3; b >= 0; --b)
+            ops[n++] = word >> (b * 8);
+    }
+    return n;
+}
+
+static int pop_registers(uint32_t *regs, uint32_t *vsp, uint32_t mask, const UnwindStack *stack)
+{
+    for (uint32_t r = 0; r < 16; ++r)
+    {
+        if (!(mask & (1u << r)))
+            continue;
+        const uint32_t offset = *vsp - stack->base;
+        if (*vsp < stack->base || stack->size < 4 || offset > stack->size - 4)
+            return -1;
+        memcpy(&regs[r], stack->data + offset, 4);
+        *vsp += 4;
+    }
+    // Popping sp replaces the virtual stack pointer.
+    if (mask & (1u << 13))
+        *vsp = regs[13];
+    return 0;
+}
+
+// Runs one frame's bytecode against regs (r0-r15), leaving the caller's registers; < 0 on anything unsupported.
+static int execute(const uint8_t *ops, uint32_t n, uint32_t *regs, const UnwindStack *stack)
+{
+    uint32_t vsp = regs[13];
+    bool pc_set = false;
+
+    for (uint32_t i = 0; i < n;)
+    {
+        const uint8_t op = ops[i++];
+        uint32_t mask = 0;
+
+        if ((op & 0xC0) == 0x00)
+            vsp += ((op & 0x3F) << 2) + 4;
+        else if ((op & 0xC0) == 0x40)
+            vsp -= ((op & 0x3F) << 2) + 4;
+        else if ((op & 0xF0) == 0x80)
+        {
+            if (i >= n)
+                return -1;
+            mask = ((op & 0xF) << 12) | (ops[i++] << 4);
+            if (!mask)
+                return -1; // Refuse to unwind
+        }
+        else if ((op & 0xF0) == 0x90)
+        {
+            if ((op & 0xF) == 13 || (op & 0xF) == 15)
+                return -1;
+            vsp = regs[op & 0xF];
+        }
+        else if ((op & 0xF0) == 0xA0)
+            mask = (((1u << ((op & 7) + 1)) - 1) << 4) | ((op & 8) ? 1u << 14 : 0);
+        else if (op == 0xB0)
+            break;
+        else if (op == 0xB1)
+        {
+            if (i >= n || !ops[i] || (ops[i] & 0xF0))
+                return -1;
+            mask = ops[i++];
+        }
+        else if (op == 0xB2)
+        {
+            uint32_t value = 0, shift = 0;
+            do
+            {
+                if (i >= n || shift > 28)
+                    return -1;
+                value |= (ops[i] & 0x7Fu) << shift;
+                shift += 7;
+            } while (ops[i++] & 0x80);
+            vsp += 0x204 + (value << 2);
+        }
+        else if (op == 0xB3 || op == 0xC8 || op == 0xC9)
+        {
+            // VFP ranges; FSTMFDX (0xB3) stores an extra format word.
+            if (i >= n)
+                return -1;
+            vsp += ((ops[i++] & 0xF) + 1) * 8 + ((op == 0xB3) ? 4 : 0);
+        }
+        else if ((op & 0xF8) == 0xB8)
+            vsp += ((op & 7) + 1) * 8 + 4;
+        else if ((op & 0xF8) == 0xD0)
+            vsp += ((op & 7) + 1) * 8;
+        else
+            return -1; // iWMMXt or spare
+
+        if (mask)
+        {
+            if (pop_registers(regs, &vsp, mask, stack) < 0)
+                return -1;
+            pc_set |= (mask & (1u << 15)) != 0;
+        }
+    }
+
+    regs[13] = vsp;
+    if (!pc_set)
+        regs[15] = regs[14];
+    return 0;
+}
+
+// Walks up from regs (r0-r15) into dst, the current pc first; returns the number of frames found.
+int unwind_backtrace(const UnwindIndex *idx, const uint32_t *regs, const UnwindStack *stack, UnwindReadFn read,
+                     uint32_t *dst, int depth)
+{
+    uint32_t r[16];
+    uint8_t ops[UNWIND_MAX_OPS];
+    int count = 0;
+
+    if (depth <= 0)
+        return 0;
+    memcpy(r, regs, sizeof(r));
+    dst[count++] = r[15];
+
+    while (count < depth)
+    {
+        // Return addresses point past the call, which may be the last instruction of its function.
+        const uint32_t pc = (count == 1) ? (r[15] & ~1u) : (r[15] & ~1u) - 1;
+        const uint32_t sp = r[13], prev = r[15];
+        const UnwindModule *mod = NULL;
+        const UnwindEntry *entry = unwind_lookup(idx, pc, &mod);
+        if (entry)
+        {
+            const int n = load_ops(idx, mod, entry, read, ops);
+            if (n < 0 || execute(ops, n, r, stack) < 0)
+                break;
+        }
+        else if (count == 1)
+            r[15] = r[14]; // Stopped outside any table; only the link register is known
+        else
+            break;
+
+        if (!r[15] || r[13] < sp || (r[13] == sp && r[15] == prev))
+            break;
+        dst[count++] = r[15];
+    }
+    return count;
+}
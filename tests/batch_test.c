@@ -0,0 +1,300 @@
+#include "../user/include/client.h"
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// The user-side client against batch_execute through a fake backend standing in for the debugger: every op's status
+// and payload, requests batch_execute must turn away before running anything, and reply buffers that run out, which
+// must stop the batch at a whole result and report only the ops that ran.
+
+static uint8_t memory[0x2000];
+static uint32_t breakpoints[8]; // Address by id, 0 once cleared
+static int breakpoint_count;
+static uint32_t backend_calls;
+
+static int fake_read(uint32_t addr, void *dst, uint32_t size)
+{
+    backend_calls++;
+    if (addr >= sizeof(memory) || size > sizeof(memory) - addr)
+        return -1;
+    memcpy(dst, memory + addr, size);
+    return 0;
+}
+
+static int fake_write(uint32_t addr, const void *src, uint32_t size)
+{
+    backend_calls++;
+    if (addr >= sizeof(memory) || size > sizeof(memory) - addr)
+        return -1;
+    memcpy(memory + addr, src, size);
+    return 0;
+}
+
+static int fake_set_breakpoint(uint32_t addr, uint32_t type)
+{
+    (void)type;
+    backend_calls++;
+    if (breakpoint_count == (int)(sizeof(breakpoints) / sizeof(breakpoints[0])))
+        return -1;
+    breakpoints[breakpoint_count] = addr;
+    return breakpoint_count++;
+}
+
+static int fake_clear_breakpoint(int id)
+{
+    backend_calls++;
+    if (id < 0 || id >= breakpoint_count || !breakpoints[id])
+        return -1;
+    breakpoints[id] = 0;
+    return 0;
+}
+
+static int fake_list_breakpoints(int after, BatchBreakpoint *dst, uint32_t max)
+{
+    backend_calls++;
+    uint32_t n = 0;
+    for (int id = after + 1; id < breakpoint_count && n < max; ++id)
+        if (breakpoints[id])
+            dst[n++] = (BatchBreakpoint){id, breakpoints[id], 3, 0};
+    return n;
+}
+
+static int fake_get_registers(int32_t thid, uint32_t *regs)
+{
+    backend_calls++;
+    if (thid && thid != 7)
+        return -1;
+    for (uint32_t i = 0; i < BATCH_REGS; ++i)
+        regs[i] = i * 0x11;
+    return 1; // THREAD_BREAKPOINT
+}
+
+static int fake_list_modules(BatchModule *dst, uint32_t max)
+{
+    backend_calls++;
+    uint32_t n = 0;
+    for (; n < 3 && n < max; ++n)
+    {
+        dst[n] = (BatchModule){100 + n, 0x81000000 + n * 0x10000, 0x1000, {0}};
+        snprintf(dst[n].name, sizeof(dst[n].name), "mod%u", n);
+    }
+    return n;
+}
+
+static const BatchBackend backend = {
+    .read = fake_read,
+    .write = fake_write,
+    .set_breakpoint = fake_set_breakpoint,
+    .clear_breakpoint = fake_clear_breakpoint,
+    .list_breakpoints = fake_list_breakpoints,
+    .get_registers = fake_get_registers,
+    .list_modules = fake_list_modules,
+};
+
+// kernel_batch without the syscall: the same size limits and the copies into and out of kernel buffers.
+int kernel_batch(const void *user_in, SceSize in_size, void *user_out, SceSize out_size)
+{
+    static uint32_t in[BATCH_MAX_IN / 4], out[BATCH_MAX_OUT / 4];
+    if (!user_in || !user_out || in_size < sizeof(BatchHeader) || in_size > BATCH_MAX_IN ||
+        out_size < sizeof(BatchHeader))
+        return -1;
+    if (out_size > BATCH_MAX_OUT)
+        out_size = BATCH_MAX_OUT;
+    memcpy(in, user_in, in_size);
+    const int ret = batch_execute(in, in_size, out, out_size, &backend);
+    if (ret > 0)
+        memcpy(user_out, out, ret);
+    return ret;
+}
+
+static void reset_backend(void)
+{
+    for (uint32_t i = 0; i < sizeof(memory); ++i)
+        memory[i] = i;
+    memset(breakpoints, 0, sizeof(breakpoints));
+    breakpoint_count = 0;
+    backend_calls = 0;
+}
+
+static uint32_t request[1024], reply[4096];
+
+static void test_ops(void)
+{
+    reset_backend();
+    PebbleBatch b;
+    PebbleReplies r;
+    pebble_batch_init(&b, request, sizeof(request));
+    CHECK_EQ(pebble_batch_write(&b, 0x10, "\xAA\xBB\xCC", 3), 0);
+    pebble_batch_read(&b, 0x0F, 5); // Sees the write
+    pebble_batch_set_breakpoint(&b, 0x8100, 3);
+    pebble_batch_set_breakpoint(&b, 0x8200, 3);
+    pebble_batch_clear_breakpoint(&b, 0);
+    pebble_batch_list_breakpoints(&b, -1, 0);
+    pebble_batch_get_registers(&b, 0);
+    pebble_batch_get_registers(&b, 9);
+    pebble_batch_list_modules(&b, 2);
+    pebble_batch_read(&b, 0x5000, 4);
+    CHECK_EQ(pebble_batch_clear_breakpoint(&b, 0), 10);
+    CHECK_EQ(pebble_batch_submit(&b, reply, sizeof(reply), &r), 11);
+
+    // A failing op only sets its own status.
+    const int32_t status[] = {0, 0, 0, 1, 0, 1, 1, -1, 2, -1, -1};
+    const uint16_t size[] = {0, 5, 0, 0, 0, sizeof(BatchBreakpoint), BATCH_REGS * 4, 0, 2 * sizeof(BatchModule), 0, 0};
+    BatchResult result;
+    const void *data;
+    uint32_t i = 0;
+    for (; pebble_batch_next(&r, &result, &data); ++i)
+    {
+        CHECK_EQ(result.status, status[i]);
+        CHECK_EQ(result.size, size[i]);
+        CHECK((data != NULL) == (size[i] != 0));
+        if (i == 1)
+            CHECK(!memcmp(data, "\x0F\xAA\xBB\xCC\x13", 5));
+        else if (i == 5)
+            CHECK_EQ(((const BatchBreakpoint *)data)->address, 0x8200);
+        else if (i == 6)
+            CHECK_EQ(((const uint32_t *)data)[15], 15 * 0x11);
+        else if (i == 8)
+            CHECK(!strcmp(((const BatchModule *)data)[1].name, "mod1"));
+    }
+    CHECK_EQ(i, 11);
+}
+
+// Runs a hand-built request straight through batch_execute, from a buffer of exactly in_size bytes so the sanitizer
+// sees any read past it.
+static int execute_raw(const void *in, uint32_t in_size)
+{
+    void *copy = malloc(in_size ? in_size : 1);
+    memcpy(copy, in, in_size);
+    const int ret = batch_execute(copy, in_size, reply, sizeof(reply), &backend);
+    free(copy);
+    return ret;
+}
+
+static void test_malformed(void)
+{
+    reset_backend();
+    struct
+    {
+        BatchHeader header;
+        BatchOp ops[2];
+        uint8_t payload[8];
+    } req = {{BATCH_MAGIC, BATCH_VERSION, 2, sizeof(BatchHeader) + 2 * sizeof(BatchOp)},
+             {{BATCH_READ, 0, 0, 4}, {BATCH_WRITE, 0, 0, 0}},
+             {0}};
+    CHECK_EQ(execute_raw(&req, req.header.size), sizeof(BatchHeader) + 2 * sizeof(BatchResult) + 4);
+    const uint32_t good = backend_calls;
+    CHECK_EQ(good, 1); // The empty write does not reach the backend
+
+    req.header.magic++;
+    CHECK_EQ(execute_raw(&req, req.header.size), -1);
+    req.header.magic--;
+    req.header.version++;
+    CHECK_EQ(execute_raw(&req, req.header.size), -1);
+    req.header.version--;
+
+    // Sizes: shorter than a header, longer than what was passed, and a count with more ops than the size holds.
+    CHECK_EQ(execute_raw(&req, sizeof(BatchHeader) - 1), -1);
+    req.header.size = sizeof(BatchHeader) - 4;
+    CHECK_EQ(execute_raw(&req, sizeof(req)), -1);
+    req.header.size = sizeof(BatchHeader) + 2 * sizeof(BatchOp);
+    CHECK_EQ(execute_raw(&req, req.header.size - 1), -1);
+    req.header.count = 3;
+    CHECK_EQ(execute_raw(&req, req.header.size), -1);
+    req.header.count = 2;
+
+    // A payload running past the end: by its padding alone, with one more op claimed after it, and by a size close
+    // to the 16-bit limit.
+    req.ops[1].size = 5;
+    req.header.size += 5;
+    req.header.count = 3;
+    CHECK_EQ(execute_raw(&req, req.header.size), -1);
+    req.header.count = 2;
+    req.ops[1].size = 0xFFFF;
+    req.header.size += 3;
+    CHECK_EQ(execute_raw(&req, req.header.size), -1);
+    req.ops[1].size = 8;
+    CHECK_EQ(execute_raw(&req, req.header.size), sizeof(BatchHeader) + 2 * sizeof(BatchResult) + 4);
+    CHECK_EQ(backend_calls, good + 2);
+
+    // A good request with nowhere to put the reply header.
+    CHECK_EQ(batch_execute(&req, req.header.size, reply, sizeof(BatchHeader) - 1, &backend), -1);
+    CHECK_EQ(backend_calls, good + 2);
+
+    // Client-side checks stop a bad op or an overfull batch before the syscall.
+    PebbleBatch b;
+    PebbleReplies r;
+    pebble_batch_init(&b, request, sizeof(BatchHeader) + 2 * sizeof(BatchOp));
+    CHECK_EQ(pebble_batch_read(&b, 0, 0), -1);
+    CHECK_EQ(pebble_batch_read(&b, 0, BATCH_MAX_READ + 1), -1);
+    CHECK_EQ(pebble_batch_read(&b, 0, 4), 0);
+    CHECK_EQ(pebble_batch_read(&b, 0, 4), 1);
+    CHECK_EQ(pebble_batch_read(&b, 0, 4), -1);
+    CHECK_EQ(pebble_batch_submit(&b, reply, sizeof(reply), &r), -1);
+    CHECK_EQ(backend_calls, good + 2);
+}
+
+static void test_truncated(void)
+{
+    reset_backend();
+    PebbleBatch b;
+    PebbleReplies r;
+    BatchResult result;
+    const void *data;
+
+    // Room for three reads and a bit: the fourth does not run, and the reply is a whole number of results.
+    pebble_batch_init(&b, request, sizeof(request));
+    for (int i = 0; i < 10; ++i)
+        pebble_batch_read(&b, i * 0x100, 0x100);
+    const uint32_t three = sizeof(BatchHeader) + 3 * (sizeof(BatchResult) + 0x100);
+    CHECK_EQ(pebble_batch_submit(&b, reply, three + sizeof(BatchResult) + 0xFC, &r), 3);
+    CHECK_EQ(backend_calls, 3);
+    CHECK_EQ(r.size, three);
+    uint32_t n = 0;
+    for (; pebble_batch_next(&r, &result, &data); ++n)
+        CHECK(result.size == 0x100 && ((const uint8_t *)data)[1] == (uint8_t)(n * 0x100 + 1));
+    CHECK_EQ(n, 3);
+
+    // An exact fit runs all of them.
+    pebble_batch_init(&b, request, sizeof(request));
+    for (int i = 0; i < 3; ++i)
+        pebble_batch_read(&b, 0, 0x100);
+    CHECK_EQ(pebble_batch_submit(&b, reply, three, &r), 3);
+    CHECK_EQ(pebble_batch_submit(&b, reply, three - 1, &r), 2);
+
+    // Lists shrink to the room left instead of stopping the batch, down to an empty list.
+    reset_backend();
+    for (int i = 0; i < 8; ++i)
+        fake_set_breakpoint(0x8000 + i * 4, 3);
+    pebble_batch_init(&b, request, sizeof(request));
+    pebble_batch_list_breakpoints(&b, -1, 3);
+    pebble_batch_list_breakpoints(&b, -1, 0);
+    pebble_batch_list_breakpoints(&b, -1, 0);
+    const uint32_t room = sizeof(BatchHeader) + 3 * sizeof(BatchResult) + 4 * sizeof(BatchBreakpoint) + 4;
+    CHECK_EQ(pebble_batch_submit(&b, reply, room, &r), 3);
+    CHECK(pebble_batch_next(&r, &result, &data) && result.status == 3 && result.size == 3 * sizeof(BatchBreakpoint));
+    CHECK(pebble_batch_next(&r, &result, &data) && result.status == 1 && result.size == sizeof(BatchBreakpoint));
+    CHECK(pebble_batch_next(&r, &result, &data) && result.status == 0 && result.size == 0 && !data);
+
+    // Registers need their whole reply up front.
+    pebble_batch_init(&b, request, sizeof(request));
+    pebble_batch_get_registers(&b, 7);
+    CHECK_EQ(pebble_batch_submit(&b, reply, sizeof(BatchHeader) + sizeof(BatchResult) + BATCH_REGS * 4 - 4, &r), 0);
+    CHECK(!pebble_batch_next(&r, &result, &data));
+
+    // A reply that claims more than the buffer holds stops the walk.
+    pebble_batch_init(&b, request, sizeof(request));
+    pebble_batch_read(&b, 0, 8);
+    CHECK_EQ(pebble_batch_submit(&b, reply, sizeof(reply), &r), 1);
+    r.size -= 4;
+    CHECK(!pebble_batch_next(&r, &result, &data));
+}
+
+int main(void)
+{
+    test_ops();
+    test_malformed();
+    test_truncated();
+    return test_result();
+}
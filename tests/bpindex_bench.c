@@ -0,0 +1,71 @@
+#include "bpindex.h"
+#include "test.h"
+
+#include <stdlib.h>
+
+// Lookup cost in ns at 16, 256 and 4096 breakpoints, half hits and half misses, with the index sized like the
+// kernel's (8192 buckets), against the linear walk over the breakpoint table that handlers used before.
+
+#define BITS 13
+#define SLOTS 4096
+#define LOOKUPS 20000000
+
+typedef struct
+{
+    uint32_t address;
+    bool active;
+} TableSlot;
+
+static BpBucket buckets[1 << BITS];
+static uint16_t next[SLOTS];
+static TableSlot table[SLOTS];
+
+static uint32_t linear_lookup(uint32_t count, uint32_t address)
+{
+    for (uint32_t i = 0; i < count; ++i)
+        if (table[i].active && table[i].address == address)
+            return 1;
+    return 0;
+}
+
+int main(void)
+{
+    const uint32_t sizes[] = {16, 256, 4096};
+    for (uint32_t z = 0; z < 3; ++z)
+    {
+        const uint32_t n = sizes[z];
+        BpIndex ix;
+        bpindex_init(&ix, buckets, BITS, next, SLOTS);
+        uint32_t seed = 42 + z;
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            table[i].address = 0x81000000 + (test_random(&seed) % 0x100000) * 2;
+            table[i].active = true;
+            bpindex_insert(&ix, table[i].address, i);
+        }
+
+        uint32_t found = 0;
+        uint16_t out[BPINDEX_MAX_CHAIN];
+        double start = bench_now_ms();
+        for (uint32_t r = 0; r < LOOKUPS; ++r)
+        {
+            const uint32_t address = (r & 1) ? table[r % n].address : 0x83000000 + r * 2;
+            found += bpindex_lookup(&ix, address, out, BPINDEX_MAX_CHAIN);
+        }
+        const double hash_ns = (bench_now_ms() - start) * 1e6 / LOOKUPS;
+
+        // Fewer rounds for the linear walk, which grows with the table.
+        const uint32_t linear_lookups = LOOKUPS / n;
+        uint32_t linear_found = 0;
+        start = bench_now_ms();
+        for (uint32_t r = 0; r < linear_lookups; ++r)
+        {
+            const uint32_t address = (r & 1) ? table[r % n].address : 0x83000000 + r * 2;
+            linear_found += linear_lookup(n, address);
+        }
+        const double linear_ns = (bench_now_ms() - start) * 1e6 / linear_lookups;
+        printf("%5u breakpoints  index %6.1f ns  linear %8.1f ns  (%u %u)\n", n, hash_ns, linear_ns, found,
+               linear_found);
+    }
+    return 0;
+}
@@ -0,0 +1,168 @@
+#include "bpindex.h"
+#include "test.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Inserts, removals and shared addresses against a plain slot -> address table, then readers looking up addresses
+// while a writer churns the index around them: stable entries must always be found exactly, absent ones never.
+
+#define SLOTS 512
+#define BITS 10
+#define STABLE 64
+#define STRESS_MS 800
+
+static BpBucket buckets[1 << BITS];
+static uint16_t next[SLOTS];
+static BpIndex ix;
+static uint32_t table[SLOTS]; // 0 when the slot is free
+
+static void check_against_table(void)
+{
+    for (uint32_t slot = 0; slot < SLOTS; ++slot)
+    {
+        if (!table[slot])
+            continue;
+        uint16_t out[SLOTS];
+        const uint32_t n = bpindex_lookup(&ix, table[slot], out, SLOTS);
+        uint32_t expected = 0, found = 0;
+        for (uint32_t s = 0; s < SLOTS; ++s)
+            expected += table[s] == table[slot];
+        for (uint32_t k = 0; k < n; ++k)
+        {
+            CHECK(table[out[k]] == table[slot]);
+            found += out[k] == slot;
+        }
+        CHECK_EQ(n, expected);
+        CHECK_EQ(found, 1);
+    }
+}
+
+static void test_churn(void)
+{
+    bpindex_init(&ix, buckets, BITS, next, SLOTS);
+    memset(table, 0, sizeof(table));
+    uint16_t out[BPINDEX_MAX_CHAIN];
+    CHECK_EQ(bpindex_lookup(&ix, 0x81000000, out, BPINDEX_MAX_CHAIN), 0);
+    CHECK_EQ(bpindex_insert(&ix, 0x81000000, SLOTS), -1);
+    CHECK_EQ(bpindex_remove(&ix, 0x81000000, 0), -1);
+
+    // A small address pool so slots share addresses and probe runs collide and wrap.
+    uint32_t seed = 99;
+    for (uint32_t round = 0; round < 200000; ++round)
+    {
+        const uint32_t slot = test_random(&seed) % SLOTS;
+        if (table[slot])
+        {
+            CHECK_EQ(bpindex_remove(&ix, table[slot], slot), 0);
+            table[slot] = 0;
+        }
+        else
+        {
+            const uint32_t address = 0x81000000 + (test_random(&seed) % 700) * 2;
+            if (bpindex_insert(&ix, address, slot) == 0)
+                table[slot] = address;
+            else
+                CHECK(ix.count + 1 > (1u << BITS) / 4 * 3);
+        }
+        if (round % 5000 == 0)
+            check_against_table();
+    }
+    check_against_table();
+
+    // Lookups stop at max; a chain longer than that reports only its first entries.
+    bpindex_init(&ix, buckets, BITS, next, SLOTS);
+    for (uint32_t slot = 0; slot < 12; ++slot)
+        bpindex_insert(&ix, 0x8100FF00, slot);
+    CHECK_EQ(bpindex_lookup(&ix, 0x8100FF00, out, BPINDEX_MAX_CHAIN), BPINDEX_MAX_CHAIN);
+}
+
+static volatile int stop;
+static uint32_t stable_address[STABLE];
+
+static uint32_t absent_address(uint32_t i)
+{
+    return 0x90000000 + i * 4;
+}
+
+// Addresses the writer churns, never one of the stable ones.
+static uint32_t churn_address(uint32_t r)
+{
+    const uint32_t address = 0x82000000 + (r % 256) * 2;
+    return (address % 8 == 0 && (address - 0x82000000) / 8 < STABLE) ? address + 2 : address;
+}
+
+static void *reader(void *arg)
+{
+    uint32_t seed = (uint32_t)(uintptr_t)arg, errors = 0;
+    while (!stop)
+    {
+        uint16_t out[BPINDEX_MAX_CHAIN];
+        const uint32_t i = test_random(&seed) % STABLE;
+        uint32_t n = bpindex_lookup(&ix, stable_address[i], out, BPINDEX_MAX_CHAIN);
+        errors += n != 1 || out[0] != i;
+        n = bpindex_lookup(&ix, absent_address(i), out, BPINDEX_MAX_CHAIN);
+        errors += n != 0;
+        n = bpindex_lookup(&ix, churn_address(test_random(&seed)), out, BPINDEX_MAX_CHAIN);
+        for (uint32_t k = 0; k < n; ++k)
+            errors += out[k] < STABLE || out[k] >= SLOTS;
+    }
+    return (void *)(uintptr_t)errors;
+}
+
+static void test_concurrent(void)
+{
+    // Stable slots stay put; the writer inserts and removes the others at addresses whose probe runs overlap theirs,
+    // so backward-shift deletion keeps moving stable buckets under the readers.
+    bpindex_init(&ix, buckets, BITS, next, SLOTS);
+    memset(table, 0, sizeof(table));
+    for (uint32_t i = 0; i < STABLE; ++i)
+    {
+        stable_address[i] = 0x82000000 + i * 2 * 4;
+        bpindex_insert(&ix, stable_address[i], i);
+    }
+
+    pthread_t readers[3];
+    stop = 0;
+    for (uintptr_t t = 0; t < 3; ++t)
+        pthread_create(&readers[t], NULL, reader, (void *)(t + 1));
+
+    uint32_t seed = 5, edits = 0;
+    const double end = bench_now_ms() + STRESS_MS;
+    while (bench_now_ms() < end)
+        for (int burst = 0; burst < 1000; ++burst, ++edits)
+        {
+            const uint32_t slot = STABLE + test_random(&seed) % (SLOTS - STABLE);
+            if (table[slot])
+            {
+                bpindex_remove(&ix, table[slot], slot);
+                table[slot] = 0;
+            }
+            else
+            {
+                const uint32_t address = churn_address(test_random(&seed));
+                if (bpindex_insert(&ix, address, slot) == 0)
+                    table[slot] = address;
+            }
+        }
+    stop = 1;
+
+    uintptr_t errors = 0;
+    for (int t = 0; t < 3; ++t)
+    {
+        void *ret;
+        pthread_join(readers[t], &ret);
+        errors += (uintptr_t)ret;
+    }
+    printf("%u edits, %lu reader errors\n", edits, (unsigned long)errors);
+    CHECK_EQ(errors, 0);
+    CHECK(edits > 0);
+}
+
+int main(void)
+{
+    test_churn();
+    test_concurrent();
+    return test_result();
+}
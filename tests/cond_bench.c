@@ -0,0 +1,56 @@
+#include "cond.h"
+#include "test.h"
+
+#include <string.h>
+
+// Per-hit cost of evaluating a condition, in ns, for the shapes conditions usually take: a register compare, a
+// memory dereference, a short-circuited chain and a bit test. Half of the hits pass.
+
+#define HITS 20000000
+
+static uint8_t memory[256];
+
+static int mem_read(uint32_t addr, void *dst, uint32_t size)
+{
+    if (addr >= sizeof(memory) || size > sizeof(memory) - addr)
+        return -1;
+    memcpy(dst, memory + addr, size);
+    return 0;
+}
+
+int main(void)
+{
+    static const char *texts[] = {
+        "",
+        "r0 == 5",
+        "[r1 + 4] != 0",
+        "r0 == 5 && [r1 + 4] != 0 && hits > 10",
+        "(b[sp] & 0x80) && (lr >> 1) == 0x8100A3C",
+        "r0 == 0x10000 || r0 == 0x20000 || r0 == 0x30000 || r0 == 5",
+    };
+    uint32_t regs[COND_REG_COUNT] = {5, 16, 2, 3};
+    regs[13] = 32;
+    regs[14] = 0x8100A3C << 1;
+    memory[20] = 7;
+    memory[32] = 0x81;
+
+    for (uint32_t i = 0; i < sizeof(texts) / sizeof(texts[0]); ++i)
+    {
+        CondProgram prog;
+        const int length = cond_compile(&prog, texts[i]);
+        if (!*texts[i])
+            prog.length = 0;
+        volatile uint32_t passed = 0;
+        const double start = bench_now_ms();
+        for (uint32_t hit = 0; hit < HITS; ++hit)
+        {
+            regs[0] = 5 + (hit & 1);
+            memory[20] = hit & 2;
+            passed += cond_eval(&prog, regs, hit, mem_read);
+        }
+        const double ns = (bench_now_ms() - start) * 1e6 / HITS;
+        printf("%-60s %3d bytes %6.1f ns/hit  (%u passed)\n", *texts[i] ? texts[i] : "(no condition)",
+               *texts[i] ? length : 0, ns, passed);
+    }
+    return 0;
+}
@@ -0,0 +1,165 @@
+#include "cond.h"
+#include "test.h"
+
+#include <string.h>
+
+// Conditions compiled and evaluated against fixed registers and a small memory image, C operator precedence, and
+// programs torn between two compiles or filled with random bytes, which must evaluate without leaving the stack or
+// the code.
+
+static uint8_t memory[256];
+
+static int mem_read(uint32_t addr, void *dst, uint32_t size)
+{
+    if (addr >= sizeof(memory) || size > sizeof(memory) - addr)
+        return -1;
+    memcpy(dst, memory + addr, size);
+    return 0;
+}
+
+static uint32_t regs[COND_REG_COUNT];
+
+static int eval(const char *text)
+{
+    CondProgram prog;
+    if (cond_compile(&prog, text) < 0)
+        return -1;
+    return cond_eval(&prog, regs, 42, mem_read);
+}
+
+static void test_expressions(void)
+{
+    static const struct
+    {
+        const char *text;
+        int expected; // -1 when it must not compile
+    } cases[] = {
+        {"r0 == 5", 1},
+        {"r0 == 5 && [r1 + 4] != 0", 1},
+        {"r0 == 5 && [r1 + 4] == 0", 0},
+        {"hits >= 100", 0},
+        {"hits == 42", 1},
+        {"b[sp] & 0x80", 1},
+        {"h[20] == 7", 1},
+        {"(lr >> 1) == 0x8100A3C", 1},
+        {"r0 < 3 || r2 == 2", 1},
+        {"!(r0 == 5)", 0},
+        {"-r0 == 0xFFFFFFFB", 1},
+        {"~r0 == 0xFFFFFFFA", 1},
+        {"(r0 || 0) == 1", 1},
+        {"cpsr & 0x20", 1},
+        {"R3 == 3 && pc == 0x81000000", 1},
+        {"r1 << 40 == 0", 1},
+        {"r0 >= 5 && r0 <= 5 && r0 > 4 && r0 < 6 && r0 != 6", 1},
+        // A load that faults makes the whole condition false, unless short-circuited away.
+        {"[0x1000] == 0", 0},
+        {"r0 == 1 && [0x1000] == 0", 0},
+        {"r0 == 5 || [0x1000] == 0", 1},
+        // C precedence: shifts above comparisons, comparisons above & ^ |, those above && ||.
+        {"r1 << 2 == 64", 1},
+        {"r0 & 2 == 2", 1},   // r0 & (2 == 2) = 5 & 1
+        {"(r0 & 2) == 2", 0}, // The bit test spelled out
+        {"r0 & 1 == 1", 1},
+        {"r2 | 1 == 3", 1},   // 2 | (1 == 3) = 2
+        {"r2 ^ 2 == 2", 1},   // 2 ^ (2 == 2) = 3
+        {"r0 | r2 & 0", 1},   // 5 | (2 & 0)
+        {"r0 ^ r0 | 1", 1},   // (5 ^ 5) | 1
+        {"r2 & r3 ^ r3", 1},  // (2 & 3) ^ 3 = 1
+        {"1 < 2 == 1", 1},    // (1 < 2) == 1
+        {"r0 & 4 && r1 | 0", 1},
+        {"r0 - 2 - 3 == 0", 1},
+        // Rejected
+        {"r0 + r1*2", -1},
+        {"r16", -1},
+        {"(r0", -1},
+        {"[r0", -1},
+        {"", -1},
+        {"r0 ==", -1},
+        {"r0 5", -1},
+    };
+    for (uint32_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i)
+    {
+        const int got = eval(cases[i].text);
+        if (got != cases[i].expected)
+        {
+            fprintf(stderr, "\"%s\" gave %d, expected %d\n", cases[i].text, got, cases[i].expected);
+            test_failures++;
+        }
+    }
+
+    // Too deep for the evaluation stack, and too long for the code buffer.
+    CHECK_EQ(eval("r0+(r0+(r0+(r0+(r0+(r0+(r0+(r0+(r0+r0))))))))"), -1);
+    CHECK_EQ(eval("r0==0x10000001||r0==0x10000002||r0==0x10000003||r0==0x10000004||r0==0x10000005||"
+                  "r0==0x10000006||r0==0x10000007||r0==0x10000008"),
+             -1);
+
+    const char *text = "sp+4";
+    CHECK_EQ(cond_register(&text), 13);
+    CHECK(strcmp(text, "+4") == 0);
+    text = "r17";
+    CHECK_EQ(cond_register(&text), -1);
+}
+
+static void test_malformed(void)
+{
+    // Halves of two different programs, as a handler could see while an entry is rewritten, and random bytes.
+    static const char *texts[] = {"r0 == 5 && [r1 + 4] != 0", "hits > 10 || b[sp] & 0x80", "(lr >> 1) == 0x8100A3C",
+                                  "-r0 == 0xFFFFFFFB && r1 < 0x12345678", "r15 == 0x81000000 || cpsr & 0x20"};
+    CondProgram a, b, torn;
+    for (uint32_t i = 0; i < 5; ++i)
+        for (uint32_t j = 0; j < 5; ++j)
+        {
+            cond_compile(&a, texts[i]);
+            cond_compile(&b, texts[j]);
+            for (uint32_t cut = 0; cut <= COND_MAX_CODE; ++cut)
+            {
+                memcpy(torn.code, a.code, cut);
+                memcpy(torn.code + cut, b.code + cut, COND_MAX_CODE - cut);
+                torn.length = (cut & 1) ? a.length : b.length;
+                cond_eval(&torn, regs, 0, mem_read);
+            }
+        }
+
+    uint32_t seed = 0xBADC0DE;
+    uint32_t passed = 0;
+    for (uint32_t round = 0; round < 200000; ++round)
+    {
+        CondProgram p;
+        for (uint32_t i = 0; i < COND_MAX_CODE; ++i)
+            p.code[i] = test_random(&seed) % ((round & 1) ? 256 : 30);
+        p.length = 1 + test_random(&seed) % COND_MAX_CODE;
+        passed += cond_eval(&p, regs, round, mem_read);
+    }
+    // Random bytes mostly fail a check; the point is that none of them faulted getting there.
+    CHECK(passed < 200000);
+
+    // Stack overflow and underflow, and a register index past the table, all just fail.
+    CondProgram p = {{0}, COND_MAX_CODE};
+    for (uint32_t i = 0; i + 1 < COND_MAX_CODE; i += 2)
+    {
+        p.code[i] = 2; // Byte immediates, one more than the stack holds
+        p.code[i + 1] = 1;
+    }
+    CHECK(!cond_eval(&p, regs, 0, mem_read));
+    CondProgram underflow = {{12, 0}, 2}; // A binary op on an empty stack
+    CHECK(!cond_eval(&underflow, regs, 0, mem_read));
+    CondProgram bad_reg = {{3, COND_REG_COUNT, 0}, 3};
+    CHECK(!cond_eval(&bad_reg, regs, 0, mem_read));
+}
+
+int main(void)
+{
+    regs[0] = 5;
+    regs[1] = 16;
+    regs[2] = 2;
+    regs[3] = 3;
+    regs[13] = 32;
+    regs[14] = 0x8100A3C << 1;
+    regs[15] = 0x81000000;
+    regs[16] = 0x60000030;
+    memory[20] = 7;
+    memory[32] = 0x81;
+    test_expressions();
+    test_malformed();
+    return test_result();
+}
@@ -0,0 +1,115 @@
+@ Hand-picked ARM encodings for disasm_test, one of each form the decoder prints. See gen_corpus.py.
+push {r4, r5, r6, lr}
+pop {r4, r5, r6, pc}
+push {r0}
+pop {r1}
+mov r0, r1
+mov r0, #0x100
+movs r2, r3, lsl #2
+mov r0, r1, lsr r2
+mvn r0, #0
+add r0, r1, r2
+add r0, r1, #4
+addne r0, r1, r2, lsl #3
+sub sp, sp, #16
+subs r0, r0, #1
+rsb r0, r1, #0
+and r0, r0, #0xff
+orr r1, r2, r3, ror #8
+eor r1, r2, r3, asr #31
+bic r1, r1, #0xf0000000
+cmp r0, #0
+cmpne r1, r2
+tst r0, #1
+teq r0, r1
+cmn r0, #5
+mul r0, r1, r2
+mla r0, r1, r2, r3
+mls r0, r1, r2, r3
+umull r0, r1, r2, r3
+smlal r0, r1, r2, r3
+ldr r0, [r1]
+ldr r0, [r1, #4]
+ldr r0, [r1, #-4]
+ldr r0, [r1, #4]!
+ldr r0, [r1], #4
+ldr r0, [r1, r2]
+ldr r0, [r1, -r2, lsl #2]
+ldr r0, [pc, #16]
+strb r0, [r1, #3]
+ldrb r0, [r1], #1
+ldrh r0, [r1, #2]
+strh r0, [r1], #-2
+ldrsb r0, [r1, r2]
+ldrsh r0, [r1, #-6]
+ldrd r0, r1, [r2, #8]
+strd r0, r1, [sp, #-8]!
+ldm r0!, {r1, r2, r3}
+stmdb r0, {r4-r11}
+ldmib r0, {r1, r2}
+stmda r0!, {r1, r2}
+b .+64
+bl .-64
+bleq .+8
+bx lr
+blx r3
+blx .+32
+movw r0, #0x1234
+movt r0, #0xabcd
+clz r0, r1
+rev r0, r1
+rev16 r0, r1
+rbit r0, r1
+uxtb r0, r1
+uxth r0, r1
+sxtb r0, r1
+sxth r0, r1
+ubfx r0, r1, #3, #5
+sbfx r0, r1, #0, #16
+bfi r0, r1, #8, #4
+bfc r0, #4, #12
+ldrex r0, [r1]
+strex r2, r0, [r1]
+mrs r0, apsr
+svc #0x1234
+bkpt #0x1234
+udf #0x10
+nop
+dmb sy
+dsb ish
+isb sy
+pld [r0, #64]
+mcr p15, 0, r0, c7, c5, 4
+mrc p15, 0, r0, c13, c0, 3
+vldr s0, [r0, #8]
+vstr d1, [sp, #-16]
+vpush {d8-d15}
+vpop {s16-s19}
+vldmia r0!, {d0-d3}
+vstmdb sp!, {s0-s1}
+vmov s0, r1
+vmov r2, s3
+vmov d1, r2, r3
+vmov r2, r3, d1
+vmrs APSR_nzcv, fpscr
+vmrs r0, fpscr
+vmsr fpscr, r1
+vadd.f32 s0, s1, s2
+vsub.f64 d0, d1, d2
+vmul.f32 s4, s5, s6
+vdiv.f64 d7, d8, d9
+vmla.f32 s0, s1, s2
+vnmul.f32 s0, s1, s2
+vmov.f32 s0, s1
+vabs.f64 d0, d1
+vneg.f32 s3, s4
+vsqrt.f32 s0, s1
+vcmp.f32 s0, s1
+vcmpe.f64 d0, #0
+vcvt.f64.f32 d0, s1
+vcvt.f32.f64 s0, d1
+vcvt.f32.s32 s0, s1
+vcvt.f64.u32 d0, s1
+vcvt.s32.f32 s0, s1
+vcvt.u32.f64 s0, d1
+ldrt r0, [r1], #4
@@ -0,0 +1,194 @@
+#!/usr/bin/env python3
+# Regenerates corpus.txt, the llvm-objdump reference disasm_test checks the decoder against:
+#
+#   python3 gen_corpus.py [llvm-mc] [llvm-objdump]
+#
+# Exact rows come from arm.s and thumb.s, assembled and disassembled by LLVM, then rewritten into the decoder's
+# conventions: small immediates in decimal and the rest in hex, runs of three or more core registers as r4-r7, VFP
+# lists as d8-d15, branch targets as bare addresses. A few encodings have two valid spellings; the decoder keeps the
+# pre-UAL one and the rows say so. Rows inside IT blocks are left out, since the decoder does not track IT state.
+#
+# Random rows are seeded encodings compared by mnemonic only, "?" where LLVM has no decoding. The decoder may leave
+# an encoding LLVM knows undecoded (coprocessor, NEON and media are out of scope) but must not invent one LLVM lacks.
+
+import os
+import random
+import re
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+MC = sys.argv[1] if len(sys.argv) > 1 else 'llvm-mc'
+OBJDUMP = sys.argv[2] if len(sys.argv) > 2 else 'llvm-objdump'
+RANDOM_ROWS = 3000
+MATTR = '+vfp3,+hwdiv,+hwdiv-arm'
+# Encodings larger random sweeps caught the decoder out on, kept in every corpus.
+PINNED = {
+    'arm': [0x17FC5EFA, 0x2129577B, 0xE1AEF1D3, 0xEEBD0B67, 0xECE46B5F, 0xEC950B2F, 0xED2F9B0F],
+    'thumb': [0xBF70, 0xBFC0, 0xE8C8627F, 0xF811FC08, 0xF811F012, 0xF990F004, 0xF911FC08, 0xDEF9],
+}
+
+
+def assemble(source, tmp):
+    with open(os.path.join(tmp, 'c.s'), 'w') as f:
+        f.write(source)
+    subprocess.run([MC, '-triple=armv7a-none-eabi', '-mattr=' + MATTR, '-filetype=obj', '-o',
+                    os.path.join(tmp, 'c.o'), os.path.join(tmp, 'c.s')], check=True, stderr=subprocess.DEVNULL)
+    return subprocess.run([OBJDUMP, '-d', '--triple=armv7a', '--mattr=' + MATTR, '--print-imm-hex',
+                           os.path.join(tmp, 'c.o')], check=True, capture_output=True, text=True).stdout
+
+
+def number(match):
+    sign, value = match.group(1), int(match.group(2), 0)
+    if sign and value >= 0x10000:  # LLVM prints some modified immediates as signed
+        sign, value = '', (1 << 32) - value
+    return '#' + sign + (str(value) if value < 16 else '0x%x' % value)
+
+
+def reg_list(match):
+    regs = [r.strip() for r in match.group(1).split(',')]
+    if regs[0][0] in 'sd':
+        nums = [int(r[1:]) for r in regs]
+        return '{%s}' % regs[0] if len(regs) == 1 else '{%s-%s%d}' % (regs[0], regs[0][0], nums[-1])
+    core = ['r%d' % i for i in range(13)]
+    out, i = [], 0
+    while i < len(regs):
+        j = i
+        while regs[j] in core and j + 1 < len(regs) and regs[j + 1] in core and \
+                core.index(regs[j + 1]) == core.index(regs[j]) + 1:
+            j += 1
+        out.append(regs[i] + '-' + regs[j] if j >= i + 2 else regs[i])
+        i = j + 1 if j >= i + 2 else i + 1
+    return '{' + ', '.join(out) + '}'
+
+
+def normalize(text, thumb, size):
+    text = re.sub(r'\s*@.*', '', text)
+    text = re.sub(r'\s*<[^>]*>', '', text)
+    text = re.sub(r'\s+', ' ', text).strip()
+    mnemonic, _, operands = text.partition(' ')
+    mnemonic = re.sub(r'\.[wn]$', '', mnemonic)
+    if mnemonic == '__brkdiv0':  # Windows alias
+        mnemonic, operands = 'udf', '#0xf9'
+    operands = re.sub(r'#(-?)(0x[0-9a-f]+|\d+)', number, operands)
+    operands = re.sub(r'\{([^}]*)\}', reg_list, operands)
+    if re.fullmatch(r'b(l|lx|[a-z]{2})?', mnemonic) and re.fullmatch(r'0x[0-9a-f]+', operands):
+        operands = '0x%x' % int(operands, 16)
+
+    # Pre-UAL spellings the decoder prints.
+    m = re.fullmatch(r'(lsl|lsr|asr|ror|rrx)(s?)([a-z]{2})?', mnemonic)
+    if m and size == 4:
+        rd, rm, *amount = [o.strip() for o in operands.split(',')]
+        shift = m.group(1) + (' ' + amount[0] if amount else '')
+        if not thumb or not amount or amount[0].startswith('#'):  # Thumb-2 register shifts are their own instructions
+            return 'mov%s%s %s, %s, %s' % (m.group(2), m.group(3) or '', rd, rm, shift)
+    if mnemonic == 'str' and size == 4 and re.fullmatch(r'\w+, \[sp, #-4\]!', operands):
+        return 'push {%s}' % operands.split(',')[0]
+    if mnemonic == 'ldr' and size == 4 and re.fullmatch(r'\w+, \[sp\], #4', operands):
+        return 'pop {%s}' % operands.split(',')[0]
+    m = re.fullmatch(r'(r\d+|sp|lr), #(-?)(\S+)', operands)
+    if mnemonic == 'adr' and size == 4 and m:
+        return '%s %s, pc, #%s' % ('subw' if m.group(2) else 'addw', m.group(1), m.group(3))
+    return (mnemonic + ' ' + operands).strip()
+
+
+def rows(listing):
+    out = []
+    for line in listing.splitlines():
+        m = re.match(r'\s+([0-9a-f]+):\s+((?:[0-9a-f]{2} )+)\s*(.*)', line)
+        if m:
+            out.append((int(m.group(1), 16), bytes.fromhex(m.group(2).replace(' ', '')), m.group(3)))
+    return out
+
+
+def encoding(data, thumb):
+    if thumb and len(data) == 4:
+        return '%04x%04x' % (int.from_bytes(data[:2], 'little'), int.from_bytes(data[2:], 'little'))
+    return '%0*x' % (len(data) * 2, int.from_bytes(data, 'little'))
+
+
+def exact(mode, tmp):
+    thumb = mode == 'thumb'
+    with open(os.path.join(HERE, mode + '.s')) as f:
+        source = f.read()
+    header = '.syntax unified\n.arch armv7-a\n.fpu vfpv3\n' + ('.thumb\n' if thumb else '.arm\n')
+    out, skip = [], 0
+    for addr, data, text in rows(assemble(header + source, tmp)):
+        if skip:
+            skip -= 1
+            continue
+        m = re.match(r'it([te]*)\s', text)
+        if thumb and m:
+            skip = 1 + len(m.group(1))
+        out.append('%s %04x %s %s' % (mode[0], addr, encoding(data, thumb), normalize(text, thumb, len(data))))
+    return out
+
+
+def random_words(thumb, rng):
+    words = []
+    while len(words) < RANDOM_ROWS:
+        if not thumb:
+            w = rng.getrandbits(32)
+            words.append((w & 0x0FFFFFFF) | 0xE0000000 if rng.random() < 0.8 else w)
+        elif rng.random() < 0.5:
+            hw = rng.getrandbits(16)
+            if (hw >> 11) >= 0x1D:
+                hw &= 0xE7FF
+            if (hw & 0xFF00) != 0xBF00 or not (hw & 0xF):  # IT would change how LLVM reads the next rows
+                words.append(hw)
+        else:
+            hw1 = rng.getrandbits(16) | 0xE800
+            if (hw1 >> 11) >= 0x1D:
+                words.append((hw1 << 16) | rng.getrandbits(16))
+    return words
+
+
+def mnemonics(words, thumb, tmp):
+    # One section per encoding, so an undecodable one cannot shift LLVM's view of the next.
+    lines = ['.syntax unified', '.thumb' if thumb else '.arm']
+    for i, w in enumerate(words):
+        lines.append('.section .t%d,"ax",%%progbits' % i)
+        lines.append('.inst.w 0x%08x' % w if thumb and w > 0xFFFF else
+                     '.inst.n 0x%04x' % w if thumb else '.inst 0x%08x' % w)
+    listing = assemble('\n'.join(lines) + '\n', tmp)
+    sections = {}
+    chunks = re.split(r'Disassembly of section \.t(\d+):', listing)
+    for i in range(1, len(chunks), 2):
+        sections[int(chunks[i])] = rows(chunks[i + 1])
+    out, shadow = {}, 0
+    for i, w in enumerate(words):
+        found = sections.get(i, [])
+        size = 4 if not thumb or w > 0xFFFF else 2
+        shadow -= 1
+        if shadow >= 0 or len(found) != 1 or len(found[0][1]) != size or '<und>' in found[0][2]:
+            if any(re.match(r'it[te]*\s', text) for _, _, text in found):
+                shadow = 4  # An IT LLVM found resynchronising carries into the next sections
+            continue  # LLVM resynchronised inside it or carried IT state into it; not a usable reference
+        text = found[0][2].split()
+        unknown = not text or text[0] in ('<unknown>', '.inst', '.word', '.short')
+        out[i] = '?' if unknown else normalize(found[0][2], thumb, size).split(' ')[0]
+    return out
+
+
+def main():
+    rng = random.Random(20)
+    lines = ['# Generated by gen_corpus.py from llvm-mc and llvm-objdump; do not edit.',
+             '# a/t: address, encoding and the exact text for ARM/Thumb. A/T: encoding and mnemonic, ? when undefined.']
+    with tempfile.TemporaryDirectory() as tmp:
+        for mode in ('arm', 'thumb'):
+            lines += exact(mode, tmp)
+        for mode in ('arm', 'thumb'):
+            thumb = mode == 'thumb'
+            words = PINNED[mode] + random_words(thumb, rng)
+            found = mnemonics(words, thumb, tmp)
+            for i, w in enumerate(words):
+                if i in found:
+                    lines.append('%s %s %s' % (mode[0].upper(), '%04x' % w if thumb and w <= 0xFFFF else
+                                               '%08x' % w, found[i]))
+    with open(os.path.join(HERE, 'corpus.txt'), 'w') as f:
+        f.write('\n'.join(lines) + '\n')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,143 @@
+@ Hand-picked Thumb encodings for disasm_test, one of each form the decoder prints. See gen_corpus.py.
+3:
+push {r4-r7, lr}
+pop {r4, pc}
+movs r0, #1
+mov r0, r1
+mov r8, r0
+adds r0, r1, r2
+adds r0, r1, #7
+adds r0, #200
+subs r3, #1
+lsls r0, r1, #2
+lsrs r0, r1, #31
+asrs r0, r1
+ands r0, r1
+rsbs r0, r1, #0
+cmp r0, #10
+cmp r0, r9
+add r0, r9
+muls r0, r1, r0
+ldr r0, [r1, #4]
+ldr r0, [sp, #16]
+ldr r0, [pc, #32]
+str r0, [r1, r2]
+ldrb r0, [r1, #3]
+strh r0, [r1, #6]
+ldrsh r0, [r1, r2]
+add r0, sp, #8
+add sp, #16
+sub sp, #16
+adr r0, .+20
+cbz r0, 1f
+cbnz r1, 1f
+sxth r0, r1
+uxtb r0, r1
+rev r0, r1
+bkpt #3
+svc #5
+nop
+wfi
+stm r0!, {r1, r2}
+ldm r0, {r0, r1}
+ldm r0!, {r1, r2}
+beq 1f
+bne 3b
+b .+100
+1:
+bx lr
+blx r3
+itte eq
+moveq r0, #1
+moveq r1, #1
+movne r0, #2
+it ne
+movne r0, #1
+bl .+4000
+blx .+4000
+b.w .+4000
+beq.w 2f
+bgt.w 3b
+push.w {r4-r11, lr}
+pop.w {r4-r11, pc}
+ldm.w r0!, {r1, r2, r8}
+stmdb r0!, {r1, r2, r8}
+mov.w r0, #0x00ff00ff
+mov.w r0, #0xab00ab00
+mov.w r0, #0x3fc00000
+mvn r0, #0
+movs.w r0, r1, lsl #3
+add.w r0, r1, r2, lsl #2
+adds.w r0, r1, #0x100
+sub.w r0, r1, #1
+subs.w r0, r1, r2
+cmp.w r0, #0x1000
+cmp.w r0, r1, lsr #4
+tst.w r0, #0x80000000
+orr.w r0, r0, #0x10000
+bic.w r0, r0, #3
+eor.w r0, r1, r2
+and.w r0, r1, #0xff
+rsb.w r0, r1, #0
+orn r0, r1, #1
+addw r0, r1, #0xfff
+subw sp, sp, #0x804
+movw r0, #0xbeef
+movt r0, #0xdead
+ubfx r0, r1, #4, #8
+sbfx r0, r1, #0, #1
+bfi r0, r1, #3, #7
+bfc r0, #0, #16
+ldr.w r0, [r1, #0x800]
+ldr r0, [r1, #-4]
+ldr r0, [r1, #4]!
+ldr r0, [r1], #-4
+ldr.w r0, [r1, r2, lsl #2]
+ldr.w r0, [pc, #0x100]
+ldr.w r0, [pc, #-0x100]
+strb.w r0, [r1, #0x123]
+ldrsh.w r0, [r1, #2]
+strh r0, [r1, #-2]!
+ldrd r0, r1, [r2, #8]
+strd r0, r1, [sp, #-8]!
+ldrd r2, r3, [r0], #16
+ldrex r0, [r1]
+ldrex r0, [r1, #8]
+strex r2, r0, [r1]
+tbb [pc, r0]
+tbh [r1, r0, lsl #1]
+mul r0, r1, r2
+mla r0, r1, r2, r3
+mls r0, r1, r2, r3
+umull r0, r1, r2, r3
+smull r0, r1, r2, r3
+lsl.w r0, r1, r2
+asrs.w r0, r1, r2
+uxtb.w r0, r8
+sxth.w r8, r0
+clz r0, r1
+rbit r0, r1
+rev.w r8, r9
+dmb sy
+dsb sy
+isb sy
+nop.w
+mrs r0, apsr
+subs pc, lr, #4
+pld [r0, #32]
+pld [r1, #-8]
+pld [r1, r2, lsl #1]
+pli [r0, #4]
+pli [r1, #-8]
+vldr s0, [r0, #8]
+vstr d16, [r1]
+vpush {d8-d15}
+vpop {d8}
+vadd.f32 s0, s1, s2
+vmul.f64 d16, d17, d18
+vmov r0, s1
+vmov s31, r12
+vcvt.s32.f32 s0, s0
+vmrs APSR_nzcv, fpscr
+mcr p15, 0, r0, c7, c10, 5
+2:
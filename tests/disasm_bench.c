@@ -0,0 +1,90 @@
+#include "disasm.h"
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Decodes a 26-row screen of the disassembly view, built from the hand-picked corpus rows, and reports microseconds
+// per screen straight through disasm_decode and through the line cache the memory view redraws from.
+
+#define FRAMES 20000
+#define ROWS 26
+
+static uint8_t code[2][512];
+static uint32_t code_size[2];
+
+static void load(void)
+{
+    FILE *f = fopen(DISASM_CORPUS, "r");
+    if (!f)
+    {
+        fprintf(stderr, "no corpus at %s\n", DISASM_CORPUS);
+        exit(1);
+    }
+    char line[128], hex[9];
+    uint32_t addr;
+    while (fgets(line, sizeof(line), f))
+    {
+        const bool thumb = line[0] == 't';
+        if ((line[0] != 'a' && !thumb) || sscanf(line + 1, "%x %8s", &addr, hex) != 2)
+            continue;
+        uint32_t encoding = strtoul(hex, NULL, 16), size = strlen(hex) / 2;
+        if (thumb && size == 4)
+            encoding = (encoding >> 16) | (encoding << 16);
+        if (code_size[thumb] + size <= sizeof(code[thumb]))
+        {
+            memcpy(code[thumb] + code_size[thumb], &encoding, size);
+            code_size[thumb] += size;
+        }
+    }
+    fclose(f);
+}
+
+static uint32_t screen(DisasmCache *cache, bool thumb, uint32_t start)
+{
+    char text[DISASM_TEXT_MAX];
+    uint32_t offset = start;
+    for (uint32_t row = 0; row < ROWS; ++row)
+    {
+        uint32_t size;
+        if (cache)
+        {
+            const DisasmLine *line = disasm_line(cache, 0x81000000 + offset, code[thumb] + offset,
+                                                 code_size[thumb] - offset, thumb);
+            size = line ? line->size : 0;
+        }
+        else
+            size = disasm_decode(0x81000000 + offset, code[thumb] + offset, code_size[thumb] - offset, thumb, text,
+                                 sizeof(text), NULL);
+        offset += size ? size : 2;
+    }
+    return offset - start;
+}
+
+static void run(const char *name, bool thumb)
+{
+    static DisasmCache cache;
+    DisasmCache *const caches[2] = {NULL, &cache};
+    const char *names[2] = {"decode", "cached"};
+    for (int c = 0; c < 2; ++c)
+    {
+        disasm_cache_reset(&cache);
+        const double start = bench_now_ms();
+        for (uint32_t f = 0; f < FRAMES; ++f)
+            screen(caches[c], thumb, (f / 64 % 4) * 16); // Scrolls every 64 frames, as when stepping
+        const double ms = bench_now_ms() - start;
+        printf("%-6s %-8s %8.2f us/screen", name, names[c], ms * 1e3 / FRAMES);
+        if (caches[c])
+            printf("  hits %u misses %u", cache.hits, cache.misses);
+        printf("\n");
+    }
+}
+
+int main(void)
+{
+    load();
+    printf("%u ARM and %u Thumb bytes of corpus code, %d rows per screen\n", code_size[0], code_size[1], ROWS);
+    run("ARM", false);
+    run("Thumb", true);
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include "disasm.h"
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// The decoder against llvm-objdump, from disasm/corpus.txt (see disasm/gen_corpus.py): the hand-picked rows must come
+// out as the same text, and the random ones with the same mnemonic, or undecoded where LLVM has none. Random rows
+// the decoder leaves undecoded though LLVM knows them are counted, not failed. Then the line cache.
+
+static void decode(char mode, uint32_t addr, uint32_t encoding, uint32_t digits, char *out)
+{
+    uint8_t bytes[4];
+    const bool thumb = mode == 't' || mode == 'T';
+    if (thumb && digits == 8)
+        encoding = (encoding >> 16) | (encoding << 16); // First halfword first
+    memcpy(bytes, &encoding, sizeof(bytes));
+    disasm_decode(addr, bytes, digits / 2, thumb, out, DISASM_TEXT_MAX, NULL);
+}
+
+// Collapses the padding after the mnemonic and drops a .w/.n width suffix, which LLVM and the decoder place apart.
+static void normalize(const char *text, char *out)
+{
+    const char *operands = strchr(text, ' ');
+    size_t len = operands ? (size_t)(operands - text) : strlen(text);
+    if (len > 2 && text[len - 2] == '.' && (text[len - 1] == 'w' || text[len - 1] == 'n'))
+        len -= 2;
+    memcpy(out, text, len);
+    out[len] = '\0';
+    if (!operands)
+        return;
+    while (*operands == ' ')
+        operands++;
+    if (*operands)
+    {
+        strcat(out, " ");
+        strcat(out, operands);
+    }
+}
+
+static void test_corpus(void)
+{
+    FILE *f = fopen(DISASM_CORPUS, "r");
+    CHECK(f != NULL);
+    if (!f)
+        return;
+
+    char line[128];
+    uint32_t exact = 0, random = 0, missed[2] = {0};
+    while (fgets(line, sizeof(line), f))
+    {
+        line[strcspn(line, "\n")] = '\0';
+        if (line[0] == '#' || !line[0])
+            continue;
+
+        char mode, hex[9], out[DISASM_TEXT_MAX], ours[DISASM_TEXT_MAX + 4];
+        uint32_t addr = 0;
+        int pos = 0;
+        const bool is_exact = line[0] == 'a' || line[0] == 't';
+        if ((is_exact && sscanf(line, "%c %x %8s %n", &mode, &addr, hex, &pos) != 3) ||
+            (!is_exact && sscanf(line, "%c %8s %n", &mode, hex, &pos) != 2))
+        {
+            fprintf(stderr, "bad corpus line: %s\n", line);
+            test_failures++;
+            continue;
+        }
+        const char *want = line + pos;
+        decode(mode, addr, strtoul(hex, NULL, 16), strlen(hex), out);
+        normalize(out, ours);
+
+        if (is_exact)
+        {
+            exact++;
+            if (strcmp(ours, want))
+            {
+                fprintf(stderr, "%c %s: \"%s\", llvm-objdump \"%s\"\n", mode, hex, ours, want);
+                test_failures++;
+            }
+            continue;
+        }
+
+        random++;
+        ours[strcspn(ours, " ")] = '\0';
+        if (ours[0] == '.')
+        {
+            if (strcmp(want, "?"))
+                missed[mode == 'T']++;
+        }
+        else if (strcmp(ours, want))
+        {
+            fprintf(stderr, "%c %s: %s, llvm-objdump %s\n", mode, hex, out, want);
+            test_failures++;
+        }
+    }
+    fclose(f);
+    CHECK(exact > 0 && random > 0);
+    printf("%u exact rows, %u random rows; left undecoded: %u ARM, %u Thumb\n", exact, random, missed[0], missed[1]);
+}
+
+static void test_cache(void)
+{
+    static DisasmCache cache;
+    uint8_t code[8] = {0x70, 0x47, 0x00, 0xBF, 0x2D, 0xE9, 0xF0, 0x4F}; // bx lr; nop; push.w {r4-r11, lr}
+    disasm_cache_reset(&cache);
+
+    const DisasmLine *line = disasm_line(&cache, 0x81000000, code, sizeof(code), true);
+    CHECK(line && line->size == 2 && !strncmp(line->text, "bx", 2));
+    CHECK(disasm_line(&cache, 0x81000000, code, sizeof(code), true) == line);
+    CHECK_EQ(cache.hits, 1);
+    CHECK_EQ(cache.misses, 1);
+
+    // Patched bytes and a change of mode both decode again.
+    code[0] = 0x00;
+    code[1] = 0xBE; // bkpt #0
+    line = disasm_line(&cache, 0x81000000, code, sizeof(code), true);
+    CHECK(line && !strncmp(line->text, "bkpt", 4));
+    line = disasm_line(&cache, 0x81000000, code, sizeof(code), false);
+    CHECK(line && line->size == 4);
+    CHECK_EQ(cache.misses, 3);
+
+    line = disasm_line(&cache, 0x81000004, code + 4, 4, true);
+    CHECK(line && line->size == 4 && !strncmp(line->text, "push.w", 6));
+    CHECK(disasm_line(&cache, 0x81000004, code + 4, 2, true) == NULL); // Half an instruction
+}
+
+int main(void)
+{
+    test_corpus();
+    test_cache();
+    return test_result();
+}
@@ -0,0 +1,75 @@
+#include "evlog.h"
+#include "test.h"
+
+#include <string.h>
+
+// Snapshots after the ring has wrapped, and the cycle spans dump_frame_stats reports: aborts on two cores interleaved
+// in the log, the PMU counter wrapping mid-abort, and an abort that left the stub without reaching the end stage.
+
+static Evlog log_;
+static EvlogEvent events[EVLOG_SIZE];
+static uint32_t scratch[EVLOG_SIZE];
+
+static void asm_stage(uint32_t core, uint16_t stage, uint32_t cycles)
+{
+    evlog_push(&log_, 0, EV_ASM_ENTRY, EVLOG_ASM_A(stage, core), cycles);
+}
+
+static void test_snapshot(void)
+{
+    for (uint32_t i = 0; i < EVLOG_SIZE + 10; ++i)
+        evlog_push(&log_, i, EV_HANDLER, 1, i * 3);
+    CHECK_EQ(evlog_snapshot(&log_, events, EVLOG_SIZE), EVLOG_SIZE);
+    for (uint32_t i = 0; i < EVLOG_SIZE; ++i)
+        CHECK_EQ(events[i].time, i + 10);
+    CHECK_EQ(evlog_snapshot(&log_, events, 4), 4);
+    CHECK_EQ(events[0].time, EVLOG_SIZE + 6);
+}
+
+static void test_spans(void)
+{
+    memset(&log_, 0, sizeof(log_));
+    asm_stage(0, EVLOG_STAGE_ENTRY, 100);
+    asm_stage(1, EVLOG_STAGE_ENTRY, 5000);
+    asm_stage(0, 1, 130);
+    asm_stage(1, 1, 5040);
+    evlog_push(&log_, 0, EV_HANDLER, 1, 0x1234); // Not an asm event, and a is not a stage
+    asm_stage(1, 6, 5940);
+    asm_stage(0, 6, 730);
+    asm_stage(2, 6, 99); // No start on this core
+
+    // Counter wraps between the stages.
+    asm_stage(3, 1, 0xFFFFFF00);
+    asm_stage(3, 6, 0x00000300);
+
+    // The start is dropped when the next abort enters the stub on that core, whatever became of the first one.
+    asm_stage(0, 1, 1000);
+    asm_stage(0, EVLOG_STAGE_ENTRY, 2000);
+    asm_stage(0, 6, 2500);
+
+    const uint32_t count = evlog_snapshot(&log_, events, EVLOG_SIZE);
+    CHECK_EQ(count, 13);
+
+    EvlogSpan span;
+    evlog_asm_span(events, count, 1, 6, scratch, &span);
+    CHECK_EQ(span.count, 3);
+    CHECK_EQ(span.p50, 900);
+    CHECK_EQ(span.max, 0x400);
+
+    evlog_asm_span(events, count, EVLOG_STAGE_ENTRY, 1, scratch, &span);
+    CHECK_EQ(span.count, 2);
+    CHECK_EQ(span.p50, 40);
+    CHECK_EQ(span.max, 40);
+
+    evlog_asm_span(events, count, EVLOG_STAGE_ENTRY, 0, scratch, &span);
+    CHECK_EQ(span.count, 0);
+    CHECK_EQ(span.p50, 0);
+    CHECK_EQ(span.max, 0);
+}
+
+int main(void)
+{
+    test_snapshot();
+    test_spans();
+    return test_result();
+}
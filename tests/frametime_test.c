@@ -0,0 +1,130 @@
+#include "frametime.h"
+#include "test.h"
+
+// Frame timings against a fake clock: stage accumulation, the rolling window and its percentiles, and which input
+// edges are attributed to which presented frame.
+
+static uint64_t fake_now;
+
+static uint64_t fake_clock(void)
+{
+    return fake_now;
+}
+
+static void test_stages(void)
+{
+    FrameTimer t;
+    frametime_init(&t, fake_clock);
+
+    // A stage entered twice in one frame is one sample of the total.
+    frametime_begin(&t, FT_MEMREAD);
+    fake_now += 300;
+    frametime_end(&t, FT_MEMREAD);
+    frametime_begin(&t, FT_DRAW);
+    fake_now += 1200;
+    frametime_end(&t, FT_DRAW);
+    frametime_begin(&t, FT_MEMREAD);
+    fake_now += 200;
+    frametime_end(&t, FT_MEMREAD);
+    frametime_commit(&t);
+
+    StageStats st;
+    frametime_stats(&t, FT_MEMREAD, &st);
+    CHECK_EQ(st.count, 1);
+    CHECK_EQ(st.max, 500);
+    frametime_stats(&t, FT_DRAW, &st);
+    CHECK_EQ(st.max, 1200);
+    // Stages the frame never entered still get a zero sample, so every stage has one per frame.
+    frametime_stats(&t, FT_INPUT, &st);
+    CHECK_EQ(st.count, 1);
+    CHECK_EQ(st.max, 0);
+
+    // The next frame starts from zero.
+    frametime_commit(&t);
+    frametime_stats(&t, FT_MEMREAD, &st);
+    CHECK_EQ(st.count, 2);
+    CHECK_EQ(st.p50, 500);
+}
+
+static void test_window(void)
+{
+    FrameTimer t;
+    frametime_init(&t, fake_clock);
+    StageStats st;
+    frametime_stats(&t, FT_DRAW, &st);
+    CHECK_EQ(st.count, 0);
+    CHECK_EQ(st.max, 0);
+
+    // Shuffled 1..64 so the stats do not depend on insertion order.
+    for (uint32_t i = 0; i < FRAMETIME_WINDOW; ++i)
+        frametime_record(&t, FT_DRAW, (i * 37) % FRAMETIME_WINDOW + 1);
+    frametime_stats(&t, FT_DRAW, &st);
+    CHECK_EQ(st.count, FRAMETIME_WINDOW);
+    CHECK_EQ(st.p50, 33);
+    CHECK_EQ(st.p95, 61);
+    CHECK_EQ(st.max, 64);
+
+    // Only the last FRAMETIME_WINDOW samples count.
+    for (uint32_t i = 0; i < FRAMETIME_WINDOW; ++i)
+        frametime_record(&t, FT_DRAW, 1000 + i);
+    frametime_stats(&t, FT_DRAW, &st);
+    CHECK_EQ(st.count, FRAMETIME_WINDOW);
+    CHECK_EQ(st.p50, 1000 + FRAMETIME_WINDOW / 2);
+    CHECK_EQ(st.max, 1000 + FRAMETIME_WINDOW - 1);
+}
+
+static void test_latency(void)
+{
+    FrameTimer t;
+    frametime_init(&t, fake_clock);
+    StageStats st;
+    fake_now = 1000000;
+
+    // Presented without a handoff: nothing to measure.
+    frametime_presented(&t);
+    frametime_stats(&t, FT_PRESENT, &st);
+    CHECK_EQ(st.count, 0);
+
+    // Edge, a second edge before the frame, handoff, present: measured from the first edge.
+    frametime_input_edge(&t);
+    fake_now += 4000;
+    frametime_input_edge(&t);
+    fake_now += 6000;
+    frametime_handoff(&t);
+    fake_now += 3000;
+    frametime_presented(&t);
+    frametime_stats(&t, FT_LATENCY, &st);
+    CHECK_EQ(st.count, 1);
+    CHECK_EQ(st.max, 13000);
+    frametime_stats(&t, FT_PRESENT, &st);
+    CHECK_EQ(st.max, 3000);
+
+    // An edge that arrives after the handoff is not in that frame; it belongs to the next one.
+    frametime_handoff(&t);
+    fake_now += 1000;
+    frametime_input_edge(&t);
+    fake_now += 2000;
+    frametime_presented(&t);
+    frametime_stats(&t, FT_LATENCY, &st);
+    CHECK_EQ(st.count, 1);
+    fake_now += 5000;
+    frametime_handoff(&t);
+    fake_now += 2000;
+    frametime_presented(&t);
+    frametime_stats(&t, FT_LATENCY, &st);
+    CHECK_EQ(st.count, 2);
+    CHECK_EQ(t.samples[FT_LATENCY][1], 9000);
+
+    // A second present of the same handoff records nothing.
+    frametime_presented(&t);
+    frametime_stats(&t, FT_PRESENT, &st);
+    CHECK_EQ(st.count, 3);
+}
+
+int main(void)
+{
+    test_stages();
+    test_window();
+    test_latency();
+    return test_result();
+}
@@ -0,0 +1,166 @@
+#include "nextpc.h"
+#include "test.h"
+
+#include <string.h>
+
+// Single-step targets for the branch forms the decoder knows, ARM and Thumb: B/BL/BLX, BX/BLX register, POP and LDM
+// with pc, LDR pc, MOV/ADD/SUBS pc, CBZ/CBNZ, TBB/TBH, and instructions in IT blocks with the condition both ways.
+// Each encoding was checked against llvm-mc's disassembly. Then the return addresses nextpc_call_return gives.
+
+#define BASE 0x80000000u
+#define PC (BASE + 0x100)
+#define SP (BASE + 0x800)
+#define T (1u << 5)
+#define Z (1u << 30)
+#define IT(state) ((((state) >> 2) & 0x3F) << 10 | ((state) & 3) << 25)
+#define END 99
+
+static uint8_t memory[0x2000];
+
+static int mem_read(uint32_t addr, void *dst, uint32_t size)
+{
+    if (addr < BASE || addr - BASE >= sizeof(memory) || size > sizeof(memory) - (addr - BASE))
+        return -1;
+    memcpy(dst, memory + addr - BASE, size);
+    return 0;
+}
+
+static void put32(uint32_t addr, uint32_t value)
+{
+    memcpy(memory + addr - BASE, &value, sizeof(value));
+}
+
+// regs lists register/value pairs up to END; sp is SP and pc is PC unless set.
+static uint32_t predict(const uint8_t *insn, uint32_t size, uint32_t cpsr, const uint32_t *set)
+{
+    uint32_t regs[NEXTPC_REG_COUNT] = {0};
+    regs[13] = SP;
+    regs[15] = PC;
+    regs[16] = cpsr;
+    for (int i = 0; set && set[i] != END; i += 2)
+        regs[set[i]] = set[i + 1];
+    memset(memory + PC - BASE, 0, 8);
+    memcpy(memory + PC - BASE, insn, size);
+    return nextpc_predict(regs, mem_read);
+}
+
+#define INSN(...) (const uint8_t[]){__VA_ARGS__}, sizeof((const uint8_t[]){__VA_ARGS__})
+#define REGS(...) (const uint32_t[]){__VA_ARGS__, END}
+
+static void test_arm(void)
+{
+    CHECK_EQ(predict(INSN(0x40, 0x00, 0x00, 0xEA), 0, NULL), PC + 8 + 0x100);             // b
+    CHECK_EQ(predict(INSN(0x40, 0x00, 0x00, 0xFA), 0, NULL), PC + 8 + 0x100);             // blx #imm
+    CHECK_EQ(predict(INSN(0x1E, 0xFF, 0x2F, 0xE1), 0, REGS(14, 0x81000005)), 0x81000004); // bx lr to Thumb
+    CHECK_EQ(predict(INSN(0x1E, 0xFF, 0x2F, 0xE1), 0, REGS(14, 0x81000008)), 0x81000008); // bx lr to ARM
+    CHECK_EQ(predict(INSN(0x32, 0xFF, 0x2F, 0xE1), 0, REGS(2, 0x81000011)), 0x81000010);  // blx r2
+
+    put32(SP, 0x81234567);
+    put32(SP + 4, 0x81000010);
+    put32(SP + 8, 0x81000020);
+    put32(SP + 12, 0x81000031);
+    CHECK_EQ(predict(INSN(0x04, 0xF0, 0x9D, 0xE4), 0, NULL), 0x81234566);                 // ldr pc, [sp], #4
+    CHECK_EQ(predict(INSN(0x10, 0x80, 0xBD, 0xE8), 0, NULL), 0x81000010);                 // pop {r4, pc}
+    CHECK_EQ(predict(INSN(0x02, 0x80, 0x90, 0xE9), 0, REGS(0, SP)), 0x81000020);          // ldmib r0, {r1, pc}
+    CHECK_EQ(predict(INSN(0x02, 0xF1, 0x91, 0xE7), 0, REGS(1, SP, 2, 3)), 0x81000030);    // ldr pc, [r1, r2, lsl #2]
+    CHECK_EQ(predict(INSN(0x00, 0xF1, 0x8F, 0xE0), 0, REGS(0, 3)), PC + 8 + 12);          // add pc, pc, r0, lsl #2
+    CHECK_EQ(predict(INSN(0x0E, 0xF0, 0xA0, 0xE1), 0, REGS(14, 0x81000100)), 0x81000100); // mov pc, lr
+    CHECK_EQ(predict(INSN(0x04, 0xF0, 0x5E, 0xE2), 0, REGS(14, 0x81000104)), 0x81000100); // subs pc, lr, #4
+    CHECK_EQ(predict(INSN(0x00, 0xF0, 0x90, 0x15), 0, REGS(0, SP)), 0x81234566);          // ldrne pc, [r0]
+    CHECK_EQ(predict(INSN(0x00, 0xF0, 0x90, 0x15), Z, REGS(0, SP)), PC + 4);
+    CHECK_EQ(predict(INSN(0x00, 0xF0, 0x90, 0xE5), 0, REGS(0, 0x10)), 0);                 // Unmapped load
+    CHECK_EQ(predict(INSN(0x01, 0x00, 0x80, 0xE0), 0, NULL), PC + 4);                     // add r0, r0, r1
+}
+
+static void test_thumb16(void)
+{
+    CHECK_EQ(predict(INSN(0xFE, 0xE7), T, NULL), PC);                        // b #-4
+    CHECK_EQ(predict(INSN(0x10, 0xD0), T | Z, NULL), PC + 4 + 0x20);         // beq
+    CHECK_EQ(predict(INSN(0x10, 0xD0), T, NULL), PC + 2);
+    CHECK_EQ(predict(INSN(0x03, 0xB3), T, REGS(3, 0)), PC + 4 + 0x40);       // cbz r3
+    CHECK_EQ(predict(INSN(0x03, 0xB3), T, REGS(3, 1)), PC + 2);
+    CHECK_EQ(predict(INSN(0x03, 0xBB), T, REGS(3, 1)), PC + 4 + 0x40);       // cbnz r3
+    CHECK_EQ(predict(INSN(0x03, 0xBB), T, REGS(3, 0)), PC + 2);
+    CHECK_EQ(predict(INSN(0x10, 0x47), T, REGS(2, 0x81000201)), 0x81000200); // bx r2
+    CHECK_EQ(predict(INSN(0x90, 0x47), T, REGS(2, 0x81000200)), 0x81000200); // blx r2 to ARM
+    CHECK_EQ(predict(INSN(0x8F, 0x46), T, REGS(1, 0x81000301)), 0x81000300); // mov pc, r1
+    CHECK_EQ(predict(INSN(0x8F, 0x44), T, REGS(1, 0x10)), PC + 4 + 0x10);    // add pc, r1
+    put32(SP + 4, 0x81000010);
+    CHECK_EQ(predict(INSN(0x10, 0xBD), T, NULL), 0x81000010); // pop {r4, pc}
+    CHECK_EQ(predict(INSN(0x08, 0xBF), T, NULL), PC + 2);     // it eq
+    CHECK_EQ(predict(INSN(0x08, 0x44), T, NULL), PC + 2);     // add r0, r1
+}
+
+static void test_it_blocks(void)
+{
+    // it eq: ITSTATE 0x08 for the one instruction in the block.
+    CHECK_EQ(predict(INSN(0x70, 0x47), T | IT(0x08), REGS(14, 0x81000401)), PC + 2);         // bx lr, eq fails
+    CHECK_EQ(predict(INSN(0x70, 0x47), T | Z | IT(0x08), REGS(14, 0x81000401)), 0x81000400); // bx lr, eq holds
+    CHECK_EQ(predict(INSN(0xFE, 0xE7), T | IT(0x08), NULL), PC + 2);                         // b in the block
+
+    // ite eq: ITSTATE 0x0C, advanced to 0x18 (ne) for the else slot.
+    CHECK_EQ(predict(INSN(0x70, 0x47), T | IT(0x18), REGS(14, 0x81000401)), 0x81000400);
+    CHECK_EQ(predict(INSN(0x70, 0x47), T | Z | IT(0x18), REGS(14, 0x81000401)), PC + 2);
+
+    // it ne before pop.w {..., pc}, then a load into pc in the block.
+    put32(SP + 0x20, 0x81000701);
+    CHECK_EQ(predict(INSN(0xBD, 0xE8, 0xF0, 0x8F), T | IT(0x18), REGS(13, SP)), 0x81000700);
+    CHECK_EQ(predict(INSN(0xBD, 0xE8, 0xF0, 0x8F), T | Z | IT(0x18), REGS(13, SP)), PC + 4);
+}
+
+static void test_thumb32(void)
+{
+    CHECK_EQ(predict(INSN(0x00, 0xF1, 0x00, 0xB8), T, NULL), PC + 4 + 0x100000);         // b.w
+    CHECK_EQ(predict(INSN(0xFF, 0xF7, 0x00, 0xF8), T, NULL), PC + 4 - 0x1000);           // bl
+    CHECK_EQ(predict(INSN(0x01, 0xF0, 0x00, 0xE8), T, NULL), ((PC + 4) & ~3u) + 0x1000); // blx #imm
+    CHECK_EQ(predict(INSN(0x7F, 0xF4, 0x00, 0xAC), T, NULL), PC + 4 - 0x800);            // bne.w
+    CHECK_EQ(predict(INSN(0x7F, 0xF4, 0x00, 0xAC), T | Z, NULL), PC + 4);
+
+    memory[PC - BASE + 4 + 6] = 0x09;
+    CHECK_EQ(predict(INSN(0xDF, 0xE8, 0x00, 0xF0), T, REGS(0, 6)), PC + 4 + 18); // tbb [pc, r0]
+    const uint16_t half = 0x30;
+    memcpy(memory + 0x904, &half, sizeof(half));
+    CHECK_EQ(predict(INSN(0xD1, 0xE8, 0x10, 0xF0), T, REGS(1, BASE + 0x900, 0, 2)), PC + 4 + 0x60); // tbh
+
+    put32(SP, 0x81234567);
+    put32(PC + 4 + 8, 0x81000501);
+    put32(SP + 0x10, 0x81000601);
+    put32(SP + 0x20, 0x81000701);
+    CHECK_EQ(predict(INSN(0x5D, 0xF8, 0x04, 0xFB), T, NULL), 0x81234566);                 // ldr pc, [sp], #4
+    CHECK_EQ(predict(INSN(0xDF, 0xF8, 0x08, 0xF0), T, NULL), 0x81000500);                 // ldr.w pc, [pc, #8]
+    CHECK_EQ(predict(INSN(0xD1, 0xF8, 0x10, 0xF0), T, REGS(1, SP)), 0x81000600);          // ldr.w pc, [r1, #16]
+    CHECK_EQ(predict(INSN(0x51, 0xF8, 0x22, 0xF0), T, REGS(1, SP, 2, 4)), 0x81000600);    // ldr.w pc, [r1, r2, lsl #2]
+    CHECK_EQ(predict(INSN(0xBD, 0xE8, 0xF0, 0x8F), T, NULL), 0x81000700);                 // pop.w {r4-r11, pc}
+    CHECK_EQ(predict(INSN(0x11, 0xE9, 0x04, 0x80), T, REGS(1, SP + 0x24)), 0x81000700);   // ldmdb r1, {r2, pc}
+    CHECK_EQ(predict(INSN(0xDE, 0xF3, 0x04, 0x8F), T, REGS(14, 0x81000105)), 0x81000100); // subs pc, lr, #4
+    CHECK_EQ(predict(INSN(0x01, 0xEB, 0x02, 0x00), T, NULL), PC + 4);                     // add.w r0, r1, r2
+}
+
+static uint32_t call_return(const uint8_t *insn, uint32_t size, uint32_t cpsr)
+{
+    uint32_t regs[NEXTPC_REG_COUNT] = {0};
+    regs[15] = PC;
+    regs[16] = cpsr;
+    memcpy(memory + PC - BASE, insn, size);
+    return nextpc_call_return(regs, mem_read);
+}
+
+static void test_call_return(void)
+{
+    CHECK_EQ(call_return(INSN(0x40, 0x00, 0x00, 0xEB), 0), PC + 4); // bl
+    CHECK_EQ(call_return(INSN(0x32, 0xFF, 0x2F, 0xE1), 0), PC + 4); // blx r2
+    CHECK_EQ(call_return(INSN(0x40, 0x00, 0x00, 0xEA), 0), 0);      // b
+    CHECK_EQ(call_return(INSN(0xFF, 0xF7, 0x00, 0xF8), T), PC + 4); // bl
+    CHECK_EQ(call_return(INSN(0x90, 0x47), T), PC + 2);             // blx r2
+    CHECK_EQ(call_return(INSN(0x10, 0x47), T), 0);                  // bx r2
+}
+
+int main(void)
+{
+    test_arm();
+    test_thumb16();
+    test_it_blocks();
+    test_thumb32();
+    test_call_return();
+    return test_result();
+}
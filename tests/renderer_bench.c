@@ -0,0 +1,115 @@
+#include "renderer.h"
+#include "test.h"
+
+#include <stdlib.h>
+
+// Renders full 960x544 screens of hex view text into a RAM framebuffer and reports characters per millisecond, for
+// the per-pixel image path glyphs used to take and for the pre-expanded glyph masks. Then reports fill and blend
+// bandwidth in MB/s for full-screen and small rectangles, against the nested per-pixel loop fills used to be.
+
+#define FRAMES 200
+#define COLUMNS (UI_WIDTH / FONT_WIDTH)
+#define ROWS (UI_HEIGHT / FONT_HEIGHT)
+
+static char lines[ROWS][COLUMNS + 1];
+
+static void build_hex_view(void)
+{
+    for (int row = 0; row < ROWS; ++row)
+    {
+        int n = snprintf(lines[row], sizeof(lines[row]), "%08X:", 0x81000000 + row * 16);
+        for (int i = 0; i < 16; ++i)
+            n += snprintf(lines[row] + n, sizeof(lines[row]) - n, " %02X", (row * 16 + i) * 37 & 0xFF);
+        n += snprintf(lines[row] + n, sizeof(lines[row]) - n, "  ");
+        for (int i = 0; i < 16 && n < COLUMNS; ++i)
+            lines[row][n++] = 33 + (row * 16 + i) % 94;
+        lines[row][n] = '\0';
+    }
+}
+
+static uint32_t count_chars(void)
+{
+    uint32_t count = 0;
+    for (int row = 0; row < ROWS; ++row)
+        for (const char *c = lines[row]; *c; ++c)
+            count += *c != ' ';
+    return count;
+}
+
+static void draw_per_pixel(void)
+{
+    for (int row = 0; row < ROWS; ++row)
+        for (int i = 0; lines[row][i]; ++i)
+            if (lines[row][i] != ' ')
+                renderer_drawImage(i * FONT_WIDTH, row * FONT_HEIGHT, FONT_WIDTH, FONT_HEIGHT,
+                                   &font[(lines[row][i] - GLYPH_FIRST) * GLYPH_BYTES]);
+}
+
+static void draw_glyphs(void)
+{
+    for (int row = 0; row < ROWS; ++row)
+        renderer_drawString(0, row * FONT_HEIGHT, lines[row]);
+}
+
+static void run(const char *name, void (*draw)(void), uint32_t chars)
+{
+    draw(); // Warm up, and builds the glyph masks on first use
+    const double start = bench_now_ms();
+    for (int f = 0; f < FRAMES; ++f)
+        draw();
+    const double ms = bench_now_ms() - start;
+    printf("%-12s %8.0f chars/ms  %6.3f ms/frame\n", name, chars * (double)FRAMES / ms, ms / FRAMES);
+}
+
+typedef struct
+{
+    const char *name;
+    uint32_t x, y, w, h, repeat;
+} FillCase;
+
+static void fill_per_pixel(uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint32_t clr)
+{
+    for (uint32_t j = y; j < y + h; ++j)
+        for (uint32_t i = x; i < x + w; ++i)
+            fb_bases[buf_index][j * UI_WIDTH + i] = clr;
+}
+
+static void run_fill(const FillCase *c)
+{
+    void (*const fills[])(uint32_t, uint32_t, uint32_t, uint32_t, uint32_t) = {fill_per_pixel, renderer_drawRectangle,
+                                                                               renderer_blendRectangle};
+    const char *names[] = {"per-pixel", "row fill", "blend"};
+    for (int f = 0; f < 3; ++f)
+    {
+        const double start = bench_now_ms();
+        for (uint32_t i = 0; i < c->repeat; ++i)
+        {
+            renderer_beginFrame(); // Keeps the blend under its per-frame budget
+            fills[f](c->x, c->y, c->w, c->h, 0x80000000 | (0x00FFFFFF & (i * 0x10101)));
+        }
+        const double ms = bench_now_ms() - start;
+        const double bytes = (double)c->w * c->h * sizeof(uint32_t) * c->repeat;
+        printf("%-12s %-10s %8.0f MB/s\n", c->name, names[f], bytes / (ms * 1e3));
+    }
+}
+
+int main(void)
+{
+    fb_bases[0] = fb_bases[1] = calloc(UI_WIDTH * UI_HEIGHT, sizeof(uint32_t));
+    renderer_setColor(0xFFFFFFFF);
+    build_hex_view();
+    const uint32_t chars = count_chars();
+    printf("%u characters per %dx%d frame\n", chars, UI_WIDTH, UI_HEIGHT);
+    run("per-pixel", draw_per_pixel, chars);
+    run("glyph masks", draw_glyphs, chars);
+
+    const FillCase cases[] = {
+        {"full screen", 0, 0, UI_WIDTH, UI_HEIGHT, 500},
+        {"panel", 549, 9, 401, 300, 4000},
+        {"highlight", 123, 41, 25, 20, 200000},
+        {"8x8", 3, 3, 8, 8, 500000},
+    };
+    for (uint32_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i)
+        run_fill(&cases[i]);
+    return 0;
+}
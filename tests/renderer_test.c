@@ -0,0 +1,210 @@
+#include "renderer.h"
+#include "test.h"
+
+#include <stdlib.h>
+
+// Glyph blits against a per-pixel reference of the 1bpp font, including clipping at every screen edge, and rectangle
+// fills and blends against plain per-pixel loops. On an ARM host with NEON the vector row kernels are also checked
+// against the scalar ones directly.
+
+static uint32_t *screen, *expected;
+
+static void clear(uint32_t *fb)
+{
+    memset(fb, 0, UI_WIDTH * UI_HEIGHT * sizeof(uint32_t));
+}
+
+static void reference_char(char c, int x, int y, uint32_t clr)
+{
+    const unsigned char *src = &font[(c - GLYPH_FIRST) * GLYPH_BYTES];
+    for (int row = 0; row < FONT_HEIGHT; ++row)
+        for (int col = 0; col < FONT_WIDTH; ++col)
+        {
+            const int px = x + col, py = y + row;
+            if (px >= 0 && px < UI_WIDTH && py >= 0 && py < UI_HEIGHT &&
+                ((src[row * 2 + col / 8] >> (7 - col % 8)) & 1))
+                expected[py * UI_WIDTH + px] = clr;
+        }
+}
+
+static void test_before_init(void)
+{
+    // Panels may draw before the first frame buffer is known; nothing must be written or counted.
+    renderer_beginFrame();
+    renderer_drawChar('A', 10, 10);
+    renderer_drawString(0, 0, "Hi");
+    renderer_drawStringBlend(0, 0, "Hi");
+    renderer_drawRectangle(0, 0, 10, 10, 0xFF00FF00);
+    renderer_endFrame();
+    CHECK_EQ(renderer_getFrameStats()->draw_calls, 0);
+}
+
+static void test_glyphs(void)
+{
+    const int xs[] = {0, 5, -1, -11, UI_WIDTH - FONT_WIDTH, UI_WIDTH - 3, UI_WIDTH - 1};
+    const int ys[] = {0, 7, -1, -19, UI_HEIGHT - FONT_HEIGHT, UI_HEIGHT - 4, UI_HEIGHT - 1};
+    renderer_setColor(0xFFC0FFEE);
+    for (char c = 33; c < 127; ++c)
+        for (uint32_t i = 0; i < sizeof(xs) / sizeof(xs[0]); ++i)
+            for (uint32_t j = 0; j < sizeof(ys) / sizeof(ys[0]); ++j)
+            {
+                clear(screen);
+                clear(expected);
+                renderer_drawChar(c, xs[i], ys[j]);
+                reference_char(c, xs[i], ys[j], 0xFFC0FFEE);
+                if (memcmp(screen, expected, UI_WIDTH * UI_HEIGHT * sizeof(uint32_t)))
+                {
+                    fprintf(stderr, "glyph '%c' at %d,%d differs\n", c, xs[i], ys[j]);
+                    test_failures++;
+                }
+            }
+}
+
+static void test_draw_image_matches(void)
+{
+    // The old per-pixel path is still there for images; glyphs must come out the same through either.
+    renderer_setColor(0xFF00FF00);
+    for (char c = 33; c < 127; ++c)
+    {
+        clear(screen);
+        renderer_drawImage(100, 50, FONT_WIDTH, FONT_HEIGHT, &font[(c - GLYPH_FIRST) * GLYPH_BYTES]);
+        memcpy(expected, screen, UI_WIDTH * UI_HEIGHT * sizeof(uint32_t));
+        clear(screen);
+        renderer_drawChar(c, 100, 50);
+        CHECK(memcmp(screen, expected, UI_WIDTH * UI_HEIGHT * sizeof(uint32_t)) == 0);
+    }
+}
+
+static void test_strings(void)
+{
+    renderer_setColor(0xFFFFFFFF);
+    clear(screen);
+    clear(expected);
+    renderer_drawString(-6, 3, "Hi 0x1F");
+    const char *s = "Hi 0x1F";
+    for (int i = 0; s[i]; ++i)
+        if (s[i] != ' ')
+            reference_char(s[i], -6 + i * FONT_WIDTH, 3, 0xFFFFFFFF);
+    CHECK(memcmp(screen, expected, UI_WIDTH * UI_HEIGHT * sizeof(uint32_t)) == 0);
+}
+
+static uint32_t reference_blend(uint32_t dst, uint32_t clr)
+{
+    uint32_t a = clr >> 24;
+    a += a >> 7;
+    const uint32_t rb = (((clr & 0xFF00FF) * a + (dst & 0xFF00FF) * (256 - a)) >> 8) & 0xFF00FF;
+    const uint32_t g = (((clr & 0x00FF00) * a + (dst & 0x00FF00) * (256 - a)) >> 8) & 0x00FF00;
+    return 0xFF000000 | rb | g;
+}
+
+static void fill_pattern(uint32_t *fb)
+{
+    for (uint32_t i = 0; i < UI_WIDTH * UI_HEIGHT; ++i)
+        fb[i] = 0xFF000000 | (i * 2654435761u >> 8);
+}
+
+static void test_fills(void)
+{
+    // Every head and tail alignment, small widths through to the full row.
+    const uint32_t widths[] = {1, 2, 3, 4, 5, 7, 8, 15, 16, 17, 31, 33, 63, 64, 65, 200, UI_WIDTH};
+    for (uint32_t x = 0; x < 8; ++x)
+        for (uint32_t i = 0; i < sizeof(widths) / sizeof(widths[0]); ++i)
+        {
+            const uint32_t w = widths[i], y = 3 + x, h = 5;
+            fill_pattern(screen);
+            memcpy(expected, screen, UI_WIDTH * UI_HEIGHT * sizeof(uint32_t));
+            renderer_drawRectangle(x, y, w, h, 0xFF123456);
+            for (uint32_t j = y; j < y + h; ++j)
+                for (uint32_t k = x; k < x + w && k < UI_WIDTH; ++k)
+                    expected[j * UI_WIDTH + k] = 0xFF123456;
+            if (memcmp(screen, expected, UI_WIDTH * UI_HEIGHT * sizeof(uint32_t)))
+            {
+                fprintf(stderr, "fill at x=%u w=%u differs\n", x, w);
+                test_failures++;
+            }
+
+            fill_pattern(screen);
+            memcpy(expected, screen, UI_WIDTH * UI_HEIGHT * sizeof(uint32_t));
+            renderer_beginFrame(); // Resets the blend budget
+            renderer_blendRectangle(x, y, w, h, 0x80E0A010);
+            bool same = true;
+            for (uint32_t j = 0; j < UI_HEIGHT && same; ++j)
+                for (uint32_t k = 0; k < UI_WIDTH && same; ++k)
+                {
+                    const uint32_t want = (j >= y && j < y + h && k >= x && k < x + w)
+                                              ? reference_blend(expected[j * UI_WIDTH + k], 0x80E0A010)
+                                              : expected[j * UI_WIDTH + k];
+                    same = screen[j * UI_WIDTH + k] == want;
+                }
+            if (!same)
+            {
+                fprintf(stderr, "blend at x=%u w=%u differs\n", x, w);
+                test_failures++;
+            }
+        }
+
+    // Clipped at the right and bottom edges, and nothing at all past them.
+    fill_pattern(screen);
+    memcpy(expected, screen, UI_WIDTH * UI_HEIGHT * sizeof(uint32_t));
+    renderer_drawRectangle(UI_WIDTH - 5, UI_HEIGHT - 2, 100, 100, 0xFF00FF00);
+    renderer_drawRectangle(UI_WIDTH, 0, 10, 10, 0xFF00FF00);
+    for (uint32_t j = UI_HEIGHT - 2; j < UI_HEIGHT; ++j)
+        for (uint32_t k = UI_WIDTH - 5; k < UI_WIDTH; ++k)
+            expected[j * UI_WIDTH + k] = 0xFF00FF00;
+    CHECK(memcmp(screen, expected, UI_WIDTH * UI_HEIGHT * sizeof(uint32_t)) == 0);
+}
+
+#if defined(__arm__) && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+void renderer_fillRowNeon(uint32_t *dst, uint32_t clr, uint32_t count);
+void renderer_blendRowNeon(uint32_t *dst, uint32_t clr, uint32_t count);
+
+static void test_neon_rows(void)
+{
+    // Guard words on both sides catch stores past either end of the row.
+    static uint32_t row[16 + 256 + 16] __attribute__((aligned(16)));
+    for (uint32_t offset = 0; offset < 8; ++offset)
+        for (uint32_t count = 0; count <= 200; ++count)
+        {
+            for (uint32_t i = 0; i < sizeof(row) / sizeof(row[0]); ++i)
+                row[i] = 0xFF000000 | i * 0x10101;
+            uint32_t want[sizeof(row) / sizeof(row[0])];
+            memcpy(want, row, sizeof(row));
+            for (uint32_t i = 0; i < count; ++i)
+                want[16 + offset + i] = 0xFFABCDEF;
+            renderer_fillRowNeon(&row[16 + offset], 0xFFABCDEF, count);
+            CHECK(memcmp(row, want, sizeof(row)) == 0);
+
+            if (count % 8)
+                continue;
+            // Both ends of the alpha range, and either side of where the scalar blend rounds alpha up.
+            const uint32_t colors[] = {0x00204080, 0x01204080, 0x60204080, 0x7F204080, 0x80204080, 0xFE204080,
+                                       0xFF204080};
+            for (uint32_t c = 0; c < sizeof(colors) / sizeof(colors[0]); ++c)
+            {
+                for (uint32_t i = 0; i < sizeof(row) / sizeof(row[0]); ++i)
+                    want[i] = row[i] = 0xFF000000 | i * 0x10101;
+                for (uint32_t i = 0; i < count; ++i)
+                    want[16 + offset + i] = reference_blend(want[16 + offset + i], colors[c]);
+                renderer_blendRowNeon(&row[16 + offset], colors[c], count);
+                CHECK(memcmp(row, want, sizeof(row)) == 0);
+            }
+        }
+}
+#endif
+
+int main(void)
+{
+    screen = calloc(UI_WIDTH * UI_HEIGHT, sizeof(uint32_t));
+    expected = calloc(UI_WIDTH * UI_HEIGHT, sizeof(uint32_t));
+    test_before_init();
+    fb_bases[0] = fb_bases[1] = screen;
+
+    test_glyphs();
+    test_draw_image_matches();
+    test_strings();
+    test_fills();
+#if defined(__arm__) && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+    test_neon_rows();
+#endif
+    return test_result();
+}
@@ -0,0 +1,91 @@
+#include "scanstore.h"
+#include "search.h"
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Footprint of one million candidates laid out densely, in clusters and spread thin, for each value width, and the
+// time a rescan takes to narrow them. The store runs in a block the size of the "pebble_scan" memblock and, to show
+// what would not fit there, in a larger one.
+
+#define SIM_BASE 0x81000000u
+#define SIM_SIZE 0x4000000u
+#define CANDIDATES 1000000u
+
+static uint8_t *memory;
+
+static int sim_read(uint32_t addr, void *dst, uint32_t size)
+{
+    memcpy(dst, memory + (addr - SIM_BASE), size);
+    return 0;
+}
+
+// Spacing in value slots between candidates; dense packs them, sparse spreads them over the whole 64 MB.
+static void layout(uint32_t width, uint32_t spacing)
+{
+    memset(memory, 0, SIM_SIZE);
+    const uint32_t value = 7;
+    for (uint32_t i = 0; i < CANDIDATES && (uint64_t)i * spacing * width < SIM_SIZE; ++i)
+        memcpy(memory + i * spacing * width, &value, width);
+}
+
+static void run(const char *name, uint32_t width, uint32_t spacing, uint8_t *block, uint32_t block_size)
+{
+    layout(width, spacing);
+    ScanStore *st = scanstore_create(block, block_size);
+    scanstore_reset(st, width, false);
+    SearchQuery q;
+    search_query_value(&q, (width == 1) ? SEARCH_U8 : (width == 2) ? SEARCH_U16 : SEARCH_U32, 7);
+    static SearchState s;
+    double start = bench_now_ms();
+    search_begin(&s, &q, sim_read, NULL, st, SIM_BASE, SIM_BASE + SIM_SIZE);
+    while (search_step(&s, SEARCH_STEP_BYTES))
+        ;
+    const double first_ms = bench_now_ms() - start;
+    const uint32_t stored = st->total, pages = st->page_count, footprint = scanstore_footprint(st);
+    const bool overflow = st->overflow;
+
+    // Every tenth candidate changes; the rescan keeps the other nine.
+    for (uint32_t i = 0; i < CANDIDATES && (uint64_t)i * spacing * width < SIM_SIZE; i += 10)
+        memory[i * spacing * width] = 8;
+    start = bench_now_ms();
+    scanstore_narrow_begin(st, SCAN_UNCHANGED, 0);
+    while (scanstore_narrow_step(st, sim_read, 64))
+        ;
+    const double rescan_ms = bench_now_ms() - start;
+
+    printf("%-12s u%-2u %4u KB block  %7u stored  %5u pages  %7u KB  %5.2f B/cand  first %6.1f ms  rescan %6.1f ms "
+           "(%u kept)%s\n",
+           name, width * 8, block_size >> 10, stored, pages, footprint >> 10, stored ? (double)footprint / stored : 0,
+           first_ms, rescan_ms, st->total, overflow ? "  OVERFLOW" : "");
+}
+
+int main(void)
+{
+    memory = malloc(SIM_SIZE);
+    const uint32_t big = 0x1000000;
+    uint8_t *block = malloc(big);
+    printf("ScanStore header %zu bytes, arena %u KB of the %u KB memblock\n", sizeof(ScanStore),
+           scanstore_create(block, SCANSTORE_ARENA_SIZE)->arena_size >> 10, SCANSTORE_ARENA_SIZE >> 10);
+
+    const uint32_t widths[] = {1, 2, 4};
+    for (uint32_t w = 0; w < 3; ++w)
+    {
+        const uint32_t width = widths[w];
+        // Sparse spaces them as far apart as 64 MB allows.
+        const struct
+        {
+            const char *name;
+            uint32_t spacing;
+        } layouts[] = {{"dense", 1}, {"every 16th", 16}, {"sparse", SIM_SIZE / width / CANDIDATES}};
+        for (uint32_t l = 0; l < 3; ++l)
+        {
+            if (!layouts[l].spacing)
+                continue;
+            run(layouts[l].name, width, layouts[l].spacing, block, SCANSTORE_ARENA_SIZE);
+            run(layouts[l].name, width, layouts[l].spacing, block, big);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,202 @@
+#include "scanstore.h"
+#include "search.h"
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// First scans through search_step into the store, then rounds of narrowing after the simulated memory changes,
+// checked candidate by candidate against a plain array of previous values, for every value width and filter.
+
+#define SIM_BASE 0x81000000u
+#define SIM_SIZE 0x200000u
+#define BLOCK_SIZE 0x400000u
+
+static uint8_t *memory;
+static bool unmapped_page;
+static uint8_t *block;
+
+// Reference: whether each position is a candidate, and its value at the last scan.
+static bool *candidate;
+static uint32_t *previous;
+
+static int sim_read(uint32_t addr, void *dst, uint32_t size)
+{
+    if (unmapped_page && addr <= SIM_BASE + 0x3000 && addr + size > SIM_BASE + 0x3000)
+        return -1;
+    memcpy(dst, memory + (addr - SIM_BASE), size);
+    return 0;
+}
+
+static uint32_t load(uint32_t offset, uint32_t width)
+{
+    uint32_t v = 0;
+    memcpy(&v, memory + offset, width);
+    return v;
+}
+
+static bool reference_keep(ScanFilter filter, uint32_t value, bool is_float, uint32_t prev, uint32_t cur)
+{
+    switch (filter)
+    {
+    case SCAN_EQUAL:
+        return cur == value;
+    case SCAN_CHANGED:
+        return cur != prev;
+    case SCAN_UNCHANGED:
+        return cur == prev;
+    default:
+        break;
+    }
+    if (is_float)
+    {
+        float p, c;
+        memcpy(&p, &prev, sizeof(p));
+        memcpy(&c, &cur, sizeof(c));
+        return (filter == SCAN_INCREASED) ? c > p : c < p;
+    }
+    return (filter == SCAN_INCREASED) ? cur > prev : cur < prev;
+}
+
+static void check_store(ScanStore *st, uint32_t width)
+{
+    uint32_t index = 0;
+    for (uint32_t off = 0; off < SIM_SIZE; off += width)
+    {
+        if (!candidate[off / width])
+            continue;
+        uint32_t addr, value;
+        if (scanstore_get(st, index, &addr, &value) < 0 || addr != SIM_BASE + off ||
+            value != previous[off / width])
+        {
+            fprintf(stderr, "candidate %u: %08X = %X, expected %08X = %X\n", index, addr, value, SIM_BASE + off,
+                    previous[off / width]);
+            test_failures++;
+            return;
+        }
+        index++;
+    }
+    CHECK_EQ(st->total, index);
+    CHECK(scanstore_get(st, index, NULL, NULL) < 0);
+}
+
+static void mutate(uint32_t *seed, uint32_t count, uint32_t width)
+{
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const uint32_t off = (test_random(seed) % (SIM_SIZE / width)) * width;
+        const uint32_t r = test_random(seed);
+        uint32_t v = load(off, width) + ((r & 1) ? 1 : -1);
+        if (r & 0x10)
+            v = r >> 8;
+        memcpy(memory + off, &v, width);
+    }
+}
+
+static void run_width(uint32_t width, bool is_float)
+{
+    uint32_t seed = 0xABC0 + width + is_float;
+    // Dense runs of the value, sparse copies elsewhere, and noise around them.
+    memset(memory, 0, SIM_SIZE);
+    const uint32_t value = is_float ? 0x41200000 : 10; // 10.0f or 10
+    for (uint32_t off = 0; off < SIM_SIZE; off += width)
+        if (off < 0x8000 || test_random(&seed) % 61 == 0)
+            memcpy(memory + off, &value, width);
+        else if (test_random(&seed) % 3 == 0)
+        {
+            const uint32_t noise = test_random(&seed) & 0x3F;
+            memcpy(memory + off, &noise, width);
+        }
+
+    ScanStore *st = scanstore_create(block, BLOCK_SIZE);
+    scanstore_reset(st, width, is_float);
+    SearchQuery q;
+    search_query_value(&q, (width == 1) ? SEARCH_U8 : (width == 2) ? SEARCH_U16 : is_float ? SEARCH_FLOAT : SEARCH_U32,
+                       10);
+    static SearchState s;
+    search_begin(&s, &q, sim_read, NULL, st, SIM_BASE, SIM_BASE + SIM_SIZE);
+    while (search_step(&s, SEARCH_STEP_BYTES))
+        ;
+    CHECK(!st->overflow);
+    CHECK_EQ(st->total, s.matches);
+    for (uint32_t off = 0; off < SIM_SIZE; off += width)
+    {
+        candidate[off / width] = load(off, width) == value;
+        previous[off / width] = load(off, width);
+    }
+    check_store(st, width);
+
+    const ScanFilter filters[] = {SCAN_UNCHANGED, SCAN_CHANGED, SCAN_INCREASED, SCAN_EQUAL, SCAN_DECREASED,
+                                  SCAN_CHANGED};
+    for (uint32_t round = 0; round < sizeof(filters) / sizeof(filters[0]); ++round)
+    {
+        mutate(&seed, 40000, width);
+        // One round where a page holding candidates has gone away; its candidates are dropped.
+        unmapped_page = round == 2;
+        const uint32_t target = 11;
+        scanstore_narrow_begin(st, filters[round], target);
+        uint32_t steps = 0;
+        while (scanstore_narrow_step(st, sim_read, 1 + round * 7))
+            steps++;
+        CHECK(!st->narrowing);
+
+        const uint32_t want = is_float ? 0x41300000 : target; // 11.0f
+        for (uint32_t off = 0; off < SIM_SIZE; off += width)
+        {
+            if (!candidate[off / width])
+                continue;
+            const uint32_t cur = load(off, width);
+            const bool gone = unmapped_page && off >= 0x3000 && off < 0x4000;
+            candidate[off / width] = !gone && reference_keep(filters[round], want, is_float, previous[off / width], cur);
+            previous[off / width] = cur;
+        }
+        check_store(st, width);
+    }
+    unmapped_page = false;
+}
+
+static void test_create(void)
+{
+    CHECK(scanstore_create(block, sizeof(ScanStore)) == NULL);
+    ScanStore *st = scanstore_create(block, BLOCK_SIZE);
+    CHECK(st != NULL);
+    CHECK((uint8_t *)st == block);
+    CHECK(st->arena >= block + sizeof(ScanStore));
+    CHECK(st->arena + st->arena_size <= block + BLOCK_SIZE);
+    CHECK_EQ(st->total, 0);
+}
+
+static void test_overflow(void)
+{
+    // A block that holds only part of the candidates: the ones kept are all retrievable, the rest are reported.
+    memset(memory, 0, SIM_SIZE);
+    ScanStore *st = scanstore_create(block, 0x10000);
+    scanstore_reset(st, 4, false);
+    SearchQuery q;
+    search_query_value(&q, SEARCH_U32, 0);
+    static SearchState s;
+    search_begin(&s, &q, sim_read, NULL, st, SIM_BASE, SIM_BASE + SIM_SIZE);
+    while (search_step(&s, SEARCH_STEP_BYTES))
+        ;
+    CHECK(st->overflow);
+    CHECK(st->total > 0 && st->total < s.matches);
+    CHECK(scanstore_footprint(st) <= st->arena_size);
+    uint32_t addr, value;
+    CHECK_EQ(scanstore_get(st, st->total - 1, &addr, &value), 0);
+    CHECK_EQ(addr, SIM_BASE + (st->total - 1) * 4);
+}
+
+int main(void)
+{
+    memory = malloc(SIM_SIZE);
+    block = malloc(BLOCK_SIZE);
+    candidate = malloc(SIM_SIZE * sizeof(bool));
+    previous = malloc(SIM_SIZE * sizeof(uint32_t));
+    test_create();
+    run_width(1, false);
+    run_width(2, false);
+    run_width(4, false);
+    run_width(4, true);
+    test_overflow();
+    return test_result();
+}
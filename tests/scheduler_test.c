@@ -0,0 +1,186 @@
+#include "scheduler.h"
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Drives the GUI scheduler the way pebble_thread does, against a simulated clock and a scripted controller, and
+// reports wakeups per second and input-to-present latency: detached, hidden, idle on a static view, idle on the memory
+// view, and while buttons are being tapped.
+
+#define SECOND 1000000ull
+#define DRAW_US 2000 // Time a frame takes to draw, from the wakeup that decided to draw until it is presented
+#define MAX_TAPS 64
+// The simulated clock starts at zero, inside the fast poll window that follows input, so idle runs allow for it.
+#define STARTUP_WAKEUPS (SCHED_ACTIVE_US / SCHED_FRAME_US + 1)
+
+typedef struct
+{
+    uint64_t press, release;
+} Tap;
+
+typedef struct
+{
+    bool attached, visible;
+    uint32_t refresh_us;
+    const Tap *taps;
+    uint32_t tap_count;
+} Scenario;
+
+typedef struct
+{
+    uint32_t wakeups, frames, presses;
+    uint64_t latency[MAX_TAPS];
+} SimResult;
+
+static bool held(const Scenario *sc, uint64_t t)
+{
+    for (uint32_t i = 0; i < sc->tap_count; ++i)
+        if (t >= sc->taps[i].press && t < sc->taps[i].release)
+            return true;
+    return false;
+}
+
+// Release time of the tap whose release a poll at t just saw.
+static uint64_t last_release(const Scenario *sc, uint64_t t)
+{
+    uint64_t latest = 0;
+    for (uint32_t i = 0; i < sc->tap_count; ++i)
+        if (sc->taps[i].release <= t && sc->taps[i].release > latest)
+            latest = sc->taps[i].release;
+    return latest;
+}
+
+static SimResult simulate(const Scenario *sc, uint64_t duration)
+{
+    SimResult r = {0};
+    GuiScheduler s;
+    sched_init(&s);
+    uint64_t now = 0, edge = 0;
+    bool prev = false, pending = false;
+    while (now < duration)
+    {
+        const uint32_t timeout = sched_timeout(&s, sc->attached, sc->visible, now);
+        if (timeout == SCHED_FOREVER)
+            break;
+        now += timeout;
+        sched_wakeup(&s, now);
+        if (!sc->visible)
+            continue;
+
+        const bool current = held(sc, now);
+        const bool released = prev && !current;
+        if (current || released)
+            sched_input(&s, now);
+        if (released)
+        {
+            sched_mark_dirty(&s);
+            edge = last_release(sc, now);
+            pending = true;
+            r.presses++;
+        }
+        sched_set_refresh(&s, sc->refresh_us);
+        if (sched_should_draw(&s, now))
+        {
+            r.frames++;
+            now += DRAW_US;
+            if (pending && r.presses <= MAX_TAPS)
+                r.latency[r.presses - 1] = now - edge;
+            pending = false;
+        }
+        prev = current;
+    }
+    r.wakeups = s.wakeups;
+    return r;
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+    const uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void report(const char *name, const SimResult *r, uint64_t duration)
+{
+    printf("%-16s %7.1f wakeups/s %6.1f frames/s", name, r->wakeups * (double)SECOND / duration,
+           r->frames * (double)SECOND / duration);
+    if (r->presses)
+    {
+        uint64_t sorted[MAX_TAPS];
+        const uint32_t n = (r->presses < MAX_TAPS) ? r->presses : MAX_TAPS;
+        memcpy(sorted, r->latency, n * sizeof(sorted[0]));
+        qsort(sorted, n, sizeof(sorted[0]), compare_u64);
+        printf("  input-to-present p50 %.1f ms max %.1f ms", sorted[n / 2] / 1000.0, sorted[n - 1] / 1000.0);
+    }
+    printf("\n");
+}
+
+static void test_idle(void)
+{
+    const uint64_t duration = 10 * SECOND;
+
+    const Scenario detached = {false, false, 0, NULL, 0};
+    SimResult r = simulate(&detached, duration);
+    report("detached", &r, duration);
+    CHECK_EQ(r.wakeups, 0);
+
+    const Scenario hidden = {true, false, 0, NULL, 0};
+    r = simulate(&hidden, duration);
+    report("hidden", &r, duration);
+    CHECK(r.wakeups <= duration / SCHED_HIDDEN_POLL_US);
+    CHECK_EQ(r.frames, 0);
+
+    // Nothing on a menu changes by itself: only the first frame is drawn, and input is polled at the idle rate.
+    const Scenario menu = {true, true, 0, NULL, 0};
+    r = simulate(&menu, duration);
+    report("idle menu", &r, duration);
+    CHECK(r.wakeups <= duration / SCHED_IDLE_POLL_US + STARTUP_WAKEUPS);
+    CHECK_EQ(r.frames, 1);
+
+    // The memory view redraws with fresh target memory once per refresh period and no more.
+    const Scenario memview = {true, true, 250000, NULL, 0};
+    r = simulate(&memview, duration);
+    report("idle memview", &r, duration);
+    CHECK(r.wakeups <= duration / SCHED_IDLE_POLL_US + STARTUP_WAKEUPS);
+    CHECK(r.frames <= duration / 250000 + 1);
+    CHECK(r.frames >= duration / (250000 + SCHED_IDLE_POLL_US + DRAW_US));
+}
+
+static void test_input_latency(void)
+{
+    // Taps from an idle GUI at arbitrary phases, each held longer than the idle poll, then a quick burst.
+    Tap taps[MAX_TAPS];
+    uint32_t count = 0, seed = 0x1234567;
+    uint64_t t = 300000;
+    for (; count < 24; ++count)
+    {
+        t += 700000 + test_random(&seed) % 600000;
+        taps[count].press = t;
+        taps[count].release = t + SCHED_IDLE_POLL_US + 10000 + test_random(&seed) % 60000;
+    }
+    for (; count < 48; ++count)
+    {
+        t = taps[count - 1].release + 40000 + test_random(&seed) % 80000;
+        taps[count].press = t;
+        taps[count].release = t + 30000 + test_random(&seed) % 40000;
+    }
+    const uint64_t duration = taps[count - 1].release + 2 * SECOND;
+    const Scenario tapping = {true, true, 0, taps, count};
+    const SimResult r = simulate(&tapping, duration);
+    report("tapping", &r, duration);
+
+    // Every tap is seen, and presented within one poll plus the frame cap.
+    CHECK_EQ(r.presses, count);
+    for (uint32_t i = 0; i < count && i < r.presses; ++i)
+        CHECK(r.latency[i] <= 2 * SCHED_FRAME_US + DRAW_US);
+    // Back to the idle poll once the buttons have been left alone.
+    CHECK(r.wakeups < (taps[count - 1].release + SCHED_ACTIVE_US) / SCHED_FRAME_US +
+                          2 * SECOND / SCHED_IDLE_POLL_US);
+}
+
+int main(void)
+{
+    test_idle();
+    test_input_latency();
+    return test_result();
+}
@@ -0,0 +1,15 @@
+#include <psp2/kernel/clib.h>
+
+#include <string.h>
+
+// Host stand-ins for the user-side libc the batch client calls.
+
+void *sceClibMemcpy(void *dst, const void *src, SceSize len)
+{
+    return memcpy(dst, src, len);
+}
+
+void *sceClibMemset(void *dst, int ch, SceSize len)
+{
+    return memset(dst, ch, len);
+}
@@ -0,0 +1,5 @@
+#pragma once
+#include "../types.h"
+
+void *sceClibMemcpy(void *dst, const void *src, SceSize len);
+void *sceClibMemset(void *dst, int ch, SceSize len);
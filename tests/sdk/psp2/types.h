@@ -0,0 +1,8 @@
+#pragma once
+
+// Just enough of the VitaSDK user headers for the batch client to build on the host; the functions are in sdk/clib.c.
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef unsigned int SceSize;
@@ -0,0 +1,40 @@
+#pragma once
+
+// Just enough of the VitaSDK kernel headers for renderer.c to build on the host; the functions are in sdk/stubs.c.
+
+#include <stdarg.h>
+#include <stdint.h>
+
+typedef int SceUID;
+typedef unsigned int SceSize;
+typedef unsigned int SceUInt32;
+typedef uint64_t SceUInt64;
+
+#define SCE_KERNEL_MEMBLOCK_TYPE_KERNEL_RW 0x1020D006
+#define SCE_DISPLAY_PIXELFORMAT_A8B8G8R8 0
+
+typedef struct
+{
+    SceSize size;
+    void *base;
+    unsigned int pitch;
+    unsigned int pixelformat;
+    unsigned int width;
+    unsigned int height;
+} SceDisplayFrameBuf;
+
+typedef struct
+{
+    SceSize size;
+    SceUID pid;
+    unsigned int vid;
+    SceDisplayFrameBuf framebuf;
+} SceDisplayFrameBufInfo;
+
+int ksceKernelPrintf(const char *format, ...);
+SceUInt64 ksceKernelGetSystemTimeWide(void);
+SceUID ksceKernelAllocMemBlock(const char *name, SceUInt32 type, SceSize size, void *opt);
+int ksceKernelGetMemBlockBase(SceUID uid, void **base);
+int ksceKernelFreeMemBlock(SceUID uid);
+int ksceKernelCopyFromUserProc(SceUID pid, void *dst, const void *src, SceSize size);
+int ksceDisplayGetFrameBufInfoForPid(SceUID pid, int head, int index, SceDisplayFrameBufInfo *info);
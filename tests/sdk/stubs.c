@@ -0,0 +1,58 @@
+#include <psp2kern/types.h>
+
+#include <time.h>
+
+// Host stand-ins: no memblocks, no target process, and the system clock in microseconds.
+
+int ksceKernelPrintf(const char *format, ...)
+{
+    (void)format;
+    return 0;
+}
+
+SceUInt64 ksceKernelGetSystemTimeWide(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (SceUInt64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+SceUID ksceKernelAllocMemBlock(const char *name, SceUInt32 type, SceSize size, void *opt)
+{
+    (void)name;
+    (void)type;
+    (void)size;
+    (void)opt;
+    return -1;
+}
+
+int ksceKernelGetMemBlockBase(SceUID uid, void **base)
+{
+    (void)uid;
+    *base = 0;
+    return -1;
+}
+
+int ksceKernelFreeMemBlock(SceUID uid)
+{
+    (void)uid;
+    return 0;
+}
+
+int ksceKernelCopyFromUserProc(SceUID pid, void *dst, const void *src, SceSize size)
+{
+    (void)pid;
+    (void)dst;
+    (void)src;
+    (void)size;
+    return -1;
+}
+
+int ksceDisplayGetFrameBufInfoForPid(SceUID pid, int head, int index, SceDisplayFrameBufInfo *info)
+{
+    (void)pid;
+    (void)head;
+    (void)index;
+    (void)info;
+    return -1;
+}
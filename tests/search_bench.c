@@ -0,0 +1,85 @@
+#include "search.h"
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Scan throughput in MB/s over a 64 MB simulated address space that looks like a game heap (mostly zeros, a few
+// common values), for each query kind, against a plain byte-by-byte compare at every position.
+
+#define SIM_BASE 0x81000000u
+#define SIM_SIZE 0x4000000u
+#define RUNS 3
+
+static uint8_t *memory;
+
+static int sim_read(uint32_t addr, void *dst, uint32_t size)
+{
+    memcpy(dst, memory + (addr - SIM_BASE), size);
+    return 0;
+}
+
+static uint32_t naive_scan(const SearchQuery *q)
+{
+    uint32_t matches = 0;
+    for (uint32_t i = 0; i + q->length <= SIM_SIZE; i += q->align)
+    {
+        uint32_t j = 0;
+        while (j < q->length && (memory[i + j] & q->mask[j]) == q->bytes[j])
+            ++j;
+        matches += j == q->length;
+    }
+    return matches;
+}
+
+static void run(const char *name, const SearchQuery *q)
+{
+    static SearchState s;
+    double best = 1e30;
+    for (int r = 0; r < RUNS; ++r)
+    {
+        const double start = bench_now_ms();
+        search_begin(&s, q, sim_read, NULL, NULL, SIM_BASE, SIM_BASE + SIM_SIZE);
+        while (search_step(&s, SEARCH_STEP_BYTES))
+            ;
+        const double ms = bench_now_ms() - start;
+        best = (ms < best) ? ms : best;
+    }
+
+    const double start = bench_now_ms();
+    const uint32_t expected = naive_scan(q);
+    const double naive_ms = bench_now_ms() - start;
+    printf("%-10s %8.0f MB/s  naive %6.0f MB/s  matches %u%s\n", name, SIM_SIZE / (best * 1e3),
+           SIM_SIZE / (naive_ms * 1e3), s.matches, (s.matches == expected) ? "" : "  MISMATCH");
+}
+
+int main(void)
+{
+    memory = malloc(SIM_SIZE);
+    static const uint8_t common[] = {0x00, 0xFF, 0x12, 0x34, 0x56, 0x78, 0x3F, 0x80};
+    uint32_t seed = 1;
+    for (uint32_t i = 0; i < SIM_SIZE; ++i)
+    {
+        const uint32_t r = test_random(&seed);
+        memory[i] = (r & 3) ? 0 : (r & 0x100) ? common[(r >> 4) & 7] : (uint8_t)(r >> 12);
+    }
+
+    SearchQuery q;
+    search_query_value(&q, SEARCH_U32, 1234567);
+    run("u32", &q);
+    search_query_value(&q, SEARCH_U16, 0x1234);
+    run("u16", &q);
+    search_query_value(&q, SEARCH_U8, 0x42);
+    run("u8", &q);
+    search_query_value(&q, SEARCH_FLOAT, 100);
+    run("float", &q);
+    search_query_value(&q, SEARCH_U32, 0);
+    run("u32 zero", &q);
+    search_query_pattern(&q, "48 ?? 6C 6?");
+    run("pattern", &q);
+    search_query_string(&q, "Hello", false);
+    run("ascii", &q);
+    search_query_string(&q, "Hello", true);
+    run("utf16", &q);
+    return 0;
+}
@@ -0,0 +1,254 @@
+#include "search.h"
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Query parsing, the prefiltered scan against a byte-by-byte reference, and whole searches over a simulated address
+// space with unmapped pages and gaps, stepped with small and large budgets.
+
+#define SIM_BASE 0x81000000u
+#define SIM_SIZE 0x800000u
+#define SIM_PAGES (SIM_SIZE / SEARCH_PAGE_SIZE)
+
+static uint8_t *memory;
+static bool mapped[SIM_PAGES];
+
+static bool page_mapped(uint32_t addr)
+{
+    return addr >= SIM_BASE && addr - SIM_BASE < SIM_SIZE && mapped[(addr - SIM_BASE) / SEARCH_PAGE_SIZE];
+}
+
+static int sim_read(uint32_t addr, void *dst, uint32_t size)
+{
+    for (uint32_t page = addr & ~(SEARCH_PAGE_SIZE - 1); page < addr + size; page += SEARCH_PAGE_SIZE)
+        if (!page_mapped(page))
+            return -1;
+    memcpy(dst, memory + (addr - SIM_BASE), size);
+    return 0;
+}
+
+static uint32_t sim_skip(uint32_t addr)
+{
+    for (uint32_t page = addr & ~(SEARCH_PAGE_SIZE - 1); page < SIM_BASE + SIM_SIZE; page += SEARCH_PAGE_SIZE)
+        if (page_mapped(page))
+            return (page > addr) ? page : addr;
+    return SIM_BASE + SIM_SIZE;
+}
+
+static void build_memory(uint32_t seed)
+{
+    // Mostly zeros with a few common values, like game heaps; holes of single pages and of whole chunks.
+    static const uint8_t common[] = {0x00, 0xFF, 0x12, 0x34, 0x56, 0x78, 0x3F, 0x80};
+    for (uint32_t i = 0; i < SIM_SIZE; ++i)
+    {
+        const uint32_t r = test_random(&seed);
+        memory[i] = (r & 3) ? 0 : (r & 0x100) ? common[(r >> 4) & 7] : (uint8_t)(r >> 12);
+    }
+    for (uint32_t p = 0; p < SIM_PAGES; ++p)
+        mapped[p] = (p % 13 != 5) && !(p >= 0x200 && p < 0x240);
+}
+
+static bool reference_match(const SearchQuery *q, uint32_t addr)
+{
+    for (uint32_t j = 0; j < q->length; ++j)
+        if (!page_mapped((addr + j) & ~(SEARCH_PAGE_SIZE - 1)) ||
+            (memory[addr + j - SIM_BASE] & q->mask[j]) != q->bytes[j])
+            return false;
+    return true;
+}
+
+static void test_queries(void)
+{
+    SearchQuery q;
+    CHECK_EQ(search_query_value(&q, SEARCH_U32, 0x12345678), 0);
+    CHECK_EQ(q.length, 4);
+    CHECK_EQ(q.align, 4);
+    CHECK_EQ(q.bytes[0], 0x78);
+    CHECK_EQ(q.anchor, 0);
+
+    // Zero bytes are poor anchors; the first byte that is neither 0x00 nor 0xFF is used.
+    CHECK_EQ(search_query_value(&q, SEARCH_U32, 0x00120000), 0);
+    CHECK_EQ(q.anchor, 2);
+    CHECK_EQ(search_query_value(&q, SEARCH_U16, 0), 0);
+    CHECK_EQ(q.length, 2);
+    CHECK_EQ(q.anchor, 0);
+
+    CHECK_EQ(search_query_value(&q, SEARCH_FLOAT, 100), 0);
+    const float hundred = 100.0f;
+    CHECK(memcmp(q.bytes, &hundred, 4) == 0);
+    CHECK_EQ(search_query_value(&q, SEARCH_PATTERN, 1), -1);
+
+    CHECK_EQ(search_query_pattern(&q, "DE AD ?? E?"), 0);
+    CHECK_EQ(q.length, 4);
+    CHECK_EQ(q.align, 1);
+    CHECK_EQ(q.mask[2], 0x00);
+    CHECK_EQ(q.mask[3], 0xF0);
+    CHECK_EQ(q.bytes[3], 0xE0);
+    CHECK_EQ(search_query_pattern(&q, "dead?0"), 0);
+    CHECK_EQ(q.mask[2], 0x0F);
+    CHECK_EQ(search_query_pattern(&q, "?? ??"), -1);
+    CHECK_EQ(search_query_pattern(&q, "ABC"), -1);
+    CHECK_EQ(search_query_pattern(&q, "XY"), -1);
+    CHECK_EQ(search_query_pattern(&q, ""), -1);
+
+    CHECK_EQ(search_query_string(&q, "Hi", true), 0);
+    CHECK_EQ(q.length, 4);
+    CHECK_EQ(q.align, 2);
+    CHECK(memcmp(q.bytes, "H\0i\0", 4) == 0);
+    CHECK_EQ(search_query_string(&q, "0123456789abcdef0123456789abcdef", false), 0);
+    CHECK_EQ(search_query_string(&q, "0123456789abcdef0", true), -1);
+}
+
+static void random_query(SearchQuery *q, uint32_t *seed, const uint8_t *source)
+{
+    // Patterns taken from the buffer itself so they match, with random nibble and byte wildcards.
+    char text[SEARCH_MAX_PATTERN * 3 + 1];
+    const uint32_t length = 1 + test_random(seed) % 6;
+    uint32_t n = 0;
+    for (uint32_t j = 0; j < length; ++j)
+    {
+        const uint32_t r = test_random(seed);
+        n += sprintf(text + n, "%02X ", source[j]);
+        if (r % 5 == 0)
+            text[n - 3] = '?';
+        if (r % 7 == 0)
+            text[n - 2] = '?';
+    }
+    text[n] = '\0';
+    if (search_query_pattern(q, text) < 0)
+        search_query_value(q, SEARCH_U8, source[0]);
+}
+
+static void test_scan(void)
+{
+    // Every buffer length around the 16-byte rounds, every alignment, against a byte-by-byte scan.
+    static uint8_t buf[300];
+    static uint32_t out[300];
+    uint32_t seed = 0xC0FFEE;
+    for (uint32_t round = 0; round < 3000; ++round)
+    {
+        const uint32_t size = test_random(&seed) % sizeof(buf);
+        for (uint32_t i = 0; i < sizeof(buf); ++i)
+            buf[i] = (test_random(&seed) & 1) ? 0 : 0x30 + test_random(&seed) % 4;
+        SearchQuery q;
+        const uint32_t kind = round % 4;
+        if (kind == 0)
+            random_query(&q, &seed, buf + test_random(&seed) % (sizeof(buf) - SEARCH_MAX_PATTERN));
+        else
+            search_query_value(&q, kind == 1 ? SEARCH_U8 : kind == 2 ? SEARCH_U16 : SEARCH_U32,
+                               0x30303030 + test_random(&seed) % 4);
+        const uint32_t addr = 0x81000000 + (test_random(&seed) & 3);
+        const uint32_t limit = (round & 1) ? size : test_random(&seed) % (size + 1);
+
+        uint32_t bits[(sizeof(buf) + 31) / 32] = {0};
+        uint32_t matches = 0;
+        const uint32_t max_out = (round % 10 == 0) ? 3 : sizeof(out) / sizeof(out[0]);
+        const uint32_t stored = search_scan(&q, buf, size, limit, addr, out, max_out, &matches, bits);
+
+        uint32_t expected = 0;
+        for (uint32_t i = 0; i < limit && i + q.length <= size; ++i)
+        {
+            bool hit = !((addr + i) & (q.align - 1));
+            for (uint32_t j = 0; j < q.length && hit; ++j)
+                hit = (buf[i + j] & q.mask[j]) == q.bytes[j];
+            if (!hit)
+                continue;
+            if (expected < stored)
+                CHECK_EQ(out[expected], addr + i);
+            const uint32_t slot = i >> __builtin_ctz(q.align);
+            CHECK(bits[slot >> 5] & (1u << (slot & 31)));
+            expected++;
+        }
+        CHECK_EQ(matches, expected);
+        CHECK_EQ(stored, (expected < max_out) ? expected : max_out);
+    }
+}
+
+static void check_search(const SearchQuery *q, uint32_t start, uint32_t end, uint32_t budget)
+{
+    static SearchState s;
+    search_begin(&s, q, sim_read, sim_skip, NULL, start, end);
+    uint32_t steps = 0;
+    while (search_step(&s, budget))
+        steps++;
+    CHECK(!s.running);
+    CHECK_EQ(search_progress(&s), 100);
+
+    uint32_t expected = 0;
+    for (uint32_t addr = start; addr + q->length <= end; addr += q->align)
+    {
+        if (!reference_match(q, addr))
+            continue;
+        if (expected < s.count && s.results[expected] != addr)
+        {
+            fprintf(stderr, "result %u is %08X, expected %08X\n", expected, s.results[expected], addr);
+            test_failures++;
+            return;
+        }
+        expected++;
+    }
+    CHECK_EQ(s.matches, expected);
+    CHECK_EQ(s.count, (expected < SEARCH_MAX_RESULTS) ? expected : SEARCH_MAX_RESULTS);
+    // Unmapped pages are skipped, not read and not counted.
+    uint64_t mapped_bytes = 0;
+    for (uint32_t addr = start; addr < end;)
+    {
+        const uint32_t next = ((addr & ~(SEARCH_PAGE_SIZE - 1)) + SEARCH_PAGE_SIZE < end)
+                                  ? (addr & ~(SEARCH_PAGE_SIZE - 1)) + SEARCH_PAGE_SIZE
+                                  : end;
+        if (page_mapped(addr & ~(SEARCH_PAGE_SIZE - 1)))
+            mapped_bytes += next - addr;
+        addr = next;
+    }
+    CHECK_EQ(s.bytes_scanned, mapped_bytes);
+}
+
+static void test_address_space(void)
+{
+    build_memory(0x5EED);
+
+    // Planted matches straddling a chunk boundary, a page boundary, and a page that runs into a hole.
+    memcpy(memory + SEARCH_CHUNK_SIZE - 3, "PEBBLE", 6);
+    memcpy(memory + 7 * SEARCH_PAGE_SIZE - 2, "PEBBLE", 6);
+    memcpy(memory + 5 * SEARCH_PAGE_SIZE - 3, "PEBBLE", 6); // Page 5 is unmapped: no match
+    memcpy(memory + 0x10 * SEARCH_PAGE_SIZE + 0x40, "P\0E\0B\0B\0L\0E\0", 12);
+    const uint32_t value = 0x3F800000;
+    memcpy(memory + 0x30000, &value, sizeof(value));
+
+    SearchQuery q;
+    search_query_string(&q, "PEBBLE", false);
+    check_search(&q, SIM_BASE, SIM_BASE + SIM_SIZE, SEARCH_STEP_BYTES);
+    check_search(&q, SIM_BASE, SIM_BASE + SIM_SIZE, 1);
+    search_query_string(&q, "PEBBLE", true);
+    check_search(&q, SIM_BASE, SIM_BASE + SIM_SIZE, SEARCH_STEP_BYTES);
+    search_query_value(&q, SEARCH_FLOAT, 1);
+    check_search(&q, SIM_BASE, SIM_BASE + SIM_SIZE, SEARCH_STEP_BYTES);
+
+    // Common values overflow the stored results; the total still counts them all.
+    search_query_value(&q, SEARCH_U8, 0x34);
+    check_search(&q, SIM_BASE, SIM_BASE + SIM_SIZE, SEARCH_STEP_BYTES);
+    search_query_value(&q, SEARCH_U16, 0x7856);
+    check_search(&q, SIM_BASE, SIM_BASE + SIM_SIZE, SEARCH_STEP_BYTES);
+
+    // Unaligned ranges, ranges starting in a hole, and an empty one.
+    uint32_t seed = 77;
+    for (int i = 0; i < 40; ++i)
+    {
+        const uint32_t start = SIM_BASE + test_random(&seed) % SIM_SIZE;
+        const uint32_t end = start + test_random(&seed) % (SIM_BASE + SIM_SIZE - start);
+        random_query(&q, &seed, memory + (start - SIM_BASE));
+        check_search(&q, start, end, 1 + test_random(&seed) % (2 * SEARCH_CHUNK_SIZE));
+    }
+    check_search(&q, SIM_BASE + 0x200 * SEARCH_PAGE_SIZE + 5, SIM_BASE + 0x240 * SEARCH_PAGE_SIZE, 0x1000);
+    check_search(&q, SIM_BASE + 0x100, SIM_BASE + 0x100, 0x1000);
+}
+
+int main(void)
+{
+    memory = malloc(SIM_SIZE);
+    test_queries();
+    test_scan();
+    test_address_space();
+    return test_result();
+}
@@ -0,0 +1,244 @@
+#include "swpatch.h"
+#include "test.h"
+
+#include <string.h>
+
+// Setting and restoring breakpoints against a simulated text segment and store: one read and one write per page
+// covering exactly the patched span, the replaced bytes saved, duplicates, misaligned and already-set addresses
+// dropped, a batch cut short by a full store, and pages whose copies fail.
+
+#define TEXT_BASE 0x81000000u
+#define TEXT_PAGES 4
+#define STORE_MAX 600
+#define BKPT_ARM 0xE1200070u
+#define BKPT_THUMB 0xBE00u
+
+typedef struct
+{
+    uint32_t addr, size;
+} Copy;
+
+static uint8_t text[TEXT_PAGES * SW_PAGE_SIZE];
+static Copy reads[16], writes[16];
+static uint32_t read_count, write_count;
+static uint32_t fail_read_page = ~0u, fail_write_page = ~0u;
+static uint32_t store[STORE_MAX];
+static uint32_t store_used, store_capacity, reserve_calls;
+static uint32_t set_addresses[4];
+static uint32_t set_count;
+
+static bool copy_ok(uint32_t addr, uint32_t size, uint32_t fail_page)
+{
+    return addr >= TEXT_BASE && addr - TEXT_BASE < sizeof(text) && size <= sizeof(text) - (addr - TEXT_BASE) &&
+           (addr - TEXT_BASE) / SW_PAGE_SIZE != fail_page;
+}
+
+static int text_read(uint32_t addr, void *dst, uint32_t size)
+{
+    if (read_count < 16)
+        reads[read_count] = (Copy){addr, size};
+    read_count++;
+    if (!copy_ok(addr, size, fail_read_page))
+        return -1;
+    memcpy(dst, text + (addr - TEXT_BASE), size);
+    return 0;
+}
+
+static int text_write(uint32_t addr, const void *src, uint32_t size)
+{
+    if (write_count < 16)
+        writes[write_count] = (Copy){addr, size};
+    write_count++;
+    if (!copy_ok(addr, size, fail_write_page))
+        return -1;
+    memcpy(text + (addr - TEXT_BASE), src, size);
+    return 0;
+}
+
+static int store_find(uint32_t addr)
+{
+    for (uint32_t i = 0; i < set_count; ++i)
+        if (set_addresses[i] == addr)
+            return 1000 + i;
+    return -1;
+}
+
+static int store_reserve(void)
+{
+    reserve_calls++;
+    return (store_used < store_capacity) ? (int)store_used++ : -1;
+}
+
+static uint32_t *store_saved(int id)
+{
+    return &store[id];
+}
+
+static const SwPatchBackend backend = {
+    .read = text_read,
+    .write = text_write,
+    .find = store_find,
+    .reserve = store_reserve,
+    .saved = store_saved,
+};
+
+static TextPatch patches[SW_PATCH_BATCH];
+
+static void reset(uint32_t capacity)
+{
+    for (uint32_t i = 0; i < sizeof(text); ++i)
+        text[i] = (uint8_t)(i * 7 + (i >> 8));
+    memset(store, 0, sizeof(store));
+    store_used = reserve_calls = 0;
+    store_capacity = capacity;
+    read_count = write_count = 0;
+    fail_read_page = fail_write_page = ~0u;
+    set_count = 0;
+}
+
+static uint32_t text_word(uint32_t addr)
+{
+    uint32_t v;
+    memcpy(&v, text + (addr - TEXT_BASE), 4);
+    return v;
+}
+
+static void test_pages(void)
+{
+    reset(STORE_MAX);
+    set_addresses[set_count++] = TEXT_BASE + 0x2000;
+    // Out of order, over three pages, with a duplicate, a misaligned address and one that is already set.
+    const uint32_t addresses[] = {TEXT_BASE + 0x1FFC, TEXT_BASE + 0x0104, TEXT_BASE + 0x3010, TEXT_BASE + 0x0040,
+                                  TEXT_BASE + 0x1008, TEXT_BASE + 0x0104, TEXT_BASE + 0x0042, TEXT_BASE + 0x2000};
+    const uint32_t count = sizeof(addresses) / sizeof(addresses[0]);
+    static uint8_t before[sizeof(text)];
+    memcpy(before, text, sizeof(text));
+
+    int done = 0;
+    bool full = true;
+    const int kept = swpatch_prepare(patches, addresses, count, &done, BKPT_ARM, 4, &backend, &full);
+    CHECK_EQ(kept, 5);
+    CHECK_EQ(done, count);
+    CHECK(!full);
+    const uint32_t want[] = {TEXT_BASE + 0x0040, TEXT_BASE + 0x0104, TEXT_BASE + 0x1008, TEXT_BASE + 0x1FFC,
+                             TEXT_BASE + 0x3010};
+    for (int i = 0; i < kept && i < 5; ++i)
+    {
+        CHECK_EQ(patches[i].address, want[i]);
+        CHECK(patches[i].id == i && patches[i].saved == &store[i] && !patches[i].ok);
+    }
+    CHECK_EQ(store_used, 5);
+
+    CHECK_EQ(swpatch_apply(patches, kept, &backend), 5);
+    CHECK_EQ(read_count, 3);
+    CHECK_EQ(write_count, 3);
+    // Each copy runs from the page's first patch to the end of its last, and no further.
+    const Copy spans[] = {{TEXT_BASE + 0x0040, 0xC8}, {TEXT_BASE + 0x1008, 0xFF8}, {TEXT_BASE + 0x3010, 4}};
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        CHECK(reads[i].addr == spans[i].addr && reads[i].size == spans[i].size);
+        CHECK(writes[i].addr == spans[i].addr && writes[i].size == spans[i].size);
+    }
+    for (int i = 0; i < 5; ++i)
+    {
+        uint32_t original;
+        memcpy(&original, before + (want[i] - TEXT_BASE), 4);
+        CHECK(patches[i].ok);
+        CHECK_EQ(store[i], original);
+        CHECK_EQ(text_word(want[i]), BKPT_ARM);
+        memcpy(text + (want[i] - TEXT_BASE), &original, 4);
+    }
+    CHECK(memcmp(text, before, sizeof(text)) == 0); // Nothing but the patched words changed
+
+    // Restoring from the saved words takes the same copies and leaves the text as it was.
+    for (int i = 0; i < 5; ++i)
+        memcpy(text + (want[i] - TEXT_BASE), &(uint32_t){BKPT_ARM}, 4);
+    TextPatch restore[5];
+    for (int i = 0; i < 5; ++i)
+        restore[4 - i] = (TextPatch){want[i], store[i], NULL, i, 4, false};
+    swpatch_sort(restore, 5);
+    read_count = write_count = 0;
+    CHECK_EQ(swpatch_apply(restore, 5, &backend), 5);
+    CHECK(read_count == 3 && write_count == 3);
+    CHECK(memcmp(text, before, sizeof(text)) == 0);
+}
+
+static void test_thumb(void)
+{
+    reset(STORE_MAX);
+    const uint32_t addresses[] = {TEXT_BASE + 0x0FFE, TEXT_BASE + 0x0FFC, TEXT_BASE + 0x0FFF};
+    uint16_t original[2];
+    memcpy(original, text + 0xFFC, 4);
+    int done = 0;
+    bool full;
+    const int kept = swpatch_prepare(patches, addresses, 3, &done, BKPT_THUMB, 2, &backend, &full);
+    CHECK_EQ(kept, 2);
+    CHECK_EQ(swpatch_apply(patches, kept, &backend), 2);
+    CHECK(read_count == 1 && reads[0].addr == TEXT_BASE + 0xFFC && reads[0].size == 4);
+    CHECK_EQ(text_word(TEXT_BASE + 0xFFC), BKPT_THUMB | BKPT_THUMB << 16);
+    CHECK_EQ(store[0], original[0]);
+    CHECK_EQ(store[1], original[1]);
+}
+
+static void test_full_store(void)
+{
+    // More addresses than a batch holds; the store runs out partway through the second batch.
+    static uint32_t addresses[SW_PATCH_BATCH + 100];
+    for (uint32_t i = 0; i < sizeof(addresses) / sizeof(addresses[0]); ++i)
+        addresses[i] = TEXT_BASE + (sizeof(addresses) / sizeof(addresses[0]) - 1 - i) * 8;
+    reset(SW_PATCH_BATCH + 40);
+
+    int done = 0;
+    bool full = true;
+    int kept = swpatch_prepare(patches, addresses, sizeof(addresses) / sizeof(addresses[0]), &done, BKPT_ARM, 4,
+                               &backend, &full);
+    CHECK_EQ(kept, SW_PATCH_BATCH);
+    CHECK_EQ(done, SW_PATCH_BATCH);
+    CHECK(!full);
+    CHECK_EQ(swpatch_apply(patches, kept, &backend), SW_PATCH_BATCH);
+
+    kept = swpatch_prepare(patches, addresses, sizeof(addresses) / sizeof(addresses[0]), &done, BKPT_ARM, 4, &backend,
+                           &full);
+    CHECK(full);
+    CHECK_EQ(kept, 40);
+    CHECK_EQ(store_used, SW_PATCH_BATCH + 40);
+    CHECK_EQ(reserve_calls, SW_PATCH_BATCH + 41); // Nothing is tried past the first refusal
+    // The patches kept are the lowest addresses, each with its own entry.
+    for (int i = 0; i < kept; ++i)
+        CHECK(patches[i].address == TEXT_BASE + i * 8 && patches[i].id == SW_PATCH_BATCH + i);
+    CHECK_EQ(swpatch_apply(patches, kept, &backend), 40);
+    CHECK_EQ(text_word(TEXT_BASE + 39 * 8), BKPT_ARM);
+    CHECK(text_word(TEXT_BASE + 40 * 8) != BKPT_ARM);
+}
+
+static void test_failed_copies(void)
+{
+    const uint32_t addresses[] = {TEXT_BASE + 0x10, TEXT_BASE + 0x1010, TEXT_BASE + 0x1020, TEXT_BASE + 0x2010};
+    for (int fail = 0; fail < 2; ++fail)
+    {
+        reset(STORE_MAX);
+        if (fail)
+            fail_write_page = 1;
+        else
+            fail_read_page = 1;
+        const uint32_t original = text_word(TEXT_BASE + 0x1010);
+        int done = 0;
+        bool full;
+        const int kept = swpatch_prepare(patches, addresses, 4, &done, BKPT_ARM, 4, &backend, &full);
+        CHECK_EQ(kept, 4);
+        CHECK_EQ(swpatch_apply(patches, kept, &backend), 2);
+        CHECK(patches[0].ok && !patches[1].ok && !patches[2].ok && patches[3].ok);
+        CHECK_EQ(text_word(TEXT_BASE + 0x1010), original);
+        CHECK_EQ(text_word(TEXT_BASE + 0x2010), BKPT_ARM);
+        CHECK_EQ(write_count, fail ? 3 : 2); // A page that could not be read is not written
+    }
+}
+
+int main(void)
+{
+    test_pages();
+    test_thumb();
+    test_full_store();
+    test_failed_copies();
+    return test_result();
+}
@@ -0,0 +1,396 @@
+#include "symbols.h"
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// NID databases, hand-built and malformed ones plus the one the nidc test writes from symbols/, finding the info block
+// in a synthetic text segment past decoys and across scan chunks, and the sorted index against a linear search.
+
+#define TEXT_BASE 0x81000000u
+#define TEXT_SIZE 0x3000u
+#define DATA_BASE 0x81100000u
+#define DATA_SIZE 0x1000u
+#define BIG_BASE 0x82000000u
+#define BIG_COUNT 3000u
+#define LOOKUPS 100000
+
+// sce_module_info and one library's export entry, laid out as symbols.c reads them.
+typedef struct
+{
+    uint16_t attributes, version;
+    char name[27];
+    uint8_t type;
+    uint32_t gp_value;
+    uint32_t export_top, export_end, import_top, import_end;
+    uint32_t module_nid;
+    uint32_t tls_start, tls_filesz, tls_memsz;
+    uint32_t module_start, module_stop;
+    uint32_t exidx_top, exidx_end, extab_top, extab_end;
+} ModuleInfo;
+
+typedef struct
+{
+    uint16_t size, version, flags, num_funcs;
+    uint32_t num_vars, num_tls;
+    uint32_t library_nid;
+    uint32_t library_name, nid_table, entry_table;
+} Exports;
+
+typedef struct
+{
+    uint32_t base, size;
+    uint8_t *bytes;
+} Region;
+
+static uint8_t text[TEXT_SIZE];
+static uint8_t big[0x8000];
+static Region regions[] = {{TEXT_BASE, sizeof(text), text}, {BIG_BASE, sizeof(big), big}};
+
+static int read_mem(uint32_t addr, void *dst, uint32_t size)
+{
+    for (uint32_t i = 0; i < sizeof(regions) / sizeof(regions[0]); ++i)
+        if (addr >= regions[i].base && addr - regions[i].base <= regions[i].size &&
+            size <= regions[i].size - (addr - regions[i].base))
+        {
+            memcpy(dst, regions[i].bytes + (addr - regions[i].base), size);
+            return 0;
+        }
+    return -1;
+}
+
+// Builds a database in words: header, NIDs, name offsets, then the pool.
+static uint32_t build_db(uint32_t *words, const uint32_t *nids, const uint32_t *names, uint32_t count,
+                         const char *pool, uint32_t pool_size)
+{
+    words[0] = NIDDB_MAGIC;
+    words[1] = NIDDB_VERSION;
+    words[2] = count;
+    words[3] = pool_size;
+    memcpy(words + 4, nids, count * 4);
+    memcpy(words + 4 + count, names, count * 4);
+    memcpy(words + 4 + count * 2, pool, pool_size);
+    return 16 + count * 8 + pool_size;
+}
+
+static const char db_pool[] = "sceFoo\0sceBar\0sceVar";
+static const uint32_t db_nids[] = {0x10, 0x20, 0x30}, db_names[] = {0, 7, 14};
+static uint32_t db_words[64];
+static uint32_t db_size;
+
+static void test_niddb_open(void)
+{
+    NidDb db;
+    uint32_t words[64];
+    db_size = build_db(db_words, db_nids, db_names, 3, db_pool, sizeof(db_pool));
+    CHECK_EQ(niddb_open(&db, db_words, db_size), 0);
+    CHECK(db.count == 3 && db.pool_size == sizeof(db_pool));
+    CHECK(niddb_lookup(&db, 0x20) && !strcmp(niddb_lookup(&db, 0x20), "sceBar"));
+    CHECK(niddb_lookup(&db, 0x30) && !strcmp(niddb_lookup(&db, 0x30), "sceVar"));
+    CHECK(niddb_lookup(&db, 0x10) && !strcmp(niddb_lookup(&db, 0x10), "sceFoo"));
+    CHECK(niddb_lookup(&db, 0x0F) == NULL);
+    CHECK(niddb_lookup(&db, 0x25) == NULL);
+    CHECK(niddb_lookup(&db, 0x31) == NULL);
+
+    CHECK(niddb_open(&db, db_words, 15) < 0);
+    CHECK(db.count == 0 && db.nids == NULL);
+    CHECK(niddb_open(&db, db_words, db_size - 1) < 0); // Pool cut short
+
+    memcpy(words, db_words, db_size);
+    words[0] ^= 1;
+    CHECK(niddb_open(&db, words, db_size) < 0);
+    words[0] = NIDDB_MAGIC;
+    words[1] = NIDDB_VERSION + 1;
+    CHECK(niddb_open(&db, words, db_size) < 0);
+
+    // Counts and sizes running past the buffer, including ones that would wrap a 32-bit sum.
+    const uint32_t counts[] = {4, (db_size - 16) / 8 + 1, 0x20000000, 0xFFFFFFFF};
+    for (uint32_t i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i)
+    {
+        build_db(words, db_nids, db_names, 3, db_pool, sizeof(db_pool));
+        words[2] = counts[i];
+        CHECK(niddb_open(&db, words, db_size) < 0);
+    }
+    const uint32_t pool_sizes[] = {0, sizeof(db_pool) + 1, 0x80000000, 0xFFFFFFFF};
+    for (uint32_t i = 0; i < sizeof(pool_sizes) / sizeof(pool_sizes[0]); ++i)
+    {
+        build_db(words, db_nids, db_names, 3, db_pool, sizeof(db_pool));
+        words[3] = pool_sizes[i];
+        CHECK(niddb_open(&db, words, db_size) < 0);
+    }
+
+    // The last name runs off the end of the pool.
+    CHECK(niddb_open(&db, words, build_db(words, db_nids, db_names, 3, db_pool, sizeof(db_pool) - 1)) < 0);
+
+    const uint32_t unsorted[] = {0x10, 0x30, 0x20}, repeated[] = {0x10, 0x20, 0x20};
+    CHECK(niddb_open(&db, words, build_db(words, unsorted, db_names, 3, db_pool, sizeof(db_pool))) < 0);
+    CHECK(niddb_open(&db, words, build_db(words, repeated, db_names, 3, db_pool, sizeof(db_pool))) < 0);
+
+    const uint32_t past[] = {0, 7, sizeof(db_pool)}, last[] = {0, 7, sizeof(db_pool) - 1};
+    CHECK(niddb_open(&db, words, build_db(words, db_nids, past, 3, db_pool, sizeof(db_pool))) < 0);
+    CHECK_EQ(niddb_open(&db, words, build_db(words, db_nids, last, 3, db_pool, sizeof(db_pool))), 0);
+    CHECK(niddb_lookup(&db, 0x30) && niddb_lookup(&db, 0x30)[0] == '\0');
+
+    // An empty database, as nidc writes it for inputs with no NIDs.
+    CHECK_EQ(niddb_open(&db, words, build_db(words, db_nids, db_names, 0, "", 1)), 0);
+    CHECK(db.count == 0 && niddb_lookup(&db, 0x10) == NULL);
+}
+
+// The database nidc wrote from symbols/nids.yml and symbols/nids.txt.
+static void test_nidc_output(void)
+{
+    static uint32_t words[1024];
+    FILE *f = fopen(NIDDB_FILE, "rb");
+    CHECK(f != NULL);
+    if (!f)
+        return;
+    const uint32_t size = fread(words, 1, sizeof(words), f);
+    fclose(f);
+
+    NidDb db;
+    CHECK_EQ(niddb_open(&db, words, size), 0);
+    CHECK_EQ(db.count, 7);
+    const struct
+    {
+        uint32_t nid;
+        const char *name;
+    } want[] = {{0xC94850C9, "ksceKernelAllocMemBlock"}, {0x009E1C61, "ksceKernelFreeMemBlock"},
+                {0xA841EDDA, "ksceKernelGetMemBlockBase"}, {0x4B675D05, "ksceKernelDelayThread"},
+                {0x00000001, "lowest"}, {0xFFFFFFFF, "highest"}, {0x12345678, "tabbed_name"}};
+    for (uint32_t i = 0; i < sizeof(want) / sizeof(want[0]); ++i)
+    {
+        const char *name = niddb_lookup(&db, want[i].nid);
+        CHECK(name && !strcmp(name, want[i].name));
+        if (!name || strcmp(name, want[i].name))
+            fprintf(stderr, "  %08X is %s\n", want[i].nid, name ? name : "missing");
+    }
+    // The yml's own keys and lines nidc cannot read.
+    CHECK(niddb_lookup(&db, 0x37FE725A) == NULL);
+    CHECK(niddb_lookup(&db, 0x6F25E18A) == NULL);
+    CHECK(niddb_lookup(&db, 0x23456789) == NULL);
+}
+
+static void put_info(uint32_t offset, const char *name, uint32_t export_top, uint32_t export_end, uint32_t exidx_top)
+{
+    ModuleInfo info = {0};
+    strncpy(info.name, name, sizeof(info.name));
+    info.export_top = export_top;
+    info.export_end = export_end;
+    info.import_top = info.import_end = export_end;
+    info.exidx_top = exidx_top;
+    info.exidx_end = exidx_top + 0x80;
+    memcpy(text + offset, &info, sizeof(info));
+}
+
+static void put_exports(uint32_t offset, uint16_t funcs, uint32_t vars, uint32_t nid_table, uint32_t entry_table)
+{
+    const Exports lib = {sizeof(Exports), 1, 0, funcs, vars, 0, 0x1234, 0, nid_table, entry_table};
+    memcpy(text + offset, &lib, sizeof(lib));
+}
+
+static void put_words(uint32_t offset, const uint32_t *words, uint32_t count)
+{
+    memcpy(text + offset, words, count * 4);
+}
+
+// The real block straddles the chunk boundary at 0x2000. Above it sit, in scan order, a bare copy of the name, a block
+// whose export table does not parse, and a well-formed block for another unwind table; below it a block with no
+// exports.
+#define REAL_INFO (0x2000u - 40)
+#define REAL_EXIDX 0x3000u
+
+static void build_text(void)
+{
+    memset(text, 0, sizeof(text));
+    memcpy(text + 0x2F00, "SceTarget", 10);
+    put_info(0x2E00, "SceTarget", 0x2D00, 0x2D20, REAL_EXIDX);
+    put_info(0x2A00, "SceTarget", 0x2900, 0x2920, 0x2C00);
+    put_exports(0x2900, 1, 0, TEXT_BASE + 0x2940, TEXT_BASE + 0x2944);
+    put_words(0x2940, (const uint32_t[]){0x99, TEXT_BASE + 0x2000}, 2);
+
+    put_info(REAL_INFO, "SceTarget", 0x400, 0x440, REAL_EXIDX);
+    put_exports(0x400, 3, 1, TEXT_BASE + 0x500, TEXT_BASE + 0x540);
+    put_words(0x500, (const uint32_t[]){0x10, 0x20, 0x40, 0x30}, 4);
+    put_words(0x540, (const uint32_t[]){TEXT_BASE + 0x101, TEXT_BASE + 0x181, 0x90000001, DATA_BASE + 0x10}, 4);
+    put_exports(0x420, 1, 0, TEXT_BASE + 0x580, TEXT_BASE + 0x584);
+    put_words(0x580, (const uint32_t[]){0x50, TEXT_BASE + 0x200}, 2);
+
+    put_info(0x800, "SceEmpty", 0x400, 0x400, REAL_EXIDX);
+}
+
+static void test_find_exports(void)
+{
+    build_text();
+    SymbolExports exports;
+    CHECK_EQ(symbols_find_exports(TEXT_BASE, TEXT_SIZE, "SceTarget", TEXT_BASE + REAL_EXIDX, read_mem, &exports), 0);
+    CHECK(exports.top == TEXT_BASE + 0x400 && exports.end == TEXT_BASE + 0x440);
+    CHECK_EQ(exports.count, 5);
+
+    // Without the unwind table to go by, the well-formed block for the other table is taken first.
+    CHECK_EQ(symbols_find_exports(TEXT_BASE, TEXT_SIZE, "SceTarget", 0, read_mem, &exports), 0);
+    CHECK(exports.top == TEXT_BASE + 0x2900 && exports.count == 1);
+    // exidx inside the text starts the scan there, and picks the block naming it.
+    CHECK_EQ(symbols_find_exports(TEXT_BASE, TEXT_SIZE, "SceTarget", TEXT_BASE + 0x2C00, read_mem, &exports), 0);
+    CHECK(exports.top == TEXT_BASE + 0x2900 && exports.count == 1);
+    CHECK_EQ(symbols_find_exports(TEXT_BASE, TEXT_SIZE, "SceEmpty", 0, read_mem, &exports), -1);
+    CHECK_EQ(exports.count, 0);
+    CHECK_EQ(symbols_find_exports(TEXT_BASE, TEXT_SIZE, "SceMissing", 0, read_mem, &exports), -1);
+    CHECK_EQ(symbols_find_exports(TEXT_BASE, TEXT_SIZE, "", 0, read_mem, &exports), -1);
+    CHECK_EQ(symbols_find_exports(TEXT_BASE, sizeof(ModuleInfo) - 1, "SceTarget", 0, read_mem, &exports), -1);
+
+    // The same block sitting exactly on either side of the boundary.
+    const uint32_t places[] = {0x2000, 0x2000 - sizeof(ModuleInfo), 0x1000 - 4, 0};
+    for (uint32_t i = 0; i < sizeof(places) / sizeof(places[0]); ++i)
+    {
+        build_text();
+        memset(text + REAL_INFO, 0, sizeof(ModuleInfo));
+        put_info(places[i], "SceTarget", 0x400, 0x440, REAL_EXIDX);
+        CHECK_EQ(symbols_find_exports(TEXT_BASE, TEXT_SIZE, "SceTarget", TEXT_BASE + REAL_EXIDX, read_mem, &exports),
+                 0);
+        CHECK(exports.top == TEXT_BASE + 0x400 && exports.count == 5);
+    }
+    build_text();
+}
+
+static Symbol symbols[BIG_COUNT + 16];
+static SymbolIndex idx;
+
+static void test_index(void)
+{
+    NidDb db;
+    CHECK_EQ(niddb_open(&db, db_words, db_size), 0);
+    SymbolExports exports;
+    CHECK_EQ(symbols_find_exports(TEXT_BASE, TEXT_SIZE, "SceTarget", TEXT_BASE + REAL_EXIDX, read_mem, &exports), 0);
+
+    symbols_init(&idx, symbols, 16);
+    const uint32_t base[4] = {TEXT_BASE, DATA_BASE}, size[4] = {TEXT_SIZE, DATA_SIZE};
+    // 0x90000000 is outside the module's segments, so four of the five exports are kept.
+    CHECK_EQ(symbols_add_module(&idx, "SceTarget", base, size, &exports, read_mem, &db), 4);
+    const uint32_t other_base[4] = {0x80000000, 0, 0x80010000}, other_size[4] = {0x100, 0, 0x100};
+    CHECK_EQ(symbols_add_module(&idx, "SceOther", other_base, other_size, NULL, read_mem, &db), 0);
+    symbols_finish(&idx);
+    CHECK_EQ(idx.range_count, 4);
+    CHECK(idx.ranges[0].start == 0x80000000 && idx.ranges[1].start == 0x80010000 && idx.ranges[3].start == DATA_BASE);
+
+    const Symbol *sym = symbols_lookup(&idx, TEXT_BASE + 0x1FF);
+    CHECK(sym && sym->addr == TEXT_BASE + 0x180 && sym->nid == 0x20 && sym->name && !strcmp(sym->name, "sceBar"));
+    sym = symbols_lookup(&idx, TEXT_BASE + 0x200);
+    CHECK(sym && sym->nid == 0x50 && sym->name == NULL);
+    CHECK(symbols_lookup(&idx, TEXT_BASE + 0xFF) == NULL);
+    CHECK(symbols_lookup(&idx, DATA_BASE + 0x0F) == NULL); // Text symbols do not reach into the data segment
+    sym = symbols_lookup(&idx, DATA_BASE + 0x10);
+    CHECK(sym && sym->name && !strcmp(sym->name, "sceVar"));
+    CHECK(symbols_lookup(&idx, TEXT_BASE + TEXT_SIZE) == NULL);
+
+    char out[64];
+    CHECK_EQ(symbols_format(&idx, TEXT_BASE + 0x104, out, sizeof(out)), 10);
+    CHECK(!strcmp(out, "sceFoo+0x4"));
+    CHECK_EQ(symbols_format(&idx, TEXT_BASE + 0x180, out, sizeof(out)), 6);
+    CHECK(!strcmp(out, "sceBar"));
+    symbols_format(&idx, TEXT_BASE + 0x210, out, sizeof(out));
+    CHECK(!strcmp(out, "SceTarget!00000050+0x10"));
+    symbols_format(&idx, TEXT_BASE + 0x20, out, sizeof(out));
+    CHECK(!strcmp(out, "SceTarget+0x20"));
+    symbols_format(&idx, 0x80010004, out, sizeof(out));
+    CHECK(!strcmp(out, "SceOther:2+0x4"));
+    CHECK_EQ(symbols_format(&idx, 0x80000100, out, sizeof(out)), 0);
+
+    // Truncation always leaves a terminated prefix and reports what was written.
+    const struct
+    {
+        uint32_t size;
+        int len;
+        const char *text;
+    } cut[] = {{1, 0, ""}, {4, 3, "sce"}, {7, 6, "sceFoo"}, {8, 7, "sceFoo+"}, {10, 9, "sceFoo+0x"},
+               {11, 10, "sceFoo+0x4"}};
+    for (uint32_t i = 0; i < sizeof(cut) / sizeof(cut[0]); ++i)
+    {
+        memset(out, 'X', sizeof(out));
+        CHECK_EQ(symbols_format(&idx, TEXT_BASE + 0x104, out, cut[i].size), cut[i].len);
+        CHECK(!strcmp(out, cut[i].text));
+        for (uint32_t k = cut[i].size; k < sizeof(out); ++k)
+            CHECK(out[k] == 'X');
+    }
+    memset(out, 'X', sizeof(out));
+    CHECK_EQ(symbols_format(&idx, TEXT_BASE + 0x104, out, 0), 0);
+    CHECK(out[0] == 'X');
+    CHECK_EQ(symbols_format(&idx, TEXT_BASE + 0x210, out, 12), 11);
+    CHECK(!strcmp(out, "SceTarget!0"));
+}
+
+static int compare_symbols(const void *a, const void *b)
+{
+    const Symbol *x = a, *y = b;
+    if (x->addr != y->addr)
+        return (x->addr < y->addr) ? -1 : 1;
+    return (x->nid < y->nid) ? -1 : (x->nid > y->nid);
+}
+
+// Closest symbol at or below addr within its segment, the slow way.
+static const Symbol *linear_lookup(const SymbolIndex *index, uint32_t addr)
+{
+    const SymbolRange *range = NULL;
+    for (uint32_t i = 0; i < index->range_count; ++i)
+        if (addr >= index->ranges[i].start && addr < index->ranges[i].end)
+            range = &index->ranges[i];
+    const Symbol *best = NULL;
+    for (uint32_t i = 0; range && i < index->symbol_count; ++i)
+        if (index->symbols[i].addr >= range->start && index->symbols[i].addr <= addr &&
+            (!best || index->symbols[i].addr > best->addr))
+            best = &index->symbols[i];
+    return best;
+}
+
+// A module exporting thousands of functions in no particular order, many sharing an address, sorted by the heap sort.
+static void test_sort(void)
+{
+    uint32_t seed = 0x5EED;
+    uint32_t *nid_table = (uint32_t *)(big + 0x100), *entry_table = nid_table + BIG_COUNT;
+    for (uint32_t i = 0; i < BIG_COUNT; ++i)
+    {
+        nid_table[i] = i;
+        // Two segments with a gap between them, plus a few entries outside both.
+        const uint32_t r = test_random(&seed);
+        entry_table[i] = (r % 64 == 0) ? 0x90000000 + r % 0x1000 : BIG_BASE + 0x10000 * (r & 1) + (r >> 1) % 0x2000;
+    }
+    const Exports lib = {sizeof(Exports), 1, 0, BIG_COUNT - 100, 100, 0, 0, 0, BIG_BASE + 0x100,
+                         BIG_BASE + 0x100 + BIG_COUNT * 4};
+    memcpy(big, &lib, sizeof(lib));
+    const SymbolExports exports = {BIG_BASE, BIG_BASE + sizeof(lib), BIG_COUNT};
+
+    symbols_init(&idx, symbols, BIG_COUNT);
+    const uint32_t base[4] = {BIG_BASE, BIG_BASE + 0x10000}, size[4] = {0x2000, 0x2000};
+    const int added = symbols_add_module(&idx, "SceBig", base, size, &exports, read_mem, NULL);
+    CHECK(added > 0 && (uint32_t)added == idx.symbol_count);
+
+    static Symbol expected[BIG_COUNT];
+    memcpy(expected, symbols, idx.symbol_count * sizeof(Symbol));
+    qsort(expected, idx.symbol_count, sizeof(Symbol), compare_symbols);
+    symbols_finish(&idx);
+    for (uint32_t i = 1; i < idx.symbol_count; ++i)
+        CHECK(symbols[i - 1].addr <= symbols[i].addr);
+    // Same symbols, each exactly once.
+    static Symbol sorted[BIG_COUNT];
+    memcpy(sorted, symbols, idx.symbol_count * sizeof(Symbol));
+    qsort(sorted, idx.symbol_count, sizeof(Symbol), compare_symbols);
+    CHECK(!memcmp(sorted, expected, idx.symbol_count * sizeof(Symbol)));
+
+    for (uint32_t i = 0; i < LOOKUPS && !test_failures; ++i)
+    {
+        const uint32_t addr = BIG_BASE - 0x100 + test_random(&seed) % 0x12200;
+        const Symbol *fast = symbols_lookup(&idx, addr), *slow = linear_lookup(&idx, addr);
+        CHECK((fast == NULL) == (slow == NULL));
+        if (fast && slow)
+            CHECK_EQ(fast->addr, slow->addr);
+    }
+}
+
+int main(void)
+{
+    test_niddb_open();
+    test_nidc_output();
+    test_find_exports();
+    test_index();
+    test_sort();
+    return test_result();
+}
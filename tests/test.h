@@ -0,0 +1,55 @@
+#pragma once
+
+// Checks and timing shared by the host tests and benchmarks. A test returns test_result() from main, so ctest sees
+// the failure count in the exit status.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+static int test_failures;
+
+#define CHECK(cond)                                                                                                    \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (!(cond))                                                                                                   \
+        {                                                                                                              \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);                                   \
+            test_failures++;                                                                                           \
+        }                                                                                                              \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                                                     \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        const long long a_ = (long long)(actual), e_ = (long long)(expected);                                          \
+        if (a_ != e_)                                                                                                  \
+        {                                                                                                              \
+            fprintf(stderr, "%s:%d: %s is %#llx, expected %#llx\n", __FILE__, __LINE__, #actual, a_, e_);              \
+            test_failures++;                                                                                           \
+        }                                                                                                              \
+    } while (0)
+
+static inline int test_result(void)
+{
+    if (test_failures)
+        fprintf(stderr, "%d checks failed\n", test_failures);
+    return test_failures != 0;
+}
+
+static inline double bench_now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+// Xorshift, so the corpora and simulated address spaces come out the same on every run.
+static inline uint32_t test_random(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
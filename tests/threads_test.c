@@ -0,0 +1,155 @@
+#include "threads.h"
+#include "test.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+// Claiming, looking up and recycling entries, then more threads than the table has slots stopping and resuming on
+// all cores while readers copy entries: a copy must never mix two writes, and no thread may end up with two entries.
+
+#define WRITERS 40
+#define READERS 2
+#define ROUNDS 10000
+
+static ThreadTable table;
+
+static void test_entries(void)
+{
+    threads_reset(&table);
+    ThreadEntry copy;
+    CHECK(threads_lock(&table, 0, true) == NULL);
+    CHECK(threads_lock(&table, 7, false) == NULL);
+    CHECK(!threads_snapshot(&table, 0, &copy));
+
+    ThreadEntry *e = threads_lock(&table, 7, true);
+    CHECK(e && e->thid == 7 && e->bp == -1 && e->reason == THREAD_RUNNING && (e->seq & 1));
+    e->reason = THREAD_BREAKPOINT;
+    e->regs[15] = 0x81000010;
+    threads_unlock(&table, e);
+    CHECK_EQ(table.generation, 1);
+    CHECK(threads_lock(&table, 7, true) == e);
+    threads_unlock(&table, e);
+    CHECK(threads_find(&table, 7, &copy) && copy.regs[15] == 0x81000010 && !(copy.seq & 1));
+    CHECK(!threads_find(&table, 8, &copy));
+
+    // A table full of stopped threads turns new ones away; once one runs again its entry goes to the newcomer.
+    for (int32_t thid = 100; thid < 100 + THREAD_TABLE_SIZE - 1; ++thid)
+    {
+        ThreadEntry *other = threads_lock(&table, thid, true);
+        CHECK(other != NULL);
+        if (other)
+        {
+            other->reason = THREAD_STEP;
+            threads_unlock(&table, other);
+        }
+    }
+    CHECK(threads_lock(&table, 500, true) == NULL);
+    e = threads_lock(&table, 7, false);
+    e->reason = THREAD_RUNNING;
+    threads_unlock(&table, e);
+    CHECK(threads_lock(&table, 500, true) == e);
+    CHECK(e->thid == 500 && e->regs[15] == 0 && e->bp == -1);
+    threads_unlock(&table, e);
+    CHECK(!threads_find(&table, 7, &copy));
+}
+
+static volatile int stop;
+
+// Stops and resumes like a handler would, writing every register with the round so a torn copy shows.
+static void *writer(void *arg)
+{
+    const int32_t thid = (int32_t)(uintptr_t)arg;
+    uintptr_t turned_away = 0;
+    for (uint32_t round = 1; round <= ROUNDS; ++round)
+    {
+        ThreadEntry *e = threads_lock(&table, thid, true);
+        if (!e)
+        {
+            turned_away++;
+            continue;
+        }
+        for (uint32_t r = 0; r < THREAD_REGS; ++r)
+            e->regs[r] = round;
+        e->reason = THREAD_BREAKPOINT;
+        e->stops++;
+        threads_unlock(&table, e);
+        if (round % 16 == 0)
+            sched_yield(); // Stays stopped a while, so the table fills up and running entries get recycled
+
+        // Stopped, so nobody can recycle the entry before the thread resumes.
+        e = threads_lock(&table, thid, false);
+        if (!e)
+        {
+            test_failures++;
+            break;
+        }
+        e->reason = THREAD_RUNNING;
+        threads_unlock(&table, e);
+    }
+    return (void *)turned_away;
+}
+
+static void *reader(void *arg)
+{
+    (void)arg;
+    uintptr_t errors = 0;
+    ThreadEntry copy;
+    while (!stop)
+        for (uint32_t i = 0; i < THREAD_TABLE_SIZE; ++i)
+        {
+            if (!threads_snapshot(&table, i, &copy))
+                continue;
+            errors += (copy.seq & 1) || copy.thid < 1 || copy.thid > WRITERS;
+            for (uint32_t r = 1; r < THREAD_REGS; ++r)
+                errors += copy.regs[r] != copy.regs[0];
+        }
+    return (void *)errors;
+}
+
+static void test_concurrent(void)
+{
+    threads_reset(&table);
+    stop = 0;
+    pthread_t writers[WRITERS], readers[READERS];
+    for (uintptr_t t = 0; t < READERS; ++t)
+        pthread_create(&readers[t], NULL, reader, NULL);
+    for (uintptr_t t = 0; t < WRITERS; ++t)
+        pthread_create(&writers[t], NULL, writer, (void *)(t + 1));
+
+    uintptr_t turned_away = 0, errors = 0;
+    for (int t = 0; t < WRITERS; ++t)
+    {
+        void *ret;
+        pthread_join(writers[t], &ret);
+        turned_away += (uintptr_t)ret;
+    }
+    stop = 1;
+    for (int t = 0; t < READERS; ++t)
+    {
+        void *ret;
+        pthread_join(readers[t], &ret);
+        errors += (uintptr_t)ret;
+    }
+
+    uint32_t owners[WRITERS + 1] = {0};
+    for (uint32_t i = 0; i < THREAD_TABLE_SIZE; ++i)
+    {
+        const ThreadEntry *e = &table.entries[i];
+        CHECK(!(e->seq & 1));
+        if (e->thid > 0 && e->thid <= WRITERS)
+            owners[e->thid]++;
+    }
+    for (int32_t thid = 1; thid <= WRITERS; ++thid)
+        CHECK(owners[thid] <= 1);
+    printf("%u stops, %lu turned away by a full table, %lu torn copies\n", table.generation / 2,
+           (unsigned long)turned_away, (unsigned long)errors);
+    CHECK_EQ(errors, 0);
+}
+
+int main(void)
+{
+    test_entries();
+    test_concurrent();
+    return test_result();
+}
@@ -0,0 +1,135 @@
+#include "trace.h"
+#include "test.h"
+
+#include <pthread.h>
+#include <string.h>
+
+// Spec parsing, records from several producer threads drained by one consumer in per-producer order, drops when the
+// ring is full, and specs with garbage in them, which must stay within the record and the register file.
+
+#define PRODUCERS 4
+#define PUSHES 200000
+
+static uint8_t memory[256];
+static TraceRing ring;
+static TraceSpec spec;
+static uint32_t regs[COND_REG_COUNT];
+
+static int mem_read(uint32_t addr, void *dst, uint32_t size)
+{
+    if (addr >= sizeof(memory) || size > sizeof(memory) - addr)
+        return -1;
+    memcpy(dst, memory + addr, size);
+    return 0;
+}
+
+static void test_parse(void)
+{
+    CHECK_EQ(trace_parse_spec(&spec, "r0 r1, lr [sp] [r2+0x10] [r2-4]"), 0);
+    CHECK_EQ(spec.reg_mask, (1u << 0) | (1u << 1) | (1u << 14));
+    CHECK_EQ(spec.mem_count, 3);
+    CHECK_EQ(spec.mem_offset[2], -4);
+    TraceSpec bad;
+    CHECK_EQ(trace_parse_spec(&bad, "r0 [r1"), -1);
+    CHECK_EQ(trace_parse_spec(&bad, "foo"), -1);
+    CHECK_EQ(trace_parse_spec(&bad, ""), -1);
+    CHECK_EQ(trace_parse_spec(&bad, "[r0] [r1] [r2] [r3] [r4]"), -1);
+}
+
+static void *producer(void *arg)
+{
+    const uint32_t id = (uint32_t)(uintptr_t)arg;
+    uint32_t r[COND_REG_COUNT];
+    memcpy(r, regs, sizeof(r));
+    r[0] = id;
+    for (uint32_t i = 0; i < PUSHES; ++i)
+    {
+        r[1] = i;
+        trace_push(&ring, &spec, id, 0x81000000, i, id, r, mem_read);
+    }
+    return NULL;
+}
+
+static void test_producers(void)
+{
+    trace_init(&ring);
+    pthread_t threads[PRODUCERS];
+    for (uintptr_t t = 0; t < PRODUCERS; ++t)
+        pthread_create(&threads[t], NULL, producer, (void *)t);
+
+    // Each producer's records come out in its own order and whole; together with the drops they add up.
+    uint32_t seen = 0, last[PRODUCERS] = {0};
+    bool first[PRODUCERS] = {true, true, true, true};
+    TraceRecord rec;
+    for (uint32_t idle = 0; idle < 1000000 && seen + ring.dropped < PRODUCERS * PUSHES;)
+    {
+        if (!trace_pop(&ring, &rec))
+        {
+            idle++;
+            continue;
+        }
+        idle = 0;
+        seen++;
+        if (rec.id >= PRODUCERS || rec.count != 6 || rec.values[0] != rec.id || rec.values[2] != 0x1234 ||
+            rec.values[3] != 0x44332211 || rec.values[4] != 0xDDCCBBAA || rec.faults != 0 ||
+            (!first[rec.id] && rec.values[1] <= last[rec.id]))
+        {
+            test_failures++;
+            break;
+        }
+        first[rec.id] = false;
+        last[rec.id] = rec.values[1];
+    }
+    for (int t = 0; t < PRODUCERS; ++t)
+        pthread_join(threads[t], NULL);
+    while (trace_pop(&ring, &rec))
+        seen++;
+    CHECK_EQ(seen + ring.dropped, PRODUCERS * PUSHES);
+    CHECK_EQ(trace_pending(&ring), 0);
+}
+
+static void test_full(void)
+{
+    trace_init(&ring);
+    for (uint32_t i = 0; i < TRACE_RING_SIZE + 10; ++i)
+        trace_push(&ring, &spec, 1, 0, i, 0, regs, mem_read);
+    CHECK_EQ(trace_pending(&ring), TRACE_RING_SIZE);
+    CHECK_EQ(ring.dropped, 10);
+    TraceRecord rec;
+    CHECK(trace_pop(&ring, &rec));
+    CHECK_EQ(rec.time, 0);
+    CHECK(trace_push(&ring, &spec, 1, 0, 99, 0, regs, mem_read));
+}
+
+static void test_garbage(void)
+{
+    // Every register bit, more memory words than fit, and register indexes past the file.
+    trace_init(&ring);
+    TraceSpec junk;
+    uint32_t seed = 31337;
+    for (uint32_t round = 0; round < 20000; ++round)
+    {
+        for (uint32_t i = 0; i < sizeof(junk); ++i)
+            ((uint8_t *)&junk)[i] = test_random(&seed);
+        if (round & 1)
+            junk.reg_mask = 0xFFFFFFFF;
+        trace_push(&ring, &junk, 0, 0, round, 0, regs, mem_read);
+        TraceRecord rec;
+        CHECK(trace_pop(&ring, &rec));
+        CHECK(rec.count <= TRACE_MAX_VALUES);
+    }
+}
+
+int main(void)
+{
+    regs[13] = 8;
+    regs[2] = 100;
+    regs[14] = 0x1234;
+    memcpy(memory + 8, "\x11\x22\x33\x44", 4);
+    memcpy(memory + 116, "\xAA\xBB\xCC\xDD", 4);
+    test_parse();
+    test_producers();
+    test_full();
+    test_garbage();
+    return test_result();
+}
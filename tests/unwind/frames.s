@@ -0,0 +1,104 @@
+@ Functions for unwind_test, one per kind of unwind entry: a leaf with compact data, Thumb push and pad, a frame
+@ pointer, a personality routine with an .ARM.extab entry, a big register and VFP save, no-unwind, and ARM code.
+@ gen_image.py links them at 0x81000000 into image.h. f_arm calls f_big calls f_pers calls f_fp calls f_push calls
+@ f_leaf; each call_* label is the return address of the call above it.
+
+.syntax unified
+.arch armv7-a
+.fpu vfpv3
+.text
+.thumb
+.globl f_leaf, f_push, f_big, f_fp, f_pers, f_cant, f_arm, call_push, call_fp, call_big, call_pers, call_arm, f_end
+.thumb_func
+f_leaf:
+.fnstart
+  nop
+  bx lr
+.fnend
+
+.thumb_func
+f_push:
+.fnstart
+  .save {r4, r5, r7, lr}
+  push {r4, r5, r7, lr}
+  .pad #16
+  sub sp, #16
+  bl f_leaf
+call_push:
+  add sp, #16
+  pop {r4, r5, r7, pc}
+.fnend
+
+.thumb_func
+f_fp:
+.fnstart
+  .save {r7, lr}
+  push {r7, lr}
+  .setfp r7, sp, #0
+  mov r7, sp
+  .pad #8
+  sub sp, #8
+  bl f_push
+call_fp:
+  mov sp, r7
+  pop {r7, pc}
+.fnend
+
+.thumb_func
+f_pers:
+.fnstart
+  .personality __gxx_personality_v0
+  .save {r4, r6, lr}
+  push {r4, r6, lr}
+  .pad #0x208
+  sub sp, #0x208
+  bl f_fp
+call_pers:
+  add sp, #0x208
+  pop {r4, r6, pc}
+  .handlerdata
+  .word 0
+.fnend
+
+.thumb_func
+f_big:
+.fnstart
+  .save {r4-r11, lr}
+  push.w {r4-r11, lr}
+  .vsave {d8-d9}
+  vpush {d8-d9}
+  .pad #0x400
+  sub sp, #0x400
+  bl f_pers
+call_big:
+  nop
+  bl f_arm_tail
+.fnend
+
+.thumb_func
+f_cant:
+.fnstart
+.cantunwind
+  bx lr
+.fnend
+
+.arm
+.align 2
+f_arm:
+.fnstart
+  .save {r0, r1, r11, lr}
+  push {r0, r1, r11, lr}
+  .vsave {d8}
+  vpush {d8}
+  bl f_big
+call_arm:
+  vpop {d8}
+  pop {r0, r1, r11, pc}
+.fnend
+f_arm_tail:
+  bx lr
+f_end:
+  nop
+.globl __gxx_personality_v0
+__gxx_personality_v0:
+  bx lr
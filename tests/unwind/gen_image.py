@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+# Regenerates image.h, the code and unwind tables unwind_test walks stacks against:
+#
+#   python3 gen_image.py [llvm-mc]
+#
+# frames.s is assembled by LLVM, so the .ARM.exidx and .ARM.extab contents are the ones a real toolchain emits. The
+# sections are then placed as a module would be loaded, .text at IMAGE_BASE with the tables after it, and their
+# R_ARM_PREL31 relocations resolved; the personality routine references resolve to 0, as nothing runs them.
+
+import os
+import struct
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+MC = sys.argv[1] if len(sys.argv) > 1 else 'llvm-mc'
+IMAGE_BASE = 0x81000000
+PLACES = {'.text': 0x000, '.ARM.exidx': 0x100, '.ARM.extab': 0x200}
+IMAGE_SIZE = 0x300
+R_ARM_PREL31 = 42
+
+
+def assemble(tmp):
+    obj = os.path.join(tmp, 'frames.o')
+    subprocess.run([MC, '-triple=armv7a-none-eabi', '-mattr=+vfp3', '-filetype=obj', '-o', obj,
+                    os.path.join(HERE, 'frames.s')], check=True)
+    with open(obj, 'rb') as f:
+        return f.read()
+
+
+def cstr(elf, offset):
+    return elf[offset:elf.index(b'\0', offset)].decode()
+
+
+def link(elf):
+    shoff, = struct.unpack_from('<I', elf, 0x20)
+    shentsize, shnum, shstrndx = struct.unpack_from('<HHH', elf, 0x2E)
+    sections = [struct.unpack_from('<10I', elf, shoff + i * shentsize) for i in range(shnum)]
+    names = [cstr(elf, sections[shstrndx][4] + s[0]) for s in sections]
+
+    image = bytearray(IMAGE_SIZE)
+    for name, place in PLACES.items():
+        s = sections[names.index(name)]
+        assert s[5] <= 0x100, name + ' outgrew its slot'
+        image[place:place + s[5]] = elf[s[4]:s[4] + s[5]]
+
+    symtab = sections[names.index('.symtab')]
+    strtab = sections[symtab[6]][4]
+    symbols = []
+    for i in range(symtab[5] // 16):
+        name, value, _, _, _, shndx = struct.unpack_from('<IIIBBH', elf, symtab[4] + i * 16)
+        section = names[shndx] if 0 < shndx < len(names) else None
+        address = IMAGE_BASE + PLACES[section] + value if section in PLACES else 0
+        symbols.append((cstr(elf, strtab + name), address))
+
+    for s in sections:
+        target = names[s[7]] if s[1] == 9 else None  # SHT_REL
+        if target not in PLACES:
+            continue
+        for k in range(s[5] // 8):
+            offset, info = struct.unpack_from('<II', elf, s[4] + k * 8)
+            if info & 0xFF != R_ARM_PREL31:
+                continue
+            at = PLACES[target] + offset
+            word, = struct.unpack_from('<I', image, at)
+            addend = ((word & 0x7FFFFFFF) ^ 0x40000000) - 0x40000000
+            value = symbols[info >> 8][1]
+            place = IMAGE_BASE + at
+            struct.pack_into('<I', image, at, (word & 0x80000000) | ((value + addend - place) & 0x7FFFFFFF))
+
+    exidx = sections[names.index('.ARM.exidx')]
+    named = [(n, a) for n, a in symbols if a and n and not n.startswith('$')]  # Not section or mapping symbols
+    return image, named, exidx[5] // 8
+
+
+def main():
+    with tempfile.TemporaryDirectory() as tmp:
+        image, symbols, exidx_count = link(assemble(tmp))
+    lines = ['// Generated by gen_image.py from frames.s; do not edit.', '#pragma once', '',
+             '#define IMAGE_BASE 0x%08Xu' % IMAGE_BASE,
+             '#define IMAGE_EXIDX 0x%08Xu' % (IMAGE_BASE + PLACES['.ARM.exidx']),
+             '#define IMAGE_EXIDX_COUNT %du' % exidx_count,
+             '#define IMAGE_EXTAB 0x%08Xu' % (IMAGE_BASE + PLACES['.ARM.extab'])]
+    lines += ['#define S_%s 0x%08Xu' % (n, a) for n, a in sorted(symbols, key=lambda s: s[1])]
+    lines += ['', 'static const uint8_t image_bytes[%d] = {' % IMAGE_SIZE]
+    for i in range(0, IMAGE_SIZE, 16):
+        lines.append('    ' + ' '.join('0x%02X,' % b for b in image[i:i + 16]))
+    lines.append('};')
+    with open(os.path.join(HERE, 'image.h'), 'w') as f:
+        f.write('\n'.join(lines) + '\n')
+
+
+if __name__ == '__main__':
+    main()
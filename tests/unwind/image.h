@@ -0,0 +1,73 @@
+// Generated by gen_image.py from frames.s; do not edit.
+#pragma once
+
+#define IMAGE_BASE 0x81000000u
+#define IMAGE_EXIDX 0x81000100u
+#define IMAGE_EXIDX_COUNT 7u
+#define IMAGE_EXTAB 0x81000200u
+#define S_f_leaf 0x81000001u
+#define S_f_push 0x81000005u
+#define S_call_push 0x8100000Cu
+#define S_f_fp 0x81000011u
+#define S_call_fp 0x8100001Au
+#define S_f_pers 0x8100001Fu
+#define S_call_pers 0x81000028u
+#define S_f_big 0x8100002Fu
+#define S_call_big 0x8100003Eu
+#define S_f_cant 0x81000045u
+#define S_f_arm 0x81000048u
+#define S_call_arm 0x81000054u
+#define S_f_arm_tail 0x8100005Cu
+#define S_f_end 0x81000060u
+#define S___gxx_personality_v0 0x81000064u
+
+static const uint8_t image_bytes[768] = {
+    0x00, 0xBF, 0x70, 0x47, 0xB0, 0xB5, 0x84, 0xB0, 0xFF, 0xF7, 0xFE, 0xFF, 0x04, 0xB0, 0xB0, 0xBD,
+    0x80, 0xB5, 0x6F, 0x46, 0x82, 0xB0, 0xFF, 0xF7, 0xFE, 0xFF, 0xBD, 0x46, 0x80, 0xBD, 0x50, 0xB5,
+    0xAD, 0xF5, 0x02, 0x7D, 0xFF, 0xF7, 0xFE, 0xFF, 0x0D, 0xF5, 0x02, 0x7D, 0x50, 0xBD, 0x2D, 0xE9,
+    0xF0, 0x4F, 0x2D, 0xED, 0x04, 0x8B, 0xAD, 0xF5, 0x80, 0x6D, 0xFF, 0xF7, 0xFE, 0xFF, 0x00, 0xBF,
+    0x00, 0xF0, 0x0C, 0xF8, 0x70, 0x47, 0x00, 0x00, 0x03, 0x48, 0x2D, 0xE9, 0x02, 0x8B, 0x2D, 0xED,
+    0xFE, 0xFF, 0xFF, 0xEB, 0x02, 0x8B, 0xBD, 0xEC, 0x03, 0x88, 0xBD, 0xE8, 0x1E, 0xFF, 0x2F, 0xE1,
+    0x00, 0xF0, 0x20, 0xE3, 0x1E, 0xFF, 0x2F, 0xE1, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0xFF, 0xFF, 0x7F, 0xB0, 0xB0, 0xB0, 0x80, 0xFC, 0xFE, 0xFF, 0x7F, 0x0B, 0x84, 0x03, 0x80,
+    0x00, 0xFF, 0xFF, 0x7F, 0x08, 0x84, 0x97, 0x80, 0x06, 0xFF, 0xFF, 0x7F, 0xE4, 0x00, 0x00, 0x00,
+    0x0E, 0xFF, 0xFF, 0x7F, 0xEC, 0x00, 0x00, 0x00, 0x1C, 0xFF, 0xFF, 0x7F, 0x01, 0x00, 0x00, 0x00,
+    0x18, 0xFF, 0xFF, 0x7F, 0xE8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x64, 0xFE, 0xFF, 0x7F, 0x84, 0x01, 0xB2, 0x01, 0xB0, 0xB0, 0xB0, 0x05, 0x00, 0x00, 0x00, 0x00,
+    0x7F, 0xB2, 0x01, 0x81, 0xB0, 0xAF, 0x81, 0xC9, 0x00, 0x00, 0x00, 0x00, 0x80, 0xC9, 0x01, 0x81,
+    0x80, 0x84, 0x03, 0xB1, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
@@ -0,0 +1,184 @@
+#include "unwind.h"
+#include "test.h"
+
+#include <string.h>
+
+#include "unwind/image.h"
+
+// Walks synthetic stacks through the LLVM-built tables in unwind/image.h (see unwind/gen_image.py): a full chain
+// through every kind of entry, depth limits, the ways a walk stops early, malformed module tables, and random stacks
+// and registers, which must never take the walk outside the stack window or past the depth asked for.
+
+#define STACK_BASE 0x70000000u
+#define STACK_SIZE 0x3000u
+#define RETURN_OUT 0x82000000u // Return address of f_arm, into code no table covers
+#define ITERATIONS 200000
+
+static uint8_t image[sizeof(image_bytes)];
+static uint8_t stack_mem[STACK_SIZE];
+static uint32_t sp;
+static UnwindEntry entries[64];
+static UnwindIndex idx;
+
+static int read_image(uint32_t addr, void *dst, uint32_t size)
+{
+    if (addr < IMAGE_BASE || addr - IMAGE_BASE > sizeof(image) || size > sizeof(image) - (addr - IMAGE_BASE))
+        return -1;
+    memcpy(dst, image + (addr - IMAGE_BASE), size);
+    return 0;
+}
+
+static void push(const uint32_t *words, uint32_t count)
+{
+    sp -= count * 4;
+    memcpy(stack_mem + (sp - STACK_BASE), words, count * 4);
+}
+
+static void pad(uint32_t bytes)
+{
+    sp -= bytes;
+    memset(stack_mem + (sp - STACK_BASE), 0xEE, bytes);
+}
+
+// Lays out the frames of f_arm -> f_big -> f_pers -> f_fp -> f_push -> f_leaf, as the prologues in frames.s leave
+// them, and sets the registers of a stop at the bx lr in f_leaf.
+static void build_chain(uint32_t *regs)
+{
+    memset(regs, 0, 16 * sizeof(uint32_t));
+    sp = STACK_BASE + STACK_SIZE;
+    // f_arm: push {r0, r1, r11, lr}, vpush {d8}
+    push((const uint32_t[]){0xA0, 0xA1, 0xB11, RETURN_OUT}, 4);
+    pad(8);
+    // f_big: push.w {r4-r11, lr}, vpush {d8-d9}, sub sp, #0x400
+    push((const uint32_t[]){0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, S_call_arm}, 9);
+    pad(16 + 0x400);
+    // f_pers: push {r4, r6, lr}, sub sp, #0x208
+    push((const uint32_t[]){0x1004, 0x1006, S_call_big | 1}, 3);
+    pad(0x208);
+    // f_fp: push {r7, lr}, mov r7, sp, sub sp, #8
+    push((const uint32_t[]){0x7777, S_call_pers | 1}, 2);
+    const uint32_t r7 = sp;
+    pad(8);
+    // f_push: push {r4, r5, r7, lr}, sub sp, #16
+    push((const uint32_t[]){0x5004, 0x5005, r7, S_call_fp | 1}, 4);
+    pad(16);
+    regs[7] = r7;
+    regs[13] = sp;
+    regs[14] = S_call_push | 1;
+    regs[15] = (S_f_leaf & ~1u) + 2;
+}
+
+static void test_lookup(void)
+{
+    unwind_init(&idx, entries, 64);
+    memcpy(entries, image + (IMAGE_EXIDX - IMAGE_BASE), IMAGE_EXIDX_COUNT * sizeof(UnwindEntry));
+    CHECK_EQ(unwind_add_module(&idx, IMAGE_EXIDX, IMAGE_EXIDX_COUNT, S_f_end), 0);
+
+    CHECK(unwind_lookup(&idx, IMAGE_BASE - 1, NULL) == NULL);
+    CHECK(unwind_lookup(&idx, S_f_end, NULL) == NULL);
+    const UnwindModule *module = NULL;
+    const UnwindEntry *e = unwind_lookup(&idx, S_f_push & ~1u, &module);
+    CHECK(e && e->fn == (S_f_push & ~1u) && module == &idx.modules[0]);
+    e = unwind_lookup(&idx, (S_f_push & ~1u) - 1, NULL);
+    CHECK(e && e->fn == (S_f_leaf & ~1u));
+    e = unwind_lookup(&idx, S_f_arm_tail, NULL); // Past the last entry, inside the text
+    CHECK(e && e->fn == S_f_arm);
+    e = unwind_lookup(&idx, S_f_cant & ~1u, NULL);
+    CHECK(e && e->data == UNWIND_CANTUNWIND);
+}
+
+static void test_chain(void)
+{
+    const UnwindStack stack = {STACK_BASE, STACK_SIZE, stack_mem};
+    uint32_t regs[16], out[16];
+    build_chain(regs);
+    const uint32_t want[] = {regs[15], S_call_push | 1, S_call_fp | 1, S_call_pers | 1, S_call_big | 1, S_call_arm,
+                             RETURN_OUT};
+    const int n = unwind_backtrace(&idx, regs, &stack, read_image, out, 16);
+    CHECK_EQ(n, 7);
+    for (int i = 0; i < n && i < 7; ++i)
+        CHECK_EQ(out[i], want[i]);
+
+    CHECK_EQ(unwind_backtrace(&idx, regs, &stack, read_image, out, 3), 3);
+    CHECK_EQ(out[2], S_call_fp | 1);
+    CHECK_EQ(unwind_backtrace(&idx, regs, &stack, read_image, out, 1), 1);
+
+    // Stopped outside any table: lr is taken once, then the walk goes on from the caller's tables.
+    regs[15] = 0x83000000;
+    CHECK_EQ(unwind_backtrace(&idx, regs, &stack, read_image, out, 16), 7);
+    CHECK_EQ(out[0], 0x83000000);
+    CHECK_EQ(out[1], S_call_push | 1);
+    CHECK_EQ(out[6], RETURN_OUT);
+}
+
+static void test_early_stops(void)
+{
+    const UnwindStack stack = {STACK_BASE, STACK_SIZE, stack_mem};
+    uint32_t regs[16], out[16];
+
+    build_chain(regs);
+    regs[15] = S_f_cant & ~1u;
+    CHECK_EQ(unwind_backtrace(&idx, regs, &stack, read_image, out, 16), 1);
+
+    // A window ending inside f_pers' saved registers.
+    build_chain(regs);
+    const UnwindStack short_window = {STACK_BASE, regs[13] - STACK_BASE + 16 + 8 + 8 + 8, stack_mem};
+    CHECK_EQ(unwind_backtrace(&idx, regs, &short_window, read_image, out, 16), 3);
+
+    // A window starting above sp, so f_push's saved registers are outside it.
+    const UnwindStack high_window = {regs[13] + 20, STACK_SIZE - 0x100, stack_mem + (regs[13] + 20 - STACK_BASE)};
+    CHECK_EQ(unwind_backtrace(&idx, regs, &high_window, read_image, out, 16), 2);
+
+    // A zero return address in f_push's frame.
+    memset(stack_mem + (regs[13] + 16 + 12 - STACK_BASE), 0, 4);
+    CHECK_EQ(unwind_backtrace(&idx, regs, &stack, read_image, out, 16), 2);
+
+    // f_pers' bytecode lives in .ARM.extab; when that cannot be read the walk ends there.
+    build_chain(regs);
+    memset(image + (IMAGE_EXTAB - IMAGE_BASE), 0xFF, sizeof(image) - (IMAGE_EXTAB - IMAGE_BASE));
+    CHECK_EQ(unwind_backtrace(&idx, regs, &stack, read_image, out, 16), 4);
+    memcpy(image, image_bytes, sizeof(image));
+}
+
+static void test_bad_modules(void)
+{
+    UnwindEntry raw[4] = {{0x10, UNWIND_CANTUNWIND}, {0x0, UNWIND_CANTUNWIND}};
+    UnwindIndex bad;
+    unwind_init(&bad, raw, 4);
+    CHECK(unwind_add_module(&bad, 0x1000, 2, 0) < 0); // Unsorted
+    CHECK(unwind_add_module(&bad, 0x1000, 5, 0) < 0); // Over capacity
+    CHECK(unwind_add_module(&bad, 0x1000, 0, 0) < 0);
+}
+
+static void test_random_stacks(void)
+{
+    const UnwindStack stack = {STACK_BASE, STACK_SIZE, stack_mem};
+    uint32_t regs[16], out[16], seed = 7;
+    for (uint32_t iter = 0; iter < ITERATIONS && !test_failures; ++iter)
+    {
+        // Mostly addresses inside the image, so walks get a few frames in before going astray.
+        for (int k = 0; k < 64; ++k)
+        {
+            const uint32_t slot = test_random(&seed) % (STACK_SIZE / 4), r = test_random(&seed);
+            const uint32_t word = (r & 1) ? IMAGE_BASE + (r >> 1) % 0x70 : r;
+            memcpy(stack_mem + slot * 4, &word, 4);
+        }
+        for (int k = 0; k < 16; ++k)
+            regs[k] = (k == 13) ? STACK_BASE + (test_random(&seed) % STACK_SIZE & ~3u)
+                                : IMAGE_BASE + test_random(&seed) % 0x70;
+        const int depth = 1 + test_random(&seed) % 16;
+        const int n = unwind_backtrace(&idx, regs, &stack, read_image, out, depth);
+        CHECK(n >= 1 && n <= depth);
+    }
+}
+
+int main(void)
+{
+    memcpy(image, image_bytes, sizeof(image));
+    test_lookup();
+    test_chain();
+    test_early_stops();
+    test_bad_modules();
+    test_random_stacks();
+    return test_result();
+}
@@ -0,0 +1,184 @@
+// Compiles a NID list into the database the symbolizer loads from ux0:data/pebbleNids.bin.
+//
+//   cc -O2 -o nidc tools/nidc.c
+//   nidc db.yml [more.txt ...] pebbleNids.bin
+//
+// Input lines are either "0x4B675D05 sceKernelDelayThread" or the "sceKernelDelayThread: 0x4B675D05" form of the
+// vita-headers db.yml files; '#' starts a comment and anything else is skipped. The first name seen for a NID wins.
+// The host tests build it too and read what it writes back through niddb_open (tests/symbols_test.c).
+
+#include "../kernel/include/symbols.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+    uint32_t nid;
+    uint32_t name; // Offset in the pool
+} Entry;
+
+static Entry *entries;
+static uint32_t entry_count, entry_capacity;
+static char *pool;
+static uint32_t pool_size, pool_capacity;
+
+static void *grow(void *p, uint32_t *capacity, uint32_t needed, size_t item)
+{
+    if (needed <= *capacity)
+        return p;
+    while (*capacity < needed)
+        *capacity = *capacity ? *capacity * 2 : 1024;
+    p = realloc(p, *capacity * item);
+    if (!p)
+    {
+        fprintf(stderr, "nidc: out of memory\n");
+        exit(1);
+    }
+    return p;
+}
+
+static void add(uint32_t nid, const char *name, size_t len)
+{
+    entries = grow(entries, &entry_capacity, entry_count + 1, sizeof(Entry));
+    pool = grow(pool, &pool_capacity, pool_size + len + 1, 1);
+    entries[entry_count++] = (Entry){nid, pool_size};
+    memcpy(pool + pool_size, name, len);
+    pool[pool_size + len] = '\0';
+    pool_size += len + 1;
+}
+
+static int parse_nid(const char *s, uint32_t *nid)
+{
+    char *end;
+    if (s[0] != '0' || (s[1] != 'x' && s[1] != 'X'))
+        return -1;
+    const unsigned long value = strtoul(s, &end, 16);
+    if (end == s + 2 || (*end && !isspace((unsigned char)*end)) || value > 0xFFFFFFFFul)
+        return -1;
+    *nid = (uint32_t)value;
+    return 0;
+}
+
+static bool is_name_char(char c)
+{
+    return isalnum((unsigned char)c) || c == '_';
+}
+
+static void parse_line(char *line)
+{
+    char *hash = strchr(line, '#');
+    if (hash)
+        *hash = '\0';
+    while (isspace((unsigned char)*line))
+        line++;
+
+    uint32_t nid;
+    const char *name = line;
+    size_t len = 0;
+    if (parse_nid(line, &nid) == 0)
+    {
+        // "0xNID name"
+        name = line + strcspn(line, " \t");
+        name += strspn(name, " \t");
+        while (is_name_char(name[len]))
+            len++;
+    }
+    else
+    {
+        // "name: 0xNID"; the yml's own keys carry module and library NIDs or flags, not symbols.
+        while (is_name_char(name[len]))
+            len++;
+        if (!len || name[len] != ':' || parse_nid(name + len + 1 + strspn(name + len + 1, " \t"), &nid) < 0)
+            return;
+        if ((len == 3 && !strncmp(name, "nid", 3)) || (len == 6 && !strncmp(name, "kernel", 6)) ||
+            (len == 7 && !strncmp(name, "version", 7)))
+            return;
+    }
+    if (len)
+        add(nid, name, len);
+}
+
+static int compare(const void *a, const void *b)
+{
+    const Entry *x = a, *y = b;
+    if (x->nid != y->nid)
+        return (x->nid < y->nid) ? -1 : 1;
+    return (x->name < y->name) ? -1 : (x->name > y->name);
+}
+
+static void put32(FILE *f, uint32_t v)
+{
+    const uint8_t b[4] = {v, v >> 8, v >> 16, v >> 24};
+    fwrite(b, 1, 4, f);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s input... output\n", argv[0]);
+        return 1;
+    }
+
+    char line[1024];
+    for (int i = 1; i < argc - 1; ++i)
+    {
+        FILE *in = fopen(argv[i], "r");
+        if (!in)
+        {
+            perror(argv[i]);
+            return 1;
+        }
+        while (fgets(line, sizeof(line), in))
+            parse_line(line);
+        fclose(in);
+    }
+
+    // Sorting by pool offset second keeps the first name seen for a NID at the head of its run.
+    qsort(entries, entry_count, sizeof(Entry), compare);
+    uint32_t count = 0, duplicates = 0;
+    for (uint32_t i = 0; i < entry_count; ++i)
+    {
+        if (count && entries[count - 1].nid == entries[i].nid)
+        {
+            if (strcmp(pool + entries[count - 1].name, pool + entries[i].name))
+                duplicates++;
+            continue;
+        }
+        entries[count++] = entries[i];
+    }
+
+    FILE *out = fopen(argv[argc - 1], "wb");
+    if (!out)
+    {
+        perror(argv[argc - 1]);
+        return 1;
+    }
+    put32(out, NIDDB_MAGIC);
+    put32(out, NIDDB_VERSION);
+    put32(out, count);
+    put32(out, pool_size ? pool_size : 1);
+    for (uint32_t i = 0; i < count; ++i)
+        put32(out, entries[i].nid);
+    for (uint32_t i = 0; i < count; ++i)
+        put32(out, entries[i].name);
+    // Names dropped as duplicates stay in the pool; the offsets simply never point at them.
+    if (pool_size)
+        fwrite(pool, 1, pool_size, out);
+    else
+        fputc('\0', out);
+    if (fclose(out))
+    {
+        perror(argv[argc - 1]);
+        return 1;
+    }
+
+    printf("%u NIDs, %u bytes of names", count, pool_size);
+    if (duplicates)
+        printf(", %u conflicting duplicates kept their first name", duplicates);
+    printf("\n");
+    return 0;
+}
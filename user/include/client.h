@@ -0,0 +1,46 @@
+#pragma once
+
+#include "../../kernel/include/batch.h"
+
+#include <stdbool.h>
+#include <psp2/types.h>
+
+// Client side of kernel_batch: queue ops into a request, submit it in one syscall, then walk the replies in order.
+// Link with pebble_client and the pebble stubs. Buffers must be 4-byte aligned.
+//
+//   PebbleBatch b;
+//   PebbleReplies r;
+//   pebble_batch_init(&b, request, sizeof(request));
+//   pebble_batch_get_registers(&b, 0);
+//   pebble_batch_read(&b, sp, 0x100);
+//   if (pebble_batch_submit(&b, reply, sizeof(reply), &r) >= 0)
+//       while (pebble_batch_next(&r, &result, &data))
+//           ...
+
+typedef struct
+{
+    uint8_t *buf;
+    uint32_t capacity, size;
+    uint16_t count;
+    bool overflow; // An op did not fit; submit refuses the batch
+} PebbleBatch;
+
+typedef struct
+{
+    const uint8_t *reply;
+    uint32_t pos, size;
+    uint16_t index, count; // count is below the number of ops queued when the reply buffer ran out
+} PebbleReplies;
+
+int kernel_batch(const void *user_in, SceSize in_size, void *user_out, SceSize out_size);
+
+void pebble_batch_init(PebbleBatch *b, void *buf, uint32_t capacity);
+int pebble_batch_read(PebbleBatch *b, uint32_t addr, uint32_t size);
+int pebble_batch_write(PebbleBatch *b, uint32_t addr, const void *src, uint32_t size);
+int pebble_batch_set_breakpoint(PebbleBatch *b, uint32_t addr, uint32_t type);
+int pebble_batch_clear_breakpoint(PebbleBatch *b, int id);
+int pebble_batch_list_breakpoints(PebbleBatch *b, int after, uint32_t max);
+int pebble_batch_get_registers(PebbleBatch *b, int32_t thid);
+int pebble_batch_list_modules(PebbleBatch *b, uint32_t max);
+int pebble_batch_submit(PebbleBatch *b, void *reply, uint32_t reply_size, PebbleReplies *out);
+bool pebble_batch_next(PebbleReplies *r, BatchResult *result, const void **data);
@@ -0,0 +1,108 @@
+#include "../include/client.h"
+
+#include <psp2/kernel/clib.h>
+
+void pebble_batch_init(PebbleBatch *b, void *buf, uint32_t capacity)
+{
+    b->buf = buf;
+    b->capacity = (capacity < BATCH_MAX_IN) ? capacity : BATCH_MAX_IN;
+    b->size = sizeof(BatchHeader);
+    b->count = 0;
+    b->overflow = capacity < sizeof(BatchHeader);
+}
+
+// Queues one op; returns its index in the batch, which is also the index of its reply, or -1 when it does not fit.
+static int push(PebbleBatch *b, uint16_t opcode, uint32_t arg0, uint32_t arg1, const void *payload, uint32_t size)
+{
+    const BatchOp op = {opcode, size, arg0, arg1};
+    if (b->overflow || size > 0xFFFF || b->count == 0xFFFF ||
+        b->capacity - b->size < sizeof(op) + BATCH_PAD(size))
+    {
+        b->overflow = true;
+        return -1;
+    }
+    sceClibMemcpy(b->buf + b->size, &op, sizeof(op));
+    if (size)
+    {
+        sceClibMemcpy(b->buf + b->size + sizeof(op), payload, size);
+        sceClibMemset(b->buf + b->size + sizeof(op) + size, 0, BATCH_PAD(size) - size);
+    }
+    b->size += sizeof(op) + BATCH_PAD(size);
+    return b->count++;
+}
+
+int pebble_batch_read(PebbleBatch *b, uint32_t addr, uint32_t size)
+{
+    if (!size || size > BATCH_MAX_READ)
+        return -1;
+    return push(b, BATCH_READ, addr, size, NULL, 0);
+}
+
+int pebble_batch_write(PebbleBatch *b, uint32_t addr, const void *src, uint32_t size)
+{
+    if (!src || !size)
+        return -1;
+    return push(b, BATCH_WRITE, addr, 0, src, size);
+}
+
+int pebble_batch_set_breakpoint(PebbleBatch *b, uint32_t addr, uint32_t type)
+{
+    return push(b, BATCH_SET_BREAKPOINT, addr, type, NULL, 0);
+}
+
+int pebble_batch_clear_breakpoint(PebbleBatch *b, int id)
+{
+    return push(b, BATCH_CLEAR_BREAKPOINT, (uint32_t)id, 0, NULL, 0);
+}
+
+int pebble_batch_list_breakpoints(PebbleBatch *b, int after, uint32_t max)
+{
+    return push(b, BATCH_LIST_BREAKPOINTS, (uint32_t)after, max, NULL, 0);
+}
+
+int pebble_batch_get_registers(PebbleBatch *b, int32_t thid)
+{
+    return push(b, BATCH_GET_REGISTERS, (uint32_t)thid, 0, NULL, 0);
+}
+
+int pebble_batch_list_modules(PebbleBatch *b, uint32_t max)
+{
+    return push(b, BATCH_LIST_MODULES, 0, max, NULL, 0);
+}
+
+// Runs the queued ops in one syscall; returns how many of them ran, or < 0 when nothing did.
+int pebble_batch_submit(PebbleBatch *b, void *reply, uint32_t reply_size, PebbleReplies *out)
+{
+    if (b->overflow || !reply || reply_size < sizeof(BatchHeader))
+        return -1;
+    const BatchHeader request = {BATCH_MAGIC, BATCH_VERSION, b->count, b->size};
+    sceClibMemcpy(b->buf, &request, sizeof(request));
+
+    const int ret = kernel_batch(b->buf, b->size, reply, reply_size);
+    BatchHeader header;
+    sceClibMemcpy(&header, reply, sizeof(header));
+    if (ret < (int)sizeof(BatchHeader) || header.magic != BATCH_MAGIC || header.version != BATCH_VERSION ||
+        header.size != (uint32_t)ret || header.count > b->count)
+        return -1;
+
+    out->reply = reply;
+    out->pos = sizeof(BatchHeader);
+    out->size = header.size;
+    out->index = 0;
+    out->count = header.count;
+    return header.count;
+}
+
+// Next reply in op order; data points at its payload inside the reply buffer, NULL when it has none.
+bool pebble_batch_next(PebbleReplies *r, BatchResult *result, const void **data)
+{
+    if (r->index >= r->count || r->size - r->pos < sizeof(BatchResult))
+        return false;
+    sceClibMemcpy(result, r->reply + r->pos, sizeof(*result));
+    if (r->size - r->pos - sizeof(*result) < BATCH_PAD(result->size))
+        return false;
+    *data = result->size ? r->reply + r->pos + sizeof(*result) : NULL;
+    r->pos += sizeof(*result) + BATCH_PAD(result->size);
+    r->index++;
+    return true;
+}
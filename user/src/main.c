@@ -55,6 +55,7 @@ int pebble_thread_user(SceSize args, void *argp)
         if (sceKernelLockMutex(pebble_mtx_uid_user, 1, NULL) == 0)
         {
             sceDisplaySetFrameBuf(&user_frame, SCE_DISPLAY_SETBUF_NEXTFRAME);
+            kernel_frame_presented();
             sceKernelUnlockMutex(pebble_mtx_uid_user, 1);
         }
     }